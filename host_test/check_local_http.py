@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+本地 HTTP 接口压测（ctest 调用，仅依赖 Python 标准库）
+
+启动 http_sim（local_http.c 运行在假 esp_http_server 上，端口由系统分配），依次运行 tools/http_load.py：
+  1. 6 个并发抓取者（多于 LOCAL_HTTP_MAX_SOCKETS，连接数满时最久未活动的连接被关闭后重连）抓取 3 秒，
+     并以 stubs/sdkconfig.h 中的 CONFIG_LOCAL_HTTP_TOKEN 校验 /command 鉴权
+  2. 2 个抓取者各抓取 50 次（保持连接）
+  3. 鉴权锁定按客户端地址：从 127.0.0.2 连续 5 次错误令牌后该地址得到 429（正确令牌也一样），
+     127.0.0.1 持正确令牌仍得到 200
+然后停止 http_sim，检查其退出码（分块超过 LOCAL_HTTP_CHUNK_SIZE 时为 1）。任一步失败时返回 1。
+
+  python3 host_test/check_local_http.py <http_sim 路径> <tools/http_load.py 路径>
+"""
+
+import http.client
+import json
+import os
+import re
+import signal
+import subprocess
+import sys
+
+SDKCONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "stubs", "sdkconfig.h")
+LOAD_RUNS = [
+    ["--clients", "6", "--duration", "3"],
+    ["--clients", "2", "--requests", "50"],
+]
+
+
+def read_token():
+    with open(SDKCONFIG, encoding="utf-8") as f:
+        m = re.search(r'#define CONFIG_LOCAL_HTTP_TOKEN "([^"]*)"', f.read())
+    if not m:
+        raise SystemExit("%s 中没有 CONFIG_LOCAL_HTTP_TOKEN" % SDKCONFIG)
+    return m.group(1)
+
+
+def post_command(host, port, source, token):
+    """从 source 地址 POST /command（ttl=0），返回状态码"""
+    conn = http.client.HTTPConnection(host, port, timeout=5, source_address=(source, 0))
+    try:
+        conn.request("POST", "/command", body=json.dumps({"ttl": 0}),
+                     headers={"Authorization": "Bearer " + token, "Content-Type": "application/json"})
+        resp = conn.getresponse()
+        resp.read()
+        return resp.status
+    finally:
+        conn.close()
+
+
+def check_lockout(host, port, token):
+    """返回错误列表"""
+    expected = [("127.0.0.2", token + "x", 401)] * 5 + [
+        ("127.0.0.2", token + "x", 429),
+        ("127.0.0.2", token, 429),
+        ("127.0.0.1", token, 200),
+    ]
+    errors = []
+    for i, (source, tok, status) in enumerate(expected):
+        got = post_command(host, port, source, tok)
+        if got != status:
+            errors.append("第 %d 次（%s，%s令牌）: 期望 %d，实际 %d" %
+                          (i + 1, source, "正确" if tok == token else "错误", status, got))
+    return errors
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit("用法: check_local_http.py <http_sim> <http_load.py>")
+    sim_path, load_path = sys.argv[1:]
+    token = read_token()
+
+    sim = subprocess.Popen([sim_path, "--port", "0", "--seconds", "120"], stdout=subprocess.PIPE)
+    failed = False
+    try:
+        line = sim.stdout.readline().decode("utf-8").strip()
+        if not line.startswith("port "):
+            raise SystemExit("http_sim 未能启动（输出 %r）" % line)
+        address = "127.0.0.1:%s" % line.split()[1]
+        for i, args in enumerate(LOAD_RUNS):
+            cmd = [sys.executable, load_path, address] + args
+            if i == 0:
+                cmd += ["--token", token]
+            print("$ http_load.py %s" % " ".join(cmd[2:]), flush=True)
+            if subprocess.run(cmd).returncode != 0:
+                failed = True
+        print("$ 鉴权锁定按客户端地址", flush=True)
+        for err in check_lockout("127.0.0.1", int(line.split()[1]), token):
+            print("锁定校验失败: %s" % err)
+            failed = True
+    finally:
+        if sim.poll() is None:
+            sim.send_signal(signal.SIGTERM)
+        try:
+            sim.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            sim.kill()
+            sim.wait()
+    if sim.returncode != 0:
+        print("http_sim 退出码 %d" % sim.returncode)
+        failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+"""
+状态 / 告警消息与 Guides/MQTT.md 的一致性检查（ctest 调用，仅依赖 Python 标准库）
+
+格式定义直接取自文档，文档与代码任一方改动都会被发现：
+  2.1 / 2.2 节的 JSON 示例     必需字段、字段顺序与类型（fan_0 ~ fan_{N-1} 按实际风扇数展开）
+  "字段说明" 列表              允许出现的字段、字符串枚举值、"保留 N 位小数"、风扇数范围、嵌套对象的子字段
+  "批量样本（series）" 示例     series 的字段与类型；另按文档检查增量编码列与变化点的结构、"最多 N 个样本"
+
+消息由 json_bench --dump 生成（当前 json_writer 版本与改用前的 cJSON 版本）。
+json_writer 版本按上述定义检查；cJSON 版本只作对照：它的每个字段在 json_writer 版本中都应出现、
+相对顺序一致、取值相同（数值按文档小数位舍入后相等，timestamp 允许相差 1 秒）。
+
+  python3 host_test/check_payload_schema.py <json_bench 路径> <Guides/MQTT.md 路径>
+"""
+
+import json
+import re
+import subprocess
+import sys
+
+
+class RawFloat(float):
+    """保留原始文本的浮点数（用于检查小数位数）"""
+
+    def __new__(cls, text):
+        value = float.__new__(cls, text)
+        value.raw = text
+        return value
+
+
+def load_json(text):
+    return json.loads(text, parse_float=RawFloat)
+
+
+def type_name(value):
+    if isinstance(value, bool):
+        return "bool"
+    if isinstance(value, (int, float)):
+        return "number"
+    if isinstance(value, str):
+        return "string"
+    if isinstance(value, list):
+        return "array"
+    if isinstance(value, dict):
+        return "object"
+    return "null"
+
+
+def decimals(value):
+    """数值的小数位数，科学计数法返回 None"""
+    raw = getattr(value, "raw", None)
+    if raw is None:
+        return 0
+    if "e" in raw or "E" in raw:
+        return None
+    return len(raw.split(".")[1]) if "." in raw else 0
+
+
+# ---- 文档解析 ----
+
+class Field:
+    def __init__(self, name):
+        self.name = name
+        self.pattern = re.compile("^" + re.sub(r"\\\{N\\-1\\\}|N", r"\\d+", re.escape(name)) + "$")
+        self.enum = []
+        self.decimals = None
+        self.children = []      # 嵌套对象的子字段名
+        self.text = ""
+
+
+class Schema:
+    def __init__(self, example, fields):
+        self.example = example  # 文档示例（dict，保持顺序）
+        self.fields = fields    # 字段说明列表中的 Field
+        self.series = None      # series 示例
+        self.max_samples = None
+        self.fan_range = None
+
+    def field(self, key):
+        for f in self.fields:
+            if f.pattern.match(key):
+                return f
+        return None
+
+
+def section(doc, number):
+    m = re.search(r"^### %s .*?$(.*?)(?=^### |\Z)" % re.escape(number), doc, re.M | re.S)
+    if not m:
+        raise SystemExit("文档中没有 %s 节" % number)
+    return m.group(1)
+
+
+BULLET = re.compile(r"^(\s*)- ((?:`[^`]+`(?:\s*(?:,|/|~|、)\s*)?)+)\s*(?:[:：-]\s*)?(.*)$")
+
+
+def parse_fields(text):
+    """解析 "字段说明" 列表（到第一个空行为止）"""
+    start = text.index("**字段说明**")
+    lines = text[start:].split("\n")[1:]
+    fields = []
+    parents = []
+    for line in lines:
+        if not line.strip():
+            break
+        # 以引号枚举值开头的子项，属于上一项的最后一个字段（如 "`fan_N_rpm`, `fan_N_tach`" 中的 tach）
+        m = re.match(r"^\s+- `\"([^\"]+)\"`", line)
+        if m:
+            if parents:
+                parents[-1].enum.append(m.group(1))
+            continue
+        m = BULLET.match(line)
+        if not m:
+            for f in parents:
+                f.text += line   # 上一项的续行
+            continue
+        indent, names, rest = len(m.group(1)), re.findall(r"`([^`]+)`", m.group(2)), m.group(3)
+        if indent == 0:
+            if "~" in m.group(2):
+                names = names[-1:]   # "`fan_0` ~ `fan_{N-1}`" 为同一个字段
+            parents = [Field(n) for n in names]
+            for f in parents:
+                f.text = rest
+                f.enum += re.findall(r'`"([A-Z_]+)"`', rest)
+                d = re.search(r"保留 (\d+) 位小数", rest)
+                if d:
+                    f.decimals = int(d.group(1))
+            fields += parents
+            continue
+        # 子项：与上一项同名的字段补充说明，否则为上一项（对象）的子字段
+        parent_names = {f.name for f in parents}
+        d = re.search(r"保留 (\d+) 位小数", rest)
+        for n in names:
+            if n in parent_names:
+                if d:
+                    next(f for f in parents if f.name == n).decimals = int(d.group(1))
+            else:
+                for f in parents:
+                    f.children.append(n)
+    return fields
+
+
+def parse_schema(doc, number):
+    text = section(doc, number)
+    blocks = re.findall(r"```json\n(.*?)```", text, re.S)
+    schema = Schema(load_json(blocks[0]), parse_fields(text))
+    for block in blocks[1:]:
+        if block.lstrip().startswith('"series"'):
+            schema.series = load_json("{" + block + "}")["series"]
+    m = re.search(r"最多 (\d+) 个样本", text)
+    if m:
+        schema.max_samples = int(m.group(1))
+    for f in schema.fields:
+        m = re.search(r"(\d+)~(\d+)", f.text)
+        if f.pattern.match("fan_0") and m:
+            schema.fan_range = (int(m.group(1)), int(m.group(2)))
+    return schema
+
+
+# ---- 检查 ----
+
+FAN_KEY = re.compile(r"^fan_(\d+)$")
+
+
+def check_value(errors, where, field, example, value):
+    t = type_name(value)
+    if example is not None and t != type_name(example):
+        errors.append("%s: 类型 %s，文档为 %s" % (where, t, type_name(example)))
+        return
+    if field and field.enum:
+        if value not in field.enum:
+            errors.append("%s: %r 不在文档枚举 %s 中" % (where, value, field.enum))
+        return
+    if t == "number":
+        d = decimals(value)
+        allowed = field.decimals if field and field.decimals is not None else 0
+        if d is None:
+            errors.append("%s: 使用了科学计数法 %s" % (where, value.raw))
+        elif d > allowed:
+            errors.append("%s: %s 有 %d 位小数，文档为 %d 位" % (where, getattr(value, "raw", value), d, allowed))
+    elif example is None and field and t != "object":
+        errors.append("%s: 类型 %s，文档说明的字段应为数值或枚举" % (where, t))
+
+
+def check_order(errors, where, keys, reference):
+    common = [k for k in keys if k in reference]
+    expected = [k for k in reference if k in common]
+    if common != expected:
+        errors.append("%s: 字段顺序 %s，应为 %s" % (where, common, expected))
+
+
+def expand_example(example, fan_count):
+    """示例的键顺序，fan_0 ~ fan_2 按实际风扇数展开"""
+    keys = []
+    for k in example:
+        m = FAN_KEY.match(k)
+        if m:
+            if m.group(1) == "0":
+                keys += ["fan_%d" % i for i in range(fan_count)]
+            continue
+        keys.append(k)
+    return keys
+
+
+def check_series(errors, schema, series, fan_count, modes, states):
+    ref = schema.series
+    if list(series) != list(ref):
+        errors.append("series: 字段 %s，文档为 %s" % (list(series), list(ref)))
+        return
+    for k, v in series.items():
+        if type_name(v) != type_name(ref[k]):
+            errors.append("series.%s: 类型 %s，文档为 %s" % (k, type_name(v), type_name(ref[k])))
+            return
+    count = len(series["co2"])
+    if schema.max_samples and count > schema.max_samples:
+        errors.append("series: %d 个样本，文档上限 %d" % (count, schema.max_samples))
+    for col in ("co2", "temp", "humi"):
+        values = series[col]
+        if len(values) != count:
+            errors.append("series.%s: 长度 %d，co2 为 %d" % (col, len(values), count))
+        for i, v in enumerate(values):
+            if v is not None and (type_name(v) != "number" or decimals(v) != 0):
+                errors.append("series.%s[%d]: %r 不是整数" % (col, i, v))
+    for col, width, enum in (("fans", fan_count, states), ("mode", 1, modes)):
+        last = -1
+        for i, change in enumerate(series[col]):
+            if (not isinstance(change, list) or len(change) != 1 + width or
+                    type_name(change[0]) != "number" or not all(s in enum for s in change[1:])):
+                errors.append("series.%s[%d]: %r 应为 [样本序号, %d 个 %s]" % (col, i, change, width, enum))
+                continue
+            if (i == 0 and change[0] != 0) or change[0] <= last or change[0] >= count:
+                errors.append("series.%s[%d]: 样本序号 %r 无效" % (col, i, change[0]))
+            last = change[0]
+        if not series[col]:
+            errors.append("series.%s: 第一个样本未列出" % col)
+
+
+def check_status(schema, msg):
+    errors = []
+    fan_count = sum(1 for k in msg if FAN_KEY.match(k))
+    if schema.fan_range and not schema.fan_range[0] <= fan_count <= schema.fan_range[1]:
+        errors.append("风扇数 %d 超出文档范围 %s" % (fan_count, schema.fan_range))
+    required = expand_example(schema.example, fan_count)
+    for k in required:
+        if k not in msg:
+            errors.append("缺少字段 %s" % k)
+    check_order(errors, "顶层", list(msg), required)
+
+    fan_example = schema.example.get("fan_0")
+    states = schema.field("fan_0").enum
+    modes = schema.field("mode").enum
+    for k, v in msg.items():
+        field = schema.field(k)
+        if field is None:
+            errors.append("字段 %s 未在文档中说明" % k)
+            continue
+        m = re.match(r"^fan_(\d+)", k)
+        if m and int(m.group(1)) >= fan_count:
+            errors.append("%s: 风扇序号超出风扇数 %d" % (k, fan_count))
+        example = fan_example if FAN_KEY.match(k) else schema.example.get(k)
+        if k == "series":
+            check_series(errors, schema, v, fan_count, modes, states)
+            continue
+        check_value(errors, k, field, example, v)
+        if isinstance(v, dict):
+            children = list(example) if isinstance(example, dict) else field.children
+            for ck in v:
+                if ck not in children:
+                    errors.append("%s.%s 未在文档中说明" % (k, ck))
+            if isinstance(example, dict):
+                for ck in example:
+                    if ck not in v:
+                        errors.append("缺少字段 %s.%s" % (k, ck))
+                    else:
+                        check_value(errors, "%s.%s" % (k, ck), None, example[ck], v[ck])
+                check_order(errors, k, list(v), list(example))
+
+    # 转速计与运行统计字段成组出现
+    for i in range(fan_count):
+        for group in (("rpm", "tach"), ("on_h", "wh", "starts", "filter")):
+            present = ["fan_%d_%s" % (i, g) in msg for g in group]
+            if any(present) and not all(present):
+                errors.append("fan_%d 的 %s 字段不完整" % (i, "/".join(group)))
+    return errors
+
+
+def check_alert(schema, msg):
+    errors = []
+    if list(msg) != list(schema.example):
+        errors.append("字段 %s，文档为 %s" % (list(msg), list(schema.example)))
+    for k, v in msg.items():
+        if k in schema.example:
+            check_value(errors, k, schema.field(k), schema.example[k], v)
+    return errors
+
+
+def compare_legacy(schema, current, legacy, path=""):
+    """cJSON 版本的每个字段都应出现在 json_writer 版本中，相对顺序与取值一致"""
+    errors = []
+    missing = [k for k in legacy if k not in current]
+    if missing:
+        errors.append("%s缺少 cJSON 版本的字段 %s" % (path, missing))
+    check_order(errors, path or "顶层", [k for k in current if k in legacy], list(legacy))
+    for k in legacy:
+        if k not in current:
+            continue
+        a, b = current[k], legacy[k]
+        field = schema.field(k) if not path else None
+        if isinstance(a, dict) and isinstance(b, dict):
+            errors += compare_legacy(schema, a, b, "%s%s." % (path, k))
+            continue
+        if isinstance(a, list) and isinstance(b, list) and a != b:
+            i = next((i for i, (x, y) in enumerate(zip(a, b)) if x != y), min(len(a), len(b)))
+            errors.append("%s%s[%d]: %r，cJSON 版本为 %r（长度 %d / %d）" %
+                          (path, k, i, a[i] if i < len(a) else None, b[i] if i < len(b) else None,
+                           len(a), len(b)))
+            continue
+        if type_name(a) == "number" and type_name(b) == "number":
+            if k == "timestamp":
+                ok = abs(a - b) <= 1
+            elif field and field.decimals is not None:
+                ok = abs(a - b) <= 0.5 * 10 ** -field.decimals + 1e-9
+            else:
+                ok = a == b
+        else:
+            ok = a == b
+        if not ok:
+            errors.append("%s%s: %r，cJSON 版本为 %r" % (path, k, a, b))
+    return errors
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit("用法: check_payload_schema.py <json_bench> <MQTT.md>")
+    bench, doc_path = sys.argv[1:]
+    with open(doc_path, encoding="utf-8") as f:
+        doc = f.read()
+    schemas = {"status": parse_schema(doc, "2.1"), "alert": parse_schema(doc, "2.2")}
+
+    out = subprocess.run([bench, "--dump"], check=True, stdout=subprocess.PIPE).stdout.decode("utf-8")
+    messages = {}
+    failures = 0
+    cases = []
+    for line in out.splitlines():
+        parts = line.split("\t", 2)
+        if len(parts) != 3:
+            failures += 1
+            print("json_bench 输出中无法识别的行（负载含未转义的换行？）: %r" % line)
+            continue
+        kind, case, payload = parts
+        if not kind.startswith("legacy_"):
+            cases.append((kind, case))
+        try:
+            messages[(kind, case)] = load_json(payload)
+        except ValueError as e:
+            failures += 1
+            print("%s/%s: 不是有效的 JSON（%s）: %s" % (kind, case, e, payload))
+
+    if not cases:
+        raise SystemExit("json_bench --dump 没有输出")
+    for kind, case in cases:
+        if (kind, case) not in messages:
+            continue
+        schema = schemas[kind]
+        msg = messages[(kind, case)]
+        errors = check_status(schema, msg) if kind == "status" else check_alert(schema, msg)
+        legacy = messages.get(("legacy_" + kind, case))
+        if legacy is None:
+            errors.append("没有 cJSON 版本的对照消息")
+        else:
+            errors += compare_legacy(schema, msg, legacy)
+        name = "%s/%s" % (kind, case)
+        if errors:
+            failures += 1
+            for e in errors:
+                print("%s: %s" % (name, e))
+        else:
+            print("%s: 通过（%d 个字段）" % (name, len(msg)))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
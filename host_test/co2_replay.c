@@ -0,0 +1,261 @@
+/**
+ * @file co2_replay.c
+ * @brief CO2 轨迹回放 - 比较阈值控制与预测式预通风（co2_predictor.c）的峰值浓度与风扇运行时长
+ *
+ * 轨迹为设备记录的每分钟 CO2 与风扇档位（CSV：minute,co2_ppm,fan_level）。
+ * 先按质量平衡 C[t+1] = C[t] + G - k(档位)·(C[t] - CO2_BASELINE) 反推每分钟的 CO2 产生率 G
+ * （即人员作息），再以 1Hz 闭环仿真两种控制器：
+ *   threshold:  local_mode_decide()（固件关闭 CONFIG_CO2_PREDICTIVE_VENTILATION 时的行为）
+ *   predictive: 与 decision_engine.c 相同，预测有效且未超过高阈值时采用 co2_predictor_decide()
+ * 传感器读数 = 一阶滞后（默认 60 秒）的真实浓度 + 确定性噪声（±10 ppm），结果可复现。
+ * 实际换气衰减率 = 模型默认值（PREDICT_DECAY_*）× gain，依次以 0.7 / 1.0 / 1.3 运行，检验模型失配。
+ *
+ *   co2_replay <trace.csv> [--fans N] [--lag 秒] [--check]
+ *   co2_replay --synth > trace.csv        生成合成办公室轨迹（traces/office_2day.csv 即由此生成）
+ *
+ * --check：gain 1.0 下预测式的峰值与超阈值分钟数都不高于阈值控制时返回 0（ctest 用）。
+ */
+
+#include "co2_predictor.h"
+#include "local_mode.h"
+#include "vent_ident.h"
+#include "runtime_config.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_MIN      (7 * 24 * 60)   // 最长 7 天轨迹
+#define REPLAY_NOISE_PPM    10              // 读数噪声幅度
+#define REPLAY_DEFAULT_LAG  60.0f           // 传感器时间常数（秒）
+#define REPLAY_DEFAULT_FANS 3
+
+static const RuntimeConfig s_config = {
+    .co2_low = CO2_THRESHOLD_LOW,
+    .co2_high = CO2_THRESHOLD_HIGH,
+    .co2_min_valid = CO2_MIN_VALID,
+    .co2_max_valid = CO2_MAX_VALID,
+};
+static float s_gain = 1.0f;   // 仿真房间相对模型的换气倍率（预测器始终使用模型默认值）
+
+// 固件依赖的替身：预测器使用模型默认衰减率，阈值使用编译期默认值
+const RuntimeConfig *runtime_config_get(void) { return &s_config; }
+float vent_ident_get_infiltration(void) { return PREDICT_DECAY_INFILTRATION; }
+float vent_ident_get_fan_decay(FanId id, FanState level) {
+    return level == FAN_HIGH ? PREDICT_DECAY_FAN_HIGH : level == FAN_LOW ? PREDICT_DECAY_FAN_LOW : 0.0f;
+}
+
+/**
+ * @brief 模型衰减率（每分钟）
+ */
+static float model_decay(FanState level, int fans) {
+    return PREDICT_DECAY_INFILTRATION + fans * vent_ident_get_fan_decay(0, level);
+}
+
+/**
+ * @brief 确定性噪声（线性同余，-REPLAY_NOISE_PPM ~ +REPLAY_NOISE_PPM）
+ */
+static int noise(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (int)((*seed >> 16) % (2 * REPLAY_NOISE_PPM + 1)) - REPLAY_NOISE_PPM;
+}
+
+typedef struct {
+    float peak;          ///< 真实浓度峰值（ppm）
+    double on_min;       ///< 风扇运行分钟数（任一档位）
+    double high_min;     ///< HIGH 档分钟数
+    double over_min;     ///< 真实浓度超过低阈值的分钟数
+    double cost;         ///< 能耗成本（LOW = PREDICT_COST_LOW，HIGH = PREDICT_COST_HIGH，× 风扇数 × 分钟）
+} ReplayResult;
+
+/**
+ * @brief 以 1Hz 闭环仿真一种控制器
+ * @param gen 每分钟 CO2 产生率
+ * @param c0 初始浓度
+ */
+static ReplayResult simulate(const float *gen, int minutes, float c0, int fans, float lag_s, bool predictive) {
+    ReplayResult r = {0};
+    FanState levels[FAN_MAX_COUNT] = {FAN_OFF};
+    FanState level = FAN_OFF;
+    float c = c0;
+    float sensed = c0;
+    uint32_t seed = 1;
+
+    co2_predictor_reset();
+    for (int s = 0; s < minutes * 60; s++) {
+        float k = model_decay(level, fans) * s_gain;
+        c += (gen[s / 60] - k * (c - CO2_BASELINE)) / 60.0f;
+        sensed += (c - sensed) * (lag_s > 1.0f ? 1.0f / lag_s : 1.0f);
+        float meas = sensed + noise(&seed);
+
+        co2_predictor_add_sample(meas, levels, (uint8_t)fans);
+        level = local_mode_decide(meas);
+        FanState predicted;
+        if (predictive && co2_predictor_decide(meas, (uint8_t)fans, s_config.co2_low, &predicted) &&
+            level != FAN_HIGH) {
+            level = predicted;
+        }
+        for (int i = 0; i < fans; i++) {
+            levels[i] = level;
+        }
+
+        if (c > r.peak) r.peak = c;
+        if (c > s_config.co2_low) r.over_min += 1.0 / 60.0;
+        if (level != FAN_OFF) r.on_min += 1.0 / 60.0;
+        if (level == FAN_HIGH) r.high_min += 1.0 / 60.0;
+        if (level != FAN_OFF) {
+            r.cost += (level == FAN_HIGH ? PREDICT_COST_HIGH : PREDICT_COST_LOW) * fans / 60.0;
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief 读取轨迹并反推每分钟产生率（3 分钟滑动平均抑制噪声，负值截为 0）
+ * @return 分钟数，失败返回 -1
+ */
+static int load_trace(const char *path, int fans, float *gen, float *c0) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    static float co2[REPLAY_MAX_MIN + 1];
+    static int lvl[REPLAY_MAX_MIN + 1];
+    char line[128];
+    int n = 0;
+    while (fgets(line, sizeof(line), f) && n <= REPLAY_MAX_MIN) {
+        int minute, level;
+        float ppm;
+        if (line[0] == '#' || sscanf(line, "%d,%f,%d", &minute, &ppm, &level) != 3) {
+            continue;   // 注释与表头
+        }
+        if (minute != n || level < FAN_OFF || level > FAN_HIGH) {
+            fprintf(stderr, "%s: 第 %d 个数据行无效（分钟须连续，档位 0~2）\n", path, n + 1);
+            fclose(f);
+            return -1;
+        }
+        co2[n] = ppm;
+        lvl[n] = level;
+        n++;
+    }
+    fclose(f);
+    if (n < 2) {
+        fprintf(stderr, "%s: 数据不足\n", path);
+        return -1;
+    }
+
+    float raw[REPLAY_MAX_MIN];
+    for (int i = 0; i + 1 < n; i++) {
+        raw[i] = co2[i + 1] - co2[i] + model_decay((FanState)lvl[i], fans) * (co2[i] - CO2_BASELINE);
+    }
+    for (int i = 0; i + 1 < n; i++) {
+        float sum = 0.0f;
+        int cnt = 0;
+        for (int j = i - 1; j <= i + 1; j++) {
+            if (j >= 0 && j + 1 < n) {
+                sum += raw[j];
+                cnt++;
+            }
+        }
+        gen[i] = fmaxf(0.0f, sum / cnt);
+    }
+    *c0 = co2[0];
+    return n - 1;
+}
+
+/**
+ * @brief 合成办公室产生率：工作日 09-12、13-18 有人，14-15 会议人数加倍，夜间与周末无人
+ */
+static float synth_generation(int minute) {
+    int day = minute / 1440;
+    int h = (minute % 1440) / 60;
+    if (day % 7 >= 5) {
+        return 0.0f;
+    }
+    if (h == 14) return 30.0f;
+    if ((h >= 9 && h < 12) || (h >= 13 && h < 18)) return 15.0f;
+    if (h == 12) return 3.0f;
+    return 0.0f;
+}
+
+/**
+ * @brief 以阈值控制、记录间隔 1 分钟生成两天合成轨迹
+ */
+static void synth_trace(int fans) {
+    uint32_t seed = 7;
+    float c = 450.0f;
+    FanState level = FAN_OFF;
+    printf("# 合成轨迹：两天办公室作息（co2_replay --synth 生成，非实测数据）\n");
+    printf("# 工作日 09-12、13-18 产生率 15 ppm/分钟，14-15 会议 30 ppm/分钟；%d 个风扇，阈值控制\n", fans);
+    printf("minute,co2_ppm,fan_level\n");
+    for (int m = 0; m <= 2 * 1440; m++) {
+        int ppm = (int)lroundf(c) + noise(&seed);
+        printf("%d,%d,%d\n", m, ppm, level);
+        for (int s = 0; s < 60; s++) {
+            c += (synth_generation(m) - model_decay(level, fans) * (c - CO2_BASELINE)) / 60.0f;
+        }
+        level = local_mode_decide((float)ppm);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int fans = REPLAY_DEFAULT_FANS;
+    float lag = REPLAY_DEFAULT_LAG;
+    bool check = false;
+    bool synth = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fans") == 0 && i + 1 < argc) {
+            fans = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lag") == 0 && i + 1 < argc) {
+            lag = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[i], "--synth") == 0) {
+            synth = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (fans < 1 || fans > FAN_MAX_COUNT || (!synth && !path)) {
+        fprintf(stderr, "用法: co2_replay <trace.csv> [--fans N] [--lag 秒] [--check] | --synth\n");
+        return 2;
+    }
+    if (synth) {
+        synth_trace(fans);
+        return 0;
+    }
+
+    static float gen[REPLAY_MAX_MIN];
+    float c0;
+    int minutes = load_trace(path, fans, gen, &c0);
+    if (minutes < 0) {
+        return 2;
+    }
+
+    printf("轨迹 %s：%d 分钟，%d 个风扇，传感器滞后 %.0f 秒，阈值 %.0f / %.0f ppm\n",
+           path, minutes, fans, lag, s_config.co2_low, s_config.co2_high);
+    printf("%-5s %-11s %7s %9s %9s %9s %8s\n", "gain", "控制器", "峰值ppm", "运行分钟", "HIGH分钟", "超阈值分钟", "成本");
+
+    int rc = 0;
+    static const float gains[] = {0.7f, 1.0f, 1.3f};
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        s_gain = gains[g];
+        ReplayResult th = simulate(gen, minutes, c0, fans, lag, false);
+        ReplayResult pr = simulate(gen, minutes, c0, fans, lag, true);
+        printf("%-5.1f %-11s %7.0f %9.0f %9.0f %9.0f %8.0f\n", s_gain, "threshold",
+               th.peak, th.on_min, th.high_min, th.over_min, th.cost);
+        printf("%-5.1f %-11s %7.0f %9.0f %9.0f %9.0f %8.0f\n", s_gain, "predictive",
+               pr.peak, pr.on_min, pr.high_min, pr.over_min, pr.cost);
+        printf("%-5.1f %-11s %+7.0f %+9.0f %+9.0f %+9.0f %+8.0f\n", s_gain, "差值",
+               pr.peak - th.peak, pr.on_min - th.on_min, pr.high_min - th.high_min,
+               pr.over_min - th.over_min, pr.cost - th.cost);
+        if (check && gains[g] == 1.0f && (pr.peak > th.peak || pr.over_min > th.over_min)) {
+            fprintf(stderr, "预测式控制的峰值或超阈值时长高于阈值控制\n");
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,545 @@
+/**
+ * @file conn_sim.c
+ * @brief 重连离散事件仿真 - 整批设备在 AP 重启 / Broker 宕机后的重连，对比 conn_supervisor.c 与改用前的固定定时器
+ *
+ * 新行为：真实的 conn_supervisor.c（原样编译）。模块状态是文件内静态变量，所以每台设备在 fork 出的
+ * 子进程中从开机运行到仿真结束，事件经管道交给父进程汇总。定时器、esp_random、WiFi 与 MQTT 客户端由本文件模拟：
+ *   - WiFi 关联 500 ~ 800 ms，AP 不在时 2.5 秒后失败；DHCP 300 ms
+ *   - 连接 Broker：TLS 握手 1.1 秒后完成，再 150 ms 收到 CONNACK；Broker 不可用时 1 秒后失败，没有 IP 时 0.2 秒
+ * 旧行为（同一网络模型，父进程内仿真）：WiFi 每次断开后固定 10 秒重连；esp-mqtt 每次失败后 10 秒自动重连，
+ * 另有 30 秒的重连定时器，先到者触发。唯一的随机性是事件处理的 0 ~ 50 ms 偏差。
+ * 每台设备开机后先连接稳定（超过 CONN_STABLE_SEC），SIM_FAULT_AT_MS 时故障开始。
+ *
+ *   conn_sim [--devices N] [--check]
+ *
+ * 输出每种场景下的 Broker 连接尝试次数、WiFi 关联次数、每秒 TLS 握手峰值与全部 / 中位恢复时间（自故障开始）。
+ * --check：两种场景下新行为全部设备恢复、恢复时间不超过故障时长 + 一个退避上限，
+ * 且 Broker 连接尝试不超过旧行为的一半、握手峰值不超过旧行为的 1/4 时返回 0（ctest 用）。
+ */
+
+#include "conn_supervisor.h"
+#include "mqtt_wrapper.h"
+#include "host_clock.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SIM_DEVICES       200
+#define SIM_FAULT_AT_MS   120000      // 故障开始时刻（开机后）
+#define SIM_MAX_EVENTS    1024        // 每台设备故障后最多记录的事件数
+#define SIM_NEVER         INT64_MAX
+
+#define WIFI_ASSOC_MS     500         // 关联耗时（另加 0 ~ 300 ms）
+#define WIFI_FAIL_MS      2500        // AP 不在时关联失败耗时
+#define DHCP_MS           300
+#define TLS_MS            1100        // DNS + TCP + TLS 握手
+#define CONNACK_MS        1250        // 发起连接到收到 CONNACK
+#define BROKER_FAIL_MS    1000        // Broker 不可用时连接失败耗时
+#define NO_IP_FAIL_MS     200         // 没有 IP 时连接失败耗时
+#define OLD_WIFI_RETRY_MS 10000       // 旧行为：WiFi 固定重连间隔
+#define OLD_AUTO_RETRY_MS 10000       // 旧行为：esp-mqtt 自动重连间隔
+#define OLD_TIMER_MS      30000       // 旧行为：MQTT 重连定时器
+
+/**
+ * @brief 故障场景（时长自故障开始计）
+ */
+typedef struct {
+    const char *name;
+    int64_t ap_down_ms;       ///< AP 断开时长（0 = 不断开）
+    int64_t broker_down_ms;   ///< Broker 不可用时长（0 = 一直可用）
+    int64_t end_ms;           ///< 仿真时长
+    int64_t recover_cap_ms;   ///< --check：故障结束后全部恢复的期限（一个退避上限加少量余量）
+} Scenario;
+
+static const Scenario k_scenarios[] = {
+    {"AP 重启（断 60 秒）", 60000, 0, 400000,
+     CONN_LINK_BACKOFF_MAX_MS + CONN_LINK_UP_SPREAD_MS + 5000},
+    {"Broker 宕机 10 分钟", 0, 600000, 1200000,
+     CONN_BROKER_BACKOFF_MAX_MS + 5000},
+};
+
+/**
+ * @brief 一台设备故障后的事件（时刻自故障开始计）
+ */
+typedef struct {
+    char kind;                ///< 'W' WiFi 关联，'M' 连接 Broker，'T' TLS 握手完成，'U' MQTT 已连接
+    int64_t t_ms;
+} SimEvent;
+
+typedef struct {
+    int count;
+    SimEvent ev[SIM_MAX_EVENTS];
+} Recorder;
+
+static const Scenario *s_sc;
+static Recorder *s_rec;
+static uint32_t s_rng;
+
+static uint32_t sim_rand(void) {
+    // xorshift32：每台设备一个种子，结果可复现
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void seed_device(int dev, uint32_t salt) {
+    s_rng = (0x9e3779b9u * (uint32_t)(dev + 1)) ^ salt;
+    if (s_rng == 0) {
+        s_rng = 1;
+    }
+}
+
+static bool ap_up(int64_t t) {
+    int64_t rel = t - SIM_FAULT_AT_MS;
+    return !(rel >= 0 && rel < s_sc->ap_down_ms);
+}
+
+static bool broker_ok(int64_t t) {
+    int64_t rel = t - SIM_FAULT_AT_MS;
+    return !(rel >= 0 && rel < s_sc->broker_down_ms);
+}
+
+static void record(char kind, int64_t t) {
+    if (t >= SIM_FAULT_AT_MS && s_rec->count < SIM_MAX_EVENTS) {
+        s_rec->ev[s_rec->count++] = (SimEvent){kind, t - SIM_FAULT_AT_MS};
+    }
+}
+
+/* ---------------- 新行为：conn_supervisor.c 的依赖 ---------------- */
+
+static TimerCallbackFunction_t s_timer_cb;
+static int64_t s_timer_at;
+static int64_t s_wifi_at;
+static bool s_wifi_ok;
+static int64_t s_dhcp_at;
+static int64_t s_tls_at;
+static int64_t s_connack_at;
+static int64_t s_fail_at;
+static bool s_ip;
+static bool s_mqtt_busy;
+static bool s_mqtt_up;
+
+static int64_t now_ms(void) {
+    return host_clock_now_us() / 1000;
+}
+
+uint32_t esp_random(void) {
+    return sim_rand();
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback) {
+    s_timer_cb = callback;
+    return &s_timer_cb;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait) {
+    s_timer_at = now_ms() + pdTICKS_TO_MS(period);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait) {
+    s_timer_at = SIM_NEVER;
+    return pdPASS;
+}
+
+esp_err_t esp_wifi_connect(void) {
+    int64_t now = now_ms();
+    record('W', now);
+    s_wifi_ok = ap_up(now + WIFI_ASSOC_MS);
+    s_wifi_at = now + (s_wifi_ok ? WIFI_ASSOC_MS + (int64_t)(sim_rand() % 300) : WIFI_FAIL_MS);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+    s_ip = false;
+    s_dhcp_at = SIM_NEVER;
+    s_wifi_ok = false;
+    s_wifi_at = now_ms() + 50;
+    return ESP_OK;
+}
+
+esp_err_t mqtt_client_reconnect(void) {
+    if (s_mqtt_busy || s_mqtt_up) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t now = now_ms();
+    s_mqtt_busy = true;
+    record('M', now);
+    conn_supervisor_on_broker_attempt();
+    if (s_ip && ap_up(now) && broker_ok(now + BROKER_FAIL_MS)) {
+        s_tls_at = now + TLS_MS;
+        s_connack_at = now + CONNACK_MS;
+    } else {
+        s_fail_at = now + (s_ip && ap_up(now) ? BROKER_FAIL_MS : NO_IP_FAIL_MS);
+    }
+    return ESP_OK;
+}
+
+static void advance_to(int64_t t) {
+    host_clock_advance_ms((uint32_t)(t - now_ms()));
+}
+
+/**
+ * @brief 故障开始：AP 断开时 WiFi 立即报告断开，MQTT 0.5 秒后发现 TCP 错误；Broker 宕机时 0.1 秒后断开
+ */
+static void inject_fault(void) {
+    int64_t now = now_ms();
+    if (s_sc->ap_down_ms > 0) {
+        s_ip = false;
+        s_wifi_at = SIM_NEVER;
+        s_dhcp_at = SIM_NEVER;
+        conn_supervisor_on_link_down(200);   // WIFI_REASON_BEACON_TIMEOUT
+    }
+    if (s_mqtt_up) {
+        s_mqtt_up = false;
+        s_mqtt_busy = true;
+        s_fail_at = now + (s_sc->ap_down_ms > 0 ? 500 : 100);
+    }
+}
+
+/**
+ * @brief 一台设备从开机运行到仿真结束（在子进程中调用）
+ */
+static void run_device_new(int dev) {
+    host_clock_reset();
+    seed_device(dev, 0);
+    s_timer_at = s_wifi_at = s_dhcp_at = s_tls_at = s_connack_at = s_fail_at = SIM_NEVER;
+    s_ip = s_mqtt_busy = s_mqtt_up = false;
+
+    conn_supervisor_init();
+    esp_wifi_connect();   // wifi_manager 启动时关联
+
+    bool faulted = false;
+    int64_t end = SIM_FAULT_AT_MS + s_sc->end_ms;
+    for (;;) {
+        int64_t *due[] = {&s_timer_at, &s_wifi_at, &s_dhcp_at, &s_tls_at, &s_connack_at, &s_fail_at};
+        size_t which = 0;
+        for (size_t i = 1; i < sizeof(due) / sizeof(due[0]); i++) {
+            if (*due[i] < *due[which]) {
+                which = i;
+            }
+        }
+        int64_t next = *due[which];
+        if (!faulted && next >= SIM_FAULT_AT_MS) {
+            advance_to(SIM_FAULT_AT_MS);
+            inject_fault();
+            faulted = true;
+            continue;
+        }
+        if (next >= end) {
+            break;
+        }
+        advance_to(next);
+        *due[which] = SIM_NEVER;
+        switch (which) {
+            case 0:
+                s_timer_cb(&s_timer_cb);
+                break;
+            case 1:
+                if (s_wifi_ok) {
+                    conn_supervisor_on_link_up();
+                    s_dhcp_at = next + DHCP_MS;
+                } else {
+                    conn_supervisor_on_link_down(201);   // WIFI_REASON_NO_AP_FOUND
+                }
+                break;
+            case 2:
+                s_ip = true;
+                conn_supervisor_on_ip_up();
+                break;
+            case 3:
+                record('T', next);
+                conn_supervisor_on_tls_up();
+                break;
+            case 4:
+                s_mqtt_busy = false;
+                s_mqtt_up = true;
+                record('U', next);
+                conn_supervisor_on_broker_up();
+                break;
+            default:
+                s_mqtt_busy = false;
+                conn_supervisor_on_broker_down();
+                break;
+        }
+    }
+}
+
+/**
+ * @brief 在子进程中仿真一台设备，读回其事件
+ * @return 0 成功，-1 子进程失败
+ */
+static int fork_device_new(int dev, Recorder *rec) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        s_rec = rec;
+        rec->count = 0;
+        run_device_new(dev);
+        size_t len = offsetof(Recorder, ev) + (size_t)rec->count * sizeof(SimEvent);
+        const char *p = (const char *)rec;
+        while (len > 0) {
+            ssize_t n = write(fds[1], p, len);
+            if (n <= 0) {
+                _exit(1);
+            }
+            p += n;
+            len -= (size_t)n;
+        }
+        _exit(0);
+    }
+
+    close(fds[1]);
+    size_t got = 0;
+    char *p = (char *)rec;
+    ssize_t n;
+    while (got < sizeof(*rec) && (n = read(fds[0], p + got, sizeof(*rec) - got)) > 0) {
+        got += (size_t)n;
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || got < offsetof(Recorder, ev) ||
+        got != offsetof(Recorder, ev) + (size_t)rec->count * sizeof(SimEvent)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ---------------- 旧行为：固定定时器 ---------------- */
+
+static int64_t jitter(void) {
+    return sim_rand() % 50;
+}
+
+/**
+ * @brief 一台设备从故障开始运行到仿真结束（故障前已连接）
+ */
+static void run_device_old(int dev) {
+    seed_device(dev, 0x5bd1e995u);
+    int64_t wifi_at = SIM_NEVER, ip_at = SIM_NEVER, tls_at = SIM_NEVER, connack_at = SIM_NEVER;
+    int64_t fail_at, auto_at = SIM_NEVER, timer_at = SIM_NEVER;
+    bool ip = true;
+    int64_t now = SIM_FAULT_AT_MS;
+    if (s_sc->ap_down_ms > 0) {
+        ip = false;
+        wifi_at = now + OLD_WIFI_RETRY_MS + jitter();
+        fail_at = now + 500;
+    } else {
+        fail_at = now + 100;
+    }
+
+    int64_t end = SIM_FAULT_AT_MS + s_sc->end_ms;
+    for (;;) {
+        int64_t *due[] = {&wifi_at, &ip_at, &tls_at, &connack_at, &fail_at, &auto_at, &timer_at};
+        size_t which = 0;
+        for (size_t i = 1; i < sizeof(due) / sizeof(due[0]); i++) {
+            if (*due[i] < *due[which]) {
+                which = i;
+            }
+        }
+        now = *due[which];
+        if (now >= end) {
+            break;
+        }
+        *due[which] = SIM_NEVER;
+        switch (which) {
+            case 0:
+                record('W', now);
+                if (ap_up(now + WIFI_ASSOC_MS)) {
+                    ip_at = now + WIFI_ASSOC_MS + (int64_t)(sim_rand() % 300) + DHCP_MS;
+                } else {
+                    wifi_at = now + WIFI_FAIL_MS + OLD_WIFI_RETRY_MS + jitter();
+                }
+                break;
+            case 1:
+                ip = true;   // esp-mqtt 不感知链路恢复，按自己的定时器重连
+                break;
+            case 2:
+                record('T', now);
+                break;
+            case 3:
+                record('U', now);
+                break;
+            case 4:
+                auto_at = now + OLD_AUTO_RETRY_MS + jitter();
+                timer_at = now + OLD_TIMER_MS + jitter();
+                break;
+            default:
+                // 自动重连或重连定时器先到者发起连接，另一个随之取消
+                auto_at = timer_at = SIM_NEVER;
+                record('M', now);
+                if (ip && ap_up(now) && broker_ok(now + BROKER_FAIL_MS)) {
+                    tls_at = now + TLS_MS;
+                    connack_at = now + CONNACK_MS;
+                } else {
+                    fail_at = now + (ip && ap_up(now) ? BROKER_FAIL_MS : NO_IP_FAIL_MS);
+                }
+                break;
+        }
+    }
+}
+
+/* ---------------- 汇总 ---------------- */
+
+typedef struct {
+    int broker_attempts;
+    int wifi_attempts;
+    int handshake_peak;       ///< 每秒 TLS 握手数峰值
+    int not_up;               ///< 仿真结束时仍未恢复的设备数
+    int64_t all_up_ms;        ///< 最后一台设备恢复的时刻
+    int64_t median_up_ms;     ///< 恢复时刻的中位数
+} FleetResult;
+
+static int cmp_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 仿真整批设备
+ * @return 0 成功，-1 子进程失败
+ */
+static int run_fleet(int devices, bool new_behavior, FleetResult *out) {
+    size_t buckets = (size_t)(s_sc->end_ms / 1000) + 1;
+    int *handshakes = calloc(buckets, sizeof(int));
+    int64_t *up_ms = calloc((size_t)devices, sizeof(int64_t));
+    Recorder *rec = malloc(sizeof(Recorder));
+    if (!handshakes || !up_ms || !rec) {
+        free(handshakes);
+        free(up_ms);
+        free(rec);
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    int rc = 0;
+    int up_count = 0;
+    for (int dev = 0; dev < devices && rc == 0; dev++) {
+        if (new_behavior) {
+            rc = fork_device_new(dev, rec);
+        } else {
+            s_rec = rec;
+            rec->count = 0;
+            run_device_old(dev);
+        }
+        int64_t first_up = -1;
+        for (int i = 0; i < rec->count && rc == 0; i++) {
+            const SimEvent *e = &rec->ev[i];
+            switch (e->kind) {
+                case 'W': out->wifi_attempts++; break;
+                case 'M': out->broker_attempts++; break;
+                case 'T': handshakes[e->t_ms / 1000]++; break;
+                case 'U':
+                    if (first_up < 0) {
+                        first_up = e->t_ms;
+                    }
+                    break;
+                default: break;
+            }
+        }
+        if (first_up < 0) {
+            out->not_up++;
+        } else {
+            up_ms[up_count++] = first_up;
+        }
+    }
+    for (size_t i = 0; i < buckets; i++) {
+        if (handshakes[i] > out->handshake_peak) {
+            out->handshake_peak = handshakes[i];
+        }
+    }
+    if (up_count > 0) {
+        qsort(up_ms, (size_t)up_count, sizeof(int64_t), cmp_i64);
+        out->all_up_ms = up_ms[up_count - 1];
+        out->median_up_ms = up_ms[up_count / 2];
+    }
+    free(handshakes);
+    free(up_ms);
+    free(rec);
+    return rc;
+}
+
+static void print_result(const char *label, const FleetResult *r) {
+    printf("  %-4s %10d %10d %12d %10.1f %10.1f", label, r->broker_attempts, r->wifi_attempts,
+           r->handshake_peak, r->all_up_ms / 1000.0, r->median_up_ms / 1000.0);
+    if (r->not_up > 0) {
+        printf("  （%d 台未恢复）", r->not_up);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    int devices = SIM_DEVICES;
+    bool check = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--devices") == 0 && i + 1 < argc) {
+            devices = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            devices = 0;
+        }
+    }
+    if (devices < 1) {
+        fprintf(stderr, "用法: conn_sim [--devices N] [--check]\n");
+        return 2;
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    printf("%d 台设备，故障前均已连接稳定，时间自故障开始计（秒）\n", devices);
+    printf("  %-4s %10s %10s %12s %10s %10s\n", "行为", "Broker尝试", "WiFi关联", "握手峰值/秒", "全部恢复", "中位恢复");
+    int rc = 0;
+    for (size_t s = 0; s < sizeof(k_scenarios) / sizeof(k_scenarios[0]); s++) {
+        s_sc = &k_scenarios[s];
+        FleetResult old_r, new_r;
+        if (run_fleet(devices, false, &old_r) != 0 || run_fleet(devices, true, &new_r) != 0) {
+            fprintf(stderr, "%s: 设备仿真子进程失败\n", s_sc->name);
+            return 2;
+        }
+        printf("%s\n", s_sc->name);
+        print_result("旧", &old_r);
+        print_result("新", &new_r);
+        if (!check) {
+            continue;
+        }
+
+        int64_t outage = s_sc->ap_down_ms > s_sc->broker_down_ms ? s_sc->ap_down_ms : s_sc->broker_down_ms;
+        if (new_r.not_up > 0 || new_r.all_up_ms > outage + s_sc->recover_cap_ms) {
+            fprintf(stderr, "%s: 新行为未在故障结束后 %lld ms 内全部恢复\n", s_sc->name,
+                    (long long)s_sc->recover_cap_ms);
+            rc = 1;
+        }
+        if (new_r.broker_attempts * 2 > old_r.broker_attempts) {
+            fprintf(stderr, "%s: Broker 连接尝试 %d 次，未少于旧行为（%d 次）的一半\n", s_sc->name,
+                    new_r.broker_attempts, old_r.broker_attempts);
+            rc = 1;
+        }
+        if (new_r.handshake_peak * 4 > old_r.handshake_peak) {
+            fprintf(stderr, "%s: 握手峰值 %d 次/秒，未低于旧行为（%d 次/秒）的 1/4\n", s_sc->name,
+                    new_r.handshake_peak, old_r.handshake_peak);
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,717 @@
+/**
+ * @file cjson_lite.c
+ * @brief 无 cJSON 源码时的替身：固件用到的 cJSON 1.7 接口子集
+ *
+ * 与 cJSON 1.7 保持一致的行为（测试结果在两者之间可比）：
+ * - 分配：每个节点一次 malloc，键名与字符串值各 strdup 一次；打印缓冲区初始 256 字节，
+ *   不足时按所需长度的 2 倍 realloc，结束时 realloc 到实际长度
+ * - 数字：整数值按 %d，其余按 %1.15g（回读不相等时 %1.17g），NaN / Inf 输出 null
+ * - 解析：ParseWithLength 忽略值之后的内容，字符串中的原始控制字符照收，
+ *   嵌套深度上限 CJSON_NESTING_LIMIT；GetObjectItem 按键名不区分大小写匹配第一个
+ * 不包含格式化打印、引用、Hooks 等固件未使用的接口。
+ * 配置时以 -DCJSON_DIR=<cJSON 源码目录>（或设置 IDF_PATH）链接真实 cJSON 代替本文件。
+ */
+
+#include "cJSON.h"
+#include <ctype.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CJSON_NESTING_LIMIT 1000
+#define PRINT_BUFFER_SIZE   256
+
+// ---- 节点 ----
+
+static cJSON *new_item(void) {
+    cJSON *item = malloc(sizeof(cJSON));
+    if (item) {
+        memset(item, 0, sizeof(cJSON));
+    }
+    return item;
+}
+
+static char *dup_string(const char *s) {
+    size_t len = strlen(s) + 1;
+    char *copy = malloc(len);
+    if (copy) {
+        memcpy(copy, s, len);
+    }
+    return copy;
+}
+
+static int saturate_int(double number) {
+    if (number >= INT_MAX) {
+        return INT_MAX;
+    }
+    if (number <= (double)INT_MIN) {
+        return INT_MIN;
+    }
+    return (int)number;
+}
+
+void cJSON_Delete(cJSON *item) {
+    while (item) {
+        cJSON *next = item->next;
+        if (!(item->type & cJSON_IsReference) && item->child) {
+            cJSON_Delete(item->child);
+        }
+        if (!(item->type & cJSON_IsReference) && item->valuestring) {
+            free(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst) && item->string) {
+            free(item->string);
+        }
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void *object) {
+    free(object);
+}
+
+cJSON *cJSON_CreateNull(void) {
+    cJSON *item = new_item();
+    if (item) {
+        item->type = cJSON_NULL;
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateNumber(double num) {
+    cJSON *item = new_item();
+    if (item) {
+        item->type = cJSON_Number;
+        item->valuedouble = num;
+        item->valueint = saturate_int(num);
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateString(const char *string) {
+    cJSON *item = new_item();
+    if (item) {
+        item->type = cJSON_String;
+        item->valuestring = dup_string(string);
+        if (!item->valuestring) {
+            cJSON_Delete(item);
+            return NULL;
+        }
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateArray(void) {
+    cJSON *item = new_item();
+    if (item) {
+        item->type = cJSON_Array;
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateObject(void) {
+    cJSON *item = new_item();
+    if (item) {
+        item->type = cJSON_Object;
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateIntArray(const int *numbers, int count) {
+    if (count < 0 || !numbers) {
+        return NULL;
+    }
+    cJSON *array = cJSON_CreateArray();
+    cJSON *prev = NULL;
+    for (int i = 0; array && i < count; i++) {
+        cJSON *n = cJSON_CreateNumber(numbers[i]);
+        if (!n) {
+            cJSON_Delete(array);
+            return NULL;
+        }
+        if (!prev) {
+            array->child = n;
+        } else {
+            prev->next = n;
+            n->prev = prev;
+        }
+        prev = n;
+    }
+    if (array && array->child) {
+        array->child->prev = prev;
+    }
+    return array;
+}
+
+// 子节点链表：child->prev 指向最后一个，追加为 O(1)
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item) {
+    if (!array || !item || array == item) {
+        return 0;
+    }
+    cJSON *child = array->child;
+    if (!child) {
+        array->child = item;
+        item->prev = item;
+        item->next = NULL;
+    } else {
+        child->prev->next = item;
+        item->prev = child->prev;
+        child->prev = item;
+    }
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *key, cJSON *item) {
+    if (!object || !key || !item || object == item) {
+        return 0;
+    }
+    char *new_key = dup_string(key);
+    if (!new_key) {
+        return 0;
+    }
+    if (!(item->type & cJSON_StringIsConst) && item->string) {
+        free(item->string);
+    }
+    item->string = new_key;
+    item->type &= ~cJSON_StringIsConst;
+    return cJSON_AddItemToArray(object, item);
+}
+
+static cJSON *add_to_object(cJSON *object, const char *key, cJSON *item) {
+    if (cJSON_AddItemToObject(object, key, item)) {
+        return item;
+    }
+    cJSON_Delete(item);
+    return NULL;
+}
+
+cJSON *cJSON_AddObjectToObject(cJSON *object, const char *key) {
+    return add_to_object(object, key, cJSON_CreateObject());
+}
+
+cJSON *cJSON_AddArrayToObject(cJSON *object, const char *key) {
+    return add_to_object(object, key, cJSON_CreateArray());
+}
+
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *key, double number) {
+    return add_to_object(object, key, cJSON_CreateNumber(number));
+}
+
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *key, const char *string) {
+    return add_to_object(object, key, cJSON_CreateString(string));
+}
+
+// ---- 查询 ----
+
+cJSON_bool cJSON_IsArray(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_Array; }
+cJSON_bool cJSON_IsObject(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_Object; }
+cJSON_bool cJSON_IsString(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_String; }
+cJSON_bool cJSON_IsNumber(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_Number; }
+cJSON_bool cJSON_IsNull(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_NULL; }
+cJSON_bool cJSON_IsTrue(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_True; }
+cJSON_bool cJSON_IsBool(const cJSON *item) { return item && (item->type & (cJSON_True | cJSON_False)) != 0; }
+
+int cJSON_GetArraySize(const cJSON *array) {
+    int size = 0;
+    for (const cJSON *c = array ? array->child : NULL; c; c = c->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index) {
+    if (!array || index < 0) {
+        return NULL;
+    }
+    cJSON *c = array->child;
+    while (c && index-- > 0) {
+        c = c->next;
+    }
+    return c;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *key) {
+    if (!object || !key) {
+        return NULL;
+    }
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcasecmp(c->string, key) == 0) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+// ---- 解析 ----
+
+typedef struct {
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth;
+} ParseBuffer;
+
+#define CAN_READ(b, n)     ((b)->offset + (n) <= (b)->length)
+#define CAN_ACCESS(b, i)   ((b)->offset + (i) < (b)->length)
+#define AT(b)              ((b)->content + (b)->offset)
+
+static bool parse_value(cJSON *item, ParseBuffer *b);
+
+static void skip_whitespace(ParseBuffer *b) {
+    while (CAN_ACCESS(b, 0) && AT(b)[0] <= 32) {
+        b->offset++;
+    }
+}
+
+static bool parse_number(cJSON *item, ParseBuffer *b) {
+    char number[64];
+    size_t len = 0;
+    while (CAN_ACCESS(b, len) && len < sizeof(number) - 1) {
+        unsigned char c = AT(b)[len];
+        if (!isdigit(c) && c != '+' && c != '-' && c != 'e' && c != 'E' && c != '.') {
+            break;
+        }
+        number[len++] = (char)c;
+    }
+    number[len] = '\0';
+    char *end = NULL;
+    double value = strtod(number, &end);
+    if (end == number) {
+        return false;
+    }
+    item->type = cJSON_Number;
+    item->valuedouble = value;
+    item->valueint = saturate_int(value);
+    b->offset += (size_t)(end - number);
+    return true;
+}
+
+static int parse_hex4(const unsigned char *in) {
+    int h = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = in[i];
+        int v = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (v < 0) {
+            return -1;
+        }
+        h = (h << 4) | v;
+    }
+    return h;
+}
+
+/**
+ * @brief \uXXXX（含代理对）转 UTF-8
+ * @return 消耗的输入字节数（6 或 12），0 为无效
+ */
+static int utf16_to_utf8(const unsigned char *in, const unsigned char *end, unsigned char **out) {
+    if (end - in < 6) {
+        return 0;
+    }
+    int first = parse_hex4(in + 2);
+    if (first < 0 || (first >= 0xDC00 && first <= 0xDFFF)) {
+        return 0;
+    }
+    unsigned long cp = (unsigned long)first;
+    int used = 6;
+    if (first >= 0xD800 && first <= 0xDBFF) {
+        if (end - in < 12 || in[6] != '\\' || in[7] != 'u') {
+            return 0;
+        }
+        int second = parse_hex4(in + 8);
+        if (second < 0xDC00 || second > 0xDFFF) {
+            return 0;
+        }
+        cp = 0x10000 + (((unsigned long)first & 0x3FF) << 10) + ((unsigned long)second & 0x3FF);
+        used = 12;
+    }
+    unsigned char *o = *out;
+    if (cp < 0x80) {
+        *o++ = (unsigned char)cp;
+    } else if (cp < 0x800) {
+        *o++ = (unsigned char)(0xC0 | (cp >> 6));
+        *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *o++ = (unsigned char)(0xE0 | (cp >> 12));
+        *o++ = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+    } else {
+        *o++ = (unsigned char)(0xF0 | (cp >> 18));
+        *o++ = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+        *o++ = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+    }
+    *out = o;
+    return used;
+}
+
+static char *parse_string_raw(ParseBuffer *b) {
+    if (!CAN_ACCESS(b, 0) || AT(b)[0] != '"') {
+        return NULL;
+    }
+    const unsigned char *start = AT(b) + 1;
+    const unsigned char *end = start;
+    const unsigned char *limit = b->content + b->length;
+    size_t skipped = 0;
+    while (end < limit && *end != '"') {
+        if (*end == '\\') {
+            if (end + 1 >= limit) {
+                return NULL;
+            }
+            skipped++;
+            end++;
+        }
+        end++;
+    }
+    if (end >= limit) {
+        return NULL;
+    }
+
+    unsigned char *out = malloc((size_t)(end - start) - skipped + 1);
+    if (!out) {
+        return NULL;
+    }
+    unsigned char *o = out;
+    for (const unsigned char *in = start; in < end;) {
+        if (*in != '\\') {
+            *o++ = *in++;
+            continue;
+        }
+        int used = 2;
+        switch (in[1]) {
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'n': *o++ = '\n'; break;
+        case 'r': *o++ = '\r'; break;
+        case 't': *o++ = '\t'; break;
+        case '"':
+        case '\\':
+        case '/': *o++ = in[1]; break;
+        case 'u':
+            used = utf16_to_utf8(in, end, &o);
+            if (used == 0) {
+                free(out);
+                return NULL;
+            }
+            break;
+        default:
+            free(out);
+            return NULL;
+        }
+        in += used;
+    }
+    *o = '\0';
+    b->offset = (size_t)(end - b->content) + 1;
+    return (char *)out;
+}
+
+static bool parse_array(cJSON *item, ParseBuffer *b) {
+    if (b->depth >= CJSON_NESTING_LIMIT) {
+        return false;
+    }
+    b->depth++;
+    item->type = cJSON_Array;
+    b->offset++;
+    skip_whitespace(b);
+    if (CAN_ACCESS(b, 0) && AT(b)[0] == ']') {
+        b->offset++;
+        b->depth--;
+        return true;
+    }
+    for (;;) {
+        cJSON *child = new_item();
+        if (!child) {
+            return false;
+        }
+        cJSON_AddItemToArray(item, child);
+        skip_whitespace(b);
+        if (!parse_value(child, b)) {
+            return false;
+        }
+        skip_whitespace(b);
+        if (CAN_ACCESS(b, 0) && AT(b)[0] == ',') {
+            b->offset++;
+            continue;
+        }
+        if (CAN_ACCESS(b, 0) && AT(b)[0] == ']') {
+            b->offset++;
+            b->depth--;
+            return true;
+        }
+        return false;
+    }
+}
+
+static bool parse_object(cJSON *item, ParseBuffer *b) {
+    if (b->depth >= CJSON_NESTING_LIMIT) {
+        return false;
+    }
+    b->depth++;
+    item->type = cJSON_Object;
+    b->offset++;
+    skip_whitespace(b);
+    if (CAN_ACCESS(b, 0) && AT(b)[0] == '}') {
+        b->offset++;
+        b->depth--;
+        return true;
+    }
+    for (;;) {
+        cJSON *child = new_item();
+        if (!child) {
+            return false;
+        }
+        cJSON_AddItemToArray(item, child);
+        skip_whitespace(b);
+        child->string = parse_string_raw(b);
+        if (!child->string) {
+            return false;
+        }
+        skip_whitespace(b);
+        if (!CAN_ACCESS(b, 0) || AT(b)[0] != ':') {
+            return false;
+        }
+        b->offset++;
+        skip_whitespace(b);
+        if (!parse_value(child, b)) {
+            return false;
+        }
+        skip_whitespace(b);
+        if (CAN_ACCESS(b, 0) && AT(b)[0] == ',') {
+            b->offset++;
+            continue;
+        }
+        if (CAN_ACCESS(b, 0) && AT(b)[0] == '}') {
+            b->offset++;
+            b->depth--;
+            return true;
+        }
+        return false;
+    }
+}
+
+static bool parse_value(cJSON *item, ParseBuffer *b) {
+    if (!CAN_ACCESS(b, 0)) {
+        return false;
+    }
+    const unsigned char *p = AT(b);
+    if (CAN_READ(b, 4) && strncmp((const char *)p, "null", 4) == 0) {
+        item->type = cJSON_NULL;
+        b->offset += 4;
+        return true;
+    }
+    if (CAN_READ(b, 5) && strncmp((const char *)p, "false", 5) == 0) {
+        item->type = cJSON_False;
+        b->offset += 5;
+        return true;
+    }
+    if (CAN_READ(b, 4) && strncmp((const char *)p, "true", 4) == 0) {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        b->offset += 4;
+        return true;
+    }
+    if (p[0] == '"') {
+        item->valuestring = parse_string_raw(b);
+        item->type = cJSON_String;
+        return item->valuestring != NULL;
+    }
+    if (p[0] == '-' || isdigit(p[0])) {
+        return parse_number(item, b);
+    }
+    if (p[0] == '[') {
+        return parse_array(item, b);
+    }
+    if (p[0] == '{') {
+        return parse_object(item, b);
+    }
+    return false;
+}
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t length) {
+    if (!value || length == 0) {
+        return NULL;
+    }
+    ParseBuffer b = {.content = (const unsigned char *)value, .length = length};
+    if (length >= 3 && memcmp(value, "\xEF\xBB\xBF", 3) == 0) {
+        b.offset = 3;  // UTF-8 BOM
+    }
+    cJSON *item = new_item();
+    if (!item) {
+        return NULL;
+    }
+    skip_whitespace(&b);
+    if (!parse_value(item, &b)) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
+
+// ---- 打印 ----
+
+typedef struct {
+    char *buffer;
+    size_t length;
+    size_t offset;
+} PrintBuffer;
+
+static char *ensure(PrintBuffer *p, size_t needed) {
+    if (!p->buffer) {
+        return NULL;
+    }
+    needed += p->offset + 1;
+    if (needed <= p->length) {
+        return p->buffer + p->offset;
+    }
+    if (needed > INT_MAX / 2) {
+        free(p->buffer);
+        p->buffer = NULL;
+        return NULL;
+    }
+    size_t new_size = needed * 2;
+    char *grown = realloc(p->buffer, new_size);
+    if (!grown) {
+        free(p->buffer);
+        p->buffer = NULL;
+        return NULL;
+    }
+    p->buffer = grown;
+    p->length = new_size;
+    return p->buffer + p->offset;
+}
+
+static bool print_raw(PrintBuffer *p, const char *s, size_t len) {
+    char *out = ensure(p, len);
+    if (!out) {
+        return false;
+    }
+    memcpy(out, s, len);
+    p->offset += len;
+    return true;
+}
+
+static bool compare_double(double a, double b) {
+    double max = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= max * DBL_EPSILON;
+}
+
+static bool print_number(const cJSON *item, PrintBuffer *p) {
+    double d = item->valuedouble;
+    char number[26];
+    int len;
+    if (isnan(d) || isinf(d)) {
+        len = snprintf(number, sizeof(number), "null");
+    } else if (d == (double)item->valueint) {
+        len = snprintf(number, sizeof(number), "%d", item->valueint);
+    } else {
+        double test = 0.0;
+        len = snprintf(number, sizeof(number), "%1.15g", d);
+        if (sscanf(number, "%lg", &test) != 1 || !compare_double(test, d)) {
+            len = snprintf(number, sizeof(number), "%1.17g", d);
+        }
+    }
+    return len > 0 && (size_t)len < sizeof(number) && print_raw(p, number, (size_t)len);
+}
+
+static bool print_string(const char *s, PrintBuffer *p) {
+    if (!s) {
+        return print_raw(p, "\"\"", 2);
+    }
+    size_t escapes = 0;
+    const unsigned char *in;
+    for (in = (const unsigned char *)s; *in; in++) {
+        if (*in == '"' || *in == '\\' || *in == '\b' || *in == '\f' || *in == '\n' || *in == '\r' ||
+            *in == '\t') {
+            escapes++;
+        } else if (*in < 32) {
+            escapes += 5;
+        }
+    }
+    size_t len = (size_t)(in - (const unsigned char *)s) + escapes;
+    char *out = ensure(p, len + 2);
+    if (!out) {
+        return false;
+    }
+    *out++ = '"';
+    for (in = (const unsigned char *)s; *in; in++) {
+        if (*in >= 32 && *in != '"' && *in != '\\') {
+            *out++ = (char)*in;
+            continue;
+        }
+        *out++ = '\\';
+        switch (*in) {
+        case '\\': *out++ = '\\'; break;
+        case '"': *out++ = '"'; break;
+        case '\b': *out++ = 'b'; break;
+        case '\f': *out++ = 'f'; break;
+        case '\n': *out++ = 'n'; break;
+        case '\r': *out++ = 'r'; break;
+        case '\t': *out++ = 't'; break;
+        default:
+            snprintf(out, 6, "u%04x", *in);
+            out += 5;
+            break;
+        }
+    }
+    *out++ = '"';
+    p->offset += len + 2;
+    return true;
+}
+
+static bool print_value(const cJSON *item, PrintBuffer *p) {
+    switch (item->type & 0xFF) {
+    case cJSON_NULL:
+        return print_raw(p, "null", 4);
+    case cJSON_False:
+        return print_raw(p, "false", 5);
+    case cJSON_True:
+        return print_raw(p, "true", 4);
+    case cJSON_Number:
+        return print_number(item, p);
+    case cJSON_String:
+        return print_string(item->valuestring, p);
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool object = (item->type & 0xFF) == cJSON_Object;
+        if (!print_raw(p, object ? "{" : "[", 1)) {
+            return false;
+        }
+        for (const cJSON *c = item->child; c; c = c->next) {
+            if (object && (!print_string(c->string, p) || !print_raw(p, ":", 1))) {
+                return false;
+            }
+            if (!print_value(c, p) || (c->next && !print_raw(p, ",", 1))) {
+                return false;
+            }
+        }
+        return print_raw(p, object ? "}" : "]", 1);
+    }
+    default:
+        return false;
+    }
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item) {
+    if (!item) {
+        return NULL;
+    }
+    PrintBuffer p = {.buffer = malloc(PRINT_BUFFER_SIZE), .length = PRINT_BUFFER_SIZE};
+    if (!p.buffer) {
+        return NULL;
+    }
+    if (!print_value(item, &p)) {
+        free(p.buffer);
+        return NULL;
+    }
+    p.buffer[p.offset] = '\0';
+    char *printed = realloc(p.buffer, p.offset + 1);
+    if (!printed) {
+        free(p.buffer);
+    }
+    return printed;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file fake_firmware.c
+ * @brief mqtt_wrapper.c 依赖的其余固件模块的替身
+ *
+ * 这些模块（风扇、转速计、能耗、辨识、作息、调度、离线缓存、连接监管、诊断、TLS 传输）
+ * 各有自己的测试或依赖硬件；替身只提供与默认配置一致的返回值，让 mqtt_wrapper.c 可以单独链接。
+ */
+
+#include "fake_firmware.h"
+#include "fan_control.h"
+#include "fan_tach.h"
+#include "fan_energy.h"
+#include "vent_ident.h"
+#include "occupancy_habit.h"
+#include "schedule.h"
+#include "telemetry_buffer.h"
+#include "conn_supervisor.h"
+#include "wifi_manager.h"
+#include "diagnostics.h"
+#include "mqtt_tls.h"
+#include <string.h>
+
+static const FanConfig s_fans[3] = {
+    { 36, 0, 150, 255, 180, 255, 150, 200, FAN_TACH_GPIO_NONE, 2, 0, 0, 0, 0 },
+    { 37, 1, 150, 255, 180, 255, 150, 200, FAN_TACH_GPIO_NONE, 2, 0, 0, 0, 0 },
+    { 38, 2, 150, 255, 180, 255, 150, 200, FAN_TACH_GPIO_NONE, 2, 0, 0, 0, 0 },
+};
+static uint8_t s_saved_count = 0;
+static uint32_t s_diag_requests = 0;
+static bool s_fan_stats = false;
+static bool s_time_valid = false;
+
+uint8_t fake_fan_config_saved_count(void) { return s_saved_count; }
+uint32_t fake_diag_report_requests(void) { return s_diag_requests; }
+void fake_firmware_set_fan_stats(bool on) { s_fan_stats = on; }
+void fake_firmware_set_time_valid(bool valid) { s_time_valid = valid; }
+
+// fan_control
+uint8_t fan_control_get_count(void) { return 3; }
+const FanConfig *fan_control_get_config(FanId id) { return id < 3 ? &s_fans[id] : NULL; }
+
+esp_err_t fan_control_save_config(const FanConfig *fans, uint8_t count) {
+    if (!fans || count == 0 || count > FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_saved_count = count;
+    return ESP_OK;
+}
+
+// fan_tach / fan_energy
+uint16_t fan_tach_get_rpm(FanId id) { return s_fan_stats ? 1200 + 37 * id : 0; }
+FanTachHealth fan_tach_get_health(FanId id) {
+    static const FanTachHealth health[] = { FAN_TACH_OK, FAN_TACH_UNDERSPEED, FAN_TACH_STALL };
+    return s_fan_stats ? health[id % 3] : FAN_TACH_NONE;
+}
+const char *fan_tach_health_to_string(FanTachHealth health) {
+    switch (health) {
+        case FAN_TACH_OK:         return "OK";
+        case FAN_TACH_UNDERSPEED: return "UNDERSPEED";
+        case FAN_TACH_STALL:      return "STALL";
+        default:                  return NULL;
+    }
+}
+
+esp_err_t fan_energy_get(FanId id, FanEnergyStats *out) {
+    memset(out, 0, sizeof(*out));
+    if (s_fan_stats) {
+        out->on_hours = 12.34f + id;
+        out->energy_wh = 56.78f * (id + 1);
+        out->starts = 10 + id;
+        out->filter_remaining = 90 - id;
+    }
+    return ESP_OK;
+}
+void fan_energy_reset_filter(uint32_t fan_mask) {}
+esp_err_t fan_energy_set_curve(FanId id, const uint16_t curve_mw[ENERGY_CURVE_POINTS]) { return ESP_OK; }
+
+// vent_ident（模型为默认衰减率）
+void vent_ident_request_start(void) {}
+void vent_ident_request_stop(void) {}
+void vent_ident_request_reset(void) {}
+void vent_ident_request_report(void) {}
+float vent_ident_get_infiltration(void) { return PREDICT_DECAY_INFILTRATION; }
+float vent_ident_get_fan_decay(FanId id, FanState level) {
+    return level == FAN_HIGH ? PREDICT_DECAY_FAN_HIGH : level == FAN_LOW ? PREDICT_DECAY_FAN_LOW : 0.0f;
+}
+
+// occupancy_habit / schedule
+HabitHint occupancy_habit_get_hint(void) { return HABIT_HINT_NONE; }
+esp_err_t occupancy_habit_export_day(uint8_t day, HabitBin out[24]) { return ESP_ERR_INVALID_STATE; }
+esp_err_t occupancy_habit_import_day(uint8_t day, const HabitBin in[24]) { return ESP_OK; }
+void occupancy_habit_clear(void) {}
+void occupancy_habit_request_export(void) {}
+esp_err_t schedule_set_periods(const SchedulePeriod periods[], uint8_t count) { return ESP_OK; }
+
+// telemetry_buffer
+FanState telemetry_sample_get_fan(const TelemetrySample *sample, FanId id) {
+    return (FanState)((sample->fans >> (2 * id)) & 0x3);
+}
+void telemetry_buffer_on_published(int msg_id) {}
+void telemetry_buffer_on_disconnected(void) {}
+void telemetry_buffer_get_stats(TelemetryStats *stats) { memset(stats, 0, sizeof(*stats)); }
+
+// 连接监管 / WiFi / 诊断 / TLS 传输
+void conn_supervisor_on_broker_attempt(void) {}
+void conn_supervisor_on_broker_up(void) {}
+void conn_supervisor_on_broker_down(void) {}
+void conn_supervisor_get_stats(ConnStats *out) { memset(out, 0, sizeof(*out)); }
+void wifi_manager_get_fast_stats(WifiFastStats *out) { memset(out, 0, sizeof(*out)); }
+void diagnostics_request_report(void) { s_diag_requests++; }
+void diagnostics_get_snapshot(DiagSnapshot *out) { memset(out, 0, sizeof(*out)); }
+const char *diag_alarm_to_string(DiagAlarm alarm) { return "NONE"; }
+// 假 esp-mqtt 不使用传输层，返回一个非空占位句柄即可
+esp_transport_handle_t mqtt_tls_transport_create(int default_port) {
+    static int s_dummy;
+    return (esp_transport_handle_t)&s_dummy;
+}
+esp_err_t esp_transport_destroy(esp_transport_handle_t t) { return ESP_OK; }
+
+// main.c
+bool is_time_valid(void) { return s_time_valid; }
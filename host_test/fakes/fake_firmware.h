@@ -0,0 +1,35 @@
+/**
+ * @file fake_firmware.h
+ * @brief mqtt_wrapper.c 依赖的其余固件模块的替身 - 测试控制接口
+ *
+ * 风扇配置为默认的 3 风扇表（无转速计），其余模块返回空统计，请求类函数只计数。
+ * fake_firmware_set_fan_stats(true) 后转速计与能耗统计返回固定的非零值（每个风扇不同）。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief fan_control_save_config() 最近一次成功保存的风扇数（未保存为 0）
+ */
+uint8_t fake_fan_config_saved_count(void);
+
+/**
+ * @brief diagnostics_request_report() 调用次数
+ */
+uint32_t fake_diag_report_requests(void);
+
+/**
+ * @brief 转速计与能耗统计是否返回非零值（默认 false：无转速计、统计全为 0）
+ * 开启后转速计健康状态按风扇序号依次为 OK / UNDERSPEED / STALL，转速 1200 + 37×id rpm，
+ * 能耗统计带小数，用于检查状态消息中的这些字段
+ */
+void fake_firmware_set_fan_stats(bool on);
+
+/**
+ * @brief is_time_valid() 的返回值（默认 false：时间未同步）
+ * 墙上时间仍为主机的 gettimeofday()，开启后 desired 文档的 "expires" 按主机时间判断
+ */
+void fake_firmware_set_time_valid(bool valid);
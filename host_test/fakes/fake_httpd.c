@@ -0,0 +1,517 @@
+/**
+ * @file fake_httpd.c
+ * @brief 假 esp_http_server - 回环地址上的 POSIX 套接字实现（HTTP/1.1 保持连接）
+ */
+
+#include "fake_httpd.h"
+#include "esp_http_server.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FAKE_HTTPD_MAX_SOCKETS  16
+#define FAKE_HTTPD_MAX_URIS     8
+#define FAKE_HTTPD_RX_BUF       4096
+#define FAKE_HTTPD_HDR_MAX      2048
+#define FAKE_HTTPD_POLL_MS      50
+
+typedef struct {
+    int fd;                     ///< -1 表示空闲
+    int64_t last_active_ms;
+    char buf[FAKE_HTTPD_RX_BUF];
+    int len;                    ///< buf 中已收到、尚未处理的字节数
+    // 当前请求
+    char hdrs[FAKE_HTTPD_HDR_MAX];
+    size_t body_left;           ///< 处理函数尚未读取的请求体字节数
+    char status[48];
+    char type[96];
+    char extra[512];            ///< httpd_resp_set_hdr() 累积的响应头
+    bool started;               ///< 已发出响应头
+    bool finished;              ///< 响应已完整发出
+} Conn;
+
+typedef struct {
+    httpd_config_t cfg;
+    int listen_fd;
+    pthread_t thread;
+    atomic_bool stop;
+    pthread_mutex_t lock;       ///< 保护 uris（可能在服务器线程运行后注册）
+    httpd_uri_t uris[FAKE_HTTPD_MAX_URIS];
+    int uri_count;
+    Conn conns[FAKE_HTTPD_MAX_SOCKETS];
+} Server;
+
+static Server s_server = { .listen_fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+static bool s_running = false;
+static int s_port_override = -1;
+static _Atomic uint16_t s_port = 0;
+static struct {
+    atomic_ulong requests, chunks, max_chunk, purged, aborted;
+} s_stats;
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static void conn_close(Conn *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->len = 0;
+}
+
+static int write_all(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static esp_err_t send_head(Conn *c, const char *length_hdr) {
+    char head[1024];
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\n%s%s\r\n",
+                     c->status, c->type, c->extra, length_hdr);
+    c->started = true;
+    return write_all(c->fd, head, (size_t)n) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+// ---- 响应 ----
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status) {
+    Conn *c = r->aux;
+    snprintf(c->status, sizeof(c->status), "%s", status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+    Conn *c = r->aux;
+    snprintf(c->type, sizeof(c->type), "%s", type);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value) {
+    Conn *c = r->aux;
+    size_t used = strlen(c->extra);
+    snprintf(c->extra + used, sizeof(c->extra) - used, "%s: %s\r\n", field, value);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    Conn *c = r->aux;
+    if (c->started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    }
+    char length_hdr[48];
+    snprintf(length_hdr, sizeof(length_hdr), "Content-Length: %zd\r\n", buf_len);
+    if (send_head(c, length_hdr) != ESP_OK || (buf_len > 0 && write_all(c->fd, buf, (size_t)buf_len) != 0)) {
+        return ESP_FAIL;
+    }
+    c->finished = true;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    Conn *c = r->aux;
+    if (c->finished) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!c->started && send_head(c, "Transfer-Encoding: chunked\r\n") != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    }
+    char size_line[24];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", buf_len);
+    if (write_all(c->fd, size_line, (size_t)n) != 0 ||
+        (buf_len > 0 && write_all(c->fd, buf, (size_t)buf_len) != 0) ||
+        write_all(c->fd, "\r\n", 2) != 0) {
+        return ESP_FAIL;
+    }
+    if (buf_len == 0) {
+        c->finished = true;
+    } else {
+        atomic_fetch_add(&s_stats.chunks, 1);
+        unsigned long max = atomic_load(&s_stats.max_chunk);
+        if ((unsigned long)buf_len > max) {
+            atomic_store(&s_stats.max_chunk, (unsigned long)buf_len);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg) {
+    const char *status = error == HTTPD_400_BAD_REQUEST ? "400 Bad Request"
+                       : error == HTTPD_404_NOT_FOUND ? "404 Not Found"
+                       : error == HTTPD_408_REQ_TIMEOUT ? "408 Request Timeout"
+                       : "500 Internal Server Error";
+    httpd_resp_set_status(req, status);
+    return httpd_resp_send(req, msg, HTTPD_RESP_USE_STRLEN);
+}
+
+// ---- 请求 ----
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len) {
+    Conn *c = r->aux;
+    if (c->body_left == 0) {
+        return 0;
+    }
+    if (buf_len > c->body_left) {
+        buf_len = c->body_left;
+    }
+    // 先交出与请求头一起收到的部分
+    if (c->len > 0) {
+        size_t n = buf_len < (size_t)c->len ? buf_len : (size_t)c->len;
+        memcpy(buf, c->buf, n);
+        memmove(c->buf, c->buf + n, (size_t)c->len - n);
+        c->len -= (int)n;
+        c->body_left -= n;
+        return (int)n;
+    }
+    ssize_t got = recv(c->fd, buf, buf_len, 0);
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    if (got <= 0) {
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+    c->body_left -= (size_t)got;
+    return (int)got;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r) {
+    return r ? ((Conn *)r->aux)->fd : -1;
+}
+
+static const char *find_hdr(const Conn *c, const char *field, size_t *value_len) {
+    size_t field_len = strlen(field);
+    for (const char *p = c->hdrs; *p;) {
+        const char *eol = strstr(p, "\r\n");
+        if (!eol) {
+            break;
+        }
+        if ((size_t)(eol - p) > field_len && strncasecmp(p, field, field_len) == 0 && p[field_len] == ':') {
+            const char *v = p + field_len + 1;
+            while (*v == ' ') {
+                v++;
+            }
+            *value_len = (size_t)(eol - v);
+            return v;
+        }
+        p = eol + 2;
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field) {
+    size_t len;
+    return find_hdr(r->aux, field, &len) ? len : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size) {
+    size_t len;
+    const char *p = find_hdr(r->aux, field, &len);
+    if (!p) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len >= val_size) {
+        memcpy(val, p, val_size - 1);
+        val[val_size - 1] = '\0';
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(val, p, len);
+    val[len] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) {
+    Server *s = handle;
+    pthread_mutex_lock(&s->lock);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (s->uri_count < FAKE_HTTPD_MAX_URIS && s->uri_count < s->cfg.max_uri_handlers) {
+        s->uris[s->uri_count++] = *uri_handler;
+        ret = ESP_OK;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ret;
+}
+
+// ---- 服务器线程 ----
+
+static bool find_handler(Server *s, int method, const char *uri, httpd_uri_t *out) {
+    bool found = false;
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < s->uri_count && !found; i++) {
+        if ((int)s->uris[i].method == method && strcmp(s->uris[i].uri, uri) == 0) {
+            *out = s->uris[i];
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return found;
+}
+
+/**
+ * @brief 处理 buf 开头的一个完整请求头及其请求体
+ * @return false 关闭连接
+ */
+static bool handle_request(Server *s, Conn *c) {
+    char *end = memmem(c->buf, (size_t)c->len, "\r\n\r\n", 4);
+    int head_len = (int)(end - c->buf) + 4;
+    char method[8] = "";
+    char uri[256] = "";
+    if (sscanf(c->buf, "%7s %255s", method, uri) != 2) {
+        return false;
+    }
+    char *first_eol = strstr(c->buf, "\r\n");
+    int hdrs_len = head_len - (int)(first_eol + 2 - c->buf);
+    if (hdrs_len >= (int)sizeof(c->hdrs)) {
+        return false;
+    }
+    memcpy(c->hdrs, first_eol + 2, (size_t)hdrs_len);
+    c->hdrs[hdrs_len] = '\0';
+    memmove(c->buf, c->buf + head_len, (size_t)(c->len - head_len));
+    c->len -= head_len;
+
+    size_t content_len = 0;
+    size_t value_len;
+    const char *value = find_hdr(c, "Content-Length", &value_len);
+    if (value) {
+        char num[24];
+        snprintf(num, sizeof(num), "%.*s", (int)(value_len < 23 ? value_len : 23), value);
+        content_len = strtoul(num, NULL, 10);
+    }
+    c->body_left = content_len;
+    strcpy(c->status, "200 OK");
+    strcpy(c->type, "text/html");
+    c->extra[0] = '\0';
+    c->started = false;
+    c->finished = false;
+
+    int m = strcmp(method, "GET") == 0 ? HTTP_GET : strcmp(method, "POST") == 0 ? HTTP_POST : 0;
+    httpd_req_t req = { .handle = s, .method = m, .content_len = content_len, .aux = c };
+    snprintf((char *)req.uri, sizeof(req.uri), "%s", uri);
+    atomic_fetch_add(&s_stats.requests, 1);
+
+    httpd_uri_t handler;
+    if (!find_handler(s, m, uri, &handler)) {
+        httpd_resp_send_err(&req, HTTPD_404_NOT_FOUND, "");
+    } else {
+        req.user_ctx = handler.user_ctx;
+        if (handler.handler(&req) != ESP_OK) {
+            atomic_fetch_add(&s_stats.aborted, 1);
+            return false;
+        }
+    }
+    if (!c->finished) {
+        esp_err_t ret = c->started ? httpd_resp_send_chunk(&req, NULL, 0) : httpd_resp_send(&req, "", 0);
+        if (ret != ESP_OK) {
+            return false;
+        }
+    }
+    // 丢弃处理函数未读取的请求体
+    while (c->body_left > 0) {
+        char discard[256];
+        if (httpd_req_recv(&req, discard, sizeof(discard)) <= 0) {
+            return false;
+        }
+    }
+    const char *conn_hdr = find_hdr(c, "Connection", &value_len);
+    return !(conn_hdr && strncasecmp(conn_hdr, "close", 5) == 0);
+}
+
+static void accept_conn(Server *s) {
+    int fd = accept(s->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    struct timeval rx = { .tv_sec = s->cfg.recv_wait_timeout };
+    struct timeval tx = { .tv_sec = s->cfg.send_wait_timeout };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rx, sizeof(rx));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tx, sizeof(tx));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int slot = -1;
+    int lru = -1;
+    for (int i = 0; i < s->cfg.max_open_sockets; i++) {
+        if (s->conns[i].fd < 0) {
+            slot = i;
+            break;
+        }
+        if (lru < 0 || s->conns[i].last_active_ms < s->conns[lru].last_active_ms) {
+            lru = i;
+        }
+    }
+    if (slot < 0) {
+        if (!s->cfg.lru_purge_enable) {
+            close(fd);
+            return;
+        }
+        conn_close(&s->conns[lru]);
+        atomic_fetch_add(&s_stats.purged, 1);
+        slot = lru;
+    }
+    s->conns[slot].fd = fd;
+    s->conns[slot].len = 0;
+    s->conns[slot].last_active_ms = now_ms();
+}
+
+static void *server_task(void *arg) {
+    Server *s = arg;
+    while (!atomic_load(&s->stop)) {
+        struct pollfd pfd[FAKE_HTTPD_MAX_SOCKETS + 1];
+        int slot[FAKE_HTTPD_MAX_SOCKETS + 1];
+        int n = 0;
+        pfd[n] = (struct pollfd){ .fd = s->listen_fd, .events = POLLIN };
+        slot[n++] = -1;
+        for (int i = 0; i < s->cfg.max_open_sockets; i++) {
+            if (s->conns[i].fd >= 0) {
+                pfd[n] = (struct pollfd){ .fd = s->conns[i].fd, .events = POLLIN };
+                slot[n++] = i;
+            }
+        }
+        if (poll(pfd, (nfds_t)n, FAKE_HTTPD_POLL_MS) <= 0) {
+            continue;
+        }
+        for (int k = 1; k < n; k++) {
+            if (!(pfd[k].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Conn *c = &s->conns[slot[k]];
+            ssize_t got = recv(c->fd, c->buf + c->len, sizeof(c->buf) - (size_t)c->len, 0);
+            if (got <= 0) {
+                conn_close(c);
+                continue;
+            }
+            c->len += (int)got;
+            c->last_active_ms = now_ms();
+            while (c->fd >= 0 && memmem(c->buf, (size_t)c->len, "\r\n\r\n", 4)) {
+                if (!handle_request(s, c)) {
+                    conn_close(c);
+                }
+            }
+            if (c->fd >= 0 && c->len == (int)sizeof(c->buf)) {
+                conn_close(c);  // 请求头超过接收缓冲区
+            }
+        }
+        if (pfd[0].revents & POLLIN) {
+            accept_conn(s);
+        }
+    }
+    return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+    Server *s = &s_server;
+    if (!handle || !config || config->max_open_sockets > FAKE_HTTPD_MAX_SOCKETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s->cfg = *config;
+    s->uri_count = 0;
+    atomic_store(&s->stop, false);
+    for (int i = 0; i < FAKE_HTTPD_MAX_SOCKETS; i++) {
+        s->conns[i].fd = -1;
+    }
+
+    uint16_t port = s_port_override >= 0 ? (uint16_t)s_port_override : config->server_port;
+    s->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    if (s->listen_fd < 0 || bind(s->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s->listen_fd, config->backlog_conn) != 0 ||
+        getsockname(s->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        perror("fake_httpd");
+        if (s->listen_fd >= 0) {
+            close(s->listen_fd);
+        }
+        s->listen_fd = -1;
+        return ESP_FAIL;
+    }
+    atomic_store(&s_port, ntohs(addr.sin_port));
+    if (pthread_create(&s->thread, NULL, server_task, s) != 0) {
+        close(s->listen_fd);
+        s->listen_fd = -1;
+        return ESP_FAIL;
+    }
+    s_running = true;
+    *handle = s;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+    Server *s = handle;
+    if (!s || !s_running) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    atomic_store(&s->stop, true);
+    pthread_join(s->thread, NULL);
+    for (int i = 0; i < FAKE_HTTPD_MAX_SOCKETS; i++) {
+        conn_close(&s->conns[i]);
+    }
+    close(s->listen_fd);
+    s->listen_fd = -1;
+    atomic_store(&s_port, 0);
+    s_running = false;
+    return ESP_OK;
+}
+
+// ---- 测试控制 ----
+
+void fake_httpd_set_port(uint16_t port) {
+    s_port_override = port;
+}
+
+void fake_httpd_stop(void) {
+    if (s_running) {
+        httpd_stop(&s_server);
+    }
+}
+
+uint16_t fake_httpd_port(void) {
+    return atomic_load(&s_port);
+}
+
+FakeHttpdStats fake_httpd_stats(void) {
+    return (FakeHttpdStats){
+        .requests = atomic_load(&s_stats.requests),
+        .chunks = atomic_load(&s_stats.chunks),
+        .max_chunk = atomic_load(&s_stats.max_chunk),
+        .purged = atomic_load(&s_stats.purged),
+        .aborted = atomic_load(&s_stats.aborted),
+    };
+}
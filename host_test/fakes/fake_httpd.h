@@ -0,0 +1,40 @@
+/**
+ * @file fake_httpd.h
+ * @brief 假 esp_http_server - 测试控制接口
+ *
+ * 在本机回环地址上用 POSIX 套接字实现 esp_http_server 的子集：一个服务器线程串行处理所有连接
+ * （同 esp_http_server 的单服务器任务），连接数达到 max_open_sockets 时按 lru_purge_enable
+ * 关闭最久未活动的连接或拒绝新连接，请求体按 recv_wait_timeout 超时，响应支持 Content-Length 与分块传输。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    unsigned long requests;     ///< 已分发给处理函数的请求数（含 404）
+    unsigned long chunks;       ///< 发送的非空分块数
+    unsigned long max_chunk;    ///< 最大分块长度（字节）
+    unsigned long purged;       ///< 因连接数已满被关闭的最久未活动连接数
+    unsigned long aborted;      ///< 处理函数返回错误而关闭的连接数
+} FakeHttpdStats;
+
+/**
+ * @brief 覆盖 httpd_start() 的监听端口（须在 httpd_start() 之前调用，0 = 由系统分配）
+ */
+void fake_httpd_set_port(uint16_t port);
+
+/**
+ * @brief 实际监听的端口（未启动时为 0）
+ */
+uint16_t fake_httpd_port(void);
+
+/**
+ * @brief 停止正在运行的服务器（同对其句柄调用 httpd_stop()，供不保留句柄的调用方使用）
+ */
+void fake_httpd_stop(void);
+
+/**
+ * @brief 服务器统计
+ */
+FakeHttpdStats fake_httpd_stats(void);
@@ -0,0 +1,195 @@
+/**
+ * @file fake_mqtt.c
+ * @brief 假 esp-mqtt 客户端 - 记录发布、订阅，按测试指令投递事件
+ */
+
+#include "fake_mqtt.h"
+#include "mqtt_client.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_MQTT_MAX_SUBS 16
+
+struct esp_mqtt_client {
+    esp_event_handler_t handler;
+    void *handler_arg;
+    bool connected;
+};
+
+static struct esp_mqtt_client s_client;
+static FakeMqttMessage s_messages[FAKE_MQTT_MAX_MESSAGES];
+static int s_first = 0;
+static int s_count = 0;
+static int s_msg_id = 0;
+static bool s_recording = true;
+static char s_subs[FAKE_MQTT_MAX_SUBS][FAKE_MQTT_TOPIC_LEN];
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config) {
+    memset(&s_client, 0, sizeof(s_client));
+    return &s_client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg) {
+    client->handler = handler;
+    client->handler_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+    client->handler = NULL;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos) {
+    for (int i = 0; i < FAKE_MQTT_MAX_SUBS; i++) {
+        if (s_subs[i][0] == '\0' || strcmp(s_subs[i], topic) == 0) {
+            strncpy(s_subs[i], topic, FAKE_MQTT_TOPIC_LEN - 1);
+            break;
+        }
+    }
+    return ++s_msg_id;
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char *topic) {
+    for (int i = 0; i < FAKE_MQTT_MAX_SUBS; i++) {
+        if (strcmp(s_subs[i], topic) == 0) {
+            s_subs[i][0] = '\0';
+        }
+    }
+    return ++s_msg_id;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                            int len, int qos, int retain) {
+    if (len == 0 && data) {
+        len = (int)strlen(data);
+    }
+    if (!s_recording) {
+        return ++s_msg_id;
+    }
+    if (s_count == FAKE_MQTT_MAX_MESSAGES) {
+        free(s_messages[s_first].data);
+        s_first = (s_first + 1) % FAKE_MQTT_MAX_MESSAGES;
+        s_count--;
+    }
+    FakeMqttMessage *m = &s_messages[(s_first + s_count) % FAKE_MQTT_MAX_MESSAGES];
+    strncpy(m->topic, topic, FAKE_MQTT_TOPIC_LEN - 1);
+    m->topic[FAKE_MQTT_TOPIC_LEN - 1] = '\0';
+    m->data = malloc((size_t)len + 1);
+    memcpy(m->data, data, (size_t)len);
+    m->data[len] = '\0';
+    m->len = len;
+    m->qos = qos;
+    m->retain = retain;
+    s_count++;
+    return ++s_msg_id;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+    return 0;
+}
+
+static void dispatch(esp_mqtt_event_t *event) {
+    event->client = &s_client;
+    if (s_client.handler) {
+        s_client.handler(s_client.handler_arg, "MQTT_EVENTS", event->event_id, event);
+    }
+}
+
+void fake_mqtt_connect(void) {
+    esp_mqtt_event_t event = { .event_id = MQTT_EVENT_CONNECTED };
+    s_client.connected = true;
+    dispatch(&event);
+}
+
+void fake_mqtt_disconnect(void) {
+    esp_mqtt_error_codes_t codes = { .error_type = MQTT_ERROR_TYPE_TCP_TRANSPORT };
+    esp_mqtt_event_t event = { .event_id = MQTT_EVENT_DISCONNECTED, .error_handle = &codes };
+    s_client.connected = false;
+    dispatch(&event);
+}
+
+void fake_mqtt_deliver_fragment(const char *topic, const void *data, int len, int offset, int total_len) {
+    // 每个分片与主题单独分配，越界读写由 ASan 发现
+    char *copy = malloc(len > 0 ? (size_t)len : 1);
+    memcpy(copy, data, (size_t)len);
+    char *topic_copy = topic ? strdup(topic) : NULL;
+    esp_mqtt_event_t event = {
+        .event_id = MQTT_EVENT_DATA,
+        .data = copy,
+        .data_len = len,
+        .total_data_len = total_len,
+        .current_data_offset = offset,
+        .topic = topic_copy,
+        .topic_len = topic_copy ? (int)strlen(topic_copy) : 0,
+        .qos = 1,
+    };
+    dispatch(&event);
+    free(copy);
+    free(topic_copy);
+}
+
+void fake_mqtt_deliver(const char *topic, const void *data, int len, int chunk) {
+    if (chunk <= 0 || chunk > len) {
+        chunk = len > 0 ? len : 1;
+    }
+    int offset = 0;
+    do {
+        int n = len - offset < chunk ? len - offset : chunk;
+        fake_mqtt_deliver_fragment(offset == 0 ? topic : NULL, (const char *)data + offset, n, offset, len);
+        offset += n;
+    } while (offset < len);
+}
+
+int fake_mqtt_message_count(void) {
+    return s_count;
+}
+
+const FakeMqttMessage *fake_mqtt_message(int i) {
+    if (i < 0 || i >= s_count) {
+        return NULL;
+    }
+    return &s_messages[(s_first + i) % FAKE_MQTT_MAX_MESSAGES];
+}
+
+const FakeMqttMessage *fake_mqtt_last(const char *suffix) {
+    size_t sl = strlen(suffix);
+    for (int i = s_count - 1; i >= 0; i--) {
+        const FakeMqttMessage *m = fake_mqtt_message(i);
+        size_t tl = strlen(m->topic);
+        if (tl >= sl && strcmp(m->topic + tl - sl, suffix) == 0) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+void fake_mqtt_clear(void) {
+    for (int i = 0; i < s_count; i++) {
+        free(s_messages[(s_first + i) % FAKE_MQTT_MAX_MESSAGES].data);
+    }
+    s_first = 0;
+    s_count = 0;
+}
+
+void fake_mqtt_set_recording(bool on) {
+    s_recording = on;
+}
+
+bool fake_mqtt_subscribed(const char *filter) {
+    for (int i = 0; i < FAKE_MQTT_MAX_SUBS; i++) {
+        if (strcmp(s_subs[i], filter) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
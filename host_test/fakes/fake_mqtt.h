@@ -0,0 +1,78 @@
+/**
+ * @file fake_mqtt.h
+ * @brief 假 esp-mqtt 客户端 - 测试控制接口
+ *
+ * 发布的消息按顺序记录（最多 FAKE_MQTT_MAX_MESSAGES 条，超出后丢弃最旧的），
+ * 连接、断开与收到消息通过 esp_mqtt_client_register_event() 注册的处理函数投递，
+ * 与 esp-mqtt 事件任务中的调用方式相同（同步、单线程）。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FAKE_MQTT_MAX_MESSAGES 64
+#define FAKE_MQTT_TOPIC_LEN    96
+
+typedef struct {
+    char topic[FAKE_MQTT_TOPIC_LEN];
+    char *data;       ///< 负载副本（额外以 '\0' 结尾，便于按字符串检查 JSON）
+    int len;
+    int qos;
+    int retain;
+} FakeMqttMessage;
+
+/**
+ * @brief 投递 MQTT_EVENT_CONNECTED
+ */
+void fake_mqtt_connect(void);
+
+/**
+ * @brief 投递 MQTT_EVENT_DISCONNECTED
+ */
+void fake_mqtt_disconnect(void);
+
+/**
+ * @brief 投递一条消息
+ * @param chunk 每个 MQTT_EVENT_DATA 的最大长度（0 = 不分片）；
+ *              与 esp-mqtt 相同，只有第一个分片携带主题
+ */
+void fake_mqtt_deliver(const char *topic, const void *data, int len, int chunk);
+
+/**
+ * @brief 投递单个 MQTT_EVENT_DATA 分片（偏移与总长由调用方给出，可以不连续或自相矛盾）
+ * @param topic 主题，NULL 表示不带主题（非第一片）
+ * @param data 本片数据
+ * @param len 本片长度
+ * @param offset current_data_offset
+ * @param total_len total_data_len
+ */
+void fake_mqtt_deliver_fragment(const char *topic, const void *data, int len, int offset, int total_len);
+
+/**
+ * @brief 已记录的发布消息数 / 第 i 条（0 = 最旧）
+ */
+int fake_mqtt_message_count(void);
+const FakeMqttMessage *fake_mqtt_message(int i);
+
+/**
+ * @brief 主题以 suffix 结尾的最近一条消息，没有时返回 NULL
+ */
+const FakeMqttMessage *fake_mqtt_last(const char *suffix);
+
+/**
+ * @brief 清空已记录的消息
+ */
+void fake_mqtt_clear(void);
+
+/**
+ * @brief 是否记录发布的消息（默认记录）
+ * 关闭后 esp_mqtt_client_publish() 只返回 msg_id、不复制负载，基准测试的计时与分配计数不含假客户端本身
+ */
+void fake_mqtt_set_recording(bool on);
+
+/**
+ * @brief 是否已订阅（精确匹配主题过滤器）
+ */
+bool fake_mqtt_subscribed(const char *filter);
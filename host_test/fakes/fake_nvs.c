@@ -0,0 +1,203 @@
+/**
+ * @file fake_nvs.c
+ * @brief 内存 NVS - 固定容量的 (命名空间, 键) 表，值按原样保存
+ *
+ * 与真实 NVS 一致的行为：只读句柄写入返回 ESP_ERR_INVALID_ARG（真实实现为 NVS_READ_ONLY），
+ * 键不存在返回 ESP_ERR_NVS_NOT_FOUND，blob / str 缓冲区过小返回 ESP_ERR_NVS_INVALID_LENGTH，
+ * out 为 NULL 时只返回长度。写入立即可见，nvs_commit 不做额外处理。
+ */
+
+#include "fake_nvs.h"
+#include "nvs.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_NVS_MAX_ENTRIES   64
+#define FAKE_NVS_MAX_HANDLES   16
+#define FAKE_NVS_NAME_LEN      16   // 与 NVS 相同：命名空间和键最多 15 个字符
+
+typedef struct {
+    bool used;
+    char ns[FAKE_NVS_NAME_LEN];
+    char key[FAKE_NVS_NAME_LEN];
+    void *data;
+    size_t len;
+} FakeNvsEntry;
+
+typedef struct {
+    bool open;
+    bool writable;
+    char ns[FAKE_NVS_NAME_LEN];
+} FakeNvsHandle;
+
+static FakeNvsEntry s_entries[FAKE_NVS_MAX_ENTRIES];
+static FakeNvsHandle s_handles[FAKE_NVS_MAX_HANDLES];
+static bool s_write_fail = false;
+static uint32_t s_write_count = 0;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void fake_nvs_erase_all(void) {
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < FAKE_NVS_MAX_ENTRIES; i++) {
+        free(s_entries[i].data);
+        s_entries[i] = (FakeNvsEntry){0};
+    }
+    s_write_count = 0;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void fake_nvs_set_write_fail(bool fail) {
+    s_write_fail = fail;
+}
+
+uint32_t fake_nvs_write_count(void) {
+    return s_write_count;
+}
+
+static FakeNvsHandle *handle_get(nvs_handle_t handle) {
+    if (handle == 0 || handle > FAKE_NVS_MAX_HANDLES || !s_handles[handle - 1].open) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static FakeNvsEntry *entry_find(const char *ns, const char *key) {
+    for (int i = 0; i < FAKE_NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && strcmp(s_entries[i].ns, ns) == 0 && strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out_handle) {
+    if (!name || !out_handle || strlen(name) >= FAKE_NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < FAKE_NVS_MAX_HANDLES; i++) {
+        if (!s_handles[i].open) {
+            s_handles[i].open = true;
+            s_handles[i].writable = (mode == NVS_READWRITE);
+            strcpy(s_handles[i].ns, name);
+            *out_handle = (nvs_handle_t)(i + 1);
+            pthread_mutex_unlock(&s_lock);
+            return ESP_OK;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    pthread_mutex_lock(&s_lock);
+    FakeNvsHandle *h = handle_get(handle);
+    if (h) {
+        h->open = false;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return handle_get(handle) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t entry_set(nvs_handle_t handle, const char *key, const void *value, size_t len) {
+    if (!key || strlen(key) >= FAKE_NVS_NAME_LEN || (!value && len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    FakeNvsHandle *h = handle_get(handle);
+    esp_err_t err = ESP_OK;
+    if (!h || !h->writable) {
+        err = ESP_ERR_INVALID_ARG;
+    } else if (s_write_fail) {
+        err = ESP_ERR_NVS_NO_FREE_PAGES;
+    } else {
+        FakeNvsEntry *e = entry_find(h->ns, key);
+        for (int i = 0; !e && i < FAKE_NVS_MAX_ENTRIES; i++) {
+            if (!s_entries[i].used) {
+                e = &s_entries[i];
+                e->used = true;
+                strcpy(e->ns, h->ns);
+                strcpy(e->key, key);
+            }
+        }
+        void *copy = malloc(len ? len : 1);
+        if (!e || !copy) {
+            free(copy);
+            err = ESP_ERR_NVS_NO_FREE_PAGES;
+        } else {
+            memcpy(copy, value, len);
+            free(e->data);
+            e->data = copy;
+            e->len = len;
+            s_write_count++;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+static esp_err_t entry_get(nvs_handle_t handle, const char *key, void *out, size_t *len) {
+    if (!key || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    FakeNvsHandle *h = handle_get(handle);
+    FakeNvsEntry *e = h ? entry_find(h->ns, key) : NULL;
+    esp_err_t err = ESP_OK;
+    if (!h) {
+        err = ESP_ERR_INVALID_ARG;
+    } else if (!e) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out && *len < e->len) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else if (out) {
+        memcpy(out, e->data, e->len);
+    }
+    if (e && err != ESP_ERR_NVS_INVALID_LENGTH) {
+        *len = e->len;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    return entry_set(handle, key, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    return entry_get(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+    return entry_set(handle, key, value, value ? strlen(value) + 1 : 0);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+    return entry_get(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    return entry_set(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value) {
+    size_t len = sizeof(*out_value);
+    return entry_get(handle, key, out_value, &len);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    pthread_mutex_lock(&s_lock);
+    FakeNvsHandle *h = handle_get(handle);
+    FakeNvsEntry *e = h ? entry_find(h->ns, key) : NULL;
+    esp_err_t err = !h ? ESP_ERR_INVALID_ARG : !e ? ESP_ERR_NVS_NOT_FOUND : ESP_OK;
+    if (e) {
+        free(e->data);
+        *e = (FakeNvsEntry){0};
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file fake_nvs.h
+ * @brief 内存 NVS - 测试控制接口
+ *
+ * 数据在进程内保留，模块重新 init 即相当于断电重启后读取 NVS。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 清空全部命名空间（相当于 nvs_flash_erase）
+ */
+void fake_nvs_erase_all(void);
+
+/**
+ * @brief 之后的写入是否失败（模拟 NVS 已满）
+ */
+void fake_nvs_set_write_fail(bool fail);
+
+/**
+ * @brief 累计写入次数（set_* 调用，用于检查写入节流）
+ */
+uint32_t fake_nvs_write_count(void);
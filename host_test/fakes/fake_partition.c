@@ -0,0 +1,136 @@
+/**
+ * @file fake_partition.c
+ * @brief 内存 Flash 分区 - 按 NOR Flash 语义模拟单个数据分区
+ *
+ * 擦除以 4096 字节扇区为单位置 0xFF，写入只能把 1 清为 0（新数据与原内容按位与），
+ * 偏移或长度越界返回 ESP_ERR_INVALID_SIZE，擦除未按扇区对齐返回 ESP_ERR_INVALID_ARG。
+ */
+
+#include "fake_partition.h"
+#include "esp_partition.h"
+#include <string.h>
+#include <sys/mman.h>
+
+#define FAKE_SECTOR_SIZE 4096
+
+/**
+ * @brief 共享内存中的分区状态（跨 fork 保留）
+ */
+typedef struct {
+    esp_partition_t part;
+    bool present;
+    bool fail;
+    uint32_t erases;
+    uint32_t dirty_writes;
+    uint8_t data[];
+} FakePartition;
+
+static FakePartition *s_fp = NULL;
+static size_t s_map_size = 0;
+
+void fake_partition_create(const char *label, size_t size) {
+    fake_partition_remove();
+    s_map_size = sizeof(FakePartition) + size;
+    void *mem = mmap(NULL, s_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        s_fp = NULL;
+        return;
+    }
+    s_fp = mem;
+    s_fp->part = (esp_partition_t){
+        .type = ESP_PARTITION_TYPE_DATA,
+        .subtype = (esp_partition_subtype_t)0x40,
+        .address = 0x210000,
+        .size = (uint32_t)size,
+        .erase_size = FAKE_SECTOR_SIZE,
+    };
+    strncpy(s_fp->part.label, label, sizeof(s_fp->part.label) - 1);
+    s_fp->present = true;
+    memset(s_fp->data, 0xFF, size);
+}
+
+void fake_partition_remove(void) {
+    if (s_fp) {
+        munmap(s_fp, s_map_size);
+        s_fp = NULL;
+    }
+}
+
+void fake_partition_set_fail(bool fail) {
+    if (s_fp) {
+        s_fp->fail = fail;
+    }
+}
+
+uint32_t fake_partition_erase_count(void) {
+    return s_fp ? s_fp->erases : 0;
+}
+
+uint32_t fake_partition_dirty_writes(void) {
+    return s_fp ? s_fp->dirty_writes : 0;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    if (!s_fp || !s_fp->present || s_fp->part.type != type) {
+        return NULL;
+    }
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != s_fp->part.subtype) {
+        return NULL;
+    }
+    if (label && strcmp(label, s_fp->part.label) != 0) {
+        return NULL;
+    }
+    return &s_fp->part;
+}
+
+static bool in_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    return s_fp && partition == &s_fp->part && offset <= partition->size && size <= partition->size - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    if (!dst) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!in_range(partition, src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, s_fp->data + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    if (!src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!in_range(partition, dst_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (s_fp->fail) {
+        return ESP_FAIL;
+    }
+    const uint8_t *in = src;
+    uint8_t *out = s_fp->data + dst_offset;
+    for (size_t i = 0; i < size; i++) {
+        if ((out[i] & in[i]) != in[i]) {
+            s_fp->dirty_writes++;
+        }
+        out[i] &= in[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (!in_range(partition, offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (offset % FAKE_SECTOR_SIZE != 0 || size % FAKE_SECTOR_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_fp->fail) {
+        return ESP_FAIL;
+    }
+    memset(s_fp->data + offset, 0xFF, size);
+    s_fp->erases += (uint32_t)(size / FAKE_SECTOR_SIZE);
+    return ESP_OK;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file fake_partition.h
+ * @brief 内存 Flash 分区 - 测试控制接口
+ *
+ * 分区内容放在进程间共享的内存中，fork 出的子进程写入后父进程可见：
+ * 测试以子进程模拟一次上电运行，子进程退出即断电，Flash 内容保留。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 创建（或重建）分区，内容为已擦除状态（全 0xFF）
+ * @param label 分区标签（esp_partition_find_first 按标签查找）
+ * @param size 分区大小（字节，须为 4096 的整数倍）
+ */
+void fake_partition_create(const char *label, size_t size);
+
+/**
+ * @brief 删除分区（之后 esp_partition_find_first 返回 NULL）
+ */
+void fake_partition_remove(void);
+
+/**
+ * @brief 之后的写入 / 擦除是否失败（模拟 Flash 故障）
+ */
+void fake_partition_set_fail(bool fail);
+
+/**
+ * @brief 累计擦除扇区数
+ */
+uint32_t fake_partition_erase_count(void);
+
+/**
+ * @brief 累计把 0 位写回 1 的次数（NOR Flash 未擦除就写入，真实硬件上数据会损坏）
+ */
+uint32_t fake_partition_dirty_writes(void);
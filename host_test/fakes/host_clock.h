@@ -0,0 +1,25 @@
+/**
+ * @file host_clock.h
+ * @brief 主机测试模拟时钟 - esp_timer_get_time() / xTaskGetTickCount() 的时间源
+ *
+ * 时钟只在测试显式推进（或被测代码调用 vTaskDelay）时前进，测试结果与运行快慢无关。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief 当前模拟时间（微秒，从 0 开始）
+ */
+int64_t host_clock_now_us(void);
+
+/**
+ * @brief 推进模拟时钟
+ */
+void host_clock_advance_ms(uint32_t ms);
+
+/**
+ * @brief 模拟时钟归零（模拟重启）
+ */
+void host_clock_reset(void);
@@ -0,0 +1,143 @@
+/**
+ * @file host_esp.c
+ * @brief 主机测试桩实现 - esp_timer、MAC 地址、esp_restart、ROM CRC32、日志级别与 libc 补齐
+ */
+
+#include "host_esp.h"
+#include "host_clock.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_TIMER_MAX 32
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    bool active;
+    bool periodic;
+    int64_t due_us;
+    uint64_t period_us;
+};
+
+static struct esp_timer *s_timers[HOST_TIMER_MAX];
+static uint32_t s_restart_count = 0;
+
+int64_t esp_timer_get_time(void) {
+    return host_clock_now_us();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    if (!args || !args->callback || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < HOST_TIMER_MAX; i++) {
+        if (!s_timers[i]) {
+            s_timers[i] = calloc(1, sizeof(struct esp_timer));
+            if (!s_timers[i]) {
+                return ESP_ERR_NO_MEM;
+            }
+            s_timers[i]->callback = args->callback;
+            s_timers[i]->arg = args->arg;
+            *out = s_timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->periodic = false;
+    timer->due_us = host_clock_now_us() + (int64_t)timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    esp_err_t err = esp_timer_start_once(timer, period_us);
+    if (err == ESP_OK) {
+        timer->periodic = true;
+        timer->period_us = period_us;
+    }
+    return err;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer || !timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+int host_timer_run_due(void) {
+    int fired = 0;
+    int64_t now = host_clock_now_us();
+    for (int i = 0; i < HOST_TIMER_MAX; i++) {
+        struct esp_timer *t = s_timers[i];
+        if (t && t->active && t->due_us <= now) {
+            if (t->periodic) {
+                t->due_us += (int64_t)t->period_us;
+            } else {
+                t->active = false;
+            }
+            t->callback(t->arg);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+    static const uint8_t k_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(mac, k_mac, sizeof(k_mac));
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    s_restart_count++;
+}
+
+uint32_t host_restart_count(void) {
+    return s_restart_count;
+}
+
+esp_log_level_t host_log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    host_log_level = level;
+}
+
+// 与 ROM 实现相同：反射多项式 0xEDB88320，入口和出口各取反一次（crc=0 时等同 zlib crc32）
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+#if HOST_NEED_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
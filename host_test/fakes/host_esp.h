@@ -0,0 +1,19 @@
+/**
+ * @file host_esp.h
+ * @brief 主机测试桩 - esp_timer 定时器与 esp_restart 的测试控制接口
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief 触发所有已启动的定时器中到期时刻不晚于当前模拟时间的（单次定时器触发后停止）
+ * @return 触发的回调数
+ */
+int host_timer_run_due(void);
+
+/**
+ * @brief esp_restart() 被调用的次数
+ */
+uint32_t host_restart_count(void);
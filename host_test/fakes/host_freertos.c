@@ -0,0 +1,97 @@
+/**
+ * @file host_freertos.c
+ * @brief 主机测试桩实现 - 模拟时钟、临界区、互斥信号量、任务
+ *
+ * 任务不真正创建：被测模块的后台任务由测试直接调用其单步函数驱动。
+ */
+
+#include "host_clock.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+static _Atomic int64_t s_now_us = 0;
+static pthread_mutex_t s_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+int64_t host_clock_now_us(void) {
+    return atomic_load(&s_now_us);
+}
+
+void host_clock_advance_ms(uint32_t ms) {
+    atomic_fetch_add(&s_now_us, (int64_t)ms * 1000);
+}
+
+void host_clock_reset(void) {
+    atomic_store(&s_now_us, 0);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host_clock_now_us() / 1000 / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    host_clock_advance_ms(ticks * portTICK_PERIOD_MS);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle) {
+    if (handle) {
+        *handle = (TaskHandle_t)fn;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux) {
+    pthread_mutex_lock(&s_critical);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux) {
+    pthread_mutex_unlock(&s_critical);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    pthread_mutex_t *m = malloc(sizeof(*m));
+    if (m) {
+        pthread_mutex_init(m, NULL);
+    }
+    return m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+    if (wait == 0) {
+        return pthread_mutex_trylock(sem) == 0 ? pdTRUE : pdFALSE;
+    }
+    return pthread_mutex_lock(sem) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return pthread_mutex_unlock(sem) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    if (sem) {
+        pthread_mutex_destroy(sem);
+        free(sem);
+    }
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        default:                    return "ESP_ERR_UNKNOWN";
+    }
+}
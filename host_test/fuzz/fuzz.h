@@ -0,0 +1,24 @@
+/**
+ * @file fuzz.h
+ * @brief 模糊测试入口约定（libFuzzer / AFL++ 与 fuzz_driver.c 共用）
+ *
+ * 每个目标实现 LLVMFuzzerTestOneInput()，可选实现 LLVMFuzzerInitialize()。
+ * 不变量不成立时 FUZZ_CHECK 打印位置后 abort()，由模糊器（或 fuzz_driver.c）保存触发的输入。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define FUZZ_CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: 不变量不成立: %s\n", __FILE__, __LINE__, #cond); \
+            abort(); \
+        } \
+    } while (0)
@@ -0,0 +1,266 @@
+/**
+ * @file fuzz_driver.c
+ * @brief 没有 libFuzzer 时（gcc）的模糊测试驱动：回放语料并做确定性变异
+ *
+ *   fuzz_<目标> [目录或文件...] [-runs=N] [-seed=N] [-max_len=N]
+ *
+ * 命令行与 libFuzzer 兼容（其余 -xxx 参数忽略），ctest 对两种构建使用同一条命令。
+ * 先按文件名顺序执行每个语料一次，再从语料出发做 N 次变异（位翻转、替换为结构字符、插入 / 删除、
+ * 重复片段、与另一个语料拼接、截断），随机数只由 -seed 决定，结果可复现。
+ * 目标崩溃（ASan / UBSan 报错或 FUZZ_CHECK 失败）时把当前输入写到 ./crash-<序号>，
+ * 以该文件为参数重新运行即可复现。
+ */
+
+#include "fuzz.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FUZZ_DEFAULT_MAX_LEN 8192
+#define FUZZ_MAX_INPUTS      1024
+
+__attribute__((weak)) int LLVMFuzzerInitialize(int *argc, char ***argv);
+__attribute__((weak)) void __sanitizer_set_death_callback(void (*callback)(void));
+
+typedef struct {
+    char *name;
+    uint8_t *data;
+    size_t size;
+} Input;
+
+static Input s_inputs[FUZZ_MAX_INPUTS];
+static int s_input_count = 0;
+static uint64_t s_rng = 1;
+
+// 崩溃时保存的当前输入
+static const uint8_t *s_current = NULL;
+static size_t s_current_size = 0;
+static unsigned long s_iteration = 0;
+static volatile sig_atomic_t s_saved = 0;
+
+static void save_crash(void) {
+    if (s_saved || !s_current) {
+        return;
+    }
+    s_saved = 1;
+    char path[32];
+    int n = snprintf(path, sizeof(path), "crash-%lu", s_iteration);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        ssize_t written = write(fd, s_current, s_current_size);
+        close(fd);
+        if (written == (ssize_t)s_current_size) {
+            static const char msg[] = "\n触发崩溃的输入已保存到 ";
+            write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            write(STDERR_FILENO, path, (size_t)n);
+            write(STDERR_FILENO, "\n", 1);
+        }
+    }
+}
+
+static void on_signal(int sig) {
+    save_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void run(const uint8_t *data, size_t size) {
+    s_current = data;
+    s_current_size = size;
+    LLVMFuzzerTestOneInput(data, size);
+    s_iteration++;
+}
+
+static bool load_file(const char *path, const char *name, size_t max_len) {
+    if (s_input_count == FUZZ_MAX_INPUTS) {
+        fprintf(stderr, "语料超过 %d 个，其余忽略\n", FUZZ_MAX_INPUTS);
+        return false;
+    }
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t *data = malloc(max_len > 0 ? max_len : 1);
+    size_t size = fread(data, 1, max_len, f);
+    fclose(f);
+    s_inputs[s_input_count++] = (Input){ .name = strdup(name), .data = data, .size = size };
+    return true;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(((const Input *)a)->name, ((const Input *)b)->name);
+}
+
+static void load_path(const char *path, size_t max_len) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        load_file(path, path, max_len);
+        return;
+    }
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return;
+    }
+    int first = s_input_count;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        char file[1024];
+        snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+        if (stat(file, &st) == 0 && S_ISREG(st.st_mode) && !load_file(file, e->d_name, max_len)) {
+            break;
+        }
+    }
+    closedir(dir);
+    qsort(&s_inputs[first], (size_t)(s_input_count - first), sizeof(Input), compare_names);
+}
+
+// ---- 变异 ----
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return n ? (uint32_t)(s_rng % n) : 0;
+}
+
+// JSON 结构字符、CBOR 的 map / text / float / break 首字节、边界值
+static const uint8_t s_interesting[] = {
+    '{', '}', '[', ']', '"', ':', ',', '\\', '0', '9', '-', '+', '.', 'e', 'E', 't', 'f', 'n', 'u', ' ',
+    0x00, 0x1f, 0x7f, 0x80, 0xa0, 0xa1, 0xbf, 0x60, 0x78, 0x7f, 0xf9, 0xfa, 0xfb, 0xff,
+};
+
+static size_t mutate(uint8_t *buf, size_t size, size_t max_len) {
+    int ops = 1 + (int)rnd(4);
+    for (int i = 0; i < ops; i++) {
+        size_t pos = size ? rnd((uint32_t)size) : 0;
+        switch (rnd(8)) {
+            case 0:  // 位翻转
+                if (size) {
+                    buf[pos] ^= (uint8_t)(1u << rnd(8));
+                }
+                break;
+            case 1:  // 随机字节
+                if (size) {
+                    buf[pos] = (uint8_t)rnd(256);
+                }
+                break;
+            case 2:  // 结构字符
+                if (size) {
+                    buf[pos] = s_interesting[rnd(sizeof(s_interesting))];
+                }
+                break;
+            case 3:  // 插入
+                if (size < max_len) {
+                    memmove(buf + pos + 1, buf + pos, size - pos);
+                    buf[pos] = rnd(2) ? s_interesting[rnd(sizeof(s_interesting))] : (uint8_t)rnd(256);
+                    size++;
+                }
+                break;
+            case 4: {  // 删除一段
+                size_t n = size ? 1 + rnd((uint32_t)(size - pos < 8 ? size - pos : 8)) : 0;
+                memmove(buf + pos, buf + pos + n, size - pos - n);
+                size -= n;
+                break;
+            }
+            case 5: {  // 重复一段
+                size_t n = size ? 1 + rnd((uint32_t)(size - pos < 16 ? size - pos : 16)) : 0;
+                if (size + n <= max_len) {
+                    memmove(buf + pos + n, buf + pos, size - pos);
+                    size += n;
+                }
+                break;
+            }
+            case 6: {  // 尾部换成另一个语料的尾部
+                const Input *other = &s_inputs[rnd((uint32_t)s_input_count)];
+                size_t from = other->size ? rnd((uint32_t)other->size) : 0;
+                size_t n = other->size - from;
+                if (pos + n > max_len) {
+                    n = max_len - pos;
+                }
+                memcpy(buf + pos, other->data + from, n);
+                size = pos + n;
+                break;
+            }
+            default:  // 截断
+                size = pos;
+                break;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char **argv) {
+    unsigned long runs = 0;
+    size_t max_len = FUZZ_DEFAULT_MAX_LEN;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = strtoul(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            s_rng = strtoull(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "-max_len=", 9) == 0) {
+            max_len = strtoul(argv[i] + 9, NULL, 10);
+        }
+    }
+    if (s_rng == 0) {
+        s_rng = 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            load_path(argv[i], max_len);
+        }
+    }
+    if (s_input_count == 0) {
+        s_inputs[s_input_count++] = (Input){ .name = strdup("(空)"), .data = malloc(1), .size = 0 };
+    }
+
+    if (__sanitizer_set_death_callback) {
+        __sanitizer_set_death_callback(save_crash);
+    }
+    signal(SIGABRT, on_signal);
+    signal(SIGSEGV, on_signal);
+    signal(SIGFPE, on_signal);
+    if (LLVMFuzzerInitialize) {
+        LLVMFuzzerInitialize(&argc, &argv);
+    }
+
+    // 逐个回放：每个输入单独复制到刚好大小的缓冲区，越界读由 ASan 发现
+    for (int i = 0; i < s_input_count; i++) {
+        uint8_t *copy = malloc(s_inputs[i].size ? s_inputs[i].size : 1);
+        memcpy(copy, s_inputs[i].data, s_inputs[i].size);
+        run(copy, s_inputs[i].size);
+        free(copy);
+    }
+
+    uint8_t *buf = malloc(max_len ? max_len : 1);
+    for (unsigned long r = 0; r < runs; r++) {
+        const Input *in = &s_inputs[rnd((uint32_t)s_input_count)];
+        size_t size = in->size < max_len ? in->size : max_len;
+        memcpy(buf, in->data, size);
+        size = mutate(buf, size, max_len);
+        uint8_t *copy = malloc(size ? size : 1);
+        memcpy(copy, buf, size);
+        run(copy, size);
+        free(copy);
+    }
+    free(buf);
+
+    fprintf(stderr, "语料 %d 个，变异 %lu 次，未发现问题\n", s_input_count, runs);
+    for (int i = 0; i < s_input_count; i++) {
+        free(s_inputs[i].name);
+        free(s_inputs[i].data);
+    }
+    return 0;
+}
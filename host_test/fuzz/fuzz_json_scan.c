@@ -0,0 +1,78 @@
+/**
+ * @file fuzz_json_scan.c
+ * @brief 模糊测试目标：json_scan() 分词器
+ *
+ * 输入原样交给 json_scan()（无 '\0' 结尾，越界读由 ASan 发现），成功时检查 token 结构：
+ * 偏移不越界且按出现顺序排列、嵌套不超过 JSON_SCAN_MAX_DEPTH、容器的子 token 落在容器范围内、
+ * 对象成员为 "键字符串 + 值"、json_token_next() 从根跳到末尾；
+ * 并用只有 4 个 token 的数组重新分词，结果应相同或为 NOMEM。
+ */
+
+#include "fuzz.h"
+#include "json_scan.h"
+
+#define FUZZ_MAX_TOKENS 64
+
+/**
+ * @brief 检查 tokens[index] 及其子 token（depth 为其所在层数，根为 0）
+ * @return 下一个兄弟 token 的序号
+ */
+static int check_token(const char *js, size_t len, const JsonToken *tokens, int count, int index, int depth) {
+    const JsonToken *tok = &tokens[index];
+    FUZZ_CHECK(tok->type >= JSON_TOK_OBJECT && tok->type <= JSON_TOK_PRIMITIVE);
+    FUZZ_CHECK(tok->start <= tok->end && tok->end <= len);
+    if (index > 0) {
+        FUZZ_CHECK(tok->start >= tokens[index - 1].start);
+    }
+
+    int next = index + 1;
+    switch (tok->type) {
+        case JSON_TOK_OBJECT:
+        case JSON_TOK_ARRAY:
+            FUZZ_CHECK(depth < JSON_SCAN_MAX_DEPTH);
+            FUZZ_CHECK(js[tok->start] == (tok->type == JSON_TOK_OBJECT ? '{' : '['));
+            FUZZ_CHECK(js[tok->end - 1] == (tok->type == JSON_TOK_OBJECT ? '}' : ']'));
+            for (int i = 0; i < tok->size; i++) {
+                FUZZ_CHECK(next < count);
+                if (tok->type == JSON_TOK_OBJECT) {
+                    FUZZ_CHECK(tokens[next].type == JSON_TOK_STRING && tokens[next].size == 1);
+                    FUZZ_CHECK(next + 1 < count);
+                    next = check_token(js, len, tokens, count, next + 1, depth + 1);
+                } else {
+                    next = check_token(js, len, tokens, count, next, depth + 1);
+                }
+                FUZZ_CHECK(tokens[next - 1].end <= tok->end);
+            }
+            break;
+        case JSON_TOK_STRING:
+            FUZZ_CHECK(tok->start > 0 && js[tok->start - 1] == '"' && js[tok->end] == '"');
+            (void)json_token_equals(js, tok, "fan_0");
+            break;
+        default: {
+            int32_t value;
+            FUZZ_CHECK(tok->size == 0 && tok->end > tok->start);
+            (void)json_token_get_int(js, tok, &value);
+            break;
+        }
+    }
+    FUZZ_CHECK(json_token_next(tokens, count, index) == next);
+    return next;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    const char *js = (const char *)data;
+    JsonToken tokens[FUZZ_MAX_TOKENS];
+    int count = json_scan(js, size, tokens, FUZZ_MAX_TOKENS);
+    if (count < 0) {
+        FUZZ_CHECK(count == JSON_SCAN_ERROR_NOMEM || count == JSON_SCAN_ERROR_INVAL ||
+                   count == JSON_SCAN_ERROR_PART);
+        return 0;
+    }
+    FUZZ_CHECK(count > 0 && count <= FUZZ_MAX_TOKENS);
+    FUZZ_CHECK(check_token(js, size, tokens, count, 0, 0) == count);
+
+    JsonToken few[4];
+    int few_count = json_scan(js, size, few, 4);
+    FUZZ_CHECK(count <= 4 ? few_count == count : few_count == JSON_SCAN_ERROR_NOMEM);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file fuzz_mqtt_command.c
+ * @brief 模糊测试目标：mqtt_wrapper.c 的消息接收路径（分片重组 → 按主题分发 → JSON / CBOR 命令解析）
+ *
+ * 输入格式（前 4 字节为控制字节，其余为消息负载，最多 8192 字节，超过接收缓冲区 4096 的消息也会出现）：
+ *   [0] 主题：s_topics[] 下标（取模）
+ *   [1] 分片长度（0 = 整条投递）
+ *   [2] 分片扰动位：bit0 丢掉第 k 片，bit1 重复第 k 片，bit2 交换第 k 与 k+1 片，
+ *       bit3 每片的 total_data_len 改为 [3] × 32（可小于或大于实际长度），bit4 从第 2 片开始投递（缺第一片）
+ *   [3] k / 谎报的 total_data_len
+ * 消息经假 esp-mqtt 的 MQTT_EVENT_DATA 投递到 mqtt_wrapper.c 的事件处理函数，与设备收到消息的路径相同。
+ * 每个输入之后再分片投递一条合法命令，检查它被执行：任何输入都不能让重组状态卡住或破坏命令解析。
+ */
+
+#include "fuzz.h"
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "esp_log.h"
+#include <string.h>
+
+#define DEVICE_TOPIC     "home/ventilation/esp32_020000000001"
+#define FUZZ_MAX_PAYLOAD 8192
+#define FUZZ_MAX_FRAGS   64
+
+static const char *const s_topics[] = {
+    DEVICE_TOPIC "/command",
+    DEVICE_TOPIC "/shadow/desired",
+    DEVICE_TOPIC "/config",
+    DEVICE_TOPIC "/command/ident",
+    DEVICE_TOPIC "/command/habit",
+    DEVICE_TOPIC "/command/schedule",
+    DEVICE_TOPIC "/command/energy",
+    DEVICE_TOPIC "/command/fan_config",
+    DEVICE_TOPIC "/command/diag",
+    DEVICE_TOPIC "/shadow/get",
+    "home/ventilation/all/command",
+    "home/ventilation/other/command",
+};
+
+typedef struct {
+    int offset;
+    int len;
+} Fragment;
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    fake_nvs_erase_all();
+    runtime_config_init();
+    mqtt_client_init();
+    fake_mqtt_set_recording(false);
+    fake_mqtt_connect();
+    return 0;
+}
+
+/**
+ * @brief 分片投递一条合法命令，检查 fan_0 被设为 expected
+ */
+static void check_command_applied(FanState expected) {
+    static const char *const names[] = { "OFF", "LOW", "HIGH" };
+    char cmd[64];
+    int len = snprintf(cmd, sizeof(cmd), "{\"fan_0\":\"%s\",\"ttl\":60}", names[expected]);
+    fake_mqtt_deliver(s_topics[0], cmd, len, 7);
+
+    FanState fans[FAN_MAX_COUNT];
+    FUZZ_CHECK(mqtt_get_remote_command(fans, 3));
+    FUZZ_CHECK(fans[0] == expected);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static unsigned s_round = 0;
+    if (size < 4 || size - 4 > FUZZ_MAX_PAYLOAD) {
+        return 0;
+    }
+    const char *topic = s_topics[data[0] % (sizeof(s_topics) / sizeof(s_topics[0]))];
+    int chunk = data[1];
+    uint8_t flags = data[2];
+    int k = data[3];
+    const char *payload = (const char *)data + 4;
+    int len = (int)size - 4;
+
+    if (chunk == 0 || chunk >= len) {
+        fake_mqtt_deliver(topic, payload, len, 0);
+    } else {
+        Fragment frags[FUZZ_MAX_FRAGS + 1];
+        int n = 0;
+        for (int offset = 0; offset < len && n < FUZZ_MAX_FRAGS; offset += chunk) {
+            frags[n++] = (Fragment){ offset, len - offset < chunk ? len - offset : chunk };
+        }
+        k %= n;
+        if ((flags & 0x01) && n > 1) {
+            memmove(&frags[k], &frags[k + 1], (size_t)(n - k - 1) * sizeof(Fragment));
+            n--;
+            k %= n;
+        }
+        if (flags & 0x02) {
+            memmove(&frags[k + 1], &frags[k], (size_t)(n - k) * sizeof(Fragment));
+            n++;
+        }
+        if ((flags & 0x04) && k + 1 < n) {
+            Fragment t = frags[k];
+            frags[k] = frags[k + 1];
+            frags[k + 1] = t;
+        }
+        int total = (flags & 0x08) ? data[3] * 32 : len;
+        for (int i = (flags & 0x10) ? 1 : 0; i < n; i++) {
+            fake_mqtt_deliver_fragment(frags[i].offset == 0 ? topic : NULL, payload + frags[i].offset,
+                                       frags[i].len, frags[i].offset, total);
+        }
+    }
+
+    check_command_applied((FanState)(s_round++ % 3));
+    return 0;
+}
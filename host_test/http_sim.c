@@ -0,0 +1,154 @@
+/**
+ * @file http_sim.c
+ * @brief 本地 HTTP 接口模拟设备 - local_http.c 运行在假 esp_http_server（fakes/fake_httpd.c）上，供 tools/http_load.py 压测
+ *
+ * /command 经真实的 mqtt_wrapper.c 解析与租约路径（与 MQTT command 主题相同），令牌为 sdkconfig.h 中的
+ * CONFIG_LOCAL_HTTP_TOKEN。另一个线程模拟固件持续更新指标（带标签的计数器、量规、直方图）与状态快照，
+ * 检验抓取与更新并发时导出内容的自洽；模拟时钟随实际时间推进（租约剩余时间、运行时间、鉴权锁定）。
+ *
+ *   http_sim [--port N] [--seconds N]
+ *
+ * 启动后在标准输出打印一行 "port <端口>"（--port 0 由系统分配，默认 CONFIG_LOCAL_HTTP_PORT），
+ * 运行 --seconds 秒（默认 30）或收到 SIGINT / SIGTERM 后停止服务器并打印统计。
+ * /metrics 出现超过 LOCAL_HTTP_CHUNK_SIZE 的分块或没有处理过请求时返回 1。
+ */
+
+#include "local_http.h"
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "metrics.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "host_clock.h"
+#include "fake_httpd.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_STEP_MS          100     // 模拟时钟推进步长
+#define SIM_STATE_EVERY      1024    // 每更新多少次指标换一次状态快照
+#define SIM_DEFAULT_SECONDS  30
+
+static volatile sig_atomic_t s_signalled = 0;
+static atomic_bool s_stop = false;
+
+static pthread_mutex_t s_state_lock = PTHREAD_MUTEX_INITIALIZER;
+static LocalHttpState s_state;
+
+// 模拟固件登记的指标
+static MetricCounter s_read_errors[4];
+static const char *const s_read_error_names[4] = {"timeout", "no_marker", "no_value", "range"};
+static MetricGauge s_heap_free;
+static MetricHistogram s_read_us;
+static const uint32_t s_read_bounds[] = {1000, 5000, 10000, 50000, 100000, 250000, 500000, 1000000};
+static unsigned long s_updates = 0;
+
+static void on_signal(int sig) {
+    s_signalled = 1;
+}
+
+static bool get_state(LocalHttpState *out) {
+    pthread_mutex_lock(&s_state_lock);
+    *out = s_state;
+    pthread_mutex_unlock(&s_state_lock);
+    return true;
+}
+
+/**
+ * @brief 模拟固件任务：不停更新指标，定期换一份随机的状态快照
+ */
+static void *firmware_task(void *arg) {
+    unsigned seed = 1;
+    while (!atomic_load(&s_stop)) {
+        metric_counter_inc(&s_read_errors[rand_r(&seed) % 4]);
+        metric_gauge_set(&s_heap_free, (int32_t)(rand_r(&seed) % 100000) - 50000);
+        metric_histogram_observe(&s_read_us, (uint32_t)(rand_r(&seed) % 2000000));
+        if (++s_updates % SIM_STATE_EVERY == 0) {
+            pthread_mutex_lock(&s_state_lock);
+            s_state.sensor.valid = rand_r(&seed) % 10 != 0;
+            s_state.sensor.pollutants.co2 = (float)(400 + rand_r(&seed) % 1600);
+            s_state.sensor.temperature = 20.0f + (float)(rand_r(&seed) % 100) / 10.0f;
+            s_state.sensor.humidity = 40.0f + (float)(rand_r(&seed) % 300) / 10.0f;
+            for (int i = 0; i < FAN_MAX_COUNT; i++) {
+                s_state.fans[i] = (FanState)(rand_r(&seed) % 3);
+            }
+            s_state.mode = (SystemMode)(rand_r(&seed) % 3);
+            s_state.mode_reason = (ModeReason)(rand_r(&seed) % 4);
+            pthread_mutex_unlock(&s_state_lock);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int port = CONFIG_LOCAL_HTTP_PORT;
+    int seconds = SIM_DEFAULT_SECONDS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "用法: http_sim [--port N] [--seconds N]\n");
+            return 2;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    fake_nvs_erase_all();
+    if (runtime_config_init() != ESP_OK || mqtt_client_init() != ESP_OK) {
+        return 1;
+    }
+    fake_mqtt_set_recording(false);
+    fake_mqtt_connect();
+
+    s_state.fan_count = FAN_MAX_COUNT;
+    metrics_register_counter(s_read_errors, 4, "co2_read_errors_total", "CO2 读取错误", "reason",
+                             s_read_error_names);
+    metrics_register_gauge(&s_heap_free, "heap_free_bytes", "堆空闲（模拟值）");
+    metrics_register_histogram(&s_read_us, "sht35_read_us", "读取耗时（微秒）", s_read_bounds,
+                               sizeof(s_read_bounds) / sizeof(s_read_bounds[0]));
+
+    fake_httpd_set_port((uint16_t)port);
+    if (local_http_start(get_state) != ESP_OK) {
+        return 1;
+    }
+    printf("port %u\n", fake_httpd_port());
+    fflush(stdout);
+
+    pthread_t firmware;
+    pthread_create(&firmware, NULL, firmware_task, NULL);
+    const struct timespec step = { .tv_nsec = SIM_STEP_MS * 1000000L };
+    for (int64_t elapsed_ms = 0; elapsed_ms < (int64_t)seconds * 1000 && !s_signalled;
+         elapsed_ms += SIM_STEP_MS) {
+        nanosleep(&step, NULL);
+        host_clock_advance_ms(SIM_STEP_MS);
+    }
+    atomic_store(&s_stop, true);
+    pthread_join(firmware, NULL);
+
+    fake_httpd_stop();  // local_http.c 不提供停止接口
+
+    FakeHttpdStats st = fake_httpd_stats();
+    fprintf(stderr, "请求 %lu 次，分块 %lu 个（最大 %lu 字节），LRU 关闭连接 %lu 次，处理函数中止 %lu 次，指标更新 %lu 次\n",
+            st.requests, st.chunks, st.max_chunk, st.purged, st.aborted, s_updates);
+    int failed = 0;
+    if (st.max_chunk > LOCAL_HTTP_CHUNK_SIZE) {
+        fprintf(stderr, "分块 %lu 字节超过 LOCAL_HTTP_CHUNK_SIZE（%d）\n", st.max_chunk, LOCAL_HTTP_CHUNK_SIZE);
+        failed = 1;
+    }
+    if (st.requests == 0) {
+        fprintf(stderr, "没有收到请求\n");
+        failed = 1;
+    }
+    return failed;
+}
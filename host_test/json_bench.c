@@ -0,0 +1,245 @@
+/**
+ * @file json_bench.c
+ * @brief 状态 / 告警消息生成基准 - json_writer（当前 mqtt_publish_status / alert）对比改用前的 cJSON 版本
+ *
+ * 两组都经同一个假 esp-mqtt 发布（计时期间不记录负载），日志级别调到 ERROR，
+ * 计时包含消息生成与发布调用。堆分配次数由链接选项 --wrap=malloc,calloc,realloc 统计
+ * （固件代码与 cJSON 的调用；libc 内部的分配不计）。cJSON 为 CMake 选用的实现（真实源码或 cjson_lite.c）。
+ *
+ *   json_bench [--runs N]   每个用例运行 N 次（默认 20000），打印每次的耗时、分配次数与消息长度
+ *   json_bench --dump       每个用例各生成一次，按行输出 "<组>\t<用例>\t<负载>"（check_payload_schema.py 用）
+ *
+ * 计时模式下 json_writer 组出现堆分配、cJSON 组没有统计到分配（--wrap 未生效）或发布失败时返回 1。
+ */
+
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "status_batch.h"
+#include "report_policy.h"
+#include "json_bench_legacy.h"
+#include "fake_firmware.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "esp_log.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_RUNS 20000
+
+// ---- 分配计数 ----
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long s_allocs = 0;
+
+void *__wrap_malloc(size_t size) {
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    s_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    s_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+// ---- 用例 ----
+
+typedef esp_err_t (*StatusFn)(SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                              SystemMode mode, ModeReason reason, const StatusBatch *batch);
+typedef esp_err_t (*AlertFn)(const char *message);
+
+typedef struct {
+    const char *name;
+    uint8_t fan_count;
+    bool fan_stats;     ///< 转速计与能耗统计为非零值
+    bool series;        ///< 附带 60 个样本的批量 series
+} StatusCase;
+
+typedef struct {
+    const char *name;
+    const char *message;
+} AlertCase;
+
+static const StatusCase s_status_cases[] = {
+    { "1fan",        1, false, false },
+    { "3fan",        3, true,  false },
+    { "8fan_series", 8, true,  true  },
+};
+
+static const AlertCase s_alert_cases[] = {
+    { "co2",    "CO₂浓度过高: 1650 ppm" },
+    { "escape", "引号\" 反斜杠\\ 换行\n 制表\t 控制\x01 斜杠/" },
+};
+
+static const struct {
+    const char *name;
+    StatusFn status;
+    AlertFn alert;
+} s_groups[] = {
+    { "json_writer", mqtt_publish_status, mqtt_publish_alert },
+    { "cJSON",       legacy_publish_status, legacy_publish_alert },
+};
+
+static SensorData s_sensor = {
+    .pollutants = { .co2 = 851.25f },
+    .temperature = 24.56f,
+    .humidity = 58.31f,
+    .valid = true,
+};
+static FanState s_fans[FAN_MAX_COUNT];
+static StatusBatch s_batch;
+
+/**
+ * @brief 60 个 1 秒样本：读数小幅波动，第 20、21 秒缺测，风扇在第 15、40 秒换档，第 30 秒切换为远程模式
+ */
+static void fill_batch(void) {
+    memset(&s_batch, 0, sizeof(s_batch));
+    s_batch.t0 = 1701935971;
+    s_batch.step_sec = 1;
+    s_batch.count = 60;
+    for (int i = 0; i < s_batch.count; i++) {
+        bool gap = i == 20 || i == 21;
+        s_batch.co2[i] = gap ? STATUS_BATCH_GAP : (int16_t)(850 + i / 4 + (i % 3) - 1);
+        s_batch.temp[i] = gap ? STATUS_BATCH_GAP : (int16_t)(245 + (i % 5 == 0));
+        s_batch.humi[i] = gap ? STATUS_BATCH_GAP : (int16_t)(582 - i / 10);
+        FanState level = i < 15 ? FAN_LOW : i < 40 ? FAN_HIGH : FAN_OFF;
+        for (int f = 0; f < FAN_MAX_COUNT; f++) {
+            s_batch.fans[i] |= (uint16_t)(((level + f) % 3) << (2 * f));
+        }
+        s_batch.mode[i] = i < 30 ? MODE_LOCAL : MODE_REMOTE;
+    }
+}
+
+static esp_err_t run_status(StatusFn fn, const StatusCase *c) {
+    fake_firmware_set_fan_stats(c->fan_stats);
+    return fn(&s_sensor, s_fans, c->fan_count, MODE_REMOTE, MODE_REASON_LEASE,
+              c->series ? &s_batch : NULL);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief 发布一次（记录负载），返回负载长度
+ */
+static int payload_len(esp_err_t (*publish)(const void *arg, int group), const void *arg, int group) {
+    fake_mqtt_clear();
+    fake_mqtt_set_recording(true);
+    CHECK_EQ(publish(arg, group), ESP_OK);
+    fake_mqtt_set_recording(false);
+    const FakeMqttMessage *m = fake_mqtt_message(fake_mqtt_message_count() - 1);
+    return m ? m->len : -1;
+}
+
+static esp_err_t publish_status(const void *arg, int group) {
+    return run_status(s_groups[group].status, arg);
+}
+
+static esp_err_t publish_alert(const void *arg, int group) {
+    return s_groups[group].alert(((const AlertCase *)arg)->message);
+}
+
+/**
+ * @brief 计时 runs 次发布（先预热 runs / 10 次），打印一行结果
+ * @return 每次平均分配次数
+ */
+static double bench(const char *kind, const char *name, esp_err_t (*publish)(const void *arg, int group),
+                    const void *arg, int group, int runs) {
+    int len = payload_len(publish, arg, group);
+    for (int i = 0; i < runs / 10; i++) {
+        publish(arg, group);
+    }
+    int failures = 0;
+    unsigned long allocs = s_allocs;
+    double start = now_ns();
+    for (int i = 0; i < runs; i++) {
+        failures += publish(arg, group) != ESP_OK;
+    }
+    double elapsed = now_ns() - start;
+    double per_run = (double)(s_allocs - allocs) / runs;
+    CHECK_EQ(failures, 0);
+    printf("%-6s %-12s %-12s %9.2f us %8.1f 次分配 %6d 字节\n",
+           kind, name, s_groups[group].name, elapsed / runs / 1000.0, per_run, len);
+    return per_run;
+}
+
+static void dump(void) {
+    fake_mqtt_set_recording(true);
+    for (int g = 0; g < 2; g++) {
+        const char *prefix = g == 0 ? "" : "legacy_";
+        for (size_t i = 0; i < sizeof(s_status_cases) / sizeof(s_status_cases[0]); i++) {
+            fake_mqtt_clear();
+            CHECK_EQ(run_status(s_groups[g].status, &s_status_cases[i]), ESP_OK);
+            const FakeMqttMessage *m = fake_mqtt_message(0);
+            printf("%sstatus\t%s\t%s\n", prefix, s_status_cases[i].name, m ? m->data : "");
+        }
+        for (size_t i = 0; i < sizeof(s_alert_cases) / sizeof(s_alert_cases[0]); i++) {
+            fake_mqtt_clear();
+            CHECK_EQ(s_groups[g].alert(s_alert_cases[i].message), ESP_OK);
+            const FakeMqttMessage *m = fake_mqtt_message(0);
+            printf("%salert\t%s\t%s\n", prefix, s_alert_cases[i].name, m ? m->data : "");
+        }
+    }
+    fake_mqtt_clear();
+}
+
+int main(int argc, char **argv) {
+    int runs = BENCH_DEFAULT_RUNS;
+    bool dump_only = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dump_only = true;
+        } else {
+            fprintf(stderr, "用法: json_bench [--runs N] | --dump\n");
+            return 2;
+        }
+    }
+    if (runs <= 0) {
+        runs = 1;
+    }
+
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+    for (int i = 0; i < FAN_MAX_COUNT; i++) {
+        s_fans[i] = (FanState)(i % 3);
+    }
+    fill_batch();
+    // 与 main.c 相同，状态消息只在 report_policy 给出触发原因后生成（trigger 字段不会是 NONE）
+    uint32_t now = runtime_config_get()->publish_interval_sec;
+    CHECK_EQ(report_policy_check(&s_sensor, s_fans, 3, MODE_REMOTE, MODE_REASON_LEASE, now),
+             REPORT_TRIGGER_INTERVAL);
+    report_policy_commit(&s_sensor, s_fans, 3, MODE_REMOTE, MODE_REASON_LEASE, now, true);
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    if (dump_only) {
+        dump();
+        return test_result();
+    }
+
+    printf("每用例 %d 次\n", runs);
+    for (size_t i = 0; i < sizeof(s_status_cases) / sizeof(s_status_cases[0]); i++) {
+        CHECK(bench("status", s_status_cases[i].name, publish_status, &s_status_cases[i], 0, runs) == 0);
+        CHECK(bench("status", s_status_cases[i].name, publish_status, &s_status_cases[i], 1, runs) > 0);
+    }
+    for (size_t i = 0; i < sizeof(s_alert_cases) / sizeof(s_alert_cases[0]); i++) {
+        CHECK(bench("alert", s_alert_cases[i].name, publish_alert, &s_alert_cases[i], 0, runs) == 0);
+        CHECK(bench("alert", s_alert_cases[i].name, publish_alert, &s_alert_cases[i], 1, runs) > 0);
+    }
+    return test_result();
+}
@@ -0,0 +1,255 @@
+/**
+ * @file json_bench_legacy.c
+ * @brief 改用 json_writer 之前的 cJSON 状态 / 告警消息生成（基准测试的对照组）
+ *
+ * 函数体取自提交 a62c58c 之前的 main/network/mqtt_wrapper.c，除以下几处外逐字保留：
+ * 函数名加 legacy_ 前缀；客户端句柄与连接标志换成本文件的静态变量（假 esp-mqtt 忽略句柄）；
+ * 主题仍为当时的固定主题。当时的状态消息还没有 trigger / report_* / conn 字段。
+ */
+
+#include "json_bench_legacy.h"
+#include "fan_tach.h"
+#include "fan_energy.h"
+#include "decision_engine.h"
+#include "telemetry_buffer.h"
+#include "esp_log.h"
+#include "mqtt_client.h"
+#include "cJSON.h"
+#include <sys/time.h>
+#include <math.h>
+#include <stdio.h>
+
+static const char *TAG = "MQTT_LEGACY";
+
+#define MQTT_TOPIC_STATUS   "home/ventilation/status"
+#define MQTT_TOPIC_ALERT    "home/ventilation/alert"
+
+static esp_mqtt_client_handle_t s_mqtt_client = NULL;
+static bool s_mqtt_connected = true;
+
+/**
+ * @brief FanState 转字符串
+ */
+static const char* fan_state_to_string(FanState state)
+{
+    switch (state) {
+        case FAN_OFF:
+            return "OFF";
+        case FAN_LOW:
+            return "LOW";
+        case FAN_HIGH:
+            return "HIGH";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief SystemMode 转字符串
+ */
+static const char* system_mode_to_string(SystemMode mode)
+{
+    switch (mode) {
+        case MODE_REMOTE:
+            return "REMOTE";
+        case MODE_LOCAL:
+            return "LOCAL";
+        case MODE_SAFE_STOP:
+            return "SAFE_STOP";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief 输出增量编码列：第一个值为绝对值，其后为与上一个有效值之差，缺测为 null
+ */
+static void add_delta_column(cJSON *parent, const char *key, const int16_t col[], int count)
+{
+    cJSON *arr = cJSON_AddArrayToObject(parent, key);
+    bool have_prev = false;
+    int prev = 0;
+    for (int i = 0; i < count; i++) {
+        if (col[i] == STATUS_BATCH_GAP) {
+            cJSON_AddItemToArray(arr, cJSON_CreateNull());
+            continue;
+        }
+        cJSON_AddItemToArray(arr, cJSON_CreateNumber(have_prev ? col[i] - prev : col[i]));
+        prev = col[i];
+        have_prev = true;
+    }
+}
+
+/**
+ * @brief 输出批量样本 "series"：数值列增量编码，风扇与模式只输出变化点 [样本序号, 状态...]
+ */
+static void add_status_series(cJSON *root, const StatusBatch *batch, uint8_t fan_count)
+{
+    cJSON *series = cJSON_AddObjectToObject(root, "series");
+    cJSON_AddNumberToObject(series, "t0", batch->t0);
+    cJSON_AddNumberToObject(series, "step", batch->step_sec);
+    add_delta_column(series, "co2", batch->co2, batch->count);
+    add_delta_column(series, "temp", batch->temp, batch->count);
+    add_delta_column(series, "humi", batch->humi, batch->count);
+
+    cJSON *fans = cJSON_AddArrayToObject(series, "fans");
+    cJSON *modes = cJSON_AddArrayToObject(series, "mode");
+    for (int i = 0; i < batch->count; i++) {
+        if (i == 0 || batch->fans[i] != batch->fans[i - 1]) {
+            cJSON *change = cJSON_CreateArray();
+            cJSON_AddItemToArray(change, cJSON_CreateNumber(i));
+            for (int f = 0; f < fan_count; f++) {
+                FanState state = status_batch_get_fan(batch, i, (FanId)f);
+                cJSON_AddItemToArray(change, cJSON_CreateString(fan_state_to_string(state)));
+            }
+            cJSON_AddItemToArray(fans, change);
+        }
+        if (i == 0 || batch->mode[i] != batch->mode[i - 1]) {
+            cJSON *change = cJSON_CreateArray();
+            cJSON_AddItemToArray(change, cJSON_CreateNumber(i));
+            cJSON_AddItemToArray(change, cJSON_CreateString(system_mode_to_string((SystemMode)batch->mode[i])));
+            cJSON_AddItemToArray(modes, change);
+        }
+    }
+}
+
+esp_err_t legacy_publish_status(SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                              SystemMode mode, ModeReason reason, const StatusBatch *batch)
+{
+    if (!sensor || !fans || fan_count > FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_mqtt_connected) {
+        ESP_LOGW(TAG, "MQTT 未连接，跳过状态发布");
+        return ESP_FAIL;
+    }
+
+    // 构建 JSON 消息
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        ESP_LOGE(TAG, "创建 JSON 对象失败");
+        return ESP_FAIL;
+    }
+
+    cJSON_AddNumberToObject(root, "co2", sensor->pollutants.co2);
+    cJSON_AddNumberToObject(root, "temp", sensor->temperature);
+    cJSON_AddNumberToObject(root, "humi", sensor->humidity);
+
+    // 添加各风扇状态（配置了转速计的风扇附带实测转速和健康状态）
+    for (int i = 0; i < fan_count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "fan_%d", i);
+        cJSON_AddStringToObject(root, key, fan_state_to_string(fans[i]));
+
+        const char *health = fan_tach_health_to_string(fan_tach_get_health((FanId)i));
+        if (health != NULL) {
+            snprintf(key, sizeof(key), "fan_%d_rpm", i);
+            cJSON_AddNumberToObject(root, key, fan_tach_get_rpm((FanId)i));
+            snprintf(key, sizeof(key), "fan_%d_tach", i);
+            cJSON_AddStringToObject(root, key, health);
+        }
+
+        FanEnergyStats energy;
+        if (fan_energy_get((FanId)i, &energy) == ESP_OK) {
+            snprintf(key, sizeof(key), "fan_%d_on_h", i);
+            cJSON_AddNumberToObject(root, key, round(energy.on_hours * 10.0) / 10.0);
+            snprintf(key, sizeof(key), "fan_%d_wh", i);
+            cJSON_AddNumberToObject(root, key, round(energy.energy_wh * 10.0) / 10.0);
+            snprintf(key, sizeof(key), "fan_%d_starts", i);
+            cJSON_AddNumberToObject(root, key, energy.starts);
+            snprintf(key, sizeof(key), "fan_%d_filter", i);
+            cJSON_AddNumberToObject(root, key, energy.filter_remaining);
+        }
+    }
+
+    cJSON_AddStringToObject(root, "mode", system_mode_to_string(mode));
+    cJSON_AddStringToObject(root, "mode_reason", decision_mode_reason_to_string(reason));
+
+    TelemetryStats backlog;
+    telemetry_buffer_get_stats(&backlog);
+    cJSON_AddNumberToObject(root, "backlog", backlog.ram_depth + backlog.flash_depth);
+    cJSON_AddNumberToObject(root, "backlog_dropped", backlog.dropped);
+
+    if (batch) {
+        add_status_series(root, batch, fan_count);
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    cJSON_AddNumberToObject(root, "timestamp", tv.tv_sec);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str == NULL) {
+        ESP_LOGE(TAG, "序列化 JSON 失败");
+        cJSON_Delete(root);
+        return ESP_FAIL;
+    }
+
+    // 发布消息（QoS 0）
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, MQTT_TOPIC_STATUS, json_str, 0, 0, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "MQTT 发布状态失败");
+        cJSON_free(json_str);
+        cJSON_Delete(root);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "发布状态: %s (msg_id=%d)", json_str, msg_id);
+
+    // 释放资源
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+
+    return ESP_OK;
+}
+
+esp_err_t legacy_publish_alert(const char *message)
+{
+    if (!message) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_mqtt_connected) {
+        ESP_LOGW(TAG, "MQTT 未连接，跳过告警发布");
+        return ESP_FAIL;
+    }
+
+    // 构建 JSON 消息
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        ESP_LOGE(TAG, "创建 JSON 对象失败");
+        return ESP_FAIL;
+    }
+
+    cJSON_AddStringToObject(root, "alert", message);
+    cJSON_AddStringToObject(root, "level", "WARNING");
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    cJSON_AddNumberToObject(root, "timestamp", tv.tv_sec);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str == NULL) {
+        ESP_LOGE(TAG, "序列化 JSON 失败");
+        cJSON_Delete(root);
+        return ESP_FAIL;
+    }
+
+    // 发布消息（QoS 1，保证送达）
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, MQTT_TOPIC_ALERT, json_str, 0, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "MQTT 发布告警失败");
+        cJSON_free(json_str);
+        cJSON_Delete(root);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGW(TAG, "发布告警: %s (msg_id=%d, QoS=1)", json_str, msg_id);
+
+    // 释放资源
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+
+    return ESP_OK;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file json_bench_legacy.h
+ * @brief 改用 json_writer 之前的 cJSON 状态 / 告警消息生成（基准测试的对照组）
+ */
+
+#pragma once
+
+#include "mqtt_wrapper.h"
+#include "status_batch.h"
+
+/**
+ * @brief 旧版 mqtt_publish_status()：cJSON 建树后 PrintUnformatted，发布到 home/ventilation/status
+ */
+esp_err_t legacy_publish_status(SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                                SystemMode mode, ModeReason reason, const StatusBatch *batch);
+
+/**
+ * @brief 旧版 mqtt_publish_alert()：发布到 home/ventilation/alert
+ */
+esp_err_t legacy_publish_alert(const char *message);
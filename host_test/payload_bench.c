@@ -0,0 +1,428 @@
+/**
+ * @file payload_bench.c
+ * @brief 上报编码基准 - JSON 与 CBOR 的消息大小、生成耗时，批量上报的每样本线上字节数，以及截断检查
+ *
+ * 消息经真实的 mqtt_wrapper.c 生成，由假 esp-mqtt 记录负载；编码与批量参数通过 config 主题下发
+ * （与后端相同的路径）。计时包含消息生成与发布调用，堆分配次数由 --wrap=malloc,calloc,realloc 统计。
+ *
+ * 线上字节数 = 负载 + MQTT PUBLISH 报头（固定头、剩余长度、主题、QoS 1 的报文标识符）
+ *            + TLS 1.2 AES-GCM 记录开销（记录头 5 + 显式 nonce 8 + 认证标签 16）。
+ * 批量样本为确定性的 1 Hz 随机游走（CO₂ 每秒 -0.5 ~ +0.75 ppm，温湿度缓变），3 个风扇，带转速计与能耗字段。
+ *
+ * 截断检查：
+ *   - 写入器：同一份文档以 1 字节起的每个不足长度的缓冲区写入，payload_writer_finish() 都必须返回 -1，
+ *     足够时输出与大缓冲区逐字节相同（缓冲区按实际大小分配，越界写入由 ASan 报告）
+ *   - 命令解析：JSON / CBOR 命令的每个真前缀经 mqtt_submit_command() 提交都必须被拒绝
+ *     （按前缀长度分配副本，越界读取由 ASan 报告）
+ *
+ *   payload_bench [--runs N]   每个用例运行 N 次（默认 20000）
+ *
+ * 任一编码出现堆分配、CBOR 不小于 JSON、批量上报的每样本字节数不低于快照或截断检查失败时返回 1。
+ */
+
+#include "mqtt_wrapper.h"
+#include "payload_writer.h"
+#include "runtime_config.h"
+#include "status_batch.h"
+#include "report_policy.h"
+#include "fake_firmware.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "esp_log.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_RUNS   20000
+#define CONFIG_TOPIC         "home/ventilation/esp32_020000000001/config"
+#define TLS_RECORD_OVERHEAD  29
+#define BACKLOG_SAMPLES      20
+
+// ---- 分配计数 ----
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long s_allocs = 0;
+
+void *__wrap_malloc(size_t size) {
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    s_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    s_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+// ---- 输入数据 ----
+
+static SensorData s_sensor = {
+    .pollutants = { .co2 = 851.25f },
+    .temperature = 24.56f,
+    .humidity = 58.31f,
+    .valid = true,
+    .timestamp = 1701936000,
+};
+static FanState s_fans[3] = {FAN_LOW, FAN_HIGH, FAN_OFF};
+static StatusBatch s_batch;
+static TelemetrySample s_backlog[BACKLOG_SAMPLES];
+static uint32_t s_rng = 1;
+
+static uint32_t next_rand(void) {
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 16;
+}
+
+/**
+ * @brief 经 config 主题切换上报参数（等待切换宽限期后生效）
+ */
+static void apply_config(int interval, int batch, PayloadFormat format) {
+    static uint32_t version = 0;
+    char doc[160];
+    int len = snprintf(doc, sizeof(doc),
+                       "{\"version\":%lu,\"publish_interval\":%d,\"status_batch\":%d,\"payload_format\":\"%s\"}",
+                       (unsigned long)++version, interval, batch, payload_format_to_string(format));
+    fake_mqtt_deliver(CONFIG_TOPIC, doc, len, 0);
+    host_clock_advance_ms(RCFG_GRACE_MS + 1000);
+    runtime_config_update();
+    CHECK_EQ(runtime_config_get()->version, version);
+    CHECK_EQ(runtime_config_get()->payload_format, format);
+}
+
+/**
+ * @brief 按当前配置采集 interval 秒的 1 Hz 样本，批次复制到 s_batch
+ * @return 批次样本数（批量上报关闭时为 0）
+ */
+static int collect_batch(int interval) {
+    float co2 = 850.0f, temp = 24.53f, humi = 58.2f;
+    static const float co2_steps[] = {-0.5f, -0.25f, 0.0f, 0.0f, 0.25f, 0.5f, 0.75f};
+    static const float temp_steps[] = {-0.01f, 0.0f, 0.0f, 0.01f};
+    static const float humi_steps[] = {-0.03f, 0.0f, 0.02f, 0.05f};
+    s_rng = 1;
+    status_batch_reset();
+    for (int i = 0; i < interval; i++) {
+        SensorData d = s_sensor;
+        d.timestamp = s_sensor.timestamp - interval + 1 + i;
+        d.pollutants.co2 = co2;
+        d.temperature = temp;
+        d.humidity = humi;
+        status_batch_add(&d, s_fans, 3, MODE_LOCAL);
+        co2 += co2_steps[next_rand() % 7];
+        temp += temp_steps[next_rand() % 4];
+        humi += humi_steps[next_rand() % 4];
+    }
+    const StatusBatch *b = status_batch_get();
+    if (!b) {
+        return 0;
+    }
+    s_batch = *b;
+    status_batch_reset();
+    return s_batch.count;
+}
+
+static void fill_backlog(void) {
+    for (int i = 0; i < BACKLOG_SAMPLES; i++) {
+        s_backlog[i] = (TelemetrySample){
+            .timestamp = 1701936000 + (uint32_t)i * 30,
+            .co2 = 851.25f + (float)i,
+            .temperature = 24.5f,
+            .humidity = 58.2f,
+            .fans = 0x21,
+            .mode = MODE_LOCAL,
+            .mode_reason = MODE_REASON_NO_LEASE,
+        };
+    }
+}
+
+// ---- 用例 ----
+
+typedef enum {
+    MSG_STATUS,
+    MSG_ALERT,
+    MSG_BACKLOG,
+} MsgKind;
+
+typedef struct {
+    const char *name;
+    MsgKind kind;
+    int series;         ///< 批量样本的上报间隔（秒，status_batch 1；0 = 无 series）
+} MsgCase;
+
+static const MsgCase s_msg_cases[] = {
+    { "状态快照",          MSG_STATUS,  0 },
+    { "状态+30样本",       MSG_STATUS,  30 },
+    { "状态+120样本",      MSG_STATUS,  120 },
+    { "告警",              MSG_ALERT,   0 },
+    { "补传20条",          MSG_BACKLOG, 0 },
+};
+
+static esp_err_t publish(const MsgCase *c) {
+    switch (c->kind) {
+        case MSG_STATUS:
+            return mqtt_publish_status(&s_sensor, s_fans, 3, MODE_LOCAL, MODE_REASON_NO_LEASE,
+                                       c->series ? &s_batch : NULL);
+        case MSG_ALERT:
+            return mqtt_publish_alert("CO₂浓度过高: 1500 ppm");
+        default:
+            return mqtt_publish_backlog(s_backlog, BACKLOG_SAMPLES) >= 0 ? ESP_OK : ESP_FAIL;
+    }
+}
+
+/**
+ * @brief 发布一次（记录负载），返回最后一条消息
+ */
+static const FakeMqttMessage *publish_recorded(const MsgCase *c) {
+    fake_mqtt_clear();
+    fake_mqtt_set_recording(true);
+    CHECK_EQ(publish(c), ESP_OK);
+    fake_mqtt_set_recording(false);
+    int n = fake_mqtt_message_count();
+    return n > 0 ? fake_mqtt_message(n - 1) : NULL;
+}
+
+/**
+ * @brief 一条消息的线上字节数（MQTT PUBLISH 报文 + TLS 记录开销）
+ */
+static int wire_bytes(const FakeMqttMessage *m) {
+    int remaining = 2 + (int)strlen(m->topic) + (m->qos > 0 ? 2 : 0) + m->len;
+    int varint = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    return 1 + varint + remaining + TLS_RECORD_OVERHEAD;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct {
+    int len;
+    double us;
+    double allocs;
+} BenchResult;
+
+/**
+ * @brief 计时 runs 次发布（先预热 runs / 10 次）
+ */
+static BenchResult bench(const MsgCase *c, int runs) {
+    BenchResult r = {0};
+    const FakeMqttMessage *m = publish_recorded(c);
+    r.len = m ? m->len : -1;
+    for (int i = 0; i < runs / 10; i++) {
+        publish(c);
+    }
+    int failures = 0;
+    unsigned long allocs = s_allocs;
+    double start = now_ns();
+    for (int i = 0; i < runs; i++) {
+        failures += publish(c) != ESP_OK;
+    }
+    r.us = (now_ns() - start) / runs / 1000.0;
+    r.allocs = (double)(s_allocs - allocs) / runs;
+    CHECK_EQ(failures, 0);
+    return r;
+}
+
+static void run_sizes(int runs) {
+    printf("每用例 %d 次（3 风扇，带转速计与能耗字段）\n", runs);
+    printf("%-16s %8s %10s %8s %10s %8s\n", "消息", "JSON字节", "JSON us", "CBOR字节", "CBOR us", "CBOR/JSON");
+    for (size_t i = 0; i < sizeof(s_msg_cases) / sizeof(s_msg_cases[0]); i++) {
+        const MsgCase *c = &s_msg_cases[i];
+        BenchResult r[2];
+        for (int f = 0; f < 2; f++) {
+            PayloadFormat format = f == 0 ? PAYLOAD_FORMAT_JSON : PAYLOAD_FORMAT_CBOR;
+            apply_config(c->series ? c->series : 30, c->series ? 1 : 0, format);
+            if (c->series) {
+                CHECK_EQ(collect_batch(c->series), c->series);
+            }
+            r[f] = bench(c, runs);
+            CHECK(r[f].allocs == 0);
+        }
+        CHECK(r[1].len > 0 && r[1].len < r[0].len);
+        printf("%-16s %8d %10.2f %8d %10.2f %7.0f%%\n", c->name, r[0].len, r[0].us, r[1].len, r[1].us,
+               100.0 * r[1].len / r[0].len);
+    }
+}
+
+// ---- 每样本线上字节数 ----
+
+typedef struct {
+    const char *name;
+    int interval;       ///< publish_interval（秒）
+    int batch;          ///< status_batch（秒，0 = 关闭）
+} WireCase;
+
+static const WireCase s_wire_cases[] = {
+    { "快照，30秒间隔",            30, 0 },
+    { "status_batch 1，30秒间隔",  30, 1 },
+    { "status_batch 5，30秒间隔",  30, 5 },
+    { "status_batch 1，60秒间隔",  60, 1 },
+};
+
+static void run_wire_cost(void) {
+    printf("\n%-26s %6s %10s %10s %10s %10s\n", "模式", "样本数", "JSON线上", "JSON/样本", "CBOR线上", "CBOR/样本");
+    static const MsgCase status_case = { "status", MSG_STATUS, 0 };
+    MsgCase series_case = { "status", MSG_STATUS, 1 };
+    double snapshot_per_sample[2] = {0};
+    for (size_t i = 0; i < sizeof(s_wire_cases) / sizeof(s_wire_cases[0]); i++) {
+        const WireCase *c = &s_wire_cases[i];
+        int samples = 1;
+        int wire[2];
+        for (int f = 0; f < 2; f++) {
+            apply_config(c->interval, c->batch, f == 0 ? PAYLOAD_FORMAT_JSON : PAYLOAD_FORMAT_CBOR);
+            int n = collect_batch(c->interval);
+            CHECK_EQ(n, c->batch ? c->interval / c->batch : 0);
+            samples = n > 0 ? n : 1;
+            const FakeMqttMessage *m = publish_recorded(n > 0 ? &series_case : &status_case);
+            wire[f] = m ? wire_bytes(m) : 0;
+        }
+        double per_sample[2] = { (double)wire[0] / samples, (double)wire[1] / samples };
+        if (c->batch == 0) {
+            memcpy(snapshot_per_sample, per_sample, sizeof(per_sample));
+        } else {
+            CHECK(per_sample[0] < snapshot_per_sample[0]);
+            CHECK(per_sample[1] < snapshot_per_sample[1]);
+        }
+        CHECK(wire[1] < wire[0]);
+        printf("%-26s %6d %10d %10.1f %10d %10.1f\n", c->name, samples, wire[0], per_sample[0],
+               wire[1], per_sample[1]);
+    }
+}
+
+// ---- 截断检查 ----
+
+/**
+ * @brief 覆盖全部值类型的文档（含转义字符、嵌套对象与数组）
+ */
+static void write_sample_doc(PayloadWriter *w) {
+    payload_writer_begin_object(w, NULL);
+    payload_writer_add_string(w, "msg", "引号\" 反斜杠\\ 换行\n 控制\x01");
+    payload_writer_add_int(w, "n", -70000);
+    payload_writer_add_fixed(w, "co2", 851.25f, 2);
+    payload_writer_add_fixed(w, "temp", 24.5f, 1);
+    payload_writer_add_null(w, "gap");
+    payload_writer_add_bool(w, "ok", true);
+    payload_writer_begin_array(w, "col");
+    payload_writer_add_int(w, NULL, 850);
+    payload_writer_add_int(w, NULL, -2);
+    payload_writer_add_null(w, NULL);
+    payload_writer_end_array(w);
+    payload_writer_begin_object(w, "fan_0");
+    payload_writer_add_string(w, "state", "HIGH");
+    payload_writer_add_int(w, "rpm", 1830);
+    payload_writer_end_object(w);
+    payload_writer_end_object(w);
+}
+
+static void check_writer_truncation(PayloadFormat format) {
+    static char full[512];
+    PayloadWriter w;
+    payload_writer_init(&w, format, full, sizeof(full));
+    write_sample_doc(&w);
+    int len = payload_writer_finish(&w);
+    CHECK(len > 0);
+    size_t need = (size_t)len + (format == PAYLOAD_FORMAT_JSON ? 1 : 0);   // JSON 结尾 '\0'
+    int accepted_short = 0;
+    for (size_t size = 1; size <= need; size++) {
+        char *buf = malloc(size);
+        payload_writer_init(&w, format, buf, size);
+        write_sample_doc(&w);
+        int n = payload_writer_finish(&w);
+        if (size < need) {
+            accepted_short += n != -1;
+        } else {
+            CHECK_EQ(n, len);
+            CHECK(memcmp(buf, full, (size_t)len) == 0);
+        }
+        free(buf);
+    }
+    printf("写入器截断（%s，%d 字节）：%zu 个不足长度，%d 个未返回 -1\n", payload_format_to_string(format), len,
+           need - 1, accepted_short);
+    CHECK_EQ(accepted_short, 0);
+}
+
+static const uint8_t k_cbor_definite[] = {   // {"fan_0": "HIGH", "ttl": 120}
+    0xa2, 0x65, 'f', 'a', 'n', '_', '0', 0x64, 'H', 'I', 'G', 'H', 0x63, 't', 't', 'l', 0x18, 0x78,
+};
+static const uint8_t k_cbor_nested[] = {     // {"note": {"a": [1, 2.5, null, "x"]}, "fan_2": "LOW", "fan_1": "OFF"}
+    0xa3, 0x64, 'n', 'o', 't', 'e', 0xa1, 0x61, 'a', 0x84, 0x01, 0xf9, 0x41, 0x00, 0xf6, 0x61, 'x',
+    0x65, 'f', 'a', 'n', '_', '2', 0x63, 'L', 'O', 'W', 0x65, 'f', 'a', 'n', '_', '1', 0x63, 'O', 'F', 'F',
+};
+static const uint8_t k_cbor_indefinite[] = { // 不定长 map：{"fan_0": "HIGH", "ttl": 60}
+    0xbf, 0x65, 'f', 'a', 'n', '_', '0', 0x64, 'H', 'I', 'G', 'H', 0x63, 't', 't', 'l', 0x18, 0x3c, 0xff,
+};
+
+static void check_command_truncation(void) {
+    static const char json_definite[] = "{\"fan_0\":\"HIGH\",\"ttl\":120}";
+    static const char json_nested[] = "{\"note\":{\"a\":[1,2.5,null,\"x\"]},\"fan_2\":\"LOW\",\"fan_1\":\"OFF\"}";
+    static const struct {
+        const char *name;
+        const void *data;
+        int len;
+    } cmds[] = {
+        { "JSON", json_definite, sizeof(json_definite) - 1 },
+        { "JSON 嵌套", json_nested, sizeof(json_nested) - 1 },
+        { "CBOR 定长", k_cbor_definite, sizeof(k_cbor_definite) },
+        { "CBOR 嵌套", k_cbor_nested, sizeof(k_cbor_nested) },
+        { "CBOR 不定长", k_cbor_indefinite, sizeof(k_cbor_indefinite) },
+    };
+    for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        CHECK_EQ(mqtt_submit_command(cmds[i].data, cmds[i].len), ESP_OK);
+        int accepted = 0;
+        for (int k = 1; k < cmds[i].len; k++) {
+            char *prefix = malloc((size_t)k);
+            memcpy(prefix, cmds[i].data, (size_t)k);
+            accepted += mqtt_submit_command(prefix, k) == ESP_OK;
+            free(prefix);
+        }
+        printf("命令截断（%s，%d 字节）：%d 个真前缀，%d 个被受理\n", cmds[i].name, cmds[i].len, cmds[i].len - 1,
+               accepted);
+        CHECK_EQ(accepted, 0);
+    }
+}
+
+int main(int argc, char **argv) {
+    int runs = BENCH_DEFAULT_RUNS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "用法: payload_bench [--runs N]\n");
+            return 2;
+        }
+    }
+    if (runs <= 0) {
+        runs = 1;
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+    fake_firmware_set_fan_stats(true);
+    fill_backlog();
+    // 与 main.c 相同，状态消息只在 report_policy 给出触发原因后生成
+    uint32_t now = runtime_config_get()->publish_interval_sec;
+    CHECK_EQ(report_policy_check(&s_sensor, s_fans, 3, MODE_LOCAL, MODE_REASON_NO_LEASE, now),
+             REPORT_TRIGGER_INTERVAL);
+    report_policy_commit(&s_sensor, s_fans, 3, MODE_LOCAL, MODE_REASON_NO_LEASE, now, true);
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    run_sizes(runs);
+    run_wire_cost();
+    printf("\n");
+    check_writer_truncation(PAYLOAD_FORMAT_JSON);
+    check_writer_truncation(PAYLOAD_FORMAT_CBOR);
+    check_command_truncation();
+    return test_result();
+}
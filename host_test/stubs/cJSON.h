@@ -0,0 +1,64 @@
+/**
+ * @file cJSON.h
+ * @brief 主机测试桩 - cJSON 接口子集
+ *
+ * 配置时找到 cJSON 源码（-DCJSON_DIR=... 或 $IDF_PATH/components/json/cJSON）则直接使用其头文件与实现，
+ * 本文件不参与编译；否则链接 fakes/cjson_lite.c（行为与分配方式同 cJSON 1.7 的替身）。
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef int cJSON_bool;
+
+#define cJSON_Invalid       (0)
+#define cJSON_False         (1 << 0)
+#define cJSON_True          (1 << 1)
+#define cJSON_NULL          (1 << 2)
+#define cJSON_Number        (1 << 3)
+#define cJSON_String        (1 << 4)
+#define cJSON_Array         (1 << 5)
+#define cJSON_Object        (1 << 6)
+#define cJSON_Raw           (1 << 7)
+#define cJSON_IsReference   256
+#define cJSON_StringIsConst 512
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t length);
+void cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *key);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+int cJSON_GetArraySize(const cJSON *array);
+cJSON_bool cJSON_IsArray(const cJSON *item);
+cJSON_bool cJSON_IsObject(const cJSON *item);
+cJSON_bool cJSON_IsString(const cJSON *item);
+cJSON_bool cJSON_IsNumber(const cJSON *item);
+cJSON_bool cJSON_IsNull(const cJSON *item);
+cJSON_bool cJSON_IsBool(const cJSON *item);
+cJSON_bool cJSON_IsTrue(const cJSON *item);
+
+cJSON *cJSON_CreateNull(void);
+cJSON *cJSON_CreateNumber(double num);
+cJSON *cJSON_CreateString(const char *string);
+cJSON *cJSON_CreateArray(void);
+cJSON *cJSON_CreateObject(void);
+cJSON *cJSON_CreateIntArray(const int *numbers, int count);
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *key, cJSON *item);
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item);
+cJSON *cJSON_AddObjectToObject(cJSON *object, const char *key);
+cJSON *cJSON_AddArrayToObject(cJSON *object, const char *key);
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *key, double number);
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *key, const char *string);
+char *cJSON_PrintUnformatted(const cJSON *item);
+void cJSON_free(void *object);
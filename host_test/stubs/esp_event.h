@@ -0,0 +1,13 @@
+/**
+ * @file esp_event.h
+ * @brief 主机测试桩 - 事件处理函数类型
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *handler_arg, esp_event_base_t base, int32_t id, void *event_data);
+
+#define ESP_EVENT_ANY_ID -1
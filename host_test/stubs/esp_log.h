@@ -0,0 +1,36 @@
+/**
+ * @file esp_log.h
+ * @brief 主机测试桩 - 日志输出到 stderr（DEBUG/VERBOSE 级别只做格式检查）
+ *
+ * esp_log_level_set() 只支持全局级别（tag 忽略），基准测试用它关闭计时区间内的日志。
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+extern esp_log_level_t host_log_level;
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+#define HOST_LOG(level, letter, tag, fmt, ...) do { \
+        if (host_log_level >= (level)) { \
+            fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__); \
+        } \
+    } while (0)
+#define HOST_LOG_NONE(tag, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); (void)(tag); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG_NONE(tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,17 @@
+/**
+ * @file esp_mac.h
+ * @brief 主机测试桩 - MAC 地址（固定为 02:00:00:00:00:01）
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+} esp_mac_type_t;
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
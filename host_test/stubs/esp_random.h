@@ -0,0 +1,10 @@
+/**
+ * @file esp_random.h
+ * @brief 主机测试桩 - 硬件随机数（实现由使用它的测试提供，见 conn_sim.c）
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
@@ -0,0 +1,10 @@
+/**
+ * @file esp_rom_crc.h
+ * @brief 主机测试桩 - ROM CRC32（实现见 fakes/host_esp.c，与 ROM 结果一致）
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
@@ -0,0 +1,10 @@
+/**
+ * @file esp_system.h
+ * @brief 主机测试桩 - esp_restart
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+void esp_restart(void);
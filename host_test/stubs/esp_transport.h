@@ -0,0 +1,12 @@
+/**
+ * @file esp_transport.h
+ * @brief 主机测试桩 - 传输层句柄（mqtt_tls.h 的接口类型）
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_transport_item_t *esp_transport_handle_t;
+
+esp_err_t esp_transport_destroy(esp_transport_handle_t t);
@@ -0,0 +1,11 @@
+/**
+ * @file esp_wifi.h
+ * @brief 主机测试桩 - WiFi 关联 / 断开（实现由使用它的测试提供，见 conn_sim.c）
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
@@ -0,0 +1,52 @@
+/**
+ * @file FreeRTOS.h
+ * @brief 主机测试桩 - FreeRTOS 基本类型与临界区（实现见 fakes/host_freertos.c）
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
+#define portMAX_DELAY 0xffffffffu
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define pdTICKS_TO_MS(t) ((uint32_t)((uint64_t)(t) * 1000 / configTICK_RATE_HZ))
+#define tskIDLE_PRIORITY 0
+#define configMAX_TASK_NAME_LEN 16
+
+#define BIT0 (1u << 0)
+#define BIT1 (1u << 1)
+#define BIT2 (1u << 2)
+#define BIT3 (1u << 3)
+#define BIT4 (1u << 4)
+#define BIT5 (1u << 5)
+#define BIT6 (1u << 6)
+#define BIT7 (1u << 7)
+
+// 临界区在主机上统一由一把递归互斥锁实现
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+#define portENTER_CRITICAL(m) vPortEnterCritical(m)
+#define portEXIT_CRITICAL(m)  vPortExitCritical(m)
+#define taskENTER_CRITICAL(m) vPortEnterCritical(m)
+#define taskEXIT_CRITICAL(m)  vPortExitCritical(m)
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+#include "task.h"
@@ -0,0 +1,17 @@
+/**
+ * @file task.h
+ * @brief 主机测试桩 - 任务接口（vTaskDelay 推进 fakes/host_clock.h 的模拟时钟）
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t handle);
@@ -0,0 +1,16 @@
+/**
+ * @file timers.h
+ * @brief 主机测试桩 - FreeRTOS 软件定时器（实现由使用它的测试提供，见 conn_sim.c）
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
@@ -0,0 +1,13 @@
+/**
+ * @file host_compat.h
+ * @brief 主机测试 - 补齐 newlib 有而旧版 glibc 没有的函数（由 CMake 强制包含）
+ */
+
+#pragma once
+
+#include <string.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+#define HOST_NEED_STRLCPY 1
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
@@ -0,0 +1,10 @@
+/**
+ * @file sockets.h
+ * @brief 主机测试桩 - lwIP 套接字接口（直接使用主机的 POSIX 套接字）
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
@@ -0,0 +1,17 @@
+/**
+ * @file sdkconfig.h
+ * @brief 主机测试用 menuconfig 配置（对应 sdkconfig.defaults，另开启模拟转速计与本地 HTTP 接口）
+ */
+
+#pragma once
+
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_FAN_TACH_MOCK 1
+#define CONFIG_MQTT_BROKER_URL "mqtts://broker.invalid:8883"
+#define CONFIG_MQTT_USERNAME "host"
+#define CONFIG_MQTT_PASSWORD "host"
+#define CONFIG_MQTT_BROADCAST_COMMANDS 1
+#define CONFIG_CO2_PREDICTIVE_VENTILATION 1
+#define CONFIG_LOCAL_HTTP 1
+#define CONFIG_LOCAL_HTTP_PORT 80
+#define CONFIG_LOCAL_HTTP_TOKEN "host-token"
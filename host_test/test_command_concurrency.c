@@ -0,0 +1,79 @@
+/**
+ * @file test_command_concurrency.c
+ * @brief 远程命令并发提交测试 - MQTT 任务与本地 HTTP 任务同时提交只改部分风扇的命令
+ *
+ * 线程 A 经假 esp-mqtt 投递 command 主题消息（MQTT 任务的路径），只改 fan_0；
+ * 线程 B 调用 mqtt_submit_command()（本地 HTTP /command 的路径），只改 fan_1。
+ * 两条路径都以当前命令为底合并，各自的风扇只有自己会改，所以每次提交前读到的
+ * 自己那台风扇必须仍是自己上次写入的档位；另一方用旧快照覆盖时即为丢失更新。
+ * 命令中带一段被忽略的填充键，拉长解析时间，使两次提交容易交错。
+ */
+
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "esp_log.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define COMMAND_TOPIC "home/ventilation/esp32_020000000001/command"
+#define ROUNDS        5000
+#define PAD_LEN       2048
+
+static char s_pad[PAD_LEN + 1];
+static atomic_int s_lost = 0;
+
+typedef struct {
+    int fan;
+    bool via_mqtt;
+} Submitter;
+
+static void *submit_task(void *arg) {
+    const Submitter *s = arg;
+    static _Thread_local char buf[PAD_LEN + 64];
+    FanState last = FAN_OFF;
+    for (int i = 0; i < ROUNDS; i++) {
+        FanState cmd[FAN_MAX_COUNT];
+        if (i > 0 && (!mqtt_get_remote_command(cmd, FAN_MAX_COUNT) || cmd[s->fan] != last)) {
+            atomic_fetch_add(&s_lost, 1);
+        }
+        last = i % 2 ? FAN_HIGH : FAN_LOW;
+        int len = snprintf(buf, sizeof(buf), "{\"fan_%d\":\"%s\",\"pad\":\"%s\",\"ttl\":300}", s->fan,
+                           last == FAN_HIGH ? "HIGH" : "LOW", s_pad);
+        if (s->via_mqtt) {
+            fake_mqtt_deliver(COMMAND_TOPIC, buf, len, 0);
+        } else if (mqtt_submit_command(buf, len) != ESP_OK) {
+            atomic_fetch_add(&s_lost, 1);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_set_recording(false);
+    fake_mqtt_connect();
+    memset(s_pad, 'x', PAD_LEN);
+
+    Submitter mqtt = { .fan = 0, .via_mqtt = true };
+    Submitter http = { .fan = 1, .via_mqtt = false };
+    pthread_t a, b;
+    pthread_create(&a, NULL, submit_task, &mqtt);
+    pthread_create(&b, NULL, submit_task, &http);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+
+    CHECK_EQ(atomic_load(&s_lost), 0);
+    FanState cmd[FAN_MAX_COUNT];
+    CHECK(mqtt_get_remote_command(cmd, FAN_MAX_COUNT));
+    CHECK_EQ(cmd[0], (ROUNDS - 1) % 2 ? FAN_HIGH : FAN_LOW);
+    CHECK_EQ(cmd[1], (ROUNDS - 1) % 2 ? FAN_HIGH : FAN_LOW);
+    return test_result();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_fan_config_restart.c
+ * @brief 风扇配置表命令测试 - "restart":true 时重启推迟到事件处理函数返回之后
+ *
+ * 命令经假 esp-mqtt 投递到 mqtt_wrapper.c 的事件处理函数：处理函数返回时告警已发出、尚未重启，
+ * 单次定时器在 MQTT_FAN_CONFIG_RESTART_DELAY_MS（500 ms）后才调用 esp_restart()。
+ * 校验失败或未要求重启时不启动定时器；等待期间重复的命令不会重复重启。
+ */
+
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "fake_firmware.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "host_esp.h"
+#include "test_util.h"
+#include <string.h>
+
+#define FAN_CONFIG_TOPIC "home/ventilation/esp32_020000000001/command/fan_config"
+#define RESTART_DELAY_MS 500
+
+#define FAN_JSON "{\"gpio\":36,\"channel\":0,\"min_duty\":150,\"max_duty\":255,\"low_duty\":180," \
+                 "\"high_duty\":255,\"night_low_duty\":150,\"night_high_duty\":200}"
+
+static void send_fan_config(const char *json) {
+    fake_mqtt_clear();
+    fake_mqtt_deliver(FAN_CONFIG_TOPIC, json, (int)strlen(json), 0);
+}
+
+static bool last_alert_contains(const char *text) {
+    const FakeMqttMessage *m = fake_mqtt_last("/alert");
+    return m && strstr(m->data, text) != NULL;
+}
+
+/**
+ * @brief 推进模拟时钟并触发到期的定时器
+ */
+static void advance_ms(uint32_t ms) {
+    host_clock_advance_ms(ms);
+    host_timer_run_due();
+}
+
+static void test_no_restart(void) {
+    // 校验失败：不保存、不重启
+    send_fan_config("{\"fans\":[{\"gpio\":36}],\"restart\":true}");
+    CHECK(last_alert_contains("未保存"));
+    advance_ms(RESTART_DELAY_MS * 4);
+    CHECK_EQ(host_restart_count(), 0);
+
+    // 未要求重启：保存后等下次重启生效
+    send_fan_config("{\"fans\":[" FAN_JSON "]}");
+    CHECK(last_alert_contains("重启后生效"));
+    CHECK_EQ(fake_fan_config_saved_count(), 1);
+    advance_ms(RESTART_DELAY_MS * 4);
+    CHECK_EQ(host_restart_count(), 0);
+}
+
+static void test_deferred_restart(void) {
+    // 处理函数返回时告警已发出、尚未重启
+    send_fan_config("{\"fans\":[" FAN_JSON "," FAN_JSON "],\"restart\":true}");
+    CHECK(last_alert_contains("即将重启"));
+    CHECK_EQ(fake_fan_config_saved_count(), 2);
+    CHECK_EQ(host_restart_count(), 0);
+
+    // 等待期间重复的命令：仍报告即将重启，只重启一次
+    advance_ms(RESTART_DELAY_MS / 2);
+    send_fan_config("{\"fans\":[" FAN_JSON "," FAN_JSON "],\"restart\":true}");
+    CHECK(last_alert_contains("即将重启"));
+    CHECK_EQ(host_restart_count(), 0);
+
+    advance_ms(RESTART_DELAY_MS / 2 - 1);
+    CHECK_EQ(host_restart_count(), 0);
+    advance_ms(1);
+    CHECK_EQ(host_restart_count(), 1);
+    advance_ms(RESTART_DELAY_MS * 4);
+    CHECK_EQ(host_restart_count(), 1);
+}
+
+int main(void) {
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+
+    test_no_restart();
+    test_deferred_restart();
+    return test_result();
+}
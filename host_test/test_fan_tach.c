@@ -0,0 +1,158 @@
+/**
+ * @file test_fan_tach.c
+ * @brief fan_tach.c 主机测试 - 以 fan_tach_mock.c 模拟转速计，验证转速闭环收敛、
+ *        转速不足与堵转告警（告警只报一次、稳定期内不判故障、恢复后清除）
+ *
+ * fan_control 由本文件的假实现代替：档位与目标转速由测试设置，set_pwm 直接改变模拟风扇的占空比。
+ * 模拟风扇转速 = 6000 rpm × 占空比/255 × gain，时间常数 1.5 s（见 fan_tach_mock.c）。
+ */
+
+#include "fan_tach.h"
+#include "fan_tach_hal.h"
+#include "fan_control.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define TARGET_LOW_RPM   3000
+#define TARGET_HIGH_RPM  5000
+
+static const FanConfig s_cfg[2] = {
+    // gpio ch min max low  high n_low n_high tach ppr  rpm: low high n_low n_high
+    {  36,  0, 60, 255, 180, 255, 150,  200,   4,   2,  TARGET_LOW_RPM, TARGET_HIGH_RPM, 2000, 4000 },
+    {  37,  1, 60, 255, 180, 255, 150,  200,   FAN_TACH_GPIO_NONE, 2, 0, 0, 0, 0 },
+};
+static FanState s_state[2];
+static uint8_t s_pwm[2];
+
+uint8_t fan_control_get_count(void) { return 2; }
+const FanConfig *fan_control_get_config(FanId id) { return id < 2 ? &s_cfg[id] : NULL; }
+FanState fan_control_get_state(FanId id) { return s_state[id]; }
+uint8_t fan_control_get_pwm(FanId id) { return s_pwm[id]; }
+
+uint16_t fan_control_get_target_rpm(FanId id) {
+    switch (s_state[id]) {
+        case FAN_LOW:  return s_cfg[id].low_rpm;
+        case FAN_HIGH: return s_cfg[id].high_rpm;
+        default:       return 0;
+    }
+}
+
+esp_err_t fan_control_set_pwm(FanId id, uint8_t duty) {
+    s_pwm[id] = duty;
+    return ESP_OK;
+}
+
+/**
+ * @brief 切换档位（与 fan_control_set_state 相同：先按开环占空比输出，闭环由 fan_tach 接管）
+ */
+static void set_state(FanState state) {
+    s_state[0] = state;
+    s_pwm[0] = state == FAN_HIGH ? s_cfg[0].high_duty : state == FAN_LOW ? s_cfg[0].low_duty : 0;
+}
+
+/**
+ * @brief 以 1 秒为周期运行 seconds 秒（每 100 ms 调用一次，与主循环相同）
+ * @return 期间产生的告警位掩码（累计）与次数
+ */
+static uint32_t run(int seconds, int *alarm_events) {
+    uint32_t alarms = 0;
+    for (int i = 0; i < seconds * 10; i++) {
+        uint32_t a = fan_tach_update(100);
+        if (a && alarm_events) {
+            (*alarm_events)++;
+        }
+        alarms |= a;
+    }
+    return alarms;
+}
+
+/**
+ * @brief 运行直到 Fan0 产生告警
+ * @return 告警出现在第几秒（1 起），max_seconds 内没有告警返回 -1
+ */
+static int seconds_until_alarm(int max_seconds) {
+    for (int s = 1; s <= max_seconds; s++) {
+        if (run(1, NULL) & (1u << 0)) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+static bool rpm_near(uint16_t rpm, uint16_t target, float ratio) {
+    return abs((int)rpm - (int)target) <= target * ratio;
+}
+
+int main(void) {
+    CHECK_EQ(fan_tach_init(), ESP_OK);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+    CHECK_EQ(fan_tach_get_health(1), FAN_TACH_NONE);   // 无转速计的风扇不参与
+    CHECK(fan_tach_health_to_string(FAN_TACH_NONE) == NULL);
+
+    // 1. 开环占空比 180 约 4235 rpm，闭环应在 30 秒内把转速拉到 3000 rpm ±5%
+    set_state(FAN_LOW);
+    int events = 0;
+    CHECK_EQ(run(30, &events), 0);
+    CHECK(rpm_near(fan_tach_get_rpm(0), TARGET_LOW_RPM, 0.05f));
+    CHECK(s_pwm[0] < s_cfg[0].low_duty);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+    uint8_t settled_pwm = s_pwm[0];
+
+    // 稳定后保持在死区内，占空比不再抖动
+    CHECK_EQ(run(20, NULL), 0);
+    CHECK(abs((int)s_pwm[0] - (int)settled_pwm) <= 1);
+
+    // 2. 滤网阻力增大（增益 0.7），闭环提高占空比重新收敛
+    fan_tach_mock_set_gain(0, 0.7f);
+    CHECK_EQ(run(40, NULL), 0);
+    CHECK(rpm_near(fan_tach_get_rpm(0), TARGET_LOW_RPM, 0.05f));
+    CHECK(s_pwm[0] > settled_pwm);
+
+    // 3. 切换到 HIGH：目标 5000 rpm 在增益 0.7 下无法达到（满占空比约 4200 rpm，仍高于 75%），
+    //    占空比饱和但不告警
+    set_state(FAN_HIGH);
+    CHECK_EQ(run(30, NULL), 0);
+    CHECK_EQ(s_pwm[0], s_cfg[0].max_duty);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+
+    // 4. 增益降到 0.5（满占空比约 3000 rpm < 75% × 5000）：连续 5 个窗口后告警转速不足，只报一次
+    fan_tach_mock_set_gain(0, 0.5f);
+    int underspeed_at = seconds_until_alarm(20);
+    CHECK(underspeed_at >= 5 && underspeed_at <= 7);      // 惯性下降约 1 秒 + 5 个窗口
+    events = 0;
+    CHECK_EQ(run(10, &events), 0);
+    CHECK_EQ(events, 0);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_UNDERSPEED);
+
+    fan_tach_mock_set_gain(0, 1.0f);
+    CHECK_EQ(run(10, NULL), 0);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+
+    // 5. 堵转：连续 3 个窗口低于 300 rpm 后告警，只报一次
+    fan_tach_mock_set_stalled(0, true);
+    CHECK_EQ(seconds_until_alarm(10), 3);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_STALL);
+    CHECK_EQ(fan_tach_get_rpm(0), 0);
+    uint8_t stalled_pwm = s_pwm[0];
+    events = 0;
+    CHECK_EQ(run(10, &events), 0);
+    CHECK_EQ(events, 0);
+    CHECK_EQ(s_pwm[0], stalled_pwm);                    // 堵转时不调速
+
+    // 关闭风扇清除告警；恢复后重新开启，稳定期（5 秒）内不判故障
+    fan_tach_mock_set_stalled(0, false);
+    set_state(FAN_OFF);
+    CHECK_EQ(run(2, NULL), 0);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+
+    fan_tach_mock_set_stalled(0, true);
+    set_state(FAN_LOW);
+    // 第 1 个窗口发现档位变化，第 6 个窗口稳定期满，再连续 3 个窗口（第 6~8 秒）堵转后告警
+    CHECK_EQ(seconds_until_alarm(20), 8);
+    fan_tach_mock_set_stalled(0, false);
+    CHECK_EQ(run(30, NULL), 0);
+    CHECK_EQ(fan_tach_get_health(0), FAN_TACH_OK);
+    CHECK(rpm_near(fan_tach_get_rpm(0), TARGET_LOW_RPM, 0.05f));
+
+    return test_result();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file test_lease_failover.c
+ * @brief 远程租约到期回退测试 - 租约到期后一个决策周期内从 MODE_REMOTE 切换到 MODE_LOCAL
+ *
+ * 命令经假 esp-mqtt 投递到 mqtt_wrapper.c 的事件处理函数（与设备收到命令的路径相同），
+ * 决策周期按 main.c 控制任务的顺序执行：mqtt_get_remote_lease → decision_detect_mode →
+ * mqtt_get_remote_command → decision_make，周期 1 秒，时间由模拟时钟推进。
+ */
+
+#include "mqtt_wrapper.h"
+#include "decision_engine.h"
+#include "local_mode.h"
+#include "runtime_config.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "test_util.h"
+#include <string.h>
+
+#define CYCLE_MS      1000
+#define FAN_COUNT     3
+#define COMMAND_TOPIC "home/ventilation/esp32_020000000001/command"
+
+typedef struct {
+    SystemMode mode;
+    ModeReason reason;
+    FanState fans[FAN_COUNT];
+} Cycle;
+
+static SensorData s_sensor = { .valid = true, .pollutants = { .co2 = 1100.0f } };
+static FanState s_fans[FAN_COUNT];
+
+/**
+ * @brief 执行一个决策周期（与 main.c 控制任务相同的调用顺序）
+ * @param gap_ms 查询租约与取远程命令之间经过的时间（模拟两次查询之间租约到期）
+ */
+static Cycle decision_cycle(uint32_t gap_ms) {
+    Cycle c;
+    FanState remote_cmd[FAN_MAX_COUNT] = {FAN_OFF};
+    FanState new_states[FAN_MAX_COUNT];
+
+    RemoteLease lease = mqtt_get_remote_lease(NULL);
+    c.mode = decision_detect_mode(true, lease, true, &c.reason);
+    host_clock_advance_ms(gap_ms);
+    if (c.mode == MODE_REMOTE && !mqtt_get_remote_command(remote_cmd, FAN_COUNT)) {
+        memcpy(new_states, s_fans, sizeof(s_fans));   // 租约刚好到期：保持当前状态，下周期切换
+    } else {
+        decision_make(&s_sensor, remote_cmd, FAN_COUNT, c.mode, new_states);
+    }
+    memcpy(s_fans, new_states, sizeof(s_fans));
+    memcpy(c.fans, s_fans, sizeof(s_fans));
+    return c;
+}
+
+static void send_command(const char *json) {
+    fake_mqtt_deliver(COMMAND_TOPIC, json, (int)strlen(json), 0);
+}
+
+/**
+ * @brief 运行决策周期直到切换为本地模式
+ * @return 租约到期时刻到切换所在周期开始的时间（毫秒），max_cycles 内未切换返回 -1
+ */
+static int64_t ms_until_local(int64_t expire_us, int max_cycles, uint32_t gap_ms, Cycle *last) {
+    for (int i = 0; i < max_cycles; i++) {
+        host_clock_advance_ms(CYCLE_MS - gap_ms);
+        int64_t start_us = host_clock_now_us();
+        *last = decision_cycle(gap_ms);
+        if (last->mode == MODE_LOCAL) {
+            return (start_us - expire_us) / 1000;
+        }
+    }
+    return -1;
+}
+
+int main(void) {
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+    CHECK(fake_mqtt_subscribed("home/ventilation/esp32_020000000001/command/#"));
+
+    // 无命令：本地模式（原因 NO_LEASE）
+    Cycle c = decision_cycle(0);
+    CHECK_EQ(c.mode, MODE_LOCAL);
+    CHECK_EQ(c.reason, MODE_REASON_NO_LEASE);
+
+    // 1. 命令带 ttl=30，在周期相位 0~999 ms 的不同时刻到达：切换始终发生在到期后的第一个周期
+    static const uint32_t phases_ms[] = {0, 1, 250, 500, 999};
+    int64_t worst_ms = 0;
+    for (size_t p = 0; p < sizeof(phases_ms) / sizeof(phases_ms[0]); p++) {
+        host_clock_advance_ms(phases_ms[p]);
+        send_command("{\"fan_0\":\"HIGH\",\"fan_1\":\"LOW\",\"fan_2\":\"OFF\",\"ttl\":30}");
+        int64_t expire_us;
+        CHECK_EQ(mqtt_get_remote_lease(&expire_us), LEASE_VALID);
+        CHECK_EQ(expire_us, host_clock_now_us() + 30 * 1000000LL);
+
+        host_clock_advance_ms(CYCLE_MS - phases_ms[p]);
+        c = decision_cycle(0);
+        CHECK_EQ(c.mode, MODE_REMOTE);
+        CHECK_EQ(c.reason, MODE_REASON_LEASE);
+        CHECK_EQ(c.fans[0], FAN_HIGH);
+        CHECK_EQ(c.fans[1], FAN_LOW);
+        CHECK_EQ(c.fans[2], FAN_OFF);
+
+        int64_t late_ms = ms_until_local(expire_us, 40, 0, &c);
+        CHECK(late_ms >= 0 && late_ms < CYCLE_MS);
+        CHECK_EQ(c.reason, MODE_REASON_LEASE_EXPIRED);
+        FanState local = local_mode_decide(s_sensor.pollutants.co2);
+        CHECK_EQ(c.fans[0], local);
+        CHECK_EQ(c.fans[2], local);
+        if (late_ms > worst_ms) {
+            worst_ms = late_ms;
+        }
+    }
+    fprintf(stderr, "租约到期到切换本地模式最长 %lld ms（周期 %d ms）\n", (long long)worst_ms, CYCLE_MS);
+
+    // 2. 租约在查询租约与取命令之间到期：本周期保持原状态，下一周期切换，仍在一个周期内
+    send_command("{\"fan_0\":\"HIGH\",\"ttl\":5}");
+    int64_t expire_us;
+    mqtt_get_remote_lease(&expire_us);
+    host_clock_advance_ms(CYCLE_MS);
+    CHECK_EQ(decision_cycle(0).fans[0], FAN_HIGH);
+    int64_t until_expire_ms = (expire_us - host_clock_now_us()) / 1000;
+    host_clock_advance_ms((uint32_t)until_expire_ms - 1);
+    c = decision_cycle(2);                                   // 查询时仍有效，取命令时已到期
+    CHECK_EQ(c.mode, MODE_REMOTE);
+    CHECK_EQ(c.fans[0], FAN_HIGH);                          // 保持
+    int64_t late_ms = ms_until_local(expire_us, 2, 2, &c);
+    CHECK(late_ms >= 0 && late_ms < CYCLE_MS);
+    CHECK_EQ(c.reason, MODE_REASON_LEASE_EXPIRED);
+
+    // 3. 到期前续租：不切换；ttl=0 释放：下一周期即切换
+    send_command("{\"fan_0\":\"LOW\",\"ttl\":10}");
+    for (int i = 0; i < 8; i++) {
+        host_clock_advance_ms(CYCLE_MS);
+        CHECK_EQ(decision_cycle(0).mode, MODE_REMOTE);
+    }
+    send_command("{\"ttl\":10}");
+    for (int i = 0; i < 8; i++) {
+        host_clock_advance_ms(CYCLE_MS);
+        c = decision_cycle(0);
+        CHECK_EQ(c.mode, MODE_REMOTE);
+        CHECK_EQ(c.fans[0], FAN_LOW);                       // 只续租的命令沿用上一条风扇命令
+    }
+    send_command("{\"ttl\":0}");
+    host_clock_advance_ms(CYCLE_MS);
+    c = decision_cycle(0);
+    CHECK_EQ(c.mode, MODE_LOCAL);
+    CHECK_EQ(c.reason, MODE_REASON_LEASE_EXPIRED);
+
+    // 4. 断线不影响租约：仍执行最后一条命令直至到期，到期后一个周期内回退
+    send_command("{\"fan_0\":\"HIGH\",\"ttl\":20}");
+    mqtt_get_remote_lease(&expire_us);
+    fake_mqtt_disconnect();
+    host_clock_advance_ms(CYCLE_MS);
+    CHECK_EQ(decision_cycle(0).mode, MODE_REMOTE);
+    late_ms = ms_until_local(expire_us, 30, 0, &c);
+    CHECK(late_ms >= 0 && late_ms < CYCLE_MS);
+
+    return test_result();
+}
@@ -0,0 +1,187 @@
+/**
+ * @file test_occupancy_habit.c
+ * @brief 作息提示测试 - 真实的 occupancy_habit.c 与 decision_engine.c，墙上时间由测试设定
+ *
+ * time() 经 --wrap 替换为测试时钟（UTC），导入作息桶后在指定时刻检查：
+ *   - 提示恰好在桶边界前 HABIT_LEAD_MIN 分钟出现、到达边界时消失，星期六 23 点跨到星期日 0 点同样成立
+ *   - 提前停止只在 CO2 低于低阈值时撤掉预测 / 预通风带来的额外通风，不覆盖阈值决策
+ */
+
+#include "decision_engine.h"
+#include "occupancy_habit.h"
+#include "co2_predictor.h"
+#include "runtime_config.h"
+#include "vent_ident.h"
+#include "esp_log.h"
+#include "fake_nvs.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FAN_COUNT   3
+#define SUNDAY      0
+#define MONDAY      1
+#define SATURDAY    6
+#define MONDAY_0000 1704067200   // 2024-01-01 00:00:00 UTC（星期一）
+
+static time_t s_now = 0;
+
+time_t __wrap_time(time_t *out) {
+    if (out) {
+        *out = s_now;
+    }
+    return s_now;
+}
+
+// 固件依赖的替身：阈值取编译期默认值，预测器使用模型默认衰减率
+static const RuntimeConfig s_config = {
+    .co2_low = CO2_THRESHOLD_LOW,
+    .co2_high = CO2_THRESHOLD_HIGH,
+    .co2_min_valid = CO2_MIN_VALID,
+    .co2_max_valid = CO2_MAX_VALID,
+};
+const RuntimeConfig *runtime_config_get(void) { return &s_config; }
+float vent_ident_get_infiltration(void) { return PREDICT_DECAY_INFILTRATION; }
+float vent_ident_get_fan_decay(FanId id, FanState level) {
+    return level == FAN_HIGH ? PREDICT_DECAY_FAN_HIGH : level == FAN_LOW ? PREDICT_DECAY_FAN_LOW : 0.0f;
+}
+bool is_time_valid(void) { return s_now >= TIME_VALID_EPOCH; }  // 同 main.c
+
+static void set_time(int hour, int min, int sec) {
+    s_now = MONDAY_0000 + hour * 3600 + min * 60 + sec;
+}
+
+/**
+ * @brief 设定为同一周（星期一起）的星期 day 的 hour:min:sec
+ */
+static void set_day_time(int day, int hour, int min, int sec) {
+    int days_after_monday = (day + 6) % 7;
+    s_now = MONDAY_0000 + days_after_monday * 86400 + hour * 3600 + min * 60 + sec;
+}
+
+/**
+ * @brief 星期一：7 点通常无人，8 点通常有人，9 点起通常无人（每桶观测满 HABIT_MIN_OBS）
+ */
+static void import_monday(void) {
+    HabitBin day[24];
+    memset(day, 0, sizeof(day));
+    for (int h = 0; h < 24; h++) {
+        day[h].observed = HABIT_MIN_OBS;
+    }
+    day[8].occupied = HABIT_MIN_OBS;
+    CHECK_EQ(occupancy_habit_import_day(MONDAY, day), ESP_OK);
+}
+
+static FanState decide(float co2) {
+    SensorData sensor = { .valid = true, .pollutants = { .co2 = co2 } };
+    FanState out[FAN_MAX_COUNT];
+    decision_make(&sensor, NULL, FAN_COUNT, MODE_LOCAL, out);
+    return out[0];
+}
+
+/**
+ * @brief 以每分钟 slope ppm 的上升喂入 minutes 分钟的 1Hz 样本（风扇关闭），最后读数为 end_co2
+ */
+static void feed_rising(float end_co2, float slope, int minutes) {
+    static const FanState off[FAN_MAX_COUNT] = {FAN_OFF};
+    co2_predictor_reset();
+    for (int s = -minutes * 60 + 1; s <= 0; s++) {
+        co2_predictor_add_sample(end_co2 + slope * (float)s / 60.0f, off, FAN_COUNT);
+    }
+}
+
+/**
+ * @brief 星期六 23 点通常无人，星期日 0 点通常有人、1 点起通常无人
+ */
+static void import_weekend(void) {
+    HabitBin day[24];
+    memset(day, 0, sizeof(day));
+    for (int h = 0; h < 24; h++) {
+        day[h].observed = HABIT_MIN_OBS;
+    }
+    CHECK_EQ(occupancy_habit_import_day(SATURDAY, day), ESP_OK);
+    day[0].occupied = HABIT_MIN_OBS;
+    CHECK_EQ(occupancy_habit_import_day(SUNDAY, day), ESP_OK);
+}
+
+static void test_hour_boundaries(void) {
+    // 提前量窗口从下一个桶边界前 HABIT_LEAD_MIN 分钟整开始，到边界为止
+    set_time(7, 29, 59);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+    set_time(7, 30, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_PRESTART);
+    set_time(7, 59, 59);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_PRESTART);
+    set_time(8, 0, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+
+    set_time(8, 29, 59);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+    set_time(8, 30, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_EARLY_STOP);
+    set_time(8, 59, 59);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_EARLY_STOP);
+    set_time(9, 0, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+
+    // 时间未同步时没有提示
+    s_now = 1000;
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+}
+
+static void test_week_wrap(void) {
+    // 星期六 23 点的提前量落到星期日 0 点（桶 167 → 桶 0）
+    set_day_time(SATURDAY, 23, 29, 59);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+    set_day_time(SATURDAY, 23, 30, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_PRESTART);
+    set_day_time(SUNDAY, 0, 0, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+    set_day_time(SUNDAY, 0, 30, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_EARLY_STOP);
+}
+
+static void test_early_stop_keeps_threshold(void) {
+    co2_predictor_reset();
+    set_time(8, 40, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_EARLY_STOP);
+
+    // 阈值决策不被覆盖：超过低阈值仍 LOW，超过高阈值仍 HIGH
+    CHECK_EQ(decide(CO2_THRESHOLD_LOW + 50.0f), FAN_LOW);
+    CHECK_EQ(decide(CO2_THRESHOLD_HIGH + 50.0f), FAN_HIGH);
+    CHECK_EQ(decide(CO2_THRESHOLD_LOW - 100.0f), FAN_OFF);
+
+    // 低于低阈值时预测要求的提前通风被撤掉；没有作息提示时预测照常生效
+    feed_rising(CO2_THRESHOLD_LOW - 60.0f, 20.0f, 10);
+    CHECK_EQ(decide(CO2_THRESHOLD_LOW - 60.0f), FAN_OFF);
+    set_time(10, 0, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_NONE);
+    feed_rising(CO2_THRESHOLD_LOW - 60.0f, 20.0f, 10);
+    CHECK(decide(CO2_THRESHOLD_LOW - 60.0f) != FAN_OFF);
+    co2_predictor_reset();
+}
+
+static void test_prestart(void) {
+    co2_predictor_reset();
+    set_time(7, 40, 0);
+    CHECK_EQ(occupancy_habit_get_hint(), HABIT_HINT_PRESTART);
+    CHECK_EQ(decide(CO2_THRESHOLD_LOW - 100.0f), FAN_LOW);
+    CHECK_EQ(decide(CO2_THRESHOLD_HIGH + 50.0f), FAN_HIGH);
+}
+
+int main(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(occupancy_habit_init(), ESP_OK);
+    import_monday();
+    import_weekend();
+
+    test_hour_boundaries();
+    test_week_wrap();
+    test_early_stop_keeps_threshold();
+    test_prestart();
+    return test_result();
+}
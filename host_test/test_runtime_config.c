@@ -0,0 +1,130 @@
+/**
+ * @file test_runtime_config.c
+ * @brief 运行时配置测试 - 配置文档与回滚命令经假 esp-mqtt 投递到本设备 config 主题
+ *
+ * 版本号必须是 1 ~ UINT32_MAX 的整数，其他值（越界、小数、负数、字符串）返回 INVALID，field 为 "version"。
+ *
+ * 模拟保留消息：Broker 在每次重连后把保留的配置文档再投递一次。回滚到上一版本后，
+ * 重发的被撤下版本（以及不高于它的版本）必须返回 STALE，重启后也一样；
+ * 同一条回滚命令重复投递不改变配置。
+ */
+
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "esp_log.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "test_util.h"
+#include <string.h>
+
+#define CONFIG_TOPIC "home/ventilation/esp32_020000000001/config"
+#define GRACE_MS     6000     // 大于 RCFG_GRACE_MS
+
+/**
+ * @brief 投递一条配置主题消息，等待切换后返回 config/state 中的 result
+ */
+static const char *send_config(const char *json) {
+    fake_mqtt_clear();
+    fake_mqtt_deliver(CONFIG_TOPIC, json, (int)strlen(json), 0);
+    host_clock_advance_ms(GRACE_MS);
+    runtime_config_update();
+    const FakeMqttMessage *m = fake_mqtt_last("/config/state");
+    if (!m) {
+        return "NONE";
+    }
+    static const char *const results[] = {"ACCEPTED", "STALE", "INVALID", "STORAGE_ERROR", "ROLLED_BACK"};
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
+        char needle[32];
+        snprintf(needle, sizeof(needle), "\"result\":\"%s\"", results[i]);
+        if (strstr(m->data, needle)) {
+            return results[i];
+        }
+    }
+    return "UNKNOWN";
+}
+
+static bool state_has(const char *text) {
+    const FakeMqttMessage *m = fake_mqtt_last("/config/state");
+    return m && strstr(m->data, text);
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+
+    // 0. 版本号校验
+    static const char *const bad_versions[] = {
+        "{\"co2_low\":900}",
+        "{\"version\":0}",
+        "{\"version\":-1}",
+        "{\"version\":2.5}",
+        "{\"version\":4294967296}",
+        "{\"version\":1e300}",
+        "{\"version\":\"3\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad_versions) / sizeof(bad_versions[0]); i++) {
+        CHECK(strcmp(send_config(bad_versions[i]), "INVALID") == 0);
+        CHECK(state_has("\"field\":\"version\""));
+        CHECK(state_has("\"requested\":0"));
+    }
+    CHECK_EQ(runtime_config_get()->version, 0);
+    CHECK(strcmp(send_config("{\"version\":4294967295,\"co2_low\":900}"), "ACCEPTED") == 0);
+    CHECK_EQ(runtime_config_get()->version, 4294967295u);
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+
+    const char *v1 = "{\"version\":1,\"co2_low\":900}";
+    const char *v2 = "{\"version\":2,\"co2_low\":950}";
+    CHECK(strcmp(send_config(v1), "ACCEPTED") == 0);
+    CHECK(strcmp(send_config(v2), "ACCEPTED") == 0);
+    CHECK_EQ(runtime_config_get()->version, 2);
+
+    // 1. 回滚目标必须是上一版本
+    CHECK(strcmp(send_config("{\"rollback\":2}"), "INVALID") == 0);
+    CHECK(strcmp(send_config("{\"rollback\":5}"), "INVALID") == 0);
+    CHECK(strcmp(send_config("{\"rollback\":true}"), "INVALID") == 0);
+    CHECK(state_has("\"field\":\"rollback\""));
+    CHECK(strcmp(send_config("{\"rollback\":1.5}"), "INVALID") == 0);
+    CHECK(strcmp(send_config("{\"rollback\":4294967297}"), "INVALID") == 0);
+    CHECK(state_has("\"field\":\"rollback\""));
+    CHECK_EQ(runtime_config_get()->version, 2);
+
+    // 2. 回滚到 v1，被撤下的 v2 记为下限
+    CHECK(strcmp(send_config("{\"rollback\":1}"), "ROLLED_BACK") == 0);
+    CHECK_EQ(runtime_config_get()->version, 1);
+    CHECK_EQ((int)runtime_config_get()->co2_low, 900);
+    CHECK_EQ(runtime_config_get_version_floor(), 2);
+    CHECK(state_has("\"min_version\":2"));
+
+    // 3. 重复投递的回滚命令不改变配置
+    CHECK(strcmp(send_config("{\"rollback\":1}"), "ROLLED_BACK") == 0);
+    CHECK_EQ(runtime_config_get()->version, 1);
+
+    // 4. 重连后 Broker 重发保留的 v2：过期
+    fake_mqtt_disconnect();
+    fake_mqtt_connect();
+    CHECK(strcmp(send_config(v2), "STALE") == 0);
+    CHECK_EQ(runtime_config_get()->version, 1);
+
+    // 5. 重启后下限仍有效
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(runtime_config_get()->version, 1);
+    CHECK_EQ(runtime_config_get_version_floor(), 2);
+    CHECK(strcmp(send_config(v2), "STALE") == 0);
+    CHECK(strcmp(send_config("{\"rollback\":1}"), "ROLLED_BACK") == 0);
+    CHECK_EQ(runtime_config_get()->version, 1);
+
+    // 6. 高于下限的新版本照常生效，之后可以再回滚到 v1
+    CHECK(strcmp(send_config("{\"version\":3,\"co2_low\":980}"), "ACCEPTED") == 0);
+    CHECK_EQ(runtime_config_get()->version, 3);
+    CHECK(strcmp(send_config("{\"rollback\":1}"), "ROLLED_BACK") == 0);
+    CHECK_EQ(runtime_config_get()->version, 1);
+    CHECK_EQ(runtime_config_get_version_floor(), 3);
+    CHECK(strcmp(send_config("{\"version\":3,\"co2_low\":980}"), "STALE") == 0);
+
+    return test_result();
+}
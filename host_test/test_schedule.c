@@ -0,0 +1,133 @@
+/**
+ * @file test_schedule.c
+ * @brief 分时段调度测试 - 真实的 schedule.c，墙上时间由测试设定
+ *
+ * time() 经 --wrap 替换为测试时钟（UTC），localtime_r() 经 --wrap 计数：
+ * 决策任务每秒调用一次 schedule_update()，只有每天 0 点（或时段表变化、时间首次同步）
+ * 预计算时做一次时区换算，常规路径只比较时间。
+ * 时段起止相同（空时段还是全天有歧义）被拒绝，全天写作 0 ~ 1440。
+ */
+
+#include "schedule.h"
+#include "esp_log.h"
+#include "fake_nvs.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define MONDAY_0000 1704067200   // 2024-01-01 00:00:00 UTC（星期一）
+
+static time_t s_now = 0;
+static int s_localtime_calls = 0;
+
+time_t __wrap_time(time_t *out) {
+    if (out) {
+        *out = s_now;
+    }
+    return s_now;
+}
+
+struct tm *__real_localtime_r(const time_t *t, struct tm *out);
+struct tm *__wrap_localtime_r(const time_t *t, struct tm *out) {
+    s_localtime_calls++;
+    return __real_localtime_r(t, out);
+}
+
+static ScheduleState state_now(void) {
+    ScheduleState st;
+    schedule_get_state(&st);
+    return st;
+}
+
+/**
+ * @brief 每秒调用一次 schedule_update()，共 seconds 秒
+ * @return 期间返回 true（跨过时段边界）的次数
+ */
+static int run_seconds(int seconds) {
+    int changes = 0;
+    for (int i = 0; i < seconds; i++) {
+        s_now++;
+        changes += schedule_update() ? 1 : 0;
+    }
+    return changes;
+}
+
+static void test_unsynced(void) {
+    s_now = 1000;   // SNTP 同步前（1970 年）
+    CHECK(!schedule_update());
+    CHECK(!state_now().quiet);
+    CHECK_EQ(s_localtime_calls, 0);
+}
+
+static void test_default_quiet_window(void) {
+    // 默认时段表：每天 22:00-08:00 静音
+    s_now = MONDAY_0000 + 21 * 3600;
+    s_localtime_calls = 0;
+    CHECK(!schedule_update());
+    CHECK_EQ(s_localtime_calls, 1);            // 时间首次同步：预计算当天
+    CHECK(!state_now().quiet);
+
+    CHECK_EQ(run_seconds(3600 - 1), 0);       // 21:00:01 ~ 21:59:59
+    CHECK(!state_now().quiet);
+    CHECK_EQ(run_seconds(1), 1);               // 22:00:00 进入静音
+    CHECK(state_now().quiet);
+    CHECK_EQ(s_localtime_calls, 1);            // 常规路径不做时区换算
+
+    CHECK_EQ(run_seconds(2 * 3600), 0);        // 跨过午夜：重新预计算次日，仍静音
+    CHECK(state_now().quiet);
+    CHECK_EQ(s_localtime_calls, 2);
+    CHECK_EQ(run_seconds(8 * 3600), 1);        // 次日 08:00 退出静音
+    CHECK(!state_now().quiet);
+    CHECK_EQ(s_localtime_calls, 2);
+}
+
+static void test_period_bounds(void) {
+    SchedulePeriod p = {.days = SCHEDULE_ALL_DAYS, .type = SCHED_DISABLED, .max_level = FAN_HIGH};
+
+    p.start_min = 8 * 60;
+    p.end_min = 8 * 60;
+    CHECK_EQ(schedule_set_periods(&p, 1), ESP_ERR_INVALID_ARG);
+    p.start_min = 0;
+    p.end_min = 0;
+    CHECK_EQ(schedule_set_periods(&p, 1), ESP_ERR_INVALID_ARG);
+    p.end_min = 1441;
+    CHECK_EQ(schedule_set_periods(&p, 1), ESP_ERR_INVALID_ARG);
+    p.start_min = 1440;
+    p.end_min = 60;
+    CHECK_EQ(schedule_set_periods(&p, 1), ESP_ERR_INVALID_ARG);
+
+    // 全天禁用：0 ~ 24:00，一整天（含午夜前后）都为 OFF
+    p.start_min = 0;
+    p.end_min = 1440;
+    CHECK_EQ(schedule_set_periods(&p, 1), ESP_OK);
+    s_now = MONDAY_0000 + 7 * 86400 + 12 * 3600;
+    schedule_update();
+    CHECK_EQ(state_now().max_level, FAN_OFF);
+    for (int h = 0; h < 24; h++) {
+        run_seconds(3600);
+        CHECK_EQ(state_now().max_level, FAN_OFF);
+    }
+
+    // 工作日 18:00 ~ 24:00 限 LOW：午夜解除
+    SchedulePeriod evening = {.days = 0x3E, .type = SCHED_CAP, .max_level = FAN_LOW,
+                              .start_min = 18 * 60, .end_min = 1440};
+    CHECK_EQ(schedule_set_periods(&evening, 1), ESP_OK);
+    s_now = MONDAY_0000 + 7 * 86400 + 23 * 3600 + 59 * 60;   // 星期一 23:59
+    schedule_update();
+    CHECK_EQ(state_now().max_level, FAN_LOW);
+    run_seconds(60);
+    CHECK_EQ(state_now().max_level, FAN_HIGH);
+}
+
+int main(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(schedule_init(), ESP_OK);
+
+    test_unsynced();
+    test_default_quiet_window();
+    test_period_bounds();
+    return test_result();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_shadow_desired.c
+ * @brief 影子 desired 重放测试 - 旧版本与已过期的文档不被执行
+ *
+ * desired 文档经假 esp-mqtt 投递到 mqtt_wrapper.c（保留消息，重连后 Broker 会重发）：
+ *   - 已执行的版本重发、比已执行版本旧的文档不续租
+ *   - 时间已同步时，"expires" 已过的文档只登记版本不执行，之后也不会再被重放；
+ *     未过期的文档租约不超过剩余时间
+ *   - 时间未同步时无法判断 "expires"，按 ttl 执行
+ * 租约按模拟时钟计时，"expires" 按主机墙上时间（gettimeofday）判断。
+ */
+
+#include "mqtt_wrapper.h"
+#include "runtime_config.h"
+#include "fake_firmware.h"
+#include "fake_mqtt.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "test_util.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define FAN_COUNT     3
+#define DESIRED_TOPIC "home/ventilation/esp32_020000000001/shadow/desired"
+
+static void send_desired(uint32_t version, const char *fan0, int ttl, int64_t expires) {
+    char json[160];
+    if (expires > 0) {
+        snprintf(json, sizeof(json), "{\"version\":%lu,\"fan_0\":\"%s\",\"ttl\":%d,\"expires\":%lld}",
+                 (unsigned long)version, fan0, ttl, (long long)expires);
+    } else {
+        snprintf(json, sizeof(json), "{\"version\":%lu,\"fan_0\":\"%s\",\"ttl\":%d}",
+                 (unsigned long)version, fan0, ttl);
+    }
+    fake_mqtt_deliver(DESIRED_TOPIC, json, (int)strlen(json), 0);
+}
+
+static int64_t wall_now(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+/**
+ * @brief 让当前租约到期（之后只有新执行的文档能再次进入远程模式）
+ */
+static void expire_lease(void) {
+    int64_t expire_us;
+    if (mqtt_get_remote_lease(&expire_us) == LEASE_VALID) {
+        host_clock_advance_ms((expire_us - host_clock_now_us()) / 1000 + 1);
+    }
+    CHECK(mqtt_get_remote_lease(NULL) != LEASE_VALID);
+}
+
+static FanState remote_fan0(void) {
+    FanState cmd[FAN_MAX_COUNT] = {FAN_OFF};
+    CHECK(mqtt_get_remote_command(cmd, FAN_COUNT));
+    return cmd[0];
+}
+
+static void test_stale_not_replayed(void) {
+    send_desired(5, "HIGH", 60, 0);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_VALID);
+    CHECK_EQ(remote_fan0(), FAN_HIGH);
+    CHECK_EQ(device_shadow_get_desired_version(), 5);
+    expire_lease();
+
+    // 重连后 Broker 重发同一版本的保留消息：不续租
+    fake_mqtt_disconnect();
+    fake_mqtt_connect();
+    send_desired(5, "HIGH", 60, 0);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_EXPIRED);
+
+    // 比已执行版本旧（例如后端回退前的保留消息）：不执行，已执行版本不变
+    send_desired(4, "LOW", 60, 0);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_EXPIRED);
+    CHECK_EQ(device_shadow_get_desired_version(), 5);
+
+    // 新版本照常执行
+    send_desired(6, "LOW", 60, 0);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_VALID);
+    CHECK_EQ(remote_fan0(), FAN_LOW);
+    expire_lease();
+}
+
+static void test_expired_not_replayed(void) {
+    fake_firmware_set_time_valid(true);
+
+    // 已过期：只登记版本，不执行
+    send_desired(7, "HIGH", 600, wall_now() - 10);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_EXPIRED);
+    CHECK_EQ(device_shadow_get_desired_version(), 7);
+
+    // 重连后同一文档重发：已登记，不会因为时间判断不同而被执行
+    fake_mqtt_disconnect();
+    fake_mqtt_connect();
+    fake_firmware_set_time_valid(false);
+    send_desired(7, "HIGH", 600, wall_now() - 10);
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_EXPIRED);
+    fake_firmware_set_time_valid(true);
+
+    // 未过期：租约不超过剩余时间
+    int64_t start_us = host_clock_now_us();
+    send_desired(8, "HIGH", 600, wall_now() + 20);
+    int64_t expire_us;
+    CHECK_EQ(mqtt_get_remote_lease(&expire_us), LEASE_VALID);
+    CHECK(expire_us - start_us <= 20 * 1000000LL);
+    CHECK(expire_us - start_us >= 18 * 1000000LL);
+    CHECK_EQ(remote_fan0(), FAN_HIGH);
+    expire_lease();
+}
+
+static void test_unsynced_uses_ttl(void) {
+    // 时间未同步：无法判断 "expires"，按 ttl 执行
+    fake_firmware_set_time_valid(false);
+    int64_t start_us = host_clock_now_us();
+    send_desired(9, "LOW", 60, wall_now() - 10);
+    int64_t expire_us;
+    CHECK_EQ(mqtt_get_remote_lease(&expire_us), LEASE_VALID);
+    CHECK_EQ(expire_us - start_us, 60 * 1000000LL);
+    CHECK_EQ(remote_fan0(), FAN_LOW);
+}
+
+int main(void) {
+    fake_nvs_erase_all();
+    CHECK_EQ(runtime_config_init(), ESP_OK);
+    CHECK_EQ(mqtt_client_init(), ESP_OK);
+    fake_mqtt_connect();
+    CHECK(fake_mqtt_subscribed(DESIRED_TOPIC));
+    CHECK_EQ(mqtt_get_remote_lease(NULL), LEASE_NONE);
+
+    test_stale_not_replayed();
+    test_expired_not_replayed();
+    test_unsynced_uses_ttl();
+    return test_result();
+}
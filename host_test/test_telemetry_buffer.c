@@ -0,0 +1,396 @@
+/**
+ * @file test_telemetry_buffer.c
+ * @brief 遥测离线缓存测试 - 1 小时 1Hz 离线样本的缓存、补传顺序、丢弃计数与断电恢复
+ *
+ * Flash 分区为共享内存中的 NOR Flash（fakes/fake_partition.c），每次上电在 fork 出的子进程中运行：
+ * 子进程退出即断电，RAM 缓冲随之丢失，只有 Flash 内容与 NVS 中的补传进度（acked_seq）保留。
+ * Broker 在收到补传消息 ACK_DELAY_MS 后确认（MQTT_EVENT_PUBLISHED），记录每个时间戳收到的次数。
+ */
+
+#include "telemetry_buffer.h"
+#include "fake_partition.h"
+#include "fake_nvs.h"
+#include "host_clock.h"
+#include "nvs.h"
+#include "test_util.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define OUTAGE_SAMPLES      3600               // 断网 1 小时，每秒一条
+#define MAX_SAMPLES         (OUTAGE_SAMPLES + 512)
+#define PARTITION_SIZE      0x40000            // 与 partitions.csv 中 telemetry 分区相同（8192 条）
+#define SMALL_PARTITION     (2 * 4096)         // 最小可用分区：2 个扇区（256 条），用于覆盖淘汰
+#define RECORDS_PER_SECTOR  128
+#define ACK_DELAY_MS        300
+#define ACK_QUEUE           64
+
+/**
+ * @brief 跨上电保留的测试状态（共享内存）
+ */
+typedef struct {
+    uint16_t received[MAX_SAMPLES + 1];   ///< Broker 收到各时间戳的次数
+    uint32_t total;                       ///< 已生成的样本数（时间戳 1..total）
+    uint32_t duplicates;                  ///< 重复收到的样本数
+    uint32_t newest;                      ///< 首次收到的最大时间戳
+    bool order_broken;                    ///< 首次收到的样本不是按时间先后
+    uint32_t nvs_acked;                   ///< NVS 中的补传进度（0 = 未保存）
+    int drain_seconds;                    ///< 最近一次 drain_all 用时
+    TelemetryStats outage;                ///< 离线 1 小时结束时的统计
+    TelemetryStats stats;                 ///< 上一次上电结束（断电）时的统计
+} Shared;
+
+static Shared *s_sh;
+
+// Broker（每次上电重新开始）
+static bool s_connected = false;
+static bool s_hold_acks = false;
+static int s_ack_id[ACK_QUEUE];
+static int64_t s_ack_due[ACK_QUEUE];
+static int s_ack_count = 0;
+static int s_next_msg = 1;
+
+static int broker_send(const TelemetrySample *samples, int count) {
+    if (!s_connected || s_ack_count == ACK_QUEUE) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        uint32_t ts = samples[i].timestamp;
+        CHECK(ts >= 1 && ts <= s_sh->total);
+        if (ts < 1 || ts > MAX_SAMPLES) {
+            continue;
+        }
+        if (s_sh->received[ts]++ > 0) {
+            s_sh->duplicates++;
+        } else {
+            if (ts <= s_sh->newest) {
+                s_sh->order_broken = true;
+            }
+            s_sh->newest = ts;
+        }
+    }
+    s_ack_id[s_ack_count] = s_next_msg;
+    s_ack_due[s_ack_count++] = host_clock_now_us() + ACK_DELAY_MS * 1000;
+    return s_next_msg++;
+}
+
+static void broker_pump(void) {
+    for (int i = 0; i < s_ack_count && !s_hold_acks;) {
+        if (s_ack_due[i] <= host_clock_now_us()) {
+            telemetry_buffer_on_published(s_ack_id[i]);
+            s_ack_count--;
+            s_ack_id[i] = s_ack_id[s_ack_count];
+            s_ack_due[i] = s_ack_due[s_ack_count];
+        } else {
+            i++;
+        }
+    }
+}
+
+static void push_samples(int n) {
+    for (int i = 0; i < n; i++) {
+        TelemetrySample s = {
+            .timestamp = ++s_sh->total,
+            .co2 = 400.0f + (float)(s_sh->total % 800),
+            .fans = (uint16_t)(s_sh->total & 0x3f),
+        };
+        telemetry_buffer_push(&s);
+    }
+}
+
+/**
+ * @brief 推进 1 秒：先缓存 pushes 条样本，在线时补传，之后每 100ms 投递到期的确认
+ */
+static void tick(bool online, int pushes) {
+    if (online != s_connected) {
+        s_connected = online;
+        if (!online) {
+            s_ack_count = 0;
+            telemetry_buffer_on_disconnected();
+        }
+    }
+    push_samples(pushes);
+    if (s_connected) {
+        telemetry_buffer_drain(broker_send, 0);
+    }
+    for (int k = 0; k < 10; k++) {
+        host_clock_advance_ms(100);
+        broker_pump();
+    }
+}
+
+/**
+ * @brief 在线补传直到没有积压
+ */
+static void drain_all(int max_seconds) {
+    int s = 0;
+    while (telemetry_buffer_has_backlog() && s < max_seconds) {
+        tick(true, 0);
+        s++;
+    }
+    CHECK(!telemetry_buffer_has_backlog());
+    s_sh->drain_seconds = s;
+}
+
+static void offline_hour(void) {
+    for (int t = 0; t < OUTAGE_SAMPLES; t++) {
+        tick(false, 1);
+    }
+    telemetry_buffer_get_stats(&s_sh->outage);
+    CHECK_EQ(s_sh->outage.ram_depth + s_sh->outage.flash_depth + s_sh->outage.dropped, OUTAGE_SAMPLES);
+    CHECK_EQ(s_sh->outage.uploaded, 0);
+}
+
+static uint32_t nvs_read_acked(void) {
+    uint32_t acked = 0;
+    nvs_handle_t h;
+    if (nvs_open("telemetry", NVS_READONLY, &h) == ESP_OK) {
+        nvs_get_u32(h, "acked_seq", &acked);
+        nvs_close(h);
+    }
+    return acked;
+}
+
+/**
+ * @brief 一次上电：子进程中初始化缓存并运行 run()，返回即断电
+ * 子进程的 NVS 写入不会回到父进程，断电前把 acked_seq 经共享内存带回，写入父进程的 NVS
+ */
+static void power_cycle(void (*run)(void)) {
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        s_test_failures = 0;                                 // 只报告本次上电中的失败
+        host_clock_reset();
+        CHECK_EQ(telemetry_buffer_init(), ESP_OK);
+        run();
+        telemetry_buffer_get_stats(&s_sh->stats);
+        s_sh->nvs_acked = nvs_read_acked();
+        fflush(stderr);
+        _exit(test_result());
+    }
+    int status = 0;
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    nvs_handle_t h;
+    if (s_sh->nvs_acked > 0 && nvs_open("telemetry", NVS_READWRITE, &h) == ESP_OK) {
+        nvs_set_u32(h, "acked_seq", s_sh->nvs_acked);
+        nvs_commit(h);
+        nvs_close(h);
+    }
+}
+
+static void reset_world(size_t partition_size) {
+    memset(s_sh, 0, sizeof(*s_sh));
+    fake_nvs_erase_all();
+    if (partition_size > 0) {
+        fake_partition_create("telemetry", partition_size);
+    } else {
+        fake_partition_remove();
+    }
+}
+
+/**
+ * @brief 时间戳 from..to 各收到的次数是否都等于 times
+ */
+static bool received_range(uint32_t from, uint32_t to, uint16_t times) {
+    for (uint32_t ts = from; ts <= to; ts++) {
+        if (s_sh->received[ts] != times) {
+            fprintf(stderr, "时间戳 %u 收到 %u 次，期望 %u\n", ts, s_sh->received[ts], times);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---- 1. 实际分区大小：1 小时离线全部保留，恢复后按顺序补传 ----
+
+static void run_hour_then_drain(void) {
+    offline_hour();
+    drain_all(2 * OUTAGE_SAMPLES);
+}
+
+static void test_hour_full_partition(void) {
+    reset_world(PARTITION_SIZE);
+    power_cycle(run_hour_then_drain);
+
+    CHECK_EQ(s_sh->outage.dropped, 0);
+    CHECK(s_sh->outage.ram_depth <= TELEMETRY_RAM_RECORDS);
+    CHECK(received_range(1, OUTAGE_SAMPLES, 1));
+    CHECK(!s_sh->order_broken);
+    CHECK_EQ(s_sh->stats.uploaded, OUTAGE_SAMPLES);
+    CHECK_EQ(s_sh->stats.dropped, 0);
+    CHECK_EQ(s_sh->stats.flash_errors, 0);
+    CHECK_EQ(fake_partition_dirty_writes(), 0);
+    // Flash 记录全部确认后保存进度，下次上电不再重发
+    CHECK_EQ(s_sh->nvs_acked, s_sh->outage.flash_depth + 1);
+    // 每 TELEMETRY_DRAIN_INTERVAL_MS 最多一批、每批最多 TELEMETRY_BATCH_MAX 条
+    int batches = (OUTAGE_SAMPLES + TELEMETRY_BATCH_MAX - 1) / TELEMETRY_BATCH_MAX;
+    CHECK(s_sh->drain_seconds <= batches * TELEMETRY_DRAIN_INTERVAL_MS / 1000 + 2);
+    fprintf(stderr, "离线 %d 条（Flash %u + RAM %u）补传用时 %d 秒\n", OUTAGE_SAMPLES,
+            s_sh->outage.flash_depth, s_sh->outage.ram_depth, s_sh->drain_seconds);
+}
+
+// ---- 2. 小分区：Flash 满后整扇区淘汰最早的记录并计入 dropped，其余按顺序补传 ----
+
+static void test_hour_sector_eviction(void) {
+    reset_world(SMALL_PARTITION);
+    power_cycle(run_hour_then_drain);
+
+    uint32_t dropped = s_sh->outage.dropped;
+    CHECK(dropped > 0);
+    CHECK_EQ(dropped % RECORDS_PER_SECTOR, 0);              // 按扇区淘汰
+    CHECK(s_sh->outage.flash_depth > RECORDS_PER_SECTOR);  // 新扇区写入前只淘汰最早的一个扇区
+    CHECK(s_sh->outage.flash_depth <= SMALL_PARTITION / 32);
+    CHECK(received_range(1, dropped, 0));                    // 丢弃的是最早的样本
+    CHECK(received_range(dropped + 1, OUTAGE_SAMPLES, 1));
+    CHECK(!s_sh->order_broken);
+    CHECK_EQ(s_sh->stats.dropped, dropped);
+    CHECK_EQ(s_sh->stats.uploaded + dropped, OUTAGE_SAMPLES);
+    CHECK_EQ(fake_partition_dirty_writes(), 0);
+}
+
+// ---- 3. 无分区：只有 RAM 缓冲，保留最新的 TELEMETRY_RAM_RECORDS 条 ----
+
+static void test_hour_ram_only(void) {
+    reset_world(0);
+    power_cycle(run_hour_then_drain);
+
+    CHECK_EQ(s_sh->outage.dropped, OUTAGE_SAMPLES - TELEMETRY_RAM_RECORDS);
+    CHECK(received_range(1, OUTAGE_SAMPLES - TELEMETRY_RAM_RECORDS, 0));
+    CHECK(received_range(OUTAGE_SAMPLES - TELEMETRY_RAM_RECORDS + 1, OUTAGE_SAMPLES, 1));
+    CHECK_EQ(s_sh->stats.uploaded, TELEMETRY_RAM_RECORDS);
+}
+
+// ---- 4. 断电恢复：Flash 记录在重启后按 NVS 进度继续补传 ----
+
+static TelemetryStats s_before_reboot;
+
+static void run_check_recovered(void) {
+    TelemetryStats st;
+    telemetry_buffer_get_stats(&st);
+    CHECK_EQ(st.ram_depth, 0);                               // RAM 缓冲随断电丢失
+    // flash_recover 从 acked_seq 起恢复：已确认但未保存进度的记录（不足一个保存间隔）会重发
+    uint32_t expected = s_sh->nvs_acked > 0 ? s_sh->outage.flash_depth - (s_sh->nvs_acked - 1)
+                                            : s_before_reboot.flash_depth;
+    CHECK_EQ(st.flash_depth, expected);
+    CHECK(st.flash_depth >= s_before_reboot.flash_depth);
+    CHECK(st.flash_depth < s_before_reboot.flash_depth + TELEMETRY_ACK_SAVE_RECORDS + TELEMETRY_BATCH_MAX);
+}
+
+static void run_partial_drain(void) {
+    run_check_recovered();
+    for (int t = 0; t < 100; t++) {                          // 约 50 批
+        tick(true, 0);
+    }
+    s_hold_acks = true;                                      // 再发一批，确认到达前断电
+    for (int t = 0; t < 3 && s_ack_count == 0; t++) {
+        tick(true, 0);
+    }
+    CHECK_EQ(s_ack_count, 1);
+}
+
+static void run_recover_and_drain(void) {
+    run_check_recovered();
+    drain_all(2 * OUTAGE_SAMPLES);
+}
+
+static void test_power_loss(void) {
+    reset_world(PARTITION_SIZE);
+    power_cycle(offline_hour);                               // 离线 1 小时后断电
+    s_before_reboot = s_sh->stats;
+    uint32_t flash_records = s_sh->outage.flash_depth;
+    CHECK_EQ(s_before_reboot.flash_depth, flash_records);
+
+    power_cycle(run_partial_drain);                          // 补传一部分后断电
+    s_before_reboot = s_sh->stats;
+    CHECK(s_before_reboot.uploaded >= 40 * TELEMETRY_BATCH_MAX);
+    CHECK(s_sh->nvs_acked > 1);
+    CHECK(s_sh->nvs_acked - 1 <= s_before_reboot.uploaded);
+    // 重发 = 已确认但未保存进度的记录 + 断电时在途的一批
+    uint32_t resend = s_before_reboot.uploaded - (s_sh->nvs_acked - 1) + TELEMETRY_BATCH_MAX;
+
+    power_cycle(run_recover_and_drain);                      // 重启后补完
+    for (uint32_t ts = 1; ts <= flash_records; ts++) {
+        CHECK(s_sh->received[ts] >= 1);                      // Flash 中的记录一条不少
+    }
+    CHECK(received_range(flash_records + 1, OUTAGE_SAMPLES, 0));
+    CHECK(!s_sh->order_broken);
+    CHECK_EQ(s_sh->duplicates, resend);
+    CHECK(resend <= TELEMETRY_ACK_SAVE_RECORDS + 2 * TELEMETRY_BATCH_MAX);
+    CHECK_EQ(s_sh->nvs_acked, flash_records + 1);
+    fprintf(stderr, "断电丢失 RAM 中 %u 条，重启后重发 %u 条\n",
+            OUTAGE_SAMPLES - flash_records, s_sh->duplicates);
+}
+
+// ---- 5. 在途批次的记录被移走或淘汰时作废其确认（cancel_pending） ----
+
+static void run_flash_batch_evicted(void) {
+    offline_hour();
+    s_hold_acks = true;
+    tick(true, 0);                                           // 从 Flash 尾部发出一批，确认暂不到达
+    CHECK_EQ(s_ack_count, 1);
+    uint32_t dropped = s_sh->outage.dropped;
+    tick(true, SMALL_PARTITION / 32);                        // 在线但发布失败：写满一圈，淘汰在途批次所在扇区
+    TelemetryStats st;
+    telemetry_buffer_get_stats(&st);
+    CHECK(st.dropped >= dropped + RECORDS_PER_SECTOR);
+    s_hold_acks = false;                                     // 迟到的确认不得移除新的尾部记录
+    drain_all(2 * OUTAGE_SAMPLES);
+}
+
+static void test_cancel_flash_batch(void) {
+    reset_world(SMALL_PARTITION);
+    power_cycle(run_flash_batch_evicted);
+
+    uint32_t total = s_sh->total;
+    uint32_t dropped = s_sh->stats.dropped;
+    uint32_t first_batch = s_sh->outage.dropped + 1;         // 被作废的那一批（已发出，随后被淘汰）
+    CHECK(received_range(first_batch, first_batch + TELEMETRY_BATCH_MAX - 1, 1));
+    CHECK(received_range(dropped + 1, total, 1));            // 淘汰后剩余的记录全部补传
+    CHECK_EQ(s_sh->stats.uploaded + dropped, total);
+    CHECK_EQ(s_sh->duplicates, 0);
+    CHECK(!s_sh->order_broken);
+}
+
+static void run_ram_batch_spilled(void) {
+    host_clock_advance_ms(TELEMETRY_DRAIN_INTERVAL_MS);     // 上电后的第一个补传间隔
+    s_hold_acks = true;
+    tick(true, 10);                                          // RAM 中的 10 条作为一批发出
+    CHECK_EQ(s_ack_count, 1);
+    tick(true, TELEMETRY_RAM_RECORDS);                       // RAM 写满，最早的一组（含在途批次）移入 Flash
+    s_hold_acks = false;
+    drain_all(600);
+}
+
+static void test_cancel_ram_batch(void) {
+    reset_world(PARTITION_SIZE);
+    power_cycle(run_ram_batch_spilled);
+
+    uint32_t total = s_sh->total;
+    CHECK(received_range(1, 10, 2));                         // 作废的批次从 Flash 重发一次
+    CHECK(received_range(11, total, 1));
+    CHECK_EQ(s_sh->duplicates, 10);
+    CHECK_EQ(s_sh->stats.uploaded, total);
+    CHECK_EQ(s_sh->stats.dropped, 0);
+    CHECK(!s_sh->order_broken);
+}
+
+int main(void) {
+    s_sh = mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (s_sh == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    test_hour_full_partition();
+    test_hour_sector_eviction();
+    test_hour_ram_only();
+    test_power_loss();
+    test_cancel_flash_batch();
+    test_cancel_ram_batch();
+
+    fake_partition_remove();
+    return test_result();
+}
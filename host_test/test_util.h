@@ -0,0 +1,35 @@
+/**
+ * @file test_util.h
+ * @brief 主机测试断言（失败时打印位置并计数，main 末尾 return test_result()）
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int s_test_failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #cond); \
+            s_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: 检查失败: %s == %s（实际 %lld，期望 %lld）\n", \
+                    __FILE__, __LINE__, #actual, #expected, a_, e_); \
+            s_test_failures++; \
+        } \
+    } while (0)
+
+static inline int test_result(void) {
+    if (s_test_failures) {
+        fprintf(stderr, "失败 %d 项\n", s_test_failures);
+        return 1;
+    }
+    fprintf(stderr, "全部通过\n");
+    return 0;
+}
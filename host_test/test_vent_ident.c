@@ -0,0 +1,242 @@
+/**
+ * @file test_vent_ident.c
+ * @brief 通风响应辨识测试 - 真实的 vent_ident.c
+ *
+ * 按 ΔC = -k·(C - 基准) 生成每分钟一个值的 1Hz 样本（每分钟 60 个相同读数，分钟均值即该值）：
+ *   - 片段拟合：点数不足、激励不足、k 为负、残差过大的片段被拒绝，参数保持默认；干净的衰减片段归属到
+ *     自然渗透 / 单台风扇，并随阶跃测试结束写入 NVS
+ *   - 阶跃测试：启动被拒绝（CO2 过低 / 过高）、步骤序列、各类中止；远程模式中止或结束时恢复测试前状态，
+ *     本地模式中止时交还给正常决策
+ */
+
+#include "vent_ident.h"
+#include "runtime_config.h"
+#include "esp_log.h"
+#include "fake_nvs.h"
+#include "test_util.h"
+#include <math.h>
+#include <string.h>
+
+#define FAN_COUNT  3
+#define STEP_SEC   (IDENT_STEP_MIN * 60)
+
+// 固件依赖的替身：阈值取编译期默认值
+static const RuntimeConfig s_config = {
+    .co2_low = CO2_THRESHOLD_LOW,
+    .co2_high = CO2_THRESHOLD_HIGH,
+    .co2_min_valid = CO2_MIN_VALID,
+    .co2_max_valid = CO2_MAX_VALID,
+};
+const RuntimeConfig *runtime_config_get(void) { return &s_config; }
+uint8_t fan_control_get_count(void) { return FAN_COUNT; }
+
+static const FanState s_all_off[FAN_COUNT] = {FAN_OFF, FAN_OFF, FAN_OFF};
+static const FanState s_all_high[FAN_COUNT] = {FAN_HIGH, FAN_HIGH, FAN_HIGH};
+static const FanState s_fan0_low[FAN_COUNT] = {FAN_LOW, FAN_OFF, FAN_OFF};
+
+static VentModel model_now(void) {
+    VentModel m;
+    vent_ident_get_model(&m);
+    return m;
+}
+
+static void feed_minute(float co2, const FanState fans[]) {
+    for (int s = 0; s < 60; s++) {
+        vent_ident_add_sample(co2, fans, FAN_COUNT);
+    }
+}
+
+/**
+ * @brief 以风扇组合 fans 运行一个片段：过渡期后 points 个拟合点，最后切换组合使片段立即拟合
+ * @param start 片段起始 CO2（ppm）
+ * @param k 真实衰减率（1/分钟，负值为远离基准增长）
+ * @param noise 叠加在每分钟值上的确定性扰动幅度（ppm）
+ */
+static void run_segment(const FanState fans[], float start, float k, float noise, int points) {
+    float c = start;
+    for (int j = 0; j < IDENT_SETTLE_MIN + points + 1; j++) {
+        // 周期 5 的扰动序列，与衰减趋势无关
+        static const float pattern[5] = {1.0f, -0.6f, 0.2f, -1.0f, 0.4f};
+        feed_minute(c + noise * pattern[j % 5], fans);
+        c -= k * (c - CO2_BASELINE);
+    }
+    vent_ident_add_sample(c, s_all_high, FAN_COUNT);
+}
+
+static void test_fit_rejected(void) {
+    VentModel before = model_now();
+
+    // 激励不足：接近基准时的衰减只有十几 ppm，拟合本身无残差也不采用
+    run_segment(s_all_off, CO2_BASELINE + 30.0f, 0.03f, 0.0f, 20);
+    // k 为负：CO2 远离基准指数增长（不符合模型）
+    run_segment(s_all_off, 700.0f, -0.03f, 0.0f, 20);
+    // 残差过大：衰减趋势上叠加 ±40 ppm 扰动，标准误超过 IDENT_MAX_DECAY_SE
+    run_segment(s_all_off, 1800.0f, 0.03f, 40.0f, 20);
+    // 点数不足：过渡期后只有 IDENT_MIN_SEGMENT_POINTS - 1 个点
+    run_segment(s_all_off, 1800.0f, 0.03f, 0.0f, IDENT_MIN_SEGMENT_POINTS - 1);
+
+    VentModel after = model_now();
+    CHECK_EQ(after.infiltration.segments, 0);
+    CHECK(after.infiltration.value == before.infiltration.value);
+    CHECK_EQ(after.generation.segments, 0);
+    CHECK(!vent_ident_take_report_pending());
+}
+
+static void test_fit_accepted(void) {
+    // 全部关闭：k 归属自然渗透
+    run_segment(s_all_off, 1800.0f, 0.03f, 0.0f, 20);
+    VentModel m = model_now();
+    CHECK_EQ(m.infiltration.segments, 1);
+    CHECK(fabsf(m.infiltration.value - 0.03f) < 0.001f);
+    CHECK(vent_ident_take_report_pending());
+
+    // 仅风扇 0 LOW：总衰减率扣除自然渗透后归属该风扇 LOW 档，其余参数不变
+    run_segment(s_fan0_low, 1800.0f, 0.03f + 0.012f, 0.0f, 20);
+    m = model_now();
+    CHECK_EQ(m.fan[0][0].segments, 1);
+    CHECK(fabsf(m.fan[0][0].value - 0.012f) < 0.001f);
+    CHECK_EQ(m.fan[0][1].segments, 0);
+    CHECK_EQ(m.fan[1][0].segments, 0);
+    CHECK_EQ(m.infiltration.segments, 1);
+}
+
+static bool step(float co2, bool valid, SystemMode mode, FanState fans[]) {
+    SensorData sensor = { .valid = valid, .pollutants = { .co2 = co2 } };
+    return vent_ident_step_override(&sensor, mode, fans, FAN_COUNT);
+}
+
+static void test_step_refused(void) {
+    FanState fans[FAN_COUNT] = {FAN_LOW, FAN_LOW, FAN_LOW};
+
+    vent_ident_request_start();
+    CHECK(!step(IDENT_STEP_MIN_CO2 - 50.0f, true, MODE_REMOTE, fans));
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_IDLE);
+    CHECK(strcmp(vent_ident_get_note(), "REFUSED_CO2_LOW") == 0);
+
+    vent_ident_request_start();
+    CHECK(!step(CO2_THRESHOLD_HIGH + 50.0f, true, MODE_REMOTE, fans));
+    CHECK(strcmp(vent_ident_get_note(), "REFUSED_UNSAFE") == 0);
+
+    vent_ident_request_start();
+    CHECK(!step(900.0f, true, MODE_SAFE_STOP, fans));
+    CHECK(strcmp(vent_ident_get_note(), "REFUSED_UNSAFE") == 0);
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_IDLE);
+    CHECK_EQ(fans[0], FAN_LOW);
+}
+
+static void test_step_sequence(void) {
+    const FanState saved[FAN_COUNT] = {FAN_HIGH, FAN_LOW, FAN_OFF};
+    FanState fans[FAN_COUNT];
+
+    memcpy(fans, saved, sizeof(fans));
+    vent_ident_request_start();
+    CHECK(step(900.0f, true, MODE_REMOTE, fans));
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_RUNNING);
+    CHECK(memcmp(fans, s_all_off, sizeof(fans)) == 0);
+
+    // 第 0 步全部关闭，之后每台风扇依次 LOW、HIGH，其余关闭
+    for (int s = 1; s < 1 + 2 * FAN_COUNT; s++) {
+        for (int t = 0; t < STEP_SEC; t++) {
+            memcpy(fans, saved, sizeof(fans));
+            CHECK(step(900.0f, true, MODE_REMOTE, fans));
+        }
+        CHECK_EQ(vent_ident_get_step(), s);
+        for (int i = 0; i < FAN_COUNT; i++) {
+            FanState expect = (i == (s - 1) / 2) ? ((s - 1) % 2 == 0 ? FAN_LOW : FAN_HIGH) : FAN_OFF;
+            CHECK_EQ(fans[i], expect);
+        }
+    }
+
+    // 启动周期计入第 0 步，最后一步少一个周期即结束：恢复测试前状态
+    for (int t = 0; t < STEP_SEC - 1; t++) {
+        memset(fans, 0, sizeof(fans));
+        CHECK(step(900.0f, true, MODE_REMOTE, fans));
+    }
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_IDLE);
+    CHECK(strcmp(vent_ident_get_note(), "COMPLETED") == 0);
+    CHECK(memcmp(fans, saved, sizeof(fans)) == 0);
+}
+
+/**
+ * @brief 启动测试并运行到第 1 步，再以 (co2, valid, mode) 运行一个周期
+ * @return 该周期的返回值；fans 为该周期的输出
+ */
+static bool abort_after_step1(float co2, bool valid, SystemMode start_mode, SystemMode mode,
+                              FanState fans[]) {
+    static const FanState saved[FAN_COUNT] = {FAN_HIGH, FAN_LOW, FAN_OFF};
+    memcpy(fans, saved, sizeof(saved));
+    vent_ident_request_start();
+    step(900.0f, true, start_mode, fans);
+    for (int t = 0; t < STEP_SEC; t++) {
+        step(900.0f, true, start_mode, fans);
+    }
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_RUNNING);
+    CHECK_EQ(vent_ident_get_step(), 1);
+
+    // 正常决策给出的输出：全部 LOW
+    for (int i = 0; i < FAN_COUNT; i++) {
+        fans[i] = FAN_LOW;
+    }
+    bool ret = step(co2, valid, mode, fans);
+    CHECK_EQ(vent_ident_get_state(), VENT_IDENT_IDLE);
+    CHECK(!step(900.0f, true, mode, fans));   // 中止后不再接管
+    return ret;
+}
+
+static void test_step_abort(void) {
+    static const FanState saved[FAN_COUNT] = {FAN_HIGH, FAN_LOW, FAN_OFF};
+    FanState fans[FAN_COUNT];
+
+    // 远程模式：中止时恢复测试前状态
+    CHECK(abort_after_step1(CO2_THRESHOLD_HIGH + 50.0f, true, MODE_REMOTE, MODE_REMOTE, fans));
+    CHECK(strcmp(vent_ident_get_note(), "ABORT_CO2_HIGH") == 0);
+    CHECK(memcmp(fans, saved, sizeof(fans)) == 0);
+
+    CHECK(abort_after_step1(CO2_BASELINE + IDENT_MIN_SIGNAL_PPM - 10.0f, true,
+                            MODE_REMOTE, MODE_REMOTE, fans));
+    CHECK(strcmp(vent_ident_get_note(), "SIGNAL_LOST") == 0);
+    CHECK(memcmp(fans, saved, sizeof(fans)) == 0);
+
+    // 本地模式：中止后交还给正常决策，输出不被改写
+    CHECK(!abort_after_step1(900.0f, false, MODE_LOCAL, MODE_LOCAL, fans));
+    CHECK(strcmp(vent_ident_get_note(), "ABORT_SENSOR") == 0);
+    CHECK_EQ(fans[0], FAN_LOW);
+
+    CHECK(!abort_after_step1(900.0f, true, MODE_LOCAL, MODE_SAFE_STOP, fans));
+    CHECK(strcmp(vent_ident_get_note(), "ABORT_SAFE_STOP") == 0);
+    CHECK_EQ(fans[0], FAN_LOW);
+
+    // 停止请求：恢复测试前状态
+    memcpy(fans, saved, sizeof(fans));
+    vent_ident_request_start();
+    CHECK(step(900.0f, true, MODE_REMOTE, fans));
+    memset(fans, 0, sizeof(fans));
+    vent_ident_request_stop();
+    CHECK(step(900.0f, true, MODE_REMOTE, fans));
+    CHECK(strcmp(vent_ident_get_note(), "STOPPED") == 0);
+    CHECK(memcmp(fans, saved, sizeof(fans)) == 0);
+}
+
+static void test_model_persisted(void) {
+    // 阶跃测试结束时已写入 NVS：重新初始化后保留学习结果
+    CHECK_EQ(vent_ident_init(), ESP_OK);
+    VentModel m = model_now();
+    CHECK_EQ(m.infiltration.segments, 1);
+    CHECK(fabsf(m.infiltration.value - 0.03f) < 0.001f);
+    CHECK_EQ(m.fan[0][0].segments, 1);
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    fake_nvs_erase_all();
+    CHECK_EQ(vent_ident_init(), ESP_OK);
+    vent_ident_take_report_pending();
+
+    test_fit_rejected();
+    test_fit_accepted();
+    test_step_refused();
+    test_step_sequence();
+    test_step_abort();
+    test_model_persisted();
+    return test_result();
+}
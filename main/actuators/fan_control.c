@@ -1,70 +1,326 @@
 /**
  * @file fan_control.c
- * @brief 风扇控制 - 多风扇版本
+ * @brief 风扇控制 - 多风扇版本（运行时风扇配置表）
  */
 
 #include "fan_control.h"
+#include "runtime_config.h"
 #include "esp_log.h"
 #include "driver/ledc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include <string.h>
 
 static const char *TAG = "FAN_CONTROL";
-static FanState current_state[FAN_COUNT] = {FAN_OFF, FAN_OFF, FAN_OFF};
-static uint8_t current_pwm[FAN_COUNT] = {0, 0, 0};
-static bool s_ledc_ready = false;
-
-// GPIO 映射
-static const gpio_num_t FAN_GPIO[FAN_COUNT] = {
-    GPIO_NUM_36,  // Fan0
-    GPIO_NUM_37,  // Fan1
-    GPIO_NUM_38   // Fan2
-};
-
-// LEDC 通道映射
-static const ledc_channel_t FAN_CHANNEL[FAN_COUNT] = {
-    LEDC_CHANNEL_0,
-    LEDC_CHANNEL_1,
-    LEDC_CHANNEL_2
-};
 
 #define FAN_PWM_FREQ_HZ      25000
 #define FAN_PWM_RESOLUTION   LEDC_TIMER_8_BIT
 #define FAN_LEDC_TIMER       LEDC_TIMER_0
 #define FAN_LEDC_SPEED_MODE  LEDC_LOW_SPEED_MODE
+#define FAN_DUTY_FULL_SCALE  255
+
+// 软启停（LEDC 硬件渐变，按满量程 0 ↔ 255 计时，实际时间按占空比差值等比缩放）
+#define FAN_RAMP_UP_MS       2000   // 软启动满量程时间
+#define FAN_RAMP_DOWN_MS     3000   // 软停止满量程时间
+#define FAN_STAGGER_MS       800    // 多风扇同时启动时的错峰间隔（限制合计冲击电流）
+
+// NVS 存储键值
+#define FAN_NVS_NAMESPACE    "fan_config"
+#define FAN_NVS_KEY_TABLE    "table"
+#define FAN_CONFIG_VERSION   2
+
+/**
+ * @brief NVS 中保存的风扇配置表（blob）
+ */
+typedef struct {
+    uint8_t version;                   ///< 配置格式版本
+    uint8_t count;                     ///< 风扇数量
+    FanConfig fans[FAN_MAX_COUNT];     ///< 风扇配置（仅前 count 项有效）
+} FanConfigTable;
+
+/**
+ * @brief 默认风扇配置表（NVS 无配置时使用，对应 30mm FAN Module X3）
+ */
+static const FanConfigTable DEFAULT_FAN_TABLE = {
+    .version = FAN_CONFIG_VERSION,
+    .count = 3,
+    .fans = {
+        // gpio  ch  min  max  low  high  n_low  n_high  tach                ppr  rpm（开环）
+        {  36,   0,  150, 255, 180, 255,  150,   200,    FAN_TACH_GPIO_NONE, 2,   0, 0, 0, 0 },  // Fan0
+        {  37,   1,  150, 255, 180, 255,  150,   200,    FAN_TACH_GPIO_NONE, 2,   0, 0, 0, 0 },  // Fan1
+        {  38,   2,  150, 255, 180, 255,  150,   200,    FAN_TACH_GPIO_NONE, 2,   0, 0, 0, 0 },  // Fan2
+    },
+};
+
+static FanConfigTable s_table;
+static FanState current_state[FAN_MAX_COUNT] = {FAN_OFF};
+static uint8_t current_pwm[FAN_MAX_COUNT] = {0};
+static uint16_t current_target_rpm[FAN_MAX_COUNT] = {0};
+static bool s_ledc_ready = false;
+
+// 错峰启动：每个风扇一个单次定时器，到期后启动硬件渐变
+static esp_timer_handle_t s_start_timer[FAN_MAX_COUNT] = {NULL};
+static uint8_t s_target_duty[FAN_MAX_COUNT] = {0};  // 最新目标占空比（定时器回调读取）
+static SemaphoreHandle_t s_fade_mutex = NULL;       // 串行化渐变启动与目标更新
+static portMUX_TYPE s_commit_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 校验风扇配置表
+ *
+ * @param fans 风扇配置数组
+ * @param count 风扇数量
+ * @return ESP_OK 有效，ESP_ERR_INVALID_ARG 无效
+ */
+static esp_err_t fan_validate_config(const FanConfig *fans, uint8_t count) {
+    if (!fans || count == 0 || count > FAN_MAX_COUNT) {
+        ESP_LOGE(TAG, "风扇数量无效 %d（允许 1-%d）", count, FAN_MAX_COUNT);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t used_channels = 0;
+    for (int i = 0; i < count; i++) {
+        const FanConfig *cfg = &fans[i];
+
+        if (!GPIO_IS_VALID_OUTPUT_GPIO(cfg->gpio)) {
+            ESP_LOGE(TAG, "Fan%d GPIO%d 不可用作输出", i, cfg->gpio);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (cfg->channel >= LEDC_CHANNEL_MAX || (used_channels & (1u << cfg->channel))) {
+            ESP_LOGE(TAG, "Fan%d LEDC 通道 %d 无效或重复", i, cfg->channel);
+            return ESP_ERR_INVALID_ARG;
+        }
+        used_channels |= 1u << cfg->channel;
+
+        if (cfg->min_duty == 0 || cfg->min_duty > cfg->max_duty) {
+            ESP_LOGE(TAG, "Fan%d 占空比范围无效 %d-%d", i, cfg->min_duty, cfg->max_duty);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (cfg->tach_gpio != FAN_TACH_GPIO_NONE) {
+            if (!GPIO_IS_VALID_GPIO(cfg->tach_gpio) || cfg->tach_gpio == cfg->gpio || cfg->pulses_per_rev == 0) {
+                ESP_LOGE(TAG, "Fan%d 转速计配置无效 GPIO%d PPR%d", i, cfg->tach_gpio, cfg->pulses_per_rev);
+                return ESP_ERR_INVALID_ARG;
+            }
+        } else if (cfg->low_rpm || cfg->high_rpm || cfg->night_low_rpm || cfg->night_high_rpm) {
+            ESP_LOGE(TAG, "Fan%d 未配置转速计，不能使用转速闭环", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 从 NVS 加载风扇配置表，无配置或配置无效时使用默认表
+ */
+static void fan_load_config(void) {
+    memcpy(&s_table, &DEFAULT_FAN_TABLE, sizeof(s_table));
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(FAN_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "NVS 无风扇配置，使用默认配置表（%d 个风扇）", s_table.count);
+        return;
+    }
+
+    FanConfigTable stored;
+    size_t len = sizeof(stored);
+    err = nvs_get_blob(nvs_handle, FAN_NVS_KEY_TABLE, &stored, &len);
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK || len != sizeof(stored) || stored.version != FAN_CONFIG_VERSION) {
+        ESP_LOGW(TAG, "NVS 风扇配置读取失败或版本不匹配，使用默认配置表");
+        return;
+    }
+
+    if (fan_validate_config(stored.fans, stored.count) != ESP_OK) {
+        ESP_LOGW(TAG, "NVS 风扇配置无效，使用默认配置表");
+        return;
+    }
+
+    memcpy(&s_table, &stored, sizeof(s_table));
+    ESP_LOGI(TAG, "从 NVS 加载风扇配置表（%d 个风扇）", s_table.count);
+}
 
 /**
  * @brief PWM 限制函数 PWM 值
  *
+ * @param cfg 风扇配置
  * @param raw_pwm 原始 PWM 值
  * @return 限制后的 PWM 值
  */
-static uint8_t fan_clamp_pwm(uint8_t raw_pwm) {
-    if (raw_pwm == 0) return 0;           // 关闭
-    if (raw_pwm < 150) return 150;        // 最低值
-    if (raw_pwm > 255) return 255;        // 最高值
+static uint8_t fan_clamp_pwm(const FanConfig *cfg, uint8_t raw_pwm) {
+    if (raw_pwm == 0) return 0;                         // 关闭
+    if (raw_pwm < cfg->min_duty) return cfg->min_duty;  // 最低值
+    if (raw_pwm > cfg->max_duty) return cfg->max_duty;  // 最高值
     return raw_pwm;
 }
 
 /**
  * @brief 根据 FanState 获取 PWM 占空比
+ * 档位占空比取自运行时配置快照（未解析时回退到风扇配置表）
  *
+ * @param id 风扇ID
  * @param state 风扇状态
  * @param is_night_mode 夜间模式
  * @return PWM 占空比
  */
-static uint8_t fan_control_get_pwm_duty(FanState state, bool is_night_mode) {
+static uint8_t fan_control_get_pwm_duty(FanId id, FanState state, bool is_night_mode) {
+    const FanConfig *cfg = &s_table.fans[id];
+    const RuntimeConfig *rc = runtime_config_get();
+    FanDuty duty = {cfg->low_duty, cfg->high_duty, cfg->night_low_duty, cfg->night_high_duty};
+    if (id < rc->fan_count) {
+        duty = rc->fan_duty[id];
+    }
+
     switch (state) {
         case FAN_OFF:  return 0;
-        case FAN_LOW:  return is_night_mode ? 150 : 180;
-        case FAN_HIGH: return is_night_mode ? 200 : 255;
+        case FAN_LOW:  return fan_clamp_pwm(cfg, is_night_mode ? duty.night_low : duty.low);
+        case FAN_HIGH: return fan_clamp_pwm(cfg, is_night_mode ? duty.night_high : duty.high);
+        default:       return 0;
+    }
+}
+
+/**
+ * @brief 根据 FanState 获取目标转速（0 = 开环）
+ *
+ * @param cfg 风扇配置
+ * @param state 风扇状态
+ * @param is_night_mode 夜间模式
+ * @return 目标转速 rpm
+ */
+static uint16_t fan_control_get_rpm_target(const FanConfig *cfg, FanState state, bool is_night_mode) {
+    switch (state) {
+        case FAN_LOW:  return is_night_mode ? cfg->night_low_rpm : cfg->low_rpm;
+        case FAN_HIGH: return is_night_mode ? cfg->night_high_rpm : cfg->high_rpm;
         default:       return 0;
     }
 }
 
+/**
+ * @brief 启动硬件渐变到目标占空比（调用方需持有 s_fade_mutex）
+ *
+ * 渐变由 LEDC 硬件完成，不占用 CPU；若上一次渐变尚未结束则先停止，
+ * 从当前实际占空比开始新的渐变。
+ */
+static esp_err_t fan_start_fade(FanId id, uint8_t target) {
+    ledc_channel_t channel = (ledc_channel_t)s_table.fans[id].channel;
+
+    // 打断进行中的渐变（无渐变时直接返回 OK）
+    ledc_fade_stop(FAN_LEDC_SPEED_MODE, channel);
+
+    uint32_t from = ledc_get_duty(FAN_LEDC_SPEED_MODE, channel);
+    if (from == target) {
+        return ESP_OK;
+    }
+
+    uint32_t delta = (from > target) ? (from - target) : (target - from);
+    uint32_t ramp_ms = (target > from) ? FAN_RAMP_UP_MS : FAN_RAMP_DOWN_MS;
+    int fade_ms = (int)(ramp_ms * delta / FAN_DUTY_FULL_SCALE);
+
+    esp_err_t err;
+    if (fade_ms == 0) {
+        err = ledc_set_duty(FAN_LEDC_SPEED_MODE, channel, target);
+        if (err == ESP_OK) {
+            err = ledc_update_duty(FAN_LEDC_SPEED_MODE, channel);
+        }
+    } else {
+        err = ledc_set_fade_with_time(FAN_LEDC_SPEED_MODE, channel, target, fade_ms);
+        if (err == ESP_OK) {
+            err = ledc_fade_start(FAN_LEDC_SPEED_MODE, channel, LEDC_FADE_NO_WAIT);
+        }
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "启动渐变失败 Fan%d (%d)", id, err);
+        return err;
+    }
+
+    ESP_LOGD(TAG, "Fan%d 渐变 %lu -> %d（%d ms）", id, (unsigned long)from, target, fade_ms);
+    return ESP_OK;
+}
+
+/**
+ * @brief 错峰启动定时器回调（esp_timer 任务上下文）
+ */
+static void fan_start_timer_callback(void *arg) {
+    FanId id = (FanId)(uintptr_t)arg;
+
+    // 在锁内读取最新目标，保证与 fan_control_set_* 的更新顺序一致
+    xSemaphoreTake(s_fade_mutex, portMAX_DELAY);
+    fan_start_fade(id, s_target_duty[id]);
+    xSemaphoreGive(s_fade_mutex);
+}
+
+/**
+ * @brief 更新单个风扇目标占空比（调用方需持有 s_fade_mutex）
+ *
+ * @param id 风扇ID
+ * @param target 目标占空比
+ * @param start_delay_ms 启动延迟（错峰启动），0 表示立即开始渐变
+ */
+static esp_err_t fan_set_target(FanId id, uint8_t target, uint32_t start_delay_ms) {
+    s_target_duty[id] = target;
+
+    // 取消尚未执行的错峰启动，以最新目标为准
+    esp_timer_stop(s_start_timer[id]);
+
+    if (start_delay_ms > 0) {
+        esp_err_t err = esp_timer_start_once(s_start_timer[id], (uint64_t)start_delay_ms * 1000);
+        if (err == ESP_OK) {
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "Fan%d 错峰定时器启动失败，立即启动 (%d)", id, err);
+    }
+    return fan_start_fade(id, target);
+}
+
+/**
+ * @brief 原子提交多通道占空比（所有风扇在同一 PWM 周期生效）
+ *
+ * 先逐通道写入占空比寄存器（此时不生效），再在临界区内连续置位各通道的
+ * 更新标志。各通道共用同一 LEDC 定时器，更新在下一个 PWM 周期边界同时生效；
+ * 置位耗时远小于 25kHz 的 40µs 周期。会打断进行中的渐变和错峰启动。
+ * 只用于 fan_control_set_all()（安全停机）：fan_control_set_states() 的批量切换走硬件渐变，
+ * 渐变无法原子启动，也不需要——跨数秒的渐变中各通道微秒级的先后差没有影响。
+ *
+ * @param duties 各风扇占空比（前 s_table.count 项）
+ */
+static esp_err_t fan_commit_duties(const uint8_t duties[]) {
+    xSemaphoreTake(s_fade_mutex, portMAX_DELAY);
+
+    for (int i = 0; i < s_table.count; i++) {
+        ledc_channel_t channel = (ledc_channel_t)s_table.fans[i].channel;
+        esp_timer_stop(s_start_timer[i]);
+        ledc_fade_stop(FAN_LEDC_SPEED_MODE, channel);
+        s_target_duty[i] = duties[i];
+
+        esp_err_t err = ledc_set_duty(FAN_LEDC_SPEED_MODE, channel, duties[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "设置占空比失败 Fan%d (%d)", i, err);
+            xSemaphoreGive(s_fade_mutex);
+            return err;
+        }
+    }
+
+    portENTER_CRITICAL(&s_commit_lock);
+    for (int i = 0; i < s_table.count; i++) {
+        ledc_update_duty(FAN_LEDC_SPEED_MODE, (ledc_channel_t)s_table.fans[i].channel);
+    }
+    portEXIT_CRITICAL(&s_commit_lock);
+
+    xSemaphoreGive(s_fade_mutex);
+    return ESP_OK;
+}
+
 esp_err_t fan_control_init(void) {
     if (s_ledc_ready) {
         return ESP_OK;
     }
 
+    fan_load_config();
+
     // 配置 LEDC 定时器（共用）
     ledc_timer_config_t timer_cfg = {
         .speed_mode = FAN_LEDC_SPEED_MODE,
@@ -80,12 +336,12 @@ esp_err_t fan_control_init(void) {
         return err;
     }
 
-    // 配置3个 LEDC 通道
-    for (int i = 0; i < FAN_COUNT; i++) {
+    // 按配置表配置 LEDC 通道
+    for (int i = 0; i < s_table.count; i++) {
         ledc_channel_config_t channel_cfg = {
-            .gpio_num = FAN_GPIO[i],
+            .gpio_num = s_table.fans[i].gpio,
             .speed_mode = FAN_LEDC_SPEED_MODE,
-            .channel = FAN_CHANNEL[i],
+            .channel = (ledc_channel_t)s_table.fans[i].channel,
             .timer_sel = FAN_LEDC_TIMER,
             .duty = 0,  // 初始占空比 0（关闭）
             .hpoint = 0
@@ -96,14 +352,91 @@ esp_err_t fan_control_init(void) {
             ESP_LOGE(TAG, "LEDC channel %d config 失败 (%d)", i, err);
             return err;
         }
+        ESP_LOGI(TAG, "Fan%d: GPIO%d CH%d 占空比 %d-%d", i,
+                 s_table.fans[i].gpio, s_table.fans[i].channel,
+                 s_table.fans[i].min_duty, s_table.fans[i].max_duty);
+    }
+
+    // 安装 LEDC 渐变服务（硬件渐变，渐变过程不占用 CPU）
+    err = ledc_fade_func_install(0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LEDC fade 安装失败 (%d)", err);
+        return err;
+    }
+
+    s_fade_mutex = xSemaphoreCreateMutex();
+    if (s_fade_mutex == NULL) {
+        ESP_LOGE(TAG, "创建渐变互斥锁失败");
+        return ESP_FAIL;
+    }
+
+    for (int i = 0; i < s_table.count; i++) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = fan_start_timer_callback,
+            .arg = (void *)(uintptr_t)i,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "fan_start",
+        };
+        err = esp_timer_create(&timer_args, &s_start_timer[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "创建 Fan%d 错峰定时器失败 (%d)", i, err);
+            return err;
+        }
     }
 
     s_ledc_ready = true;
-    for (int i = 0; i < FAN_COUNT; i++) {
+    for (int i = 0; i < FAN_MAX_COUNT; i++) {
         current_state[i] = FAN_OFF;
         current_pwm[i] = 0;
+        current_target_rpm[i] = 0;
     }
-    ESP_LOGI(TAG, "初始化风扇控制完成 GPIO36/37/38 25kHz 8位");
+    ESP_LOGI(TAG, "初始化风扇控制完成 %d 个风扇 25kHz 8位，软启停 %d/%d ms，错峰 %d ms",
+             s_table.count, FAN_RAMP_UP_MS, FAN_RAMP_DOWN_MS, FAN_STAGGER_MS);
+    return ESP_OK;
+}
+
+uint8_t fan_control_get_count(void) {
+    // 未初始化时 s_table.count 为 0，调用方循环自然不执行
+    return s_table.count;
+}
+
+const FanConfig *fan_control_get_config(FanId id) {
+    if (id >= s_table.count) {
+        return NULL;
+    }
+    return &s_table.fans[id];
+}
+
+esp_err_t fan_control_save_config(const FanConfig *fans, uint8_t count) {
+    esp_err_t err = fan_validate_config(fans, count);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    FanConfigTable table = {0};
+    table.version = FAN_CONFIG_VERSION;
+    table.count = count;
+    memcpy(table.fans, fans, count * sizeof(FanConfig));
+
+    nvs_handle_t nvs_handle;
+    err = nvs_open(FAN_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存风扇配置: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(nvs_handle, FAN_NVS_KEY_TABLE, &table, sizeof(table));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "保存风扇配置失败: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "风扇配置表已保存到 NVS（%d 个风扇），重启后生效", count);
     return ESP_OK;
 }
 
@@ -113,26 +446,20 @@ esp_err_t fan_control_set_state(FanId id, FanState state, bool is_night_mode) {
         return ESP_FAIL;
     }
 
-    if (id >= FAN_COUNT) {
+    if (id >= s_table.count) {
         ESP_LOGE(TAG, "无效的风扇ID %d", id);
         return ESP_FAIL;
     }
 
-    uint8_t pwm = fan_control_get_pwm_duty(state, is_night_mode);
+    uint8_t pwm = fan_control_get_pwm_duty(id, state, is_night_mode);
     current_state[id] = state;
     current_pwm[id] = pwm;
+    current_target_rpm[id] = fan_control_get_rpm_target(&s_table.fans[id], state, is_night_mode);
 
-    // 设置 LEDC 占空比
-    esp_err_t err = ledc_set_duty(FAN_LEDC_SPEED_MODE, FAN_CHANNEL[id], pwm);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "设置占空比失败 Fan%d (%d)", id, err);
-        return err;
-    }
-
-    // 更新占空比
-    err = ledc_update_duty(FAN_LEDC_SPEED_MODE, FAN_CHANNEL[id]);
+    xSemaphoreTake(s_fade_mutex, portMAX_DELAY);
+    esp_err_t err = fan_set_target(id, pwm, 0);
+    xSemaphoreGive(s_fade_mutex);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "更新占空比失败 Fan%d (%d)", id, err);
         return err;
     }
 
@@ -140,41 +467,82 @@ esp_err_t fan_control_set_state(FanId id, FanState state, bool is_night_mode) {
     return ESP_OK;
 }
 
-esp_err_t fan_control_set_all(FanState state, bool is_night_mode) {
+esp_err_t fan_control_set_states(const FanState states[], uint8_t count, bool is_night_mode) {
+    if (!s_ledc_ready) {
+        ESP_LOGE(TAG, "LEDC 未初始化");
+        return ESP_FAIL;
+    }
+
+    if (!states || count > s_table.count) {
+        ESP_LOGE(TAG, "无效的风扇状态数组（count=%d）", count);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_err_t err = ESP_OK;
-    for (int i = 0; i < FAN_COUNT; i++) {
-        esp_err_t ret = fan_control_set_state((FanId)i, state, is_night_mode);
+    uint32_t start_slot = 0;
+
+    xSemaphoreTake(s_fade_mutex, portMAX_DELAY);
+    for (int i = 0; i < count; i++) {
+        uint8_t pwm = fan_control_get_pwm_duty(i, states[i], is_night_mode);
+        bool starting = (s_target_duty[i] == 0 && pwm > 0);
+
+        current_state[i] = states[i];
+        current_pwm[i] = pwm;
+        current_target_rpm[i] = fan_control_get_rpm_target(&s_table.fans[i], states[i], is_night_mode);
+
+        // 从停止状态启动的风扇依次错开 FAN_STAGGER_MS，其余立即渐变
+        uint32_t delay_ms = starting ? start_slot * FAN_STAGGER_MS : 0;
+        if (starting) {
+            start_slot++;
+        }
+
+        esp_err_t ret = fan_set_target((FanId)i, pwm, delay_ms);
         if (ret != ESP_OK) {
             err = ret;
         }
     }
+    xSemaphoreGive(s_fade_mutex);
+
+    if (start_slot > 1) {
+        ESP_LOGI(TAG, "%lu 个风扇错峰启动，间隔 %d ms", (unsigned long)start_slot, FAN_STAGGER_MS);
+    }
     return err;
 }
 
+esp_err_t fan_control_set_all(FanState state, bool is_night_mode) {
+    if (!s_ledc_ready) {
+        ESP_LOGE(TAG, "LEDC 未初始化");
+        return ESP_FAIL;
+    }
+
+    uint8_t duties[FAN_MAX_COUNT] = {0};
+    for (int i = 0; i < s_table.count; i++) {
+        duties[i] = fan_control_get_pwm_duty(i, state, is_night_mode);
+        current_state[i] = state;
+        current_pwm[i] = duties[i];
+        current_target_rpm[i] = fan_control_get_rpm_target(&s_table.fans[i], state, is_night_mode);
+    }
+
+    return fan_commit_duties(duties);
+}
+
 esp_err_t fan_control_set_pwm(FanId id, uint8_t duty) {
     if (!s_ledc_ready) {
         ESP_LOGE(TAG, "LEDC 未初始化");
         return ESP_FAIL;
     }
 
-    if (id >= FAN_COUNT) {
+    if (id >= s_table.count) {
         ESP_LOGE(TAG, "无效的风扇ID %d", id);
         return ESP_FAIL;
     }
 
-    current_pwm[id] = fan_clamp_pwm(duty);
+    current_pwm[id] = fan_clamp_pwm(&s_table.fans[id], duty);
 
-    // 设置 LEDC 占空比
-    esp_err_t err = ledc_set_duty(FAN_LEDC_SPEED_MODE, FAN_CHANNEL[id], current_pwm[id]);
+    xSemaphoreTake(s_fade_mutex, portMAX_DELAY);
+    esp_err_t err = fan_set_target(id, current_pwm[id], 0);
+    xSemaphoreGive(s_fade_mutex);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "设置占空比失败 Fan%d (%d)", id, err);
-        return err;
-    }
-
-    // 更新占空比
-    err = ledc_update_duty(FAN_LEDC_SPEED_MODE, FAN_CHANNEL[id]);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "更新占空比失败 Fan%d (%d)", id, err);
         return err;
     }
 
@@ -183,14 +551,21 @@ esp_err_t fan_control_set_pwm(FanId id, uint8_t duty) {
 }
 
 FanState fan_control_get_state(FanId id) {
-    if (id >= FAN_COUNT) {
+    if (id >= s_table.count) {
         return FAN_OFF;
     }
     return current_state[id];
 }
 
+uint16_t fan_control_get_target_rpm(FanId id) {
+    if (id >= s_table.count) {
+        return 0;
+    }
+    return current_target_rpm[id];
+}
+
 uint8_t fan_control_get_pwm(FanId id) {
-    if (id >= FAN_COUNT) {
+    if (id >= s_table.count) {
         return 0;
     }
     return current_pwm[id];
@@ -1,6 +1,6 @@
 /**
  * @file fan_control.h
- * @brief 风扇控制接口定义 - 30mm FAN Module X3 PWM 版本（多风扇）
+ * @brief 风扇控制接口定义 - 30mm FAN Module PWM 版本（多风扇，运行时配置表）
  */
 
 #ifndef FAN_CONTROL_H
@@ -11,10 +11,36 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * @brief 单个风扇配置（保存在 NVS fan_config/table）
+ */
+typedef struct {
+    uint8_t gpio;             ///< PWM 输出 GPIO
+    uint8_t channel;          ///< LEDC 通道（0 ~ LEDC_CHANNEL_MAX-1，不可重复）
+    uint8_t min_duty;         ///< 非零占空比下限（低于此值风扇无法启动）
+    uint8_t max_duty;         ///< 占空比上限
+    uint8_t low_duty;         ///< 白天 LOW 档占空比
+    uint8_t high_duty;        ///< 白天 HIGH 档占空比
+    uint8_t night_low_duty;   ///< 夜间 LOW 档占空比
+    uint8_t night_high_duty;  ///< 夜间 HIGH 档占空比
+    uint8_t tach_gpio;        ///< 转速计输入 GPIO（FAN_TACH_GPIO_NONE 表示无转速反馈）
+    uint8_t pulses_per_rev;   ///< 每转脉冲数（常见 PC 风扇为 2）
+    uint16_t low_rpm;         ///< 白天 LOW 档目标转速（0 = 开环，仅按占空比）
+    uint16_t high_rpm;        ///< 白天 HIGH 档目标转速（0 = 开环）
+    uint16_t night_low_rpm;   ///< 夜间 LOW 档目标转速（0 = 开环）
+    uint16_t night_high_rpm;  ///< 夜间 HIGH 档目标转速（0 = 开环）
+} FanConfig;
+
+/**
+ * @brief 无转速计输入
+ */
+#define FAN_TACH_GPIO_NONE 0xFF
+
 /**
  * @brief 初始化风扇控制
+ * 从 NVS 加载风扇配置表（无配置时使用默认 3 风扇表），
  * 初始化 LEDC PWM 25kHz 8位分辨率
- * 接线:
+ * 默认接线:
  *   Fan0: GPIO36 -> FAN0 PWM
  *   Fan1: GPIO37 -> FAN1 PWM
  *   Fan2: GPIO38 -> FAN2 PWM
@@ -22,31 +48,67 @@
  */
 esp_err_t fan_control_init(void);
 
+/**
+ * @brief 获取实际风扇数量（1 ~ FAN_MAX_COUNT，未初始化时为 0）
+ * @return 风扇数量
+ */
+uint8_t fan_control_get_count(void);
+
+/**
+ * @brief 获取单个风扇配置
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
+ * @return 风扇配置指针，无效ID返回NULL
+ */
+const FanConfig *fan_control_get_config(FanId id);
+
+/**
+ * @brief 校验并保存风扇配置表到 NVS（重启后生效，由 MQTT fan_config 命令调用）
+ * @param fans 风扇配置数组
+ * @param count 风扇数量 1 ~ FAN_MAX_COUNT
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 配置无效，其他 NVS 错误
+ */
+esp_err_t fan_control_save_config(const FanConfig *fans, uint8_t count);
+
 /**
  * @brief 设置单个风扇状态
- * PWM 占空比:
+ * 通过 LEDC 硬件渐变软启停（启动满量程 2s，停止满量程 3s）
+ * PWM 占空比取自运行时配置（未下发覆盖时即风扇配置表，默认值）:
  *   FAN_OFF:  0
  *   FAN_LOW:  白天~2700rpm (180), 夜间~3600rpm (150)
  *   FAN_HIGH: 白天~4300rpm (255), 夜间~6000rpm (200)
- * @param id 风扇ID (FAN_ID_0/1/2)
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
  * @param state 风扇状态 OFF/LOW/HIGH
- * @param is_night_mode 夜间模式 22:00-8:00
+ * @param is_night_mode 静音时段（使用夜间占空比，由 schedule 决定）
  * @return ESP_OK 成功，ESP_FAIL 失败
  */
 esp_err_t fan_control_set_state(FanId id, FanState state, bool is_night_mode);
 
 /**
- * @brief 设置所有风扇状态（批量操作）
+ * @brief 批量设置风扇状态（软启停 + 错峰启动）
+ * 各风扇以硬件渐变过渡到目标占空比；同一批次中从停止状态启动的风扇
+ * 依次错开 800ms 开始渐变，限制合计冲击电流。
+ * 各通道的渐变逐个启动，不保证在同一 PWM 周期生效（渐变本身持续数秒，先后差可忽略）；
+ * 需要所有通道同时切换时（安全停机）使用 fan_control_set_all()
+ * @param states 风扇状态数组
+ * @param count 风扇数量（不超过 fan_control_get_count()）
+ * @param is_night_mode 静音时段（使用夜间占空比，由 schedule 决定）
+ * @return ESP_OK 成功，其他 失败
+ */
+esp_err_t fan_control_set_states(const FanState states[], uint8_t count, bool is_night_mode);
+
+/**
+ * @brief 设置所有风扇状态（立即生效，原子提交）
+ * 不做渐变，所有通道在同一 PWM 周期切换到新占空比，用于安全停机等场景
  * @param state 风扇状态 OFF/LOW/HIGH
- * @param is_night_mode 夜间模式 22:00-8:00
+ * @param is_night_mode 静音时段（使用夜间占空比，由 schedule 决定）
  * @return ESP_OK 成功，ESP_FAIL 失败
  */
 esp_err_t fan_control_set_all(FanState state, bool is_night_mode);
 
 /**
  * @brief 设置单个风扇 PWM 占空比
- * clamp 到 0 和 150-255 范围
- * @param id 风扇ID (FAN_ID_0/1/2)
+ * clamp 到 0 和 min_duty-max_duty 范围
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
  * @param duty PWM 占空比 0-255
  * @return ESP_OK
  */
@@ -54,14 +116,21 @@ esp_err_t fan_control_set_pwm(FanId id, uint8_t duty);
 
 /**
  * @brief 获取单个风扇当前状态
- * @param id 风扇ID (FAN_ID_0/1/2)
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
  * @return 当前 FanState，无效ID返回FAN_OFF
  */
 FanState fan_control_get_state(FanId id);
 
+/**
+ * @brief 获取单个风扇当前目标转速（转速闭环模式）
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
+ * @return 目标转速 rpm，0 表示开环（或风扇关闭），无效ID返回0
+ */
+uint16_t fan_control_get_target_rpm(FanId id);
+
 /**
  * @brief 获取单个风扇当前 PWM 占空比
- * @param id 风扇ID (FAN_ID_0/1/2)
+ * @param id 风扇ID (0 ~ fan_control_get_count()-1)
  * @return 当前 PWM 值 0-255，无效ID返回0
  */
 uint8_t fan_control_get_pwm(FanId id);
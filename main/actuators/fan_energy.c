@@ -0,0 +1,233 @@
+/**
+ * @file fan_energy.c
+ * @brief 风扇能耗与运行统计
+ *
+ * 每个决策周期按各风扇当前占空比积分：运行时长、占空比加权时长（滤网负荷）、
+ * 按功率曲线插值得到的能耗，以及 0 → 非 0 的启动次数。累计值全部用整数
+ * （毫秒 / 微焦）保存，避免长期运行的浮点精度损失。
+ *
+ * Flash 写入合并：只在有风扇运行过且距上次保存满 ENERGY_SAVE_INTERVAL_MIN
+ * 分钟时写一次 NVS；掉电最多丢失这段时间的统计。
+ */
+
+#include "fan_energy.h"
+#include "fan_control.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "FAN_ENERGY";
+
+// NVS 存储键值
+#define ENERGY_NVS_NAMESPACE  "fan_energy"
+#define ENERGY_NVS_KEY_DATA   "counters"
+#define ENERGY_VERSION        1
+
+#define MS_PER_HOUR           3600000.0f
+
+/**
+ * @brief 单个风扇累计值（NVS 中按此格式保存）
+ */
+typedef struct {
+    uint64_t on_ms;          ///< 运行时长（毫秒）
+    uint64_t duty_ms;        ///< Σ 占空比 × 毫秒（255 = 满占空比）
+    uint64_t energy_uj;      ///< 能耗（微焦 = mW × ms）
+    uint64_t filter_duty_ms; ///< 滤网更换后的 Σ 占空比 × 毫秒
+    uint32_t starts;         ///< 启动次数
+    uint16_t curve_mw[ENERGY_CURVE_POINTS];  ///< 功率曲线
+} FanEnergyCounters;
+
+/**
+ * @brief NVS 中保存的统计（blob）
+ */
+typedef struct {
+    uint8_t version;
+    FanEnergyCounters fans[FAN_MAX_COUNT];
+} FanEnergyBlob;
+
+static const uint16_t s_default_curve[ENERGY_CURVE_POINTS] = ENERGY_DEFAULT_CURVE_MW;
+
+static FanEnergyCounters s_fans[FAN_MAX_COUNT];
+static uint8_t s_last_pwm[FAN_MAX_COUNT] = {0};
+static portMUX_TYPE s_energy_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t s_minute_ms = 0;
+static uint32_t s_minutes = 0;
+static uint32_t s_last_save_min = 0;
+static bool s_dirty = false;                 ///< 上次保存后有风扇运行过
+static volatile bool s_save_soon = false;    ///< 命令修改了数据，下一分钟保存
+
+/**
+ * @brief 功率曲线分段线性插值
+ * @return 功率（mW）
+ */
+static uint32_t power_at(const uint16_t curve[ENERGY_CURVE_POINTS], uint8_t duty) {
+    uint32_t pos = (uint32_t)duty * (ENERGY_CURVE_POINTS - 1);
+    uint32_t seg = pos / 255;
+    if (seg >= ENERGY_CURVE_POINTS - 1) {
+        return curve[ENERGY_CURVE_POINTS - 1];
+    }
+    uint32_t frac = pos % 255;
+    return curve[seg] + ((uint32_t)(curve[seg + 1] - curve[seg]) * frac) / 255;
+}
+
+/**
+ * @brief 功率曲线须单调不减
+ */
+static bool curve_is_valid(const uint16_t curve[ENERGY_CURVE_POINTS]) {
+    for (int i = 1; i < ENERGY_CURVE_POINTS; i++) {
+        if (curve[i] < curve[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 保存统计到 NVS
+ */
+static esp_err_t energy_save(void) {
+    static FanEnergyBlob blob;
+    blob.version = ENERGY_VERSION;
+    portENTER_CRITICAL(&s_energy_lock);
+    memcpy(blob.fans, s_fans, sizeof(blob.fans));
+    portEXIT_CRITICAL(&s_energy_lock);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存能耗统计: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_blob(nvs_handle, ENERGY_NVS_KEY_DATA, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "能耗统计保存失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_dirty = false;
+    s_save_soon = false;
+    s_last_save_min = s_minutes;
+    ESP_LOGD(TAG, "能耗统计已保存到 NVS");
+    return ESP_OK;
+}
+
+esp_err_t fan_energy_init(void) {
+    memset(s_fans, 0, sizeof(s_fans));
+    for (int i = 0; i < FAN_MAX_COUNT; i++) {
+        memcpy(s_fans[i].curve_mw, s_default_curve, sizeof(s_default_curve));
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "NVS 无能耗统计，从零开始累计");
+        return ESP_OK;
+    }
+
+    static FanEnergyBlob blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs_handle, ENERGY_NVS_KEY_DATA, &blob, &len);
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK || len != sizeof(blob) || blob.version != ENERGY_VERSION) {
+        ESP_LOGW(TAG, "NVS 能耗统计读取失败或版本不匹配，从零开始累计");
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < FAN_MAX_COUNT; i++) {
+        if (!curve_is_valid(blob.fans[i].curve_mw)) {
+            memcpy(blob.fans[i].curve_mw, s_default_curve, sizeof(s_default_curve));
+        }
+    }
+    memcpy(s_fans, blob.fans, sizeof(s_fans));
+
+    ESP_LOGI(TAG, "从 NVS 加载能耗统计");
+    return ESP_OK;
+}
+
+void fan_energy_update(uint32_t elapsed_ms) {
+    uint8_t fan_count = fan_control_get_count();
+
+    portENTER_CRITICAL(&s_energy_lock);
+    for (int i = 0; i < fan_count; i++) {
+        uint8_t pwm = fan_control_get_pwm((FanId)i);
+        FanEnergyCounters *c = &s_fans[i];
+
+        if (pwm > 0) {
+            if (s_last_pwm[i] == 0) {
+                c->starts++;
+            }
+            c->on_ms += elapsed_ms;
+            c->duty_ms += (uint64_t)pwm * elapsed_ms;
+            c->filter_duty_ms += (uint64_t)pwm * elapsed_ms;
+            c->energy_uj += (uint64_t)power_at(c->curve_mw, pwm) * elapsed_ms;
+            s_dirty = true;
+        }
+        s_last_pwm[i] = pwm;
+    }
+    portEXIT_CRITICAL(&s_energy_lock);
+
+    s_minute_ms += elapsed_ms;
+    if (s_minute_ms < 60000) {
+        return;
+    }
+    s_minute_ms -= 60000;
+    s_minutes++;
+
+    // 合并写入，降低 Flash 磨损
+    if (s_save_soon || (s_dirty && s_minutes - s_last_save_min >= ENERGY_SAVE_INTERVAL_MIN)) {
+        energy_save();
+    }
+}
+
+esp_err_t fan_energy_get(FanId id, FanEnergyStats *out) {
+    if (id >= fan_control_get_count() || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_energy_lock);
+    FanEnergyCounters c = s_fans[id];
+    portEXIT_CRITICAL(&s_energy_lock);
+
+    out->on_hours = c.on_ms / MS_PER_HOUR;
+    out->duty_hours = c.duty_ms / 255.0f / MS_PER_HOUR;
+    out->energy_wh = c.energy_uj / 1e6f / 3600.0f;
+    out->starts = c.starts;
+    out->filter_hours = c.filter_duty_ms / 255.0f / MS_PER_HOUR;
+
+    int remaining = 100 - (int)(out->filter_hours * 100.0f / FILTER_LIFE_HOURS);
+    out->filter_remaining = remaining < 0 ? 0 : remaining;
+    return ESP_OK;
+}
+
+void fan_energy_reset_filter(uint32_t fan_mask) {
+    uint8_t fan_count = fan_control_get_count();
+    portENTER_CRITICAL(&s_energy_lock);
+    for (int i = 0; i < fan_count; i++) {
+        if (fan_mask & (1u << i)) {
+            s_fans[i].filter_duty_ms = 0;
+        }
+    }
+    portEXIT_CRITICAL(&s_energy_lock);
+
+    s_save_soon = true;
+    ESP_LOGI(TAG, "滤网计时已清零（风扇掩码 0x%02lx）", (unsigned long)fan_mask);
+}
+
+esp_err_t fan_energy_set_curve(FanId id, const uint16_t curve_mw[ENERGY_CURVE_POINTS]) {
+    if (id >= fan_control_get_count() || !curve_mw || !curve_is_valid(curve_mw)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_energy_lock);
+    memcpy(s_fans[id].curve_mw, curve_mw, sizeof(s_fans[id].curve_mw));
+    portEXIT_CRITICAL(&s_energy_lock);
+
+    s_save_soon = true;
+    ESP_LOGI(TAG, "Fan%d 功率曲线已更新（满占空比 %d mW）", id, curve_mw[ENERGY_CURVE_POINTS - 1]);
+    return ESP_OK;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file fan_energy.h
+ * @brief 风扇能耗与运行统计接口定义 - 运行时长、启动次数、能耗积分与滤网寿命估算
+ */
+
+#ifndef FAN_ENERGY_H
+#define FAN_ENERGY_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 单个风扇累计统计（上报用，已换算单位）
+ */
+typedef struct {
+    float on_hours;        ///< 累计运行时长（小时，占空比 > 0）
+    float duty_hours;      ///< 占空比加权运行时长（满占空比等效小时）
+    float energy_wh;       ///< 累计能耗估算（Wh）
+    uint32_t starts;       ///< 累计启动次数（占空比 0 → 非 0）
+    float filter_hours;    ///< 滤网更换后的占空比加权运行时长（小时）
+    int filter_remaining;  ///< 滤网剩余寿命（%，0 ~ 100）
+} FanEnergyStats;
+
+/**
+ * @brief 初始化能耗统计，从 NVS 加载累计值与功率曲线（须在 fan_control_init() 之后调用）
+ * @return ESP_OK 成功
+ */
+esp_err_t fan_energy_init(void);
+
+/**
+ * @brief 按当前占空比积分运行时长与能耗（决策任务每周期调用）
+ * 累计满 1 分钟检查一次是否需要保存（合并写入，每 ENERGY_SAVE_INTERVAL_MIN 分钟最多一次）
+ * @param elapsed_ms 距上次调用的时间（毫秒）
+ */
+void fan_energy_update(uint32_t elapsed_ms);
+
+/**
+ * @brief 获取单个风扇累计统计
+ * @param id 风扇ID
+ * @param[out] out 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 无效ID
+ */
+esp_err_t fan_energy_get(FanId id, FanEnergyStats *out);
+
+/**
+ * @brief 更换滤网后清零滤网计时（下一分钟保存）
+ * @param fan_mask 风扇位掩码（bit i = Fan i）
+ */
+void fan_energy_reset_filter(uint32_t fan_mask);
+
+/**
+ * @brief 设置单个风扇功率曲线（下一分钟保存）
+ * @param id 风扇ID
+ * @param curve_mw 占空比 0 ~ 255 等分的 ENERGY_CURVE_POINTS 个点上的功率（mW），须单调不减
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t fan_energy_set_curve(FanId id, const uint16_t curve_mw[ENERGY_CURVE_POINTS]);
+
+#endif // FAN_ENERGY_H
@@ -0,0 +1,225 @@
+/**
+ * @file fan_tach.c
+ * @brief 风扇转速反馈 - 转速计算、堵转检测、转速闭环
+ */
+
+#include "fan_tach.h"
+#include "fan_tach_hal.h"
+#include "fan_control.h"
+#include "esp_log.h"
+
+static const char *TAG = "FAN_TACH";
+
+#define FAN_TACH_WINDOW_MS       1000   // 转速计算窗口
+#define FAN_TACH_SETTLE_MS       5000   // 档位变化后的稳定时间（软启动 + 风扇加速），期间不判故障
+#define FAN_STALL_RPM            300    // 低于此转速视为堵转
+#define FAN_STALL_SAMPLES        3      // 连续 3 个窗口堵转才告警
+#define FAN_UNDERSPEED_RATIO     0.75f  // 低于目标转速 75% 视为转速不足
+#define FAN_UNDERSPEED_SAMPLES   5      // 连续 5 个窗口转速不足才告警
+
+// 转速闭环（积分微调，开环占空比作为前馈）
+#define FAN_RPM_KI               0.01f  // 每 rpm 误差每窗口调整的占空比
+#define FAN_RPM_MAX_STEP         8.0f   // 每窗口最大调整量
+#define FAN_RPM_DEADBAND_RATIO   0.03f  // ±3% 目标转速内不调整
+
+/**
+ * @brief 单个风扇转速反馈状态
+ */
+typedef struct {
+    bool enabled;            ///< 已配置且计数通道初始化成功
+    uint8_t pulses_per_rev;  ///< 每转脉冲数
+    uint16_t rpm;            ///< 最近一次实测转速
+    FanTachHealth health;    ///< 健康状态
+    FanState last_state;     ///< 上次采样时的档位（检测档位变化）
+    uint16_t last_target;    ///< 上次采样时的目标转速
+    uint32_t settle_ms;      ///< 档位变化后已经过的时间
+    uint8_t stall_count;     ///< 连续堵转窗口数
+    uint8_t under_count;     ///< 连续转速不足窗口数
+    float trim_duty;         ///< 闭环调速当前占空比
+} FanTachState;
+
+static FanTachState s_tach[FAN_MAX_COUNT] = {0};
+static uint32_t s_window_ms = 0;
+
+esp_err_t fan_tach_init(void) {
+    uint8_t fan_count = fan_control_get_count();
+    int enabled = 0;
+
+    for (int i = 0; i < fan_count; i++) {
+        const FanConfig *cfg = fan_control_get_config((FanId)i);
+        s_tach[i] = (FanTachState){ .health = FAN_TACH_NONE };
+
+        if (cfg == NULL || cfg->tach_gpio == FAN_TACH_GPIO_NONE) {
+            continue;
+        }
+
+        esp_err_t err = fan_tach_hal_init((FanId)i, cfg->tach_gpio);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Fan%d 转速计 GPIO%d 初始化失败 (%d)，按无反馈运行", i, cfg->tach_gpio, err);
+            continue;
+        }
+
+        s_tach[i].enabled = true;
+        s_tach[i].pulses_per_rev = cfg->pulses_per_rev;
+        s_tach[i].health = FAN_TACH_OK;
+        enabled++;
+        ESP_LOGI(TAG, "Fan%d 转速计 GPIO%d，%d 脉冲/转", i, cfg->tach_gpio, cfg->pulses_per_rev);
+    }
+
+    s_window_ms = 0;
+    ESP_LOGI(TAG, "转速反馈初始化完成（%d/%d 个风扇）", enabled, fan_count);
+    return ESP_OK;
+}
+
+/**
+ * @brief 转速闭环：按实测转速微调占空比
+ */
+static void fan_tach_trim(FanId id, FanTachState *t, uint16_t target_rpm) {
+    const FanConfig *cfg = fan_control_get_config(id);
+    float error = (float)target_rpm - (float)t->rpm;
+
+    if (error > -FAN_RPM_DEADBAND_RATIO * target_rpm && error < FAN_RPM_DEADBAND_RATIO * target_rpm) {
+        return;
+    }
+
+    float step = error * FAN_RPM_KI;
+    if (step > FAN_RPM_MAX_STEP) step = FAN_RPM_MAX_STEP;
+    if (step < -FAN_RPM_MAX_STEP) step = -FAN_RPM_MAX_STEP;
+
+    float duty = t->trim_duty + step;
+    if (duty < cfg->min_duty) duty = cfg->min_duty;
+    if (duty > cfg->max_duty) duty = cfg->max_duty;
+
+    if ((uint8_t)(duty + 0.5f) != fan_control_get_pwm(id)) {
+        fan_control_set_pwm(id, (uint8_t)(duty + 0.5f));
+        ESP_LOGD(TAG, "Fan%d 闭环调速: 目标 %d rpm, 实测 %d rpm, PWM -> %d",
+                 id, target_rpm, t->rpm, (uint8_t)(duty + 0.5f));
+    }
+    t->trim_duty = duty;
+}
+
+/**
+ * @brief 堵转/转速不足检测
+ * @return true 新产生告警
+ */
+static bool fan_tach_check_health(FanId id, FanTachState *t, uint8_t pwm, uint16_t target_rpm) {
+    FanTachHealth old_health = t->health;
+
+    if (pwm == 0 || t->settle_ms < FAN_TACH_SETTLE_MS) {
+        // 风扇关闭或仍在加速，清除计数（已有告警保持到风扇恢复转动）
+        t->stall_count = 0;
+        t->under_count = 0;
+        if (pwm == 0) {
+            t->health = FAN_TACH_OK;
+        }
+        return false;
+    }
+
+    if (t->rpm < FAN_STALL_RPM) {
+        if (t->stall_count < FAN_STALL_SAMPLES) {
+            t->stall_count++;
+        }
+    } else {
+        t->stall_count = 0;
+    }
+
+    const FanConfig *cfg = fan_control_get_config(id);
+    bool saturated = (pwm >= cfg->max_duty);
+    if (target_rpm > 0 && saturated && t->rpm < target_rpm * FAN_UNDERSPEED_RATIO) {
+        if (t->under_count < FAN_UNDERSPEED_SAMPLES) {
+            t->under_count++;
+        }
+    } else {
+        t->under_count = 0;
+    }
+
+    if (t->stall_count >= FAN_STALL_SAMPLES) {
+        t->health = FAN_TACH_STALL;
+    } else if (t->under_count >= FAN_UNDERSPEED_SAMPLES) {
+        t->health = FAN_TACH_UNDERSPEED;
+    } else if (t->stall_count == 0 && t->under_count == 0) {
+        t->health = FAN_TACH_OK;
+    }
+
+    if (t->health != old_health && t->health != FAN_TACH_OK) {
+        ESP_LOGW(TAG, "Fan%d %s: %d rpm (PWM %d, 目标 %d rpm)",
+                 id, fan_tach_health_to_string(t->health), t->rpm, pwm, target_rpm);
+        return true;
+    }
+    if (t->health != old_health) {
+        ESP_LOGI(TAG, "Fan%d 转速恢复正常: %d rpm", id, t->rpm);
+    }
+    return false;
+}
+
+uint32_t fan_tach_update(uint32_t elapsed_ms) {
+    s_window_ms += elapsed_ms;
+    if (s_window_ms < FAN_TACH_WINDOW_MS) {
+        return 0;
+    }
+    uint32_t window_ms = s_window_ms;
+    s_window_ms = 0;
+
+    uint32_t alarms = 0;
+    uint8_t fan_count = fan_control_get_count();
+
+    for (int i = 0; i < fan_count; i++) {
+        FanTachState *t = &s_tach[i];
+        if (!t->enabled) {
+            continue;
+        }
+
+        uint32_t pulses = 0;
+        if (fan_tach_hal_read((FanId)i, window_ms, &pulses) != ESP_OK) {
+            continue;
+        }
+        t->rpm = (uint16_t)((uint64_t)pulses * 60000 / ((uint64_t)t->pulses_per_rev * window_ms));
+
+        // 档位或目标转速变化：重新计时，闭环从开环占空比重新开始
+        FanState state = fan_control_get_state((FanId)i);
+        uint16_t target_rpm = fan_control_get_target_rpm((FanId)i);
+        if (state != t->last_state || target_rpm != t->last_target) {
+            t->last_state = state;
+            t->last_target = target_rpm;
+            t->settle_ms = 0;
+            t->trim_duty = fan_control_get_pwm((FanId)i);
+        } else if (t->settle_ms < FAN_TACH_SETTLE_MS) {
+            t->settle_ms += window_ms;
+        }
+
+        uint8_t pwm = fan_control_get_pwm((FanId)i);
+        if (fan_tach_check_health((FanId)i, t, pwm, target_rpm)) {
+            alarms |= 1u << i;
+        }
+
+        // 堵转（含确认前的疑似堵转）时不调速，提高占空比无意义
+        if (target_rpm > 0 && pwm > 0 && t->settle_ms >= FAN_TACH_SETTLE_MS && t->rpm >= FAN_STALL_RPM) {
+            fan_tach_trim((FanId)i, t, target_rpm);
+        }
+    }
+
+    return alarms;
+}
+
+uint16_t fan_tach_get_rpm(FanId id) {
+    if (id >= FAN_MAX_COUNT || !s_tach[id].enabled) {
+        return 0;
+    }
+    return s_tach[id].rpm;
+}
+
+FanTachHealth fan_tach_get_health(FanId id) {
+    if (id >= FAN_MAX_COUNT || !s_tach[id].enabled) {
+        return FAN_TACH_NONE;
+    }
+    return s_tach[id].health;
+}
+
+const char *fan_tach_health_to_string(FanTachHealth health) {
+    switch (health) {
+        case FAN_TACH_OK:         return "OK";
+        case FAN_TACH_UNDERSPEED: return "UNDERSPEED";
+        case FAN_TACH_STALL:      return "STALL";
+        default:                  return NULL;
+    }
+}
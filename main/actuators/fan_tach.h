@@ -0,0 +1,60 @@
+/**
+ * @file fan_tach.h
+ * @brief 风扇转速反馈接口定义 - PCNT 转速计 + 堵转检测 + 转速闭环
+ */
+
+#ifndef FAN_TACH_H
+#define FAN_TACH_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 风扇转速健康状态
+ */
+typedef enum {
+    FAN_TACH_NONE = 0,      ///< 未配置转速计
+    FAN_TACH_OK,            ///< 转速正常（或风扇关闭）
+    FAN_TACH_UNDERSPEED,    ///< 转速不足（闭环调速已达上限仍低于目标）
+    FAN_TACH_STALL          ///< 堵转或断线（有占空比但无转速脉冲）
+} FanTachHealth;
+
+/**
+ * @brief 初始化转速反馈
+ * 为配置了 tach_gpio 的风扇分配 PCNT 单元（ESP32-S3 共 4 个）
+ * 需在 fan_control_init() 之后调用
+ * @return ESP_OK 成功（部分风扇无可用 PCNT 单元时仅告警），ESP_FAIL 失败
+ */
+esp_err_t fan_tach_init(void);
+
+/**
+ * @brief 转速采样与闭环调速（周期调用）
+ * 累计调用间隔，满 1 秒后读取脉冲数计算转速，执行堵转/转速不足检测，
+ * 并对配置了目标转速的风扇微调占空比
+ * @param elapsed_ms 距上次调用的时间（毫秒）
+ * @return 本次新产生告警的风扇位掩码（bit i = Fan i）
+ */
+uint32_t fan_tach_update(uint32_t elapsed_ms);
+
+/**
+ * @brief 获取单个风扇实测转速
+ * @param id 风扇ID
+ * @return 转速 rpm，未配置转速计或无效ID返回0
+ */
+uint16_t fan_tach_get_rpm(FanId id);
+
+/**
+ * @brief 获取单个风扇转速健康状态
+ * @param id 风扇ID
+ * @return FanTachHealth，无效ID返回FAN_TACH_NONE
+ */
+FanTachHealth fan_tach_get_health(FanId id);
+
+/**
+ * @brief FanTachHealth 转字符串（"OK"/"UNDERSPEED"/"STALL"，无转速计返回NULL）
+ */
+const char *fan_tach_health_to_string(FanTachHealth health);
+
+#endif // FAN_TACH_H
@@ -0,0 +1,48 @@
+/**
+ * @file fan_tach_hal.h
+ * @brief 风扇转速计脉冲计数硬件抽象
+ *
+ * 两种实现二选一（menuconfig → 风扇控制 → 使用模拟转速计）：
+ *   fan_tach_pcnt.c: PCNT 外设计数（默认）
+ *   fan_tach_mock.c: 按当前 PWM 模拟脉冲，用于无风扇硬件时测试堵转检测和闭环调速
+ */
+
+#ifndef FAN_TACH_HAL_H
+#define FAN_TACH_HAL_H
+
+#include "esp_err.h"
+#include "main.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 初始化单个风扇的脉冲计数通道
+ * @param id 风扇ID
+ * @param gpio 转速计输入 GPIO（开漏输出，启用内部上拉）
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 无可用计数单元，其他 失败
+ */
+esp_err_t fan_tach_hal_init(FanId id, uint8_t gpio);
+
+/**
+ * @brief 读取并清零脉冲计数
+ * @param id 风扇ID
+ * @param elapsed_ms 本次计数窗口长度（PCNT 实现不使用，模拟实现用于生成脉冲）
+ * @param[out] pulses 窗口内脉冲数
+ * @return ESP_OK 成功，其他 失败
+ */
+esp_err_t fan_tach_hal_read(FanId id, uint32_t elapsed_ms, uint32_t *pulses);
+
+#if CONFIG_FAN_TACH_MOCK
+/**
+ * @brief 模拟风扇堵转（转速立即归零）
+ */
+void fan_tach_mock_set_stalled(FanId id, bool stalled);
+
+/**
+ * @brief 模拟供电电压/滤网阻力变化（转速 = 满速 × 占空比 × gain，默认 1.0）
+ */
+void fan_tach_mock_set_gain(FanId id, float gain);
+#endif
+
+#endif // FAN_TACH_HAL_H
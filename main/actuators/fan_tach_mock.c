@@ -0,0 +1,74 @@
+/**
+ * @file fan_tach_mock.c
+ * @brief 风扇转速计脉冲计数 - 模拟实现（无风扇硬件测试用）
+ *
+ * 按 fan_control 当前 PWM 生成脉冲：目标转速 = 满速 × 占空比/255 × gain，
+ * 实际转速一阶惯性逼近目标。可注入堵转和增益变化，验证告警与闭环调速。
+ */
+
+#include "fan_tach_hal.h"
+
+#if CONFIG_FAN_TACH_MOCK
+
+#include "fan_control.h"
+#include "esp_log.h"
+
+static const char *TAG = "FAN_TACH_MOCK";
+
+#define FAN_TACH_MOCK_FULL_RPM   6000.0f  // 占空比 255、gain 1.0 时的转速
+#define FAN_TACH_MOCK_TAU_MS     1500.0f  // 转速惯性时间常数
+
+typedef struct {
+    bool ready;
+    bool stalled;
+    float gain;
+    float rpm;             ///< 当前模拟转速
+    float pulse_residue;   ///< 不足 1 个脉冲的余量
+} FanTachMock;
+
+static FanTachMock s_mock[FAN_MAX_COUNT] = {0};
+
+esp_err_t fan_tach_hal_init(FanId id, uint8_t gpio) {
+    if (id >= FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_mock[id] = (FanTachMock){ .ready = true, .gain = 1.0f };
+    ESP_LOGW(TAG, "Fan%d 使用模拟转速计（GPIO%d 未使用）", id, gpio);
+    return ESP_OK;
+}
+
+esp_err_t fan_tach_hal_read(FanId id, uint32_t elapsed_ms, uint32_t *pulses) {
+    if (id >= FAN_MAX_COUNT || !s_mock[id].ready || !pulses) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FanTachMock *m = &s_mock[id];
+    const FanConfig *cfg = fan_control_get_config(id);
+    float target = m->stalled ? 0.0f
+                 : FAN_TACH_MOCK_FULL_RPM * fan_control_get_pwm(id) / 255.0f * m->gain;
+
+    // 一阶惯性：alpha = dt / (tau + dt)
+    float alpha = elapsed_ms / (FAN_TACH_MOCK_TAU_MS + elapsed_ms);
+    m->rpm = m->stalled ? 0.0f : m->rpm + (target - m->rpm) * alpha;
+
+    float exact = m->rpm * cfg->pulses_per_rev * elapsed_ms / 60000.0f + m->pulse_residue;
+    *pulses = (uint32_t)exact;
+    m->pulse_residue = exact - *pulses;
+    return ESP_OK;
+}
+
+void fan_tach_mock_set_stalled(FanId id, bool stalled) {
+    if (id < FAN_MAX_COUNT) {
+        s_mock[id].stalled = stalled;
+        ESP_LOGW(TAG, "Fan%d 模拟%s", id, stalled ? "堵转" : "恢复");
+    }
+}
+
+void fan_tach_mock_set_gain(FanId id, float gain) {
+    if (id < FAN_MAX_COUNT && gain >= 0.0f) {
+        s_mock[id].gain = gain;
+        ESP_LOGW(TAG, "Fan%d 模拟增益 %.2f", id, gain);
+    }
+}
+
+#endif // CONFIG_FAN_TACH_MOCK
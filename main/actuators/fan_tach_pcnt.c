@@ -0,0 +1,99 @@
+/**
+ * @file fan_tach_pcnt.c
+ * @brief 风扇转速计脉冲计数 - PCNT 外设实现
+ */
+
+#include "fan_tach_hal.h"
+
+#if !CONFIG_FAN_TACH_MOCK
+
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/pulse_cnt.h"
+
+static const char *TAG = "FAN_TACH_PCNT";
+
+#define FAN_TACH_PCNT_HIGH_LIMIT  32767   // 6000rpm × 2ppr 每秒 200 脉冲，远低于上限
+#define FAN_TACH_PCNT_LOW_LIMIT   -1
+#define FAN_TACH_GLITCH_NS        10000   // 滤除 10µs 以下毛刺（PWM 串扰）
+
+static pcnt_unit_handle_t s_units[FAN_MAX_COUNT] = {NULL};
+
+esp_err_t fan_tach_hal_init(FanId id, uint8_t gpio) {
+    if (id >= FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcnt_unit_config_t unit_cfg = {
+        .low_limit = FAN_TACH_PCNT_LOW_LIMIT,
+        .high_limit = FAN_TACH_PCNT_HIGH_LIMIT,
+    };
+    pcnt_unit_handle_t unit = NULL;
+    esp_err_t err = pcnt_new_unit(&unit_cfg, &unit);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Fan%d 无可用 PCNT 单元 (%d)", id, err);
+        return err;
+    }
+
+    pcnt_glitch_filter_config_t filter_cfg = {
+        .max_glitch_ns = FAN_TACH_GLITCH_NS,
+    };
+    err = pcnt_unit_set_glitch_filter(unit, &filter_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Fan%d PCNT 滤波器配置失败 (%d)", id, err);
+    }
+
+    // 仅用边沿输入，上升沿计数，下降沿保持
+    pcnt_chan_config_t chan_cfg = {
+        .edge_gpio_num = gpio,
+        .level_gpio_num = -1,
+    };
+    pcnt_channel_handle_t chan = NULL;
+    err = pcnt_new_channel(unit, &chan_cfg, &chan);
+    if (err == ESP_OK) {
+        err = pcnt_channel_set_edge_action(chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fan%d PCNT 通道配置失败 (%d)", id, err);
+        pcnt_del_unit(unit);
+        return err;
+    }
+
+    // 转速计为开漏输出，启用内部上拉
+    gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+
+    err = pcnt_unit_enable(unit);
+    if (err == ESP_OK) {
+        err = pcnt_unit_clear_count(unit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_start(unit);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fan%d PCNT 启动失败 (%d)", id, err);
+        return err;
+    }
+
+    s_units[id] = unit;
+    return ESP_OK;
+}
+
+esp_err_t fan_tach_hal_read(FanId id, uint32_t elapsed_ms, uint32_t *pulses) {
+    (void)elapsed_ms;
+
+    if (id >= FAN_MAX_COUNT || s_units[id] == NULL || !pulses) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int count = 0;
+    esp_err_t err = pcnt_unit_get_count(s_units[id], &count);
+    if (err != ESP_OK) {
+        return err;
+    }
+    pcnt_unit_clear_count(s_units[id]);
+
+    *pulses = (count > 0) ? (uint32_t)count : 0;
+    return ESP_OK;
+}
+
+#endif // !CONFIG_FAN_TACH_MOCK
@@ -0,0 +1,249 @@
+/**
+ * @file co2_predictor.c
+ * @brief CO2 短时预测与预测式预通风
+ *
+ * 模型（单区域质量平衡，1 分钟步长）：
+ *   C[t+1] = C[t] + G - k(档位) · (C[t] - CO2_BASELINE)
+ * 其中 k = 自然渗透 + Σ 各风扇档位衰减率（由 vent_ident 在线辨识），G 为人员等产生的 CO2 速率。
+ * 历史窗口按分钟记录 CO2 均值与当时生效的 k，用最小二乘拟合 G
+ * （k 已知时 G 的最小二乘解即残差 ΔC + k·(C - 基准) 的均值）。
+ */
+
+#include "co2_predictor.h"
+#include "vent_ident.h"
+#include "runtime_config.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "CO2_PREDICT";
+
+#define SAMPLES_PER_MIN      60       ///< 1Hz 采样，每分钟聚合一次
+#define DECAY_SCALE          10000.0f ///< 衰减率定点缩放（1e-4/分钟）
+#define NO_START             255      ///< 方案无需启动风扇
+
+/**
+ * @brief 分钟历史点（紧凑存储）
+ */
+typedef struct {
+    uint16_t co2;      ///< 分钟均值（ppm）
+    uint16_t decay;    ///< 该分钟平均衰减率（×DECAY_SCALE）
+} HistoryPoint;
+
+static HistoryPoint s_history[PREDICT_HISTORY_MIN];
+static uint8_t s_head = 0;       ///< 下一个写入位置
+static uint8_t s_count = 0;      ///< 有效点数
+
+// 当前分钟累加器
+static float s_acc_co2 = 0.0f;
+static float s_acc_decay = 0.0f;
+static uint8_t s_acc_n = 0;
+
+// 决策保持
+static FanState s_last_level = FAN_OFF;
+static uint32_t s_hold_sec = PREDICT_MIN_HOLD_SEC;
+
+static Co2PredictorInfo s_info = {0};
+
+/**
+ * @brief 计算给定档位（全部风扇统一）下的总衰减率
+ */
+static float level_decay(FanState level, uint8_t fan_count) {
+    float k = vent_ident_get_infiltration();
+    for (uint8_t i = 0; i < fan_count; i++) {
+        k += vent_ident_get_fan_decay((FanId)i, level);
+    }
+    return k;
+}
+
+/**
+ * @brief 按时间顺序取第 i 个历史点（0 = 最旧）
+ */
+static const HistoryPoint *history_at(uint8_t i) {
+    uint8_t idx = (uint8_t)((s_head + PREDICT_HISTORY_MIN - s_count + i) % PREDICT_HISTORY_MIN);
+    return &s_history[idx];
+}
+
+/**
+ * @brief 拟合最近 PREDICT_FIT_MIN 分钟的斜率与产生率
+ * @return true 点数足够
+ */
+static bool fit_generation(float *slope, float *generation) {
+    uint8_t n = s_count < PREDICT_FIT_MIN ? s_count : PREDICT_FIT_MIN;
+    if (n < PREDICT_MIN_FIT_POINTS) {
+        return false;
+    }
+    uint8_t first = s_count - n;
+
+    // 线性回归斜率（ppm/分钟）
+    float sum_t = 0.0f, sum_c = 0.0f, sum_tt = 0.0f, sum_tc = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        float t = (float)i;
+        float c = (float)history_at(first + i)->co2;
+        sum_t += t;
+        sum_c += c;
+        sum_tt += t * t;
+        sum_tc += t * c;
+    }
+    float denom = n * sum_tt - sum_t * sum_t;
+    *slope = (denom > 0.0f) ? (n * sum_tc - sum_t * sum_c) / denom : 0.0f;
+
+    // G = mean(ΔC + k·(C - 基准))
+    float sum_g = 0.0f;
+    for (uint8_t i = 0; i + 1 < n; i++) {
+        const HistoryPoint *p = history_at(first + i);
+        const HistoryPoint *q = history_at(first + i + 1);
+        float k = p->decay / DECAY_SCALE;
+        sum_g += ((float)q->co2 - (float)p->co2) + k * ((float)p->co2 - CO2_BASELINE);
+    }
+    float g = sum_g / (float)(n - 1);
+    *generation = g > 0.0f ? g : 0.0f;
+    return true;
+}
+
+/**
+ * @brief 前向仿真一个方案：先以 k_off 运行 delay 分钟，然后以 k_on 运行到时域结束
+ * @return 时域内预测峰值
+ */
+static float simulate(float c0, float g, uint8_t delay, float k_off, float k_on) {
+    float c = c0;
+    float peak = c0;
+    for (uint8_t t = 0; t < PREDICT_HORIZON_MIN; t++) {
+        float k = (t < delay) ? k_off : k_on;
+        c += g - k * (c - CO2_BASELINE);
+        if (c > peak) {
+            peak = c;
+        }
+    }
+    return peak;
+}
+
+void co2_predictor_reset(void) {
+    memset(s_history, 0, sizeof(s_history));
+    s_head = 0;
+    s_count = 0;
+    s_acc_co2 = 0.0f;
+    s_acc_decay = 0.0f;
+    s_acc_n = 0;
+    s_last_level = FAN_OFF;
+    s_hold_sec = PREDICT_MIN_HOLD_SEC;
+    memset(&s_info, 0, sizeof(s_info));
+}
+
+bool co2_predictor_add_sample(float co2_ppm, const FanState fans[], uint8_t fan_count) {
+    const RuntimeConfig *cfg = runtime_config_get();
+    if (!fans || co2_ppm < cfg->co2_min_valid || co2_ppm > cfg->co2_max_valid) {
+        return false;
+    }
+
+    float decay = vent_ident_get_infiltration();
+    for (uint8_t i = 0; i < fan_count && i < FAN_MAX_COUNT; i++) {
+        decay += vent_ident_get_fan_decay((FanId)i, fans[i]);
+    }
+
+    s_acc_co2 += co2_ppm;
+    s_acc_decay += decay;
+    if (++s_acc_n < SAMPLES_PER_MIN) {
+        return false;
+    }
+
+    HistoryPoint *p = &s_history[s_head];
+    p->co2 = (uint16_t)(s_acc_co2 / s_acc_n + 0.5f);
+    p->decay = (uint16_t)(s_acc_decay / s_acc_n * DECAY_SCALE + 0.5f);
+    s_head = (s_head + 1) % PREDICT_HISTORY_MIN;
+    if (s_count < PREDICT_HISTORY_MIN) {
+        s_count++;
+    }
+
+    s_acc_co2 = 0.0f;
+    s_acc_decay = 0.0f;
+    s_acc_n = 0;
+    return true;
+}
+
+bool co2_predictor_estimate_generation(float *generation) {
+    float slope;
+    return generation && fit_generation(&slope, generation);
+}
+
+bool co2_predictor_decide(float current_co2, uint8_t fan_count, float threshold, FanState *out_level) {
+    if (!out_level || fan_count == 0) {
+        return false;
+    }
+
+    float slope, g;
+    if (!fit_generation(&slope, &g)) {
+        s_info.valid = false;
+        return false;
+    }
+
+    // 最短保持时间内沿用上次决策（每 1Hz 调用计 1 秒）
+    if (s_hold_sec < PREDICT_MIN_HOLD_SEC) {
+        s_hold_sec++;
+        *out_level = s_last_level;
+        return true;
+    }
+
+    const float limit = threshold - PREDICT_MARGIN_PPM;
+    const float k_off = level_decay(FAN_OFF, fan_count);
+    const float k_level[] = {k_off, level_decay(FAN_LOW, fan_count), level_decay(FAN_HIGH, fan_count)};
+
+    // 候选方案：全程关闭，或延迟 d 分钟后以 LOW/HIGH 运行；选成本最低的可行方案
+    FanState best_level = FAN_HIGH;
+    uint8_t best_delay = 0;
+    float best_cost = -1.0f;
+    float best_peak = simulate(current_co2, g, 0, k_off, k_level[FAN_HIGH]);
+
+    float peak = simulate(current_co2, g, PREDICT_HORIZON_MIN, k_off, k_off);
+    if (peak < limit) {
+        best_level = FAN_OFF;
+        best_delay = NO_START;
+        best_cost = 0.0f;
+        best_peak = peak;
+    } else {
+        static const FanState levels[] = {FAN_LOW, FAN_HIGH};
+        for (uint8_t l = 0; l < 2; l++) {
+            float unit = (levels[l] == FAN_LOW ? PREDICT_COST_LOW : PREDICT_COST_HIGH) * fan_count;
+            for (uint8_t d = 0; d < PREDICT_HORIZON_MIN; d++) {
+                float cost = unit * (PREDICT_HORIZON_MIN - d);
+                if (best_cost >= 0.0f && cost >= best_cost) {
+                    continue;
+                }
+                peak = simulate(current_co2, g, d, k_off, k_level[levels[l]]);
+                if (peak < limit) {
+                    best_level = levels[l];
+                    best_delay = d;
+                    best_cost = cost;
+                    best_peak = peak;
+                }
+            }
+        }
+        if (best_cost < 0.0f) {
+            ESP_LOGD(TAG, "无可行方案，预测峰值 %.0f ppm，使用 HIGH", best_peak);
+        }
+    }
+
+    // 方案的第一步：延迟 0 分钟才立即启动
+    FanState level = (best_delay == 0) ? best_level : FAN_OFF;
+
+    s_info.valid = true;
+    s_info.slope = slope;
+    s_info.generation = g;
+    s_info.forecast_peak = best_peak;
+    s_info.start_delay = best_delay;
+
+    if (level != s_last_level) {
+        ESP_LOGI(TAG, "预测决策 %d → %d (斜率 %.1f ppm/min, G=%.1f, 峰值 %.0f ppm)",
+                 s_last_level, level, slope, g, best_peak);
+        s_last_level = level;
+        s_hold_sec = 0;
+    }
+
+    *out_level = level;
+    return true;
+}
+
+void co2_predictor_get_info(Co2PredictorInfo *info) {
+    if (info) {
+        *info = s_info;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file co2_predictor.h
+ * @brief CO2 短时预测接口定义 - 预测式预通风
+ */
+
+#ifndef CO2_PREDICTOR_H
+#define CO2_PREDICTOR_H
+
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 预测器拟合结果（用于日志与状态上报）
+ */
+typedef struct {
+    bool valid;            ///< 历史点数足够，拟合有效
+    float slope;           ///< 最近 CO2 变化率（ppm/分钟）
+    float generation;      ///< 估计的 CO2 产生率 G（ppm/分钟）
+    float forecast_peak;   ///< 所选方案在预测时域内的峰值（ppm）
+    uint8_t start_delay;   ///< 所选方案的启动延迟（分钟，255 = 无需启动）
+} Co2PredictorInfo;
+
+/**
+ * @brief 重置预测器历史
+ */
+void co2_predictor_reset(void);
+
+/**
+ * @brief 添加 1Hz 采样点（内部按分钟取均值存入历史窗口）
+ * @param co2_ppm CO2 浓度（ppm，原始读数）
+ * @param fans 当前已生效的风扇状态数组
+ * @param fan_count 风扇数量
+ * @return true 本次采样完成了一个新的分钟点
+ */
+bool co2_predictor_add_sample(float co2_ppm, const FanState fans[], uint8_t fan_count);
+
+/**
+ * @brief 用最近 PREDICT_FIT_MIN 分钟历史估计 CO2 产生率（供作息学习判定有人）
+ * @param[out] generation 产生率（ppm/分钟，≥ 0）
+ * @return true 历史足够，false 点数不足
+ */
+bool co2_predictor_estimate_generation(float *generation);
+
+/**
+ * @brief 预测式决策（所有风扇统一档位）
+ * 拟合 G 后对候选方案（全程关闭 / 延迟 d 分钟后 LOW 或 HIGH）做前向仿真，
+ * 选择预测峰值低于 threshold - PREDICT_MARGIN_PPM 的最低成本方案，输出其第一步档位。
+ * 计算量固定为 (2 × PREDICT_HORIZON_MIN + 1) 个方案 × PREDICT_HORIZON_MIN 步。
+ * @param current_co2 当前 CO2（ppm，原始读数）
+ * @param fan_count 风扇数量
+ * @param threshold 需保持低于的 CO2 阈值（ppm）
+ * @param[out] out_level 决策档位
+ * @return true 预测有效，false 历史不足（调用方应回退到阈值控制）
+ */
+bool co2_predictor_decide(float current_co2, uint8_t fan_count, float threshold, FanState *out_level);
+
+/**
+ * @brief 获取最近一次拟合/预测结果
+ * @param[out] info 输出结果
+ */
+void co2_predictor_get_info(Co2PredictorInfo *info);
+
+#endif // CO2_PREDICTOR_H
@@ -5,19 +5,27 @@
 
 #include "decision_engine.h"
 #include "local_mode.h"
+#include "co2_predictor.h"
+#include "occupancy_habit.h"
+#include "runtime_config.h"
 #include "esp_log.h"
+#include <stdio.h>
 
 static const char *TAG = "DECISION";
 
-void decision_make(SensorData *sensor, const FanState remote_cmd[FAN_COUNT],
-                   SystemMode mode, FanState out_fans[FAN_COUNT]) {
+void decision_make(SensorData *sensor, const FanState remote_cmd[], uint8_t fan_count,
+                   SystemMode mode, FanState out_fans[]) {
     if (!out_fans) {
         ESP_LOGE(TAG, "输出数组为空");
         return;
     }
 
+    if (fan_count > FAN_MAX_COUNT) {
+        fan_count = FAN_MAX_COUNT;
+    }
+
     // 默认全部关闭
-    for (int i = 0; i < FAN_COUNT; i++) {
+    for (int i = 0; i < fan_count; i++) {
         out_fans[i] = FAN_OFF;
     }
 
@@ -36,29 +44,82 @@ void decision_make(SensorData *sensor, const FanState remote_cmd[FAN_COUNT],
             ESP_LOGW(TAG, "远程模式但命令为空");
             return;
         }
-        // 直接使用远程命令
-        for (int i = 0; i < FAN_COUNT; i++) {
+        // 直接使用远程命令（日志合为一行，如 "[2,1,0]"）
+        char buf[2 * FAN_MAX_COUNT + 1] = "";
+        int pos = 0;
+        for (int i = 0; i < fan_count; i++) {
             out_fans[i] = remote_cmd[i];
+            pos += snprintf(buf + pos, sizeof(buf) - pos, i == 0 ? "%d" : ",%d", out_fans[i]);
         }
-        ESP_LOGI(TAG, "远程模式: fan_0=%d, fan_1=%d, fan_2=%d",
-                 out_fans[0], out_fans[1], out_fans[2]);
+        ESP_LOGI(TAG, "远程模式: 风扇命令=[%s]", buf);
         return;
     }
 
-    // MODE_LOCAL: 3个风扇统一根据 CO2 决策（暂时同步）
-    FanState local_decision = local_mode_decide(sensor->pollutants.co2);
-    for (int i = 0; i < FAN_COUNT; i++) {
+    // MODE_LOCAL: 所有风扇统一根据 CO2 决策（暂时同步）
+    float co2_low = runtime_config_get()->co2_low;
+    FanState threshold_decision = local_mode_decide(sensor->pollutants.co2);
+    FanState local_decision = threshold_decision;
+#if CONFIG_CO2_PREDICTIVE_VENTILATION
+    // 预测有效时由预测决定启停时机，超过高阈值仍强制 HIGH 兜底
+    FanState predicted;
+    if (co2_predictor_decide(sensor->pollutants.co2, fan_count, co2_low, &predicted) &&
+        threshold_decision != FAN_HIGH) {
+        local_decision = predicted;
+    }
+#endif
+    // 作息提示：通常即将有人时提前低速通风；通常即将离开且 CO2 已低于低阈值时，
+    // 不再做预测或预通风带来的额外通风，回到阈值决策（阈值决策本身不被覆盖）
+    HabitHint hint = occupancy_habit_get_hint();
+    if (hint == HABIT_HINT_PRESTART && local_decision == FAN_OFF) {
+        local_decision = FAN_LOW;
+    } else if (hint == HABIT_HINT_EARLY_STOP && sensor->pollutants.co2 < co2_low &&
+               local_decision > threshold_decision) {
+        local_decision = threshold_decision;
+    }
+    for (int i = 0; i < fan_count; i++) {
         out_fans[i] = local_decision;
     }
     ESP_LOGI(TAG, "本地模式: CO2=%.0f, 统一决策=%d", sensor->pollutants.co2, local_decision);
 }
 
-SystemMode decision_detect_mode(bool wifi_ok, bool sensor_ok) {
+SystemMode decision_detect_mode(bool wifi_ok, RemoteLease lease, bool sensor_ok, ModeReason *reason) {
+    ModeReason r;
+    SystemMode mode;
+
     if (!sensor_ok) {
-        return MODE_SAFE_STOP;
+        r = MODE_REASON_SENSOR_FAULT;
+        mode = MODE_SAFE_STOP;
+    } else if (!wifi_ok) {
+        r = MODE_REASON_NO_WIFI;
+        mode = MODE_LOCAL;
+    } else if (lease == LEASE_VALID) {
+        r = MODE_REASON_LEASE;
+        mode = MODE_REMOTE;
+    } else {
+        // 后端沉默（租约过期）或从未下发命令：回退本地 CO2 控制
+        r = (lease == LEASE_EXPIRED) ? MODE_REASON_LEASE_EXPIRED : MODE_REASON_NO_LEASE;
+        mode = MODE_LOCAL;
     }
-    if (wifi_ok) {
-        return MODE_REMOTE;
+
+    if (reason) {
+        *reason = r;
+    }
+    return mode;
+}
+
+const char* decision_mode_reason_to_string(ModeReason reason) {
+    switch (reason) {
+        case MODE_REASON_LEASE:
+            return "LEASE";
+        case MODE_REASON_NO_WIFI:
+            return "NO_WIFI";
+        case MODE_REASON_NO_LEASE:
+            return "NO_LEASE";
+        case MODE_REASON_LEASE_EXPIRED:
+            return "LEASE_EXPIRED";
+        case MODE_REASON_SENSOR_FAULT:
+            return "SENSOR_FAULT";
+        default:
+            return "UNKNOWN";
     }
-    return MODE_LOCAL;
 }
@@ -13,26 +13,37 @@
  * @brief 决策风扇状态（多风扇版本）
  *
  * MODE_REMOTE: 直接使用远程命令数组
- * MODE_LOCAL: 3个风扇统一根据 CO2 阈值决策（暂时同步）
+ * MODE_LOCAL: 所有风扇统一根据 CO2 阈值决策（暂时同步），
+ *             启用预测式预通风时由 co2_predictor 提前决定启停时机，
+ *             occupancy_habit 按周作息提前低速通风或提前停止
  * MODE_SAFE_STOP: 强制关闭所有风扇
  *
  * @param sensor 传感器数据
  * @param remote_cmd 远程命令数组（MODE_REMOTE 时使用）
+ * @param fan_count 风扇数量（1 ~ FAN_MAX_COUNT）
  * @param mode 系统运行模式
- * @param out_fans 输出3个风扇状态数组
+ * @param out_fans 输出风扇状态数组（前 fan_count 项）
  */
-void decision_make(SensorData *sensor, const FanState remote_cmd[FAN_COUNT],
-                   SystemMode mode, FanState out_fans[FAN_COUNT]);
+void decision_make(SensorData *sensor, const FanState remote_cmd[], uint8_t fan_count,
+                   SystemMode mode, FanState out_fans[]);
 
 /**
  * @brief 检测系统运行模式
  *   传感器异常 -> MODE_SAFE_STOP
- *   WiFi 可用 -> MODE_REMOTE
  *   WiFi 断开 -> MODE_LOCAL
+ *   WiFi 可用且远程租约有效 -> MODE_REMOTE
+ *   WiFi 可用但无租约或租约过期 -> MODE_LOCAL
  * @param wifi_ok WiFi 连接状态
+ * @param lease 远程命令租约状态
  * @param sensor_ok 传感器健康状态
+ * @param[out] reason 判定原因（可为 NULL）
  * @return 系统模式
  */
-SystemMode decision_detect_mode(bool wifi_ok, bool sensor_ok);
+SystemMode decision_detect_mode(bool wifi_ok, RemoteLease lease, bool sensor_ok, ModeReason *reason);
+
+/**
+ * @brief ModeReason 转字符串（用于日志与状态上报）
+ */
+const char* decision_mode_reason_to_string(ModeReason reason);
 
 #endif // DECISION_ENGINE_H
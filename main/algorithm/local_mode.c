@@ -3,6 +3,7 @@
  * @brief 本地模式决策逻辑
  */
 #include "local_mode.h"
+#include "runtime_config.h"
 #include "esp_log.h"
 
 static const char *TAG = "LOCAL_MODE";
@@ -12,9 +13,10 @@ FanState local_mode_decide(float co2_ppm) {
 
     // TODO: 可以添加更多传感器数据和复杂逻辑
     // 基于 CO2 阈值决策风扇状态
-    if (co2_ppm > CO2_THRESHOLD_HIGH) {
+    const RuntimeConfig *cfg = runtime_config_get();
+    if (co2_ppm > cfg->co2_high) {
         return FAN_HIGH;
-    } else if (co2_ppm > CO2_THRESHOLD_LOW) {
+    } else if (co2_ppm > cfg->co2_low) {
         return FAN_LOW;
     } else {
         return FAN_OFF;
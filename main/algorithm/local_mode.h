@@ -9,7 +9,7 @@
 #include "main.h"
 
 /**
- * @brief 本地模式决策
+ * @brief 本地模式决策（阈值取自运行时配置，默认值如下）
  *   CO2 > 1200ppm -> FAN_HIGH
  *   CO2 > 1000ppm -> FAN_LOW
  *   CO2 <= 1000ppm -> FAN_OFF
@@ -0,0 +1,251 @@
+/**
+ * @file occupancy_habit.c
+ * @brief 周作息学习
+ *
+ * 一周 168 个小时桶，每桶保存观测分钟数、有人分钟数与产生率累计（均为整数）。
+ * 每分钟根据 CO2 产生率判定是否有人并累加到当前桶；观测数达到上限时整桶减半，
+ * 使旧数据逐渐淡出。决策时比较"当前"与"HABIT_LEAD_MIN 分钟后"所在桶的有人概率，
+ * 给出提前通风或提前停止的提示。
+ */
+
+#include "occupancy_habit.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "HABIT";
+
+// NVS 存储键值
+#define HABIT_NVS_NAMESPACE  "habit"
+#define HABIT_NVS_KEY_BINS   "bins"
+#define HABIT_VERSION        1
+
+/**
+ * @brief NVS 中保存的直方图（blob）
+ */
+typedef struct {
+    uint8_t version;
+    HabitBin bins[HABIT_BINS];
+} HabitBlob;
+
+static HabitBin s_bins[HABIT_BINS];
+static portMUX_TYPE s_bins_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t s_minutes = 0;
+static uint32_t s_last_save_min = 0;
+static volatile bool s_save_pending = false;
+static volatile bool s_export_pending = false;
+static HabitHint s_last_hint = HABIT_HINT_NONE;
+
+/**
+ * @brief 计算给定时间所在的桶序号
+ * @return 桶序号，时间未同步时返回 -1
+ */
+static int bin_of(time_t t) {
+    if (!is_time_valid()) {
+        return -1;
+    }
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    return timeinfo.tm_wday * 24 + timeinfo.tm_hour;
+}
+
+/**
+ * @brief 保存直方图到 NVS
+ */
+static esp_err_t habit_save(void) {
+    static HabitBlob blob;
+    blob.version = HABIT_VERSION;
+    portENTER_CRITICAL(&s_bins_lock);
+    memcpy(blob.bins, s_bins, sizeof(blob.bins));
+    portEXIT_CRITICAL(&s_bins_lock);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(HABIT_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存作息直方图: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_blob(nvs_handle, HABIT_NVS_KEY_BINS, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "作息直方图保存失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_save_pending = false;
+    s_last_save_min = s_minutes;
+    ESP_LOGI(TAG, "作息直方图已保存到 NVS");
+    return ESP_OK;
+}
+
+/**
+ * @brief 检查单个桶计数是否自洽
+ */
+static bool bin_is_valid(const HabitBin *b) {
+    return b->observed <= HABIT_OBS_MAX &&
+           b->occupied <= b->observed &&
+           b->gen_sum <= (uint32_t)b->occupied * UINT8_MAX;
+}
+
+esp_err_t occupancy_habit_init(void) {
+    memset(s_bins, 0, sizeof(s_bins));
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(HABIT_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "NVS 无作息直方图，从零开始学习");
+        return ESP_OK;
+    }
+
+    static HabitBlob blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs_handle, HABIT_NVS_KEY_BINS, &blob, &len);
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK || len != sizeof(blob) || blob.version != HABIT_VERSION) {
+        ESP_LOGW(TAG, "NVS 作息直方图读取失败或版本不匹配，从零开始学习");
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < HABIT_BINS; i++) {
+        if (!bin_is_valid(&blob.bins[i])) {
+            ESP_LOGW(TAG, "作息直方图数据损坏，从零开始学习");
+            return ESP_OK;
+        }
+    }
+    memcpy(s_bins, blob.bins, sizeof(s_bins));
+
+    ESP_LOGI(TAG, "从 NVS 加载作息直方图");
+    return ESP_OK;
+}
+
+void occupancy_habit_add_minute(float generation) {
+    s_minutes++;
+
+    int bin = bin_of(time(NULL));
+    if (bin >= 0) {
+        bool occupied = generation >= HABIT_OCCUPIED_G;
+        uint32_t g = generation > 0.0f ? (uint32_t)(generation + 0.5f) : 0;
+        if (g > UINT8_MAX) {
+            g = UINT8_MAX;
+        }
+
+        portENTER_CRITICAL(&s_bins_lock);
+        HabitBin *b = &s_bins[bin];
+        if (b->observed >= HABIT_OBS_MAX) {
+            // 老化：整桶减半，比例不变
+            b->observed /= 2;
+            b->occupied /= 2;
+            b->gen_sum /= 2;
+        }
+        b->observed++;
+        if (occupied) {
+            b->occupied++;
+            b->gen_sum += g;
+        }
+        portEXIT_CRITICAL(&s_bins_lock);
+        s_save_pending = true;
+    }
+
+    // 合并写入，降低 Flash 磨损
+    if (s_save_pending && s_minutes - s_last_save_min >= HABIT_SAVE_INTERVAL_MIN) {
+        habit_save();
+    }
+}
+
+int occupancy_habit_get_probability(uint16_t bin) {
+    if (bin >= HABIT_BINS) {
+        return -1;
+    }
+    portENTER_CRITICAL(&s_bins_lock);
+    HabitBin b = s_bins[bin];
+    portEXIT_CRITICAL(&s_bins_lock);
+
+    if (b.observed < HABIT_MIN_OBS) {
+        return -1;
+    }
+    return (int)b.occupied * 100 / b.observed;
+}
+
+HabitHint occupancy_habit_get_hint(void) {
+    time_t now = time(NULL);
+    int bin_now = bin_of(now);
+    int bin_ahead = bin_of(now + HABIT_LEAD_MIN * 60);
+
+    HabitHint hint = HABIT_HINT_NONE;
+    if (bin_now >= 0 && bin_ahead >= 0 && bin_now != bin_ahead) {
+        int p_now = occupancy_habit_get_probability((uint16_t)bin_now);
+        int p_ahead = occupancy_habit_get_probability((uint16_t)bin_ahead);
+        if (p_now >= 0 && p_ahead >= 0) {
+            if (p_now < HABIT_VACANT_PCT && p_ahead >= HABIT_OCCUPIED_PCT) {
+                hint = HABIT_HINT_PRESTART;
+            } else if (p_now >= HABIT_OCCUPIED_PCT && p_ahead < HABIT_VACANT_PCT) {
+                hint = HABIT_HINT_EARLY_STOP;
+            }
+        }
+    }
+
+    if (hint != s_last_hint) {
+        ESP_LOGI(TAG, "作息提示变化: %d → %d", s_last_hint, hint);
+        s_last_hint = hint;
+    }
+    return hint;
+}
+
+esp_err_t occupancy_habit_export_day(uint8_t day, HabitBin out[24]) {
+    if (day >= 7 || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_bins_lock);
+    memcpy(out, &s_bins[day * 24], 24 * sizeof(HabitBin));
+    portEXIT_CRITICAL(&s_bins_lock);
+    return ESP_OK;
+}
+
+esp_err_t occupancy_habit_import_day(uint8_t day, const HabitBin in[24]) {
+    if (day >= 7 || !in) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < 24; i++) {
+        if (!bin_is_valid(&in[i])) {
+            ESP_LOGW(TAG, "导入数据不合法: day=%d hour=%d", day, i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    portENTER_CRITICAL(&s_bins_lock);
+    memcpy(&s_bins[day * 24], in, 24 * sizeof(HabitBin));
+    portEXIT_CRITICAL(&s_bins_lock);
+
+    // 导入后尽快保存（下一分钟写入）
+    s_save_pending = true;
+    s_last_save_min = s_minutes - HABIT_SAVE_INTERVAL_MIN;
+    ESP_LOGI(TAG, "已导入星期 %d 的作息数据", day);
+    return ESP_OK;
+}
+
+void occupancy_habit_clear(void) {
+    portENTER_CRITICAL(&s_bins_lock);
+    memset(s_bins, 0, sizeof(s_bins));
+    portEXIT_CRITICAL(&s_bins_lock);
+
+    s_save_pending = true;
+    s_last_save_min = s_minutes - HABIT_SAVE_INTERVAL_MIN;
+    ESP_LOGI(TAG, "作息直方图已清空");
+}
+
+void occupancy_habit_request_export(void) {
+    s_export_pending = true;
+}
+
+bool occupancy_habit_take_export_pending(void) {
+    bool pending = s_export_pending;
+    s_export_pending = false;
+    return pending;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file occupancy_habit.h
+ * @brief 周作息学习接口定义 - 按"星期 × 小时"统计有人概率与 CO2 产生率
+ */
+
+#ifndef OCCUPANCY_HABIT_H
+#define OCCUPANCY_HABIT_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 单个小时桶的整数计数（NVS 中按此格式保存）
+ */
+typedef struct {
+    uint8_t observed;   ///< 观测分钟数（≤ HABIT_OBS_MAX）
+    uint8_t occupied;   ///< 其中判定有人的分钟数
+    uint16_t gen_sum;   ///< 有人分钟的 CO2 产生率累计（ppm/分钟，取整）
+} HabitBin;
+
+/**
+ * @brief 作息提示（决策引擎据此调整本地模式）
+ */
+typedef enum {
+    HABIT_HINT_NONE = 0,    ///< 无提示（数据不足或时间未同步）
+    HABIT_HINT_PRESTART,    ///< 通常即将有人：提前低速通风
+    HABIT_HINT_EARLY_STOP,  ///< 通常即将离开：提前停止通风
+} HabitHint;
+
+/**
+ * @brief 初始化作息学习，从 NVS 加载直方图
+ * @return ESP_OK 成功
+ */
+esp_err_t occupancy_habit_init(void);
+
+/**
+ * @brief 记录一分钟的观测（时间未同步时忽略）
+ * @param generation 最近的 CO2 产生率估计（ppm/分钟）
+ */
+void occupancy_habit_add_minute(float generation);
+
+/**
+ * @brief 根据当前时间与直方图给出作息提示
+ * @return 作息提示
+ */
+HabitHint occupancy_habit_get_hint(void);
+
+/**
+ * @brief 获取指定桶的有人概率
+ * @param bin 桶序号（星期日 0 点为 0，0 ~ HABIT_BINS-1）
+ * @return 概率百分比（0 ~ 100），观测不足时返回 -1
+ */
+int occupancy_habit_get_probability(uint16_t bin);
+
+/**
+ * @brief 导出某一天的 24 个桶
+ * @param day 星期（0 = 星期日）
+ * @param[out] out 输出 24 个桶
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t occupancy_habit_export_day(uint8_t day, HabitBin out[24]);
+
+/**
+ * @brief 导入某一天的 24 个桶（覆盖现有数据，用于批量下发作息）
+ * @param day 星期（0 = 星期日）
+ * @param in 24 个桶
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数或计数不合法
+ */
+esp_err_t occupancy_habit_import_day(uint8_t day, const HabitBin in[24]);
+
+/**
+ * @brief 清空直方图
+ */
+void occupancy_habit_clear(void);
+
+/**
+ * @brief 请求导出完整直方图（由网络任务发布）
+ */
+void occupancy_habit_request_export(void);
+
+/**
+ * @brief 查询并清除导出请求标志
+ * @return true 需要导出
+ */
+bool occupancy_habit_take_export_pending(void);
+
+#endif // OCCUPANCY_HABIT_H
@@ -0,0 +1,300 @@
+/**
+ * @file schedule.c
+ * @brief 分时段调度
+ *
+ * 时段表按周配置，每天 0 点把当天所有时段边界展开为按时间排序的切换点
+ * （含前一天跨午夜延续的时段），并合并相邻的相同状态。
+ * 运行时只需比较当前时间与下一个切换点，不再每次调用 localtime_r。
+ * 时间未同步时不应用任何时段。
+ */
+
+#include "schedule.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "SCHEDULE";
+
+// NVS 存储键值
+#define SCHED_NVS_NAMESPACE  "schedule"
+#define SCHED_NVS_KEY_TABLE  "table"
+#define SCHED_TABLE_VERSION  1
+
+#define MIN_PER_DAY          1440
+#define MAX_TRANSITIONS      (2 * SCHEDULE_MAX_PERIODS + 1)
+
+/**
+ * @brief NVS 中保存的时段表（blob）
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    SchedulePeriod periods[SCHEDULE_MAX_PERIODS];
+} ScheduleTable;
+
+/**
+ * @brief 预计算的切换点
+ */
+typedef struct {
+    time_t at;            ///< 切换时刻
+    ScheduleState state;  ///< 切换后的状态
+} Transition;
+
+/**
+ * @brief 默认时段表：每天 22:00-08:00 静音（与原夜间模式一致）
+ */
+static const ScheduleTable s_default_table = {
+    .version = SCHED_TABLE_VERSION,
+    .count = 1,
+    .periods = {
+        {.days = SCHEDULE_ALL_DAYS, .type = SCHED_QUIET, .max_level = FAN_HIGH,
+         .start_min = 22 * 60, .end_min = 8 * 60},
+    },
+};
+
+static const ScheduleState s_free_state = {.quiet = false, .max_level = FAN_HIGH};
+
+static ScheduleTable s_table;
+static ScheduleTable s_pending_table;
+static volatile bool s_table_pending = false;
+static portMUX_TYPE s_table_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static Transition s_trans[MAX_TRANSITIONS];
+static uint8_t s_trans_count = 0;
+static uint8_t s_trans_idx = 0;       ///< 下一个切换点
+static time_t s_day_start = 0;        ///< 当天 0 点
+static time_t s_day_end = 0;          ///< 次日 0 点（到达即重新预计算）
+static ScheduleState s_state = {.quiet = false, .max_level = FAN_HIGH};
+
+/**
+ * @brief 校验时段表
+ */
+static bool table_is_valid(const SchedulePeriod periods[], uint8_t count) {
+    if (count > SCHEDULE_MAX_PERIODS) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        const SchedulePeriod *p = &periods[i];
+        if (p->days == 0 || (p->days & ~SCHEDULE_ALL_DAYS) ||
+            p->type > SCHED_DISABLED || p->max_level > FAN_HIGH ||
+            p->start_min >= MIN_PER_DAY || p->end_min > MIN_PER_DAY || p->start_min == p->end_min) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 计算某星期某分钟的调度状态
+ */
+static ScheduleState state_at(int wday, int minute) {
+    ScheduleState st = s_free_state;
+    int prev_day = (wday + 6) % 7;
+
+    for (int i = 0; i < s_table.count; i++) {
+        const SchedulePeriod *p = &s_table.periods[i];
+        bool active;
+        if (p->start_min < p->end_min) {
+            active = (p->days & (1 << wday)) && minute >= p->start_min && minute < p->end_min;
+        } else {
+            // 跨午夜：起始日的 start 之后，或次日的 end 之前
+            active = ((p->days & (1 << wday)) && minute >= p->start_min) ||
+                     ((p->days & (1 << prev_day)) && minute < p->end_min);
+        }
+        if (!active) {
+            continue;
+        }
+
+        if (p->type == SCHED_QUIET) {
+            st.quiet = true;
+        } else {
+            FanState cap = (p->type == SCHED_DISABLED) ? FAN_OFF : (FanState)p->max_level;
+            if (cap < st.max_level) {
+                st.max_level = cap;
+            }
+        }
+    }
+    return st;
+}
+
+/**
+ * @brief 预计算当天切换点，并定位当前状态
+ */
+static void build_day(time_t now) {
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    int wday = timeinfo.tm_wday;
+    int now_min = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    s_day_start = mktime(&timeinfo);
+    timeinfo.tm_mday += 1;
+    s_day_end = mktime(&timeinfo);
+
+    // 候选边界：0 点及所有时段起止时刻
+    uint16_t bounds[MAX_TRANSITIONS];
+    uint8_t n = 0;
+    bounds[n++] = 0;
+    for (int i = 0; i < s_table.count; i++) {
+        bounds[n++] = s_table.periods[i].start_min;
+        bounds[n++] = s_table.periods[i].end_min;
+    }
+
+    // 插入排序（最多 17 项）
+    for (int i = 1; i < n; i++) {
+        uint16_t v = bounds[i];
+        int j = i - 1;
+        while (j >= 0 && bounds[j] > v) {
+            bounds[j + 1] = bounds[j];
+            j--;
+        }
+        bounds[j + 1] = v;
+    }
+
+    // 展开为切换点，去重并合并相同状态
+    s_trans_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && bounds[i] == bounds[i - 1]) {
+            continue;
+        }
+        ScheduleState st = state_at(wday, bounds[i]);
+        if (s_trans_count > 0) {
+            const ScheduleState *last = &s_trans[s_trans_count - 1].state;
+            if (last->quiet == st.quiet && last->max_level == st.max_level) {
+                continue;
+            }
+        }
+        s_trans[s_trans_count].at = s_day_start + (time_t)bounds[i] * 60;
+        s_trans[s_trans_count].state = st;
+        s_trans_count++;
+    }
+
+    // 定位当前时刻所在区间
+    s_trans_idx = 0;
+    while (s_trans_idx < s_trans_count && s_trans[s_trans_idx].at <= now) {
+        s_trans_idx++;
+    }
+    s_state = (s_trans_idx > 0) ? s_trans[s_trans_idx - 1].state : state_at(wday, now_min);
+
+    ESP_LOGI(TAG, "预计算当天时段: %d 个切换点，当前 静音=%d 上限=%d",
+             s_trans_count, s_state.quiet, s_state.max_level);
+}
+
+esp_err_t schedule_init(void) {
+    s_table = s_default_table;
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(SCHED_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "NVS 无时段表，使用默认配置（每天 22:00-08:00 静音）");
+        return ESP_OK;
+    }
+
+    ScheduleTable stored;
+    size_t len = sizeof(stored);
+    err = nvs_get_blob(nvs_handle, SCHED_NVS_KEY_TABLE, &stored, &len);
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK || len != sizeof(stored) || stored.version != SCHED_TABLE_VERSION ||
+        !table_is_valid(stored.periods, stored.count)) {
+        ESP_LOGW(TAG, "NVS 时段表读取失败或无效，使用默认配置");
+        return ESP_OK;
+    }
+
+    s_table = stored;
+    ESP_LOGI(TAG, "从 NVS 加载时段表（%d 个时段）", s_table.count);
+    return ESP_OK;
+}
+
+bool schedule_update(void) {
+    ScheduleState old = s_state;
+    bool rebuild = false;
+
+    if (s_table_pending) {
+        portENTER_CRITICAL(&s_table_lock);
+        s_table = s_pending_table;
+        s_table_pending = false;
+        portEXIT_CRITICAL(&s_table_lock);
+        rebuild = true;
+    }
+
+    time_t now = time(NULL);
+    if (now < TIME_VALID_EPOCH) {
+        // 时间未同步：不应用任何时段（与 is_time_valid() 相同的判断，只取一次时间）
+        s_day_end = 0;
+        s_state = s_free_state;
+    } else if (rebuild || now >= s_day_end || now < s_day_start) {
+        build_day(now);
+    } else {
+        // 常规路径：仅比较下一个切换时刻
+        while (s_trans_idx < s_trans_count && now >= s_trans[s_trans_idx].at) {
+            s_state = s_trans[s_trans_idx].state;
+            s_trans_idx++;
+        }
+    }
+
+    bool changed = (old.quiet != s_state.quiet || old.max_level != s_state.max_level);
+    if (changed) {
+        ESP_LOGI(TAG, "时段切换: 静音 %d → %d，档位上限 %d → %d",
+                 old.quiet, s_state.quiet, old.max_level, s_state.max_level);
+    }
+    return changed;
+}
+
+void schedule_get_state(ScheduleState *state) {
+    if (state) {
+        *state = s_state;
+    }
+}
+
+bool schedule_apply_cap(FanState fans[], uint8_t fan_count) {
+    if (!fans) {
+        return false;
+    }
+    bool capped = false;
+    for (int i = 0; i < fan_count && i < FAN_MAX_COUNT; i++) {
+        if (fans[i] > s_state.max_level) {
+            fans[i] = s_state.max_level;
+            capped = true;
+        }
+    }
+    return capped;
+}
+
+esp_err_t schedule_set_periods(const SchedulePeriod periods[], uint8_t count) {
+    if ((count > 0 && !periods) || !table_is_valid(periods, count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ScheduleTable table = {.version = SCHED_TABLE_VERSION, .count = count};
+    memcpy(table.periods, periods, count * sizeof(SchedulePeriod));
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(SCHED_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存时段表: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_blob(nvs_handle, SCHED_NVS_KEY_TABLE, &table, sizeof(table));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "时段表保存失败: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    portENTER_CRITICAL(&s_table_lock);
+    s_pending_table = table;
+    s_table_pending = true;
+    portEXIT_CRITICAL(&s_table_lock);
+
+    ESP_LOGI(TAG, "时段表已保存（%d 个时段），下一周期生效", count);
+    return ESP_OK;
+}
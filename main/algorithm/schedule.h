@@ -0,0 +1,83 @@
+/**
+ * @file schedule.h
+ * @brief 分时段调度接口定义 - 周配置的静音时段、档位上限与禁用时段
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHEDULE_MAX_PERIODS  8     ///< 最多时段数
+#define SCHEDULE_ALL_DAYS     0x7F  ///< 每天（bit0 = 星期日 ... bit6 = 星期六）
+
+/**
+ * @brief 时段类型
+ */
+typedef enum {
+    SCHED_QUIET = 0,    ///< 静音：使用夜间占空比（night_low_duty / night_high_duty）
+    SCHED_CAP,          ///< 档位上限：风扇不超过 max_level
+    SCHED_DISABLED,     ///< 禁用：风扇关闭
+} SchedulePeriodType;
+
+/**
+ * @brief 单个时段
+ * end_min < start_min 表示跨越午夜，跨过午夜的部分仍属于 days 中的起始日；
+ * end_min == start_min 不合法（无法区分空时段与全天），全天为 0 ~ 1440
+ */
+typedef struct {
+    uint8_t days;        ///< 生效星期位掩码
+    uint8_t type;        ///< SchedulePeriodType
+    uint8_t max_level;   ///< SCHED_CAP 时的档位上限（FanState）
+    uint16_t start_min;  ///< 开始时刻（当日分钟数 0 ~ 1439）
+    uint16_t end_min;    ///< 结束时刻（当日分钟数 0 ~ 1440，1440 = 24:00）
+} SchedulePeriod;
+
+/**
+ * @brief 当前生效的调度状态
+ */
+typedef struct {
+    bool quiet;           ///< 静音（夜间占空比）
+    FanState max_level;   ///< 档位上限（FAN_HIGH = 不限制，FAN_OFF = 禁用）
+} ScheduleState;
+
+/**
+ * @brief 初始化调度，从 NVS 加载时段表（无配置时默认每天 22:00-08:00 静音）
+ * @return ESP_OK 成功
+ */
+esp_err_t schedule_init(void);
+
+/**
+ * @brief 更新调度状态（决策任务每周期调用）
+ * 每天 0 点（或时段表变化、时间首次同步时）预计算当天的切换时刻，
+ * 其余调用只比较当前时间与下一个切换时刻。
+ * @return true 本次跨过时段边界（调度状态可能变化，需重新下发 PWM）
+ */
+bool schedule_update(void);
+
+/**
+ * @brief 获取当前调度状态（以最近一次 schedule_update() 为准）
+ * @param[out] state 输出状态
+ */
+void schedule_get_state(ScheduleState *state);
+
+/**
+ * @brief 按当前档位上限限制风扇状态
+ * @param[in,out] fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @return true 至少一个风扇被限制
+ */
+bool schedule_apply_cap(FanState fans[], uint8_t fan_count);
+
+/**
+ * @brief 校验并保存时段表（可在 MQTT 任务中调用，下一次 schedule_update() 生效）
+ * @param periods 时段数组
+ * @param count 时段数量（0 ~ SCHEDULE_MAX_PERIODS，0 表示不设任何时段）
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 时段不合法
+ */
+esp_err_t schedule_set_periods(const SchedulePeriod periods[], uint8_t count);
+
+#endif // SCHEDULE_H
@@ -0,0 +1,490 @@
+/**
+ * @file vent_ident.c
+ * @brief 房间通风响应在线辨识
+ *
+ * 风扇组合保持不变的一段时间称为一个片段。片段内每分钟一个 CO2 均值 C[j]，
+ * 以 x = C[j] - 基准、y = C[j+1] - C[j] 做一元线性回归 y = G - k·x，
+ * 得到该组合下的总衰减率 k 与产生率 G，再按组合归属到具体参数：
+ *   - 全部关闭         → 自然渗透 k0
+ *   - 仅一台风扇运行   → 该风扇该档位 k - k0（阶跃测试即构造此类片段）
+ *   - 全部同档运行     → 每台风扇 (k - k0) / N（本地模式的被动学习）
+ */
+
+#include "vent_ident.h"
+#include "fan_control.h"
+#include "runtime_config.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "VENT_IDENT";
+
+// NVS 存储键值
+#define IDENT_NVS_NAMESPACE  "vent_model"
+#define IDENT_NVS_KEY_MODEL  "model"
+#define IDENT_MODEL_VERSION  1
+
+#define SAMPLES_PER_MIN      60       ///< 1Hz 采样，每分钟聚合一次
+#define IDENT_STEP_SEC       (IDENT_STEP_MIN * 60)
+
+/**
+ * @brief NVS 中保存的模型（blob）
+ */
+typedef struct {
+    uint8_t version;
+    VentModel model;
+} VentModelBlob;
+
+/**
+ * @brief 跨任务请求（MQTT 任务写入，决策任务消费）
+ */
+typedef enum {
+    IDENT_REQ_NONE = 0,
+    IDENT_REQ_START,
+    IDENT_REQ_STOP,
+    IDENT_REQ_RESET,
+} IdentRequest;
+
+static VentModel s_model;
+static portMUX_TYPE s_model_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 当前片段
+static FanState s_seg_cfg[FAN_MAX_COUNT];
+static uint8_t s_seg_fan_count = 0;
+static float s_seg_x[IDENT_MAX_SEGMENT_MIN];
+static float s_seg_y[IDENT_MAX_SEGMENT_MIN];
+static uint8_t s_seg_n = 0;
+static uint8_t s_seg_skip = IDENT_SETTLE_MIN;
+static float s_prev_mean = 0.0f;
+static bool s_prev_valid = false;
+
+// 当前分钟累加器
+static float s_min_sum = 0.0f;
+static uint8_t s_min_n = 0;
+
+// NVS 合并写入
+static uint32_t s_minutes = 0;
+static uint32_t s_last_save_min = 0;
+static bool s_save_pending = false;
+
+// 阶跃测试
+static volatile IdentRequest s_request = IDENT_REQ_NONE;
+static volatile bool s_report_pending = false;
+static VentIdentState s_state = VENT_IDENT_IDLE;
+static uint8_t s_step = 0;
+static uint8_t s_step_total = 0;
+static uint32_t s_step_sec = 0;
+static FanState s_saved_states[FAN_MAX_COUNT];
+static const char *s_note = "NONE";
+
+/**
+ * @brief 恢复默认模型参数
+ */
+static void model_set_defaults(uint8_t fan_count) {
+    memset(&s_model, 0, sizeof(s_model));
+    s_model.fan_count = fan_count;
+    s_model.infiltration.value = PREDICT_DECAY_INFILTRATION;
+    s_model.generation.value = PREDICT_GENERATION_DEFAULT;
+    for (int i = 0; i < FAN_MAX_COUNT; i++) {
+        s_model.fan[i][0].value = PREDICT_DECAY_FAN_LOW;
+        s_model.fan[i][1].value = PREDICT_DECAY_FAN_HIGH;
+    }
+}
+
+/**
+ * @brief 保存模型到 NVS
+ */
+static esp_err_t model_save(void) {
+    VentModelBlob blob = {.version = IDENT_MODEL_VERSION};
+    vent_ident_get_model(&blob.model);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(IDENT_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存通风模型: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_blob(nvs_handle, IDENT_NVS_KEY_MODEL, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "通风模型保存失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_save_pending = false;
+    s_last_save_min = s_minutes;
+    ESP_LOGI(TAG, "通风模型已保存到 NVS");
+    return ESP_OK;
+}
+
+/**
+ * @brief 用一次片段估计更新参数（先按累计平均收敛，之后指数平滑）
+ */
+static void param_update(VentParam *p, float estimate, float r2) {
+    float alpha = 1.0f / (float)(p->segments + 1);
+    if (alpha < IDENT_LEARN_RATE) {
+        alpha = IDENT_LEARN_RATE;
+    }
+    if (p->segments == 0) {
+        // 首次估计直接替换默认值
+        alpha = 1.0f;
+        p->r2 = r2;
+    }
+    p->value += alpha * (estimate - p->value);
+    p->r2 += alpha * (r2 - p->r2);
+    if (p->segments < UINT16_MAX) {
+        p->segments++;
+    }
+}
+
+/**
+ * @brief 拟合当前片段并归属到模型参数
+ */
+static void segment_evaluate(void) {
+    uint8_t n = s_seg_n;
+    s_seg_n = 0;
+    if (n < IDENT_MIN_SEGMENT_POINTS) {
+        return;
+    }
+
+    float mx = 0.0f, my = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        mx += s_seg_x[i];
+        my += s_seg_y[i];
+    }
+    mx /= n;
+    my /= n;
+
+    float sxx = 0.0f, sxy = 0.0f, syy = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        float dx = s_seg_x[i] - mx;
+        float dy = s_seg_y[i] - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+
+    // 激励不足（CO2 几乎不变）时无法区分 G 与 k
+    if (sxx < n * IDENT_MIN_X_STD * IDENT_MIN_X_STD || syy <= 0.0f) {
+        ESP_LOGD(TAG, "片段激励不足，跳过（%d 点）", n);
+        return;
+    }
+
+    float slope = sxy / sxx;
+    float k = -slope;
+    float g = my + k * mx;
+    float r2 = (sxy * sxy) / (sxx * syy);
+    float resid = syy - slope * sxy;
+    float se = sqrtf((resid > 0.0f ? resid : 0.0f) / (float)(n - 2) / sxx);
+
+    if (k < 0.0f || k > IDENT_MAX_DECAY || se > IDENT_MAX_DECAY_SE) {
+        ESP_LOGD(TAG, "片段估计被拒绝: k=%.4f se=%.4f", k, se);
+        return;
+    }
+
+    // 风扇组合分类
+    uint8_t on_count = 0;
+    FanId on_fan = 0;
+    bool same_level = true;
+    for (uint8_t i = 0; i < s_seg_fan_count; i++) {
+        if (s_seg_cfg[i] != FAN_OFF) {
+            on_count++;
+            on_fan = i;
+        }
+        if (s_seg_cfg[i] != s_seg_cfg[0]) {
+            same_level = false;
+        }
+    }
+
+    portENTER_CRITICAL(&s_model_lock);
+    float k0 = s_model.infiltration.value;
+    if (on_count == 0) {
+        param_update(&s_model.infiltration, k, r2);
+    } else if (on_count == 1) {
+        float est = k - k0;
+        param_update(&s_model.fan[on_fan][s_seg_cfg[on_fan] - 1], est > 0.0f ? est : 0.0f, r2);
+    } else if (same_level) {
+        float est = (k - k0) / s_seg_fan_count;
+        for (uint8_t i = 0; i < s_seg_fan_count; i++) {
+            param_update(&s_model.fan[i][s_seg_cfg[0] - 1], est > 0.0f ? est : 0.0f, r2);
+        }
+    }
+    if (g > IDENT_OCCUPIED_MIN_G) {
+        param_update(&s_model.generation, g, r2);
+    }
+    portEXIT_CRITICAL(&s_model_lock);
+
+    ESP_LOGI(TAG, "片段拟合: %d 点, 运行 %d 台, k=%.4f/min (se %.4f), G=%.1f ppm/min, R²=%.2f",
+             n, on_count, k, se, g, r2);
+
+    s_save_pending = true;
+    s_report_pending = true;
+}
+
+/**
+ * @brief 结束阶跃测试
+ */
+static void step_test_end(const char *note) {
+    ESP_LOGI(TAG, "阶跃测试结束: %s（第 %d/%d 步）", note, s_step, s_step_total);
+    s_state = VENT_IDENT_IDLE;
+    s_step = 0;
+    s_step_sec = 0;
+    s_note = note;
+    s_report_pending = true;
+    if (s_save_pending) {
+        model_save();
+    }
+}
+
+esp_err_t vent_ident_init(void) {
+    uint8_t fan_count = fan_control_get_count();
+    model_set_defaults(fan_count);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(IDENT_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "NVS 无通风模型，使用默认参数");
+        return ESP_OK;
+    }
+
+    VentModelBlob blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs_handle, IDENT_NVS_KEY_MODEL, &blob, &len);
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK || len != sizeof(blob) || blob.version != IDENT_MODEL_VERSION) {
+        ESP_LOGW(TAG, "NVS 通风模型读取失败或版本不匹配，使用默认参数");
+        return ESP_OK;
+    }
+    if (blob.model.fan_count != fan_count) {
+        // 风扇配置表变化后各风扇参数不再对应，只保留房间级参数
+        ESP_LOGW(TAG, "风扇数量变化（%d → %d），重新学习风扇衰减率",
+                 blob.model.fan_count, fan_count);
+        s_model.infiltration = blob.model.infiltration;
+        s_model.generation = blob.model.generation;
+        return ESP_OK;
+    }
+
+    s_model = blob.model;
+    ESP_LOGI(TAG, "从 NVS 加载通风模型: k0=%.4f/min, G=%.1f ppm/min",
+             s_model.infiltration.value, s_model.generation.value);
+    return ESP_OK;
+}
+
+void vent_ident_add_sample(float co2_ppm, const FanState fans[], uint8_t fan_count) {
+    const RuntimeConfig *cfg = runtime_config_get();
+    if (!fans || co2_ppm < cfg->co2_min_valid || co2_ppm > cfg->co2_max_valid) {
+        return;
+    }
+    if (fan_count > FAN_MAX_COUNT) {
+        fan_count = FAN_MAX_COUNT;
+    }
+
+    // 风扇组合变化：结束当前片段，丢弃过渡期
+    if (fan_count != s_seg_fan_count ||
+        memcmp(fans, s_seg_cfg, fan_count * sizeof(FanState)) != 0) {
+        segment_evaluate();
+        memcpy(s_seg_cfg, fans, fan_count * sizeof(FanState));
+        s_seg_fan_count = fan_count;
+        s_seg_skip = IDENT_SETTLE_MIN;
+        s_prev_valid = false;
+        s_min_sum = 0.0f;
+        s_min_n = 0;
+    }
+
+    s_min_sum += co2_ppm;
+    if (++s_min_n < SAMPLES_PER_MIN) {
+        return;
+    }
+    float mean = s_min_sum / s_min_n;
+    s_min_sum = 0.0f;
+    s_min_n = 0;
+    s_minutes++;
+
+    if (s_seg_skip > 0) {
+        s_seg_skip--;
+    } else {
+        if (s_prev_valid) {
+            s_seg_x[s_seg_n] = s_prev_mean - CO2_BASELINE;
+            s_seg_y[s_seg_n] = mean - s_prev_mean;
+            s_seg_n++;
+            if (s_seg_n >= IDENT_MAX_SEGMENT_MIN) {
+                segment_evaluate();
+            }
+        }
+        s_prev_mean = mean;
+        s_prev_valid = true;
+    }
+
+    // 合并写入，降低 Flash 磨损
+    if (s_save_pending && s_minutes - s_last_save_min >= IDENT_SAVE_INTERVAL_MIN) {
+        model_save();
+    }
+}
+
+void vent_ident_request_start(void) {
+    s_request = IDENT_REQ_START;
+}
+
+void vent_ident_request_stop(void) {
+    s_request = IDENT_REQ_STOP;
+}
+
+void vent_ident_request_reset(void) {
+    s_request = IDENT_REQ_RESET;
+}
+
+void vent_ident_request_report(void) {
+    s_report_pending = true;
+}
+
+bool vent_ident_step_override(const SensorData *sensor, SystemMode mode,
+                              FanState out_fans[], uint8_t fan_count) {
+    if (!out_fans) {
+        return false;
+    }
+    if (fan_count > FAN_MAX_COUNT) {
+        fan_count = FAN_MAX_COUNT;
+    }
+
+    IdentRequest req = s_request;
+    s_request = IDENT_REQ_NONE;
+    float co2 = (sensor && sensor->valid) ? sensor->pollutants.co2 : 0.0f;
+    float co2_high = runtime_config_get()->co2_high;
+
+    switch (req) {
+        case IDENT_REQ_START:
+            if (s_state == VENT_IDENT_RUNNING) {
+                break;
+            }
+            if (mode == MODE_SAFE_STOP || co2 < IDENT_STEP_MIN_CO2 || co2 > co2_high) {
+                ESP_LOGW(TAG, "拒绝阶跃测试: CO2=%.0f ppm, 模式=%d", co2, mode);
+                s_note = (co2 < IDENT_STEP_MIN_CO2) ? "REFUSED_CO2_LOW" : "REFUSED_UNSAFE";
+                s_report_pending = true;
+                break;
+            }
+            memcpy(s_saved_states, out_fans, fan_count * sizeof(FanState));
+            s_state = VENT_IDENT_RUNNING;
+            s_step = 0;
+            s_step_sec = 0;
+            s_step_total = 1 + 2 * fan_count;
+            s_note = "RUNNING";
+            s_report_pending = true;
+            ESP_LOGI(TAG, "开始阶跃测试: %d 步 × %d 分钟", s_step_total, IDENT_STEP_MIN);
+            break;
+
+        case IDENT_REQ_STOP:
+            if (s_state == VENT_IDENT_RUNNING) {
+                step_test_end("STOPPED");
+                memcpy(out_fans, s_saved_states, fan_count * sizeof(FanState));
+                return true;
+            }
+            break;
+
+        case IDENT_REQ_RESET:
+            ESP_LOGI(TAG, "清除已学习参数");
+            portENTER_CRITICAL(&s_model_lock);
+            model_set_defaults(fan_count);
+            portEXIT_CRITICAL(&s_model_lock);
+            s_seg_n = 0;
+            s_report_pending = true;
+            model_save();
+            break;
+
+        default:
+            break;
+    }
+
+    if (s_state != VENT_IDENT_RUNNING) {
+        return false;
+    }
+
+    // 安全检查：异常中止后交还给正常决策（远程模式恢复测试前状态）
+    const char *abort_note = NULL;
+    if (mode == MODE_SAFE_STOP) {
+        abort_note = "ABORT_SAFE_STOP";
+    } else if (!sensor || !sensor->valid) {
+        abort_note = "ABORT_SENSOR";
+    } else if (co2 > co2_high) {
+        abort_note = "ABORT_CO2_HIGH";
+    } else if (co2 < CO2_BASELINE + IDENT_MIN_SIGNAL_PPM) {
+        abort_note = "SIGNAL_LOST";
+    }
+    if (abort_note) {
+        step_test_end(abort_note);
+        if (mode == MODE_REMOTE) {
+            memcpy(out_fans, s_saved_states, fan_count * sizeof(FanState));
+            return true;
+        }
+        return false;
+    }
+
+    if (++s_step_sec >= IDENT_STEP_SEC) {
+        s_step_sec = 0;
+        if (++s_step >= s_step_total) {
+            step_test_end("COMPLETED");
+            memcpy(out_fans, s_saved_states, fan_count * sizeof(FanState));
+            return true;
+        }
+        s_report_pending = true;
+    }
+
+    // 第 0 步全部关闭；之后每台风扇依次 LOW、HIGH，其余关闭
+    for (uint8_t i = 0; i < fan_count; i++) {
+        out_fans[i] = FAN_OFF;
+    }
+    if (s_step > 0) {
+        uint8_t fan = (s_step - 1) / 2;
+        out_fans[fan] = ((s_step - 1) % 2 == 0) ? FAN_LOW : FAN_HIGH;
+    }
+    return true;
+}
+
+VentIdentState vent_ident_get_state(void) {
+    return s_state;
+}
+
+uint8_t vent_ident_get_step(void) {
+    return s_step;
+}
+
+const char* vent_ident_get_note(void) {
+    return s_note;
+}
+
+float vent_ident_get_infiltration(void) {
+    portENTER_CRITICAL(&s_model_lock);
+    float k0 = s_model.infiltration.value;
+    portEXIT_CRITICAL(&s_model_lock);
+    return k0;
+}
+
+float vent_ident_get_fan_decay(FanId id, FanState level) {
+    if (id >= FAN_MAX_COUNT || level == FAN_OFF) {
+        return 0.0f;
+    }
+    portENTER_CRITICAL(&s_model_lock);
+    float k = s_model.fan[id][level == FAN_HIGH ? 1 : 0].value;
+    portEXIT_CRITICAL(&s_model_lock);
+    return k;
+}
+
+void vent_ident_get_model(VentModel *model) {
+    if (!model) {
+        return;
+    }
+    portENTER_CRITICAL(&s_model_lock);
+    *model = s_model;
+    portEXIT_CRITICAL(&s_model_lock);
+}
+
+bool vent_ident_take_report_pending(void) {
+    bool pending = s_report_pending;
+    s_report_pending = false;
+    return pending;
+}
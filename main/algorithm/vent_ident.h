@@ -0,0 +1,131 @@
+/**
+ * @file vent_ident.h
+ * @brief 房间通风响应在线辨识接口定义
+ *
+ * 模型：dC/dt = G - k·(C - CO2_BASELINE)，k = 自然渗透 k0 + Σ 各风扇档位衰减率。
+ * 辨识来源：
+ *   - 被动学习：风扇组合保持不变的片段内，对 ΔC = G - k·(C - 基准) 做最小二乘
+ *   - 阶跃测试：依次全部关闭、单风扇 LOW、单风扇 HIGH，逐个分离每台风扇的衰减率
+ * 结果保存在 NVS，供预测决策（co2_predictor）读取，并通过 MQTT 上报。
+ */
+
+#ifndef VENT_IDENT_H
+#define VENT_IDENT_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 单个辨识参数及其拟合质量
+ */
+typedef struct {
+    float value;        ///< 参数值（衰减率 1/分钟，或产生率 ppm/分钟）
+    float r2;           ///< 拟合优度 R²（按更新平滑）
+    uint16_t segments;  ///< 参与更新的片段数（0 = 仍为默认值）
+} VentParam;
+
+/**
+ * @brief 房间通风模型
+ */
+typedef struct {
+    uint8_t fan_count;                    ///< 风扇数量
+    VentParam infiltration;               ///< 自然渗透衰减率 k0
+    VentParam generation;                 ///< 有人时的 CO2 产生率 G
+    VentParam fan[FAN_MAX_COUNT][2];      ///< 各风扇衰减率 [0]=LOW [1]=HIGH
+} VentModel;
+
+/**
+ * @brief 阶跃测试状态
+ */
+typedef enum {
+    VENT_IDENT_IDLE = 0,    ///< 空闲（仅被动学习）
+    VENT_IDENT_RUNNING,     ///< 阶跃测试进行中
+} VentIdentState;
+
+/**
+ * @brief 初始化辨识模块，从 NVS 加载模型（无记录时使用 main.h 默认值）
+ * @return ESP_OK 成功
+ */
+esp_err_t vent_ident_init(void);
+
+/**
+ * @brief 添加 1Hz 采样点（按分钟聚合，风扇组合不变时累积片段）
+ * @param co2_ppm CO2 浓度（ppm，原始读数）
+ * @param fans 当前已生效的风扇状态数组
+ * @param fan_count 风扇数量
+ */
+void vent_ident_add_sample(float co2_ppm, const FanState fans[], uint8_t fan_count);
+
+/**
+ * @brief 请求启动阶跃测试（可在 MQTT 任务中调用，由决策任务执行）
+ */
+void vent_ident_request_start(void);
+
+/**
+ * @brief 请求中止阶跃测试（可在 MQTT 任务中调用）
+ */
+void vent_ident_request_stop(void);
+
+/**
+ * @brief 请求清除已学习参数并恢复默认值（可在 MQTT 任务中调用）
+ */
+void vent_ident_request_reset(void);
+
+/**
+ * @brief 请求立即上报模型（可在 MQTT 任务中调用）
+ */
+void vent_ident_request_report(void);
+
+/**
+ * @brief 阶跃测试覆盖决策输出（决策任务每周期调用）
+ * 测试进行中时用测试档位覆盖 out_fans；CO2 超过高阈值或传感器无效时自动中止。
+ * 远程模式下测试结束时恢复测试前的风扇状态（远程无新命令时决策任务会保持当前状态）。
+ * @param sensor 传感器数据
+ * @param mode 当前运行模式（MODE_SAFE_STOP 时中止测试）
+ * @param[in,out] out_fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @return true 测试进行中（已覆盖），false 未覆盖
+ */
+bool vent_ident_step_override(const SensorData *sensor, SystemMode mode,
+                              FanState out_fans[], uint8_t fan_count);
+
+/**
+ * @brief 获取阶跃测试状态
+ */
+VentIdentState vent_ident_get_state(void);
+
+/**
+ * @brief 获取当前阶跃测试步骤序号（空闲时为 0）
+ */
+uint8_t vent_ident_get_step(void);
+
+/**
+ * @brief 获取最近一次阶跃测试的结束原因（如 "COMPLETED"、"ABORT_CO2_HIGH"，无记录时为 "NONE"）
+ */
+const char* vent_ident_get_note(void);
+
+/**
+ * @brief 获取自然渗透衰减率（1/分钟）
+ */
+float vent_ident_get_infiltration(void);
+
+/**
+ * @brief 获取单个风扇在指定档位下的衰减率（1/分钟，FAN_OFF 返回 0）
+ */
+float vent_ident_get_fan_decay(FanId id, FanState level);
+
+/**
+ * @brief 获取模型副本
+ * @param[out] model 输出模型
+ */
+void vent_ident_get_model(VentModel *model);
+
+/**
+ * @brief 查询并清除"模型待上报"标志（模型更新、测试状态变化或收到上报请求时置位）
+ * @return true 需要上报
+ */
+bool vent_ident_take_report_pending(void);
+
+#endif // VENT_IDENT_H
@@ -0,0 +1,419 @@
+/**
+ * @file runtime_config.c
+ * @brief 运行时配置
+ *
+ * 配置以整份快照发布：MQTT 任务解析并校验新文档、写入 NVS 后放入待生效区，
+ * 决策任务在周期开始时把它复制到备用槽位并原子切换读指针。读者拿到的快照
+ * 在其生命周期内不会被修改；两次切换至少间隔 RCFG_GRACE_MS，保证被换下的
+ * 槽位不再有读者后才会被复用。
+ *
+ * NVS 中保留当前与上一版本两份配置：启动时当前配置损坏或校验失败会自动回滚，
+ * 也可通过 MQTT 命令手动回滚到指定的上一版本。回滚后记录被撤下的版本号作为下限，
+ * 之后不高于下限的文档（Broker 重发的保留消息）一律视为过期。
+ */
+
+#include "runtime_config.h"
+#include "fan_control.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "RT_CONFIG";
+
+// NVS 存储键值
+#define RCFG_NVS_NAMESPACE     "rt_config"
+#define RCFG_NVS_KEY_ACTIVE    "active"
+#define RCFG_NVS_KEY_PREVIOUS  "previous"
+#define RCFG_NVS_KEY_FLOOR     "floor"
+#define RCFG_FORMAT_VERSION    1
+
+/**
+ * @brief NVS 中保存的配置（blob）
+ */
+typedef struct {
+    uint8_t format;       ///< 存储格式版本
+    RuntimeConfig cfg;
+} RuntimeConfigBlob;
+
+/**
+ * @brief 编译期默认值（main.h 中的常量）
+ */
+#define RCFG_DEFAULTS {                                \
+    .version = 0,                                      \
+    .co2_low = CO2_THRESHOLD_LOW,                      \
+    .co2_high = CO2_THRESHOLD_HIGH,                    \
+    .co2_alert = CO2_ALERT_THRESHOLD,                  \
+    .co2_min_valid = CO2_MIN_VALID,                    \
+    .co2_max_valid = CO2_MAX_VALID,                    \
+    .temp_min_valid = TEMP_MIN_VALID,                  \
+    .temp_max_valid = TEMP_MAX_VALID,                  \
+    .humi_min_valid = HUMI_MIN_VALID,                  \
+    .humi_max_valid = HUMI_MAX_VALID,                  \
+    .publish_interval_sec = MQTT_PUBLISH_INTERVAL_SEC, \
+    .preheat_sec = PREHEATING_TIME_SEC,                \
+    .stabilize_sec = STABILIZING_TIME_SEC,             \
+    .lease_default_sec = REMOTE_LEASE_DEFAULT_SEC,     \
+    .duty_mask = 0,                                    \
+    .fan_count = 0,                                    \
+    .status_batch_sec = STATUS_BATCH_DECIMATION,       \
+    .payload_format = PAYLOAD_FORMAT_JSON,             \
+    .group = "",                                       \
+    .report_mode = REPORT_MODE_INTERVAL,               \
+    .heartbeat_sec = REPORT_HEARTBEAT_SEC,             \
+    .co2_deadband = REPORT_DEADBAND_CO2,               \
+    .temp_deadband = REPORT_DEADBAND_TEMP,             \
+    .humi_deadband = REPORT_DEADBAND_HUMI,             \
+}
+
+// 两个快照槽位，s_active 指向当前生效的一个
+static RuntimeConfig s_slots[2] = {RCFG_DEFAULTS, RCFG_DEFAULTS};
+static RuntimeConfig *s_active = &s_slots[0];
+static int64_t s_last_swap_us = 0;
+
+// 待生效配置（MQTT 任务写入，决策任务读取）
+static RuntimeConfig s_pending;
+static volatile bool s_pending_valid = false;
+static portMUX_TYPE s_pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 版本下限：回滚撤下的最高版本，新文档须高于它（只在 MQTT 任务中修改）
+static uint32_t s_version_floor = 0;
+
+/**
+ * @brief 判断数值在闭区间内（NaN 视为越界）
+ */
+static bool in_range(float v, float lo, float hi) {
+    return v >= lo && v <= hi;
+}
+
+/**
+ * @brief 分组名校验：以 '\0' 结尾，只含字母、数字、'_'、'-'（用作 MQTT 主题层级）
+ */
+static bool valid_group(const char *group) {
+    for (size_t i = 0; i <= RCFG_GROUP_MAX_LEN; i++) {
+        char c = group[i];
+        if (c == '\0') {
+            return true;
+        }
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '_' || c == '-')) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 解析风扇占空比：未覆盖的风扇取风扇配置表中的值
+ */
+static void resolve_fan_duty(RuntimeConfig *cfg) {
+    cfg->fan_count = fan_control_get_count();
+    for (int i = 0; i < cfg->fan_count; i++) {
+        if (cfg->duty_mask & (1u << i)) {
+            continue;
+        }
+        const FanConfig *fan = fan_control_get_config((FanId)i);
+        cfg->fan_duty[i].low = fan->low_duty;
+        cfg->fan_duty[i].high = fan->high_duty;
+        cfg->fan_duty[i].night_low = fan->night_low_duty;
+        cfg->fan_duty[i].night_high = fan->night_high_duty;
+    }
+}
+
+/**
+ * @brief 从 NVS 读取一份配置并解析、校验
+ */
+static esp_err_t load_blob(nvs_handle_t nvs_handle, const char *key, RuntimeConfig *out) {
+    RuntimeConfigBlob blob;
+    size_t len = sizeof(blob);
+    esp_err_t err = nvs_get_blob(nvs_handle, key, &blob, &len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len != sizeof(blob) || blob.format != RCFG_FORMAT_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    RuntimeConfig cfg = blob.cfg;
+    resolve_fan_duty(&cfg);
+    const char *field = NULL;
+    if (runtime_config_validate(&cfg, &field) != ESP_OK) {
+        ESP_LOGW(TAG, "NVS 配置 %s 校验失败（字段 %s）", key, field);
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = cfg;
+    return ESP_OK;
+}
+
+/**
+ * @brief 保存配置：active ← cfg，previous ← old_active（非 NULL 时），floor ← floor（非 0 时）
+ */
+static esp_err_t save_rotate(const RuntimeConfig *cfg, const RuntimeConfigBlob *old_active, uint32_t floor) {
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(RCFG_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "无法打开 NVS 保存配置: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    RuntimeConfigBlob blob = {.format = RCFG_FORMAT_VERSION, .cfg = *cfg};
+    err = ESP_OK;
+    if (old_active) {
+        err = nvs_set_blob(nvs_handle, RCFG_NVS_KEY_PREVIOUS, old_active, sizeof(*old_active));
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, RCFG_NVS_KEY_ACTIVE, &blob, sizeof(blob));
+    }
+    if (err == ESP_OK && floor > 0) {
+        err = nvs_set_u32(nvs_handle, RCFG_NVS_KEY_FLOOR, floor);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "配置保存失败: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * @brief 放入待生效区（下一次 runtime_config_update() 切换）
+ */
+static void set_pending(const RuntimeConfig *cfg) {
+    portENTER_CRITICAL(&s_pending_lock);
+    s_pending = *cfg;
+    s_pending_valid = true;
+    portEXIT_CRITICAL(&s_pending_lock);
+}
+
+esp_err_t runtime_config_init(void) {
+    RuntimeConfig cfg = RCFG_DEFAULTS;
+    resolve_fan_duty(&cfg);
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(RCFG_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_OK) {
+        err = load_blob(nvs_handle, RCFG_NVS_KEY_ACTIVE, &cfg);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "从 NVS 加载配置 v%lu", (unsigned long)cfg.version);
+        } else if (err != ESP_ERR_NVS_NOT_FOUND &&
+                   load_blob(nvs_handle, RCFG_NVS_KEY_PREVIOUS, &cfg) == ESP_OK) {
+            ESP_LOGW(TAG, "当前配置无效，回滚到上一版本 v%lu", (unsigned long)cfg.version);
+        } else {
+            cfg = (RuntimeConfig)RCFG_DEFAULTS;
+            resolve_fan_duty(&cfg);
+            ESP_LOGI(TAG, "NVS 无有效配置，使用编译期默认值");
+        }
+        if (nvs_get_u32(nvs_handle, RCFG_NVS_KEY_FLOOR, &s_version_floor) != ESP_OK) {
+            s_version_floor = 0;
+        }
+        nvs_close(nvs_handle);
+    } else {
+        s_version_floor = 0;
+        ESP_LOGI(TAG, "NVS 无配置，使用编译期默认值");
+    }
+
+    // 任务尚未启动，直接写入当前槽位
+    *s_active = cfg;
+    return ESP_OK;
+}
+
+const RuntimeConfig *runtime_config_get(void) {
+    return __atomic_load_n(&s_active, __ATOMIC_ACQUIRE);
+}
+
+void runtime_config_copy(RuntimeConfig *out) {
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_pending_lock);
+    bool pending = s_pending_valid;
+    if (pending) {
+        *out = s_pending;
+    }
+    portEXIT_CRITICAL(&s_pending_lock);
+    if (!pending) {
+        *out = *runtime_config_get();
+    }
+}
+
+esp_err_t runtime_config_validate(const RuntimeConfig *cfg, const char **field) {
+    const char *bad = NULL;
+
+    if (!cfg) {
+        bad = "config";
+    } else if (!in_range(cfg->co2_min_valid, 0.0f, RCFG_CO2_LIMIT) ||
+               !in_range(cfg->co2_max_valid, cfg->co2_min_valid + 1.0f, RCFG_CO2_LIMIT)) {
+        bad = "co2_valid";
+    } else if (!in_range(cfg->co2_low, cfg->co2_min_valid, cfg->co2_max_valid)) {
+        bad = "co2_low";
+    } else if (!in_range(cfg->co2_high, cfg->co2_low + 1.0f, cfg->co2_max_valid)) {
+        bad = "co2_high";
+    } else if (!in_range(cfg->co2_alert, 1.0f, cfg->co2_max_valid)) {
+        bad = "co2_alert";
+    } else if (!in_range(cfg->temp_min_valid, RCFG_TEMP_LIMIT_MIN, RCFG_TEMP_LIMIT_MAX) ||
+               !in_range(cfg->temp_max_valid, cfg->temp_min_valid + 1.0f, RCFG_TEMP_LIMIT_MAX)) {
+        bad = "temp_valid";
+    } else if (!in_range(cfg->humi_min_valid, 0.0f, 100.0f) ||
+               !in_range(cfg->humi_max_valid, cfg->humi_min_valid + 1.0f, 100.0f)) {
+        bad = "humi_valid";
+    } else if (cfg->publish_interval_sec < RCFG_PUBLISH_MIN_SEC ||
+               cfg->publish_interval_sec > RCFG_PUBLISH_MAX_SEC) {
+        bad = "publish_interval";
+    } else if (cfg->preheat_sec > RCFG_PREHEAT_MAX_SEC) {
+        bad = "preheat";
+    } else if (cfg->stabilize_sec > RCFG_STABILIZE_MAX_SEC) {
+        bad = "stabilize";
+    } else if (cfg->lease_default_sec < RCFG_LEASE_MIN_SEC ||
+               cfg->lease_default_sec > REMOTE_LEASE_MAX_SEC) {
+        bad = "lease_default";
+    } else if (cfg->status_batch_sec > RCFG_BATCH_MAX_SEC) {
+        bad = "status_batch";
+    } else if (cfg->payload_format > PAYLOAD_FORMAT_CBOR) {
+        bad = "payload_format";
+    } else if (!valid_group(cfg->group)) {
+        bad = "group";
+    } else if (cfg->report_mode > REPORT_MODE_ON_CHANGE) {
+        bad = "report_mode";
+    } else if (cfg->heartbeat_sec < RCFG_PUBLISH_MIN_SEC || cfg->heartbeat_sec > RCFG_HEARTBEAT_MAX_SEC) {
+        bad = "heartbeat";
+    } else if (!in_range(cfg->co2_deadband, 0.0f, RCFG_DEADBAND_CO2_MAX) ||
+               !in_range(cfg->temp_deadband, 0.0f, RCFG_DEADBAND_TEMP_MAX) ||
+               !in_range(cfg->humi_deadband, 0.0f, RCFG_DEADBAND_HUMI_MAX)) {
+        bad = "deadband";
+    } else if (cfg->fan_count > FAN_MAX_COUNT || (cfg->duty_mask >> cfg->fan_count)) {
+        bad = "fans";
+    } else {
+        for (int i = 0; i < cfg->fan_count; i++) {
+            const FanDuty *d = &cfg->fan_duty[i];
+            if (d->low == 0 || d->night_low == 0 || d->low > d->high || d->night_low > d->night_high) {
+                bad = "fans";
+                break;
+            }
+        }
+    }
+
+    if (field) {
+        *field = bad;
+    }
+    return bad ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+RuntimeConfigResult runtime_config_submit(const RuntimeConfig *cfg, const char **field) {
+    if (field) {
+        *field = NULL;
+    }
+    if (!cfg) {
+        return RCFG_RESULT_INVALID;
+    }
+
+    RuntimeConfig current;
+    runtime_config_copy(&current);
+    if (cfg->version <= current.version || cfg->version <= s_version_floor) {
+        ESP_LOGI(TAG, "忽略配置 v%lu（当前 v%lu，下限 v%lu）", (unsigned long)cfg->version,
+                 (unsigned long)current.version, (unsigned long)s_version_floor);
+        return RCFG_RESULT_STALE;
+    }
+
+    RuntimeConfig candidate = *cfg;
+    resolve_fan_duty(&candidate);
+    if (runtime_config_validate(&candidate, field) != ESP_OK) {
+        ESP_LOGW(TAG, "配置 v%lu 校验失败（字段 %s），保持 v%lu",
+                 (unsigned long)cfg->version, field ? *field : "?", (unsigned long)current.version);
+        return RCFG_RESULT_INVALID;
+    }
+
+    // 当前配置保存为上一版本（编译期默认值无需保存）
+    RuntimeConfigBlob old_active = {.format = RCFG_FORMAT_VERSION, .cfg = current};
+    if (save_rotate(&candidate, current.version > 0 ? &old_active : NULL, 0) != ESP_OK) {
+        return RCFG_RESULT_STORAGE_ERROR;
+    }
+
+    set_pending(&candidate);
+    ESP_LOGI(TAG, "配置 v%lu 已保存，下一周期生效", (unsigned long)candidate.version);
+    return RCFG_RESULT_ACCEPTED;
+}
+
+RuntimeConfigResult runtime_config_rollback(uint32_t version) {
+    RuntimeConfig current;
+    runtime_config_copy(&current);
+    if (version == current.version && version <= s_version_floor) {
+        return RCFG_RESULT_ROLLED_BACK;  // 已回滚到该版本（重复投递）
+    }
+    if (version == 0 || version >= current.version) {
+        ESP_LOGW(TAG, "回滚目标 v%lu 不低于当前 v%lu", (unsigned long)version, (unsigned long)current.version);
+        return RCFG_RESULT_INVALID;
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(RCFG_NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        ESP_LOGW(TAG, "NVS 无上一版本配置，无法回滚");
+        return RCFG_RESULT_INVALID;
+    }
+    RuntimeConfig previous;
+    esp_err_t err = load_blob(nvs_handle, RCFG_NVS_KEY_PREVIOUS, &previous);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "上一版本配置不可用，无法回滚: %s", esp_err_to_name(err));
+        return RCFG_RESULT_INVALID;
+    }
+    if (previous.version != version) {
+        ESP_LOGW(TAG, "上一版本为 v%lu，无法回滚到 v%lu", (unsigned long)previous.version,
+                 (unsigned long)version);
+        return RCFG_RESULT_INVALID;
+    }
+
+    // 上一版本保持不变（与当前相同），被撤下的版本记为下限，不会再被保留消息带回
+    uint32_t floor = current.version > s_version_floor ? current.version : s_version_floor;
+    if (save_rotate(&previous, NULL, floor) != ESP_OK) {
+        return RCFG_RESULT_STORAGE_ERROR;
+    }
+    s_version_floor = floor;
+
+    set_pending(&previous);
+    ESP_LOGW(TAG, "配置回滚: v%lu → v%lu", (unsigned long)current.version, (unsigned long)previous.version);
+    return RCFG_RESULT_ROLLED_BACK;
+}
+
+uint32_t runtime_config_get_version_floor(void) {
+    return s_version_floor;
+}
+
+bool runtime_config_update(void) {
+    if (!s_pending_valid) {
+        return false;
+    }
+
+    // 宽限期：被换下的槽位在 RCFG_GRACE_MS 内仍可能有读者
+    int64_t now = esp_timer_get_time();
+    if (s_last_swap_us != 0 && now - s_last_swap_us < (int64_t)RCFG_GRACE_MS * 1000) {
+        return false;
+    }
+
+    RuntimeConfig *next = (s_active == &s_slots[0]) ? &s_slots[1] : &s_slots[0];
+    portENTER_CRITICAL(&s_pending_lock);
+    *next = s_pending;
+    s_pending_valid = false;
+    portEXIT_CRITICAL(&s_pending_lock);
+
+    uint32_t old_version = s_active->version;
+    __atomic_store_n(&s_active, next, __ATOMIC_RELEASE);
+    s_last_swap_us = now;
+
+    ESP_LOGI(TAG, "配置切换: v%lu → v%lu", (unsigned long)old_version, (unsigned long)next->version);
+    return true;
+}
+
+const char *runtime_config_result_to_string(RuntimeConfigResult result) {
+    switch (result) {
+        case RCFG_RESULT_ACCEPTED:      return "ACCEPTED";
+        case RCFG_RESULT_STALE:         return "STALE";
+        case RCFG_RESULT_INVALID:       return "INVALID";
+        case RCFG_RESULT_STORAGE_ERROR: return "STORAGE_ERROR";
+        case RCFG_RESULT_ROLLED_BACK:   return "ROLLED_BACK";
+        default:                        return "UNKNOWN";
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * @file runtime_config.h
+ * @brief 运行时配置接口定义 - 阈值、周期与风扇占空比的热更新（MQTT 下发，NVS 持久化）
+ */
+
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 单个风扇各档位占空比
+ */
+typedef struct {
+    uint8_t low;          ///< 白天 LOW 档
+    uint8_t high;         ///< 白天 HIGH 档
+    uint8_t night_low;    ///< 静音时段 LOW 档
+    uint8_t night_high;   ///< 静音时段 HIGH 档
+} FanDuty;
+
+/**
+ * @brief 运行时配置快照
+ * 发布后不再修改：读者通过 runtime_config_get() 取得指针后直接读取字段，无需加锁。
+ * 指针只能在一次循环内使用，不得跨 vTaskDelay 保存（旧快照在 RCFG_GRACE_MS 后复用）。
+ */
+typedef struct {
+    uint32_t version;              ///< 配置文档版本（单调递增，0 = 编译期默认值）
+
+    float co2_low;                 ///< CO2 低速阈值（ppm）
+    float co2_high;                ///< CO2 高速阈值（ppm）
+    float co2_alert;               ///< CO2 告警阈值（ppm）
+    float co2_min_valid;           ///< CO2 最小有效值（ppm）
+    float co2_max_valid;           ///< CO2 最大有效值（ppm）
+    float temp_min_valid;          ///< 温度最小有效值（℃）
+    float temp_max_valid;          ///< 温度最大有效值（℃）
+    float humi_min_valid;          ///< 湿度最小有效值（%）
+    float humi_max_valid;          ///< 湿度最大有效值（%）
+
+    uint16_t publish_interval_sec; ///< MQTT 状态上报间隔（秒）
+    uint16_t preheat_sec;          ///< CO2 传感器预热时间（秒）
+    uint16_t stabilize_sec;        ///< CO2 传感器稳定时间（秒）
+    uint16_t lease_default_sec;    ///< 远程命令默认租约（秒）
+
+    uint8_t duty_mask;             ///< 覆盖风扇配置表占空比的风扇位掩码
+    uint8_t fan_count;             ///< fan_duty 中已解析的风扇数量
+    FanDuty fan_duty[FAN_MAX_COUNT]; ///< 已解析的各风扇占空比（未覆盖的取自风扇配置表）
+
+    uint16_t status_batch_sec;     ///< 批量状态上报抽取间隔（秒，0 = 关闭）
+    uint8_t payload_format;        ///< 上报消息编码 PayloadFormat
+    char group[RCFG_GROUP_MAX_LEN + 1]; ///< 设备分组名（空串 = 不加入分组）
+
+    uint8_t report_mode;           ///< 状态上报方式 ReportMode
+    uint16_t heartbeat_sec;        ///< 变化上报最长静默（秒）
+    float co2_deadband;            ///< 变化上报 CO2 死区（ppm，0 = 任何变化）
+    float temp_deadband;           ///< 变化上报温度死区（℃，0 = 任何变化）
+    float humi_deadband;           ///< 变化上报湿度死区（%，0 = 任何变化）
+} RuntimeConfig;
+
+/**
+ * @brief 提交结果（随 config/state 上报）
+ */
+typedef enum {
+    RCFG_RESULT_ACCEPTED = 0,  ///< 校验通过并已保存，下一决策周期生效
+    RCFG_RESULT_STALE,         ///< 版本不高于当前版本或回滚下限，忽略（重复投递的保留消息）
+    RCFG_RESULT_INVALID,       ///< 校验失败，保持当前配置
+    RCFG_RESULT_STORAGE_ERROR, ///< NVS 写入失败，保持当前配置
+    RCFG_RESULT_ROLLED_BACK,   ///< 已回滚到上一版本配置
+} RuntimeConfigResult;
+
+/**
+ * @brief 初始化运行时配置（须在 fan_control_init() 之后调用）
+ * 从 NVS 加载当前配置；当前配置损坏或校验失败时回滚到上一版本，仍失败则使用编译期默认值
+ * @return ESP_OK 成功
+ */
+esp_err_t runtime_config_init(void);
+
+/**
+ * @brief 获取当前配置快照（不会返回 NULL，初始化前为编译期默认值）
+ * @return 只读快照指针
+ */
+const RuntimeConfig *runtime_config_get(void);
+
+/**
+ * @brief 复制当前生效（或等待生效）的配置，作为增量修改的基础
+ * @param[out] out 输出配置
+ */
+void runtime_config_copy(RuntimeConfig *out);
+
+/**
+ * @brief 校验配置
+ * @param cfg 待校验配置
+ * @param[out] field 校验失败的字段名（可为 NULL）
+ * @return ESP_OK 有效，ESP_ERR_INVALID_ARG 无效
+ */
+esp_err_t runtime_config_validate(const RuntimeConfig *cfg, const char **field);
+
+/**
+ * @brief 提交新配置：校验 → 保存到 NVS（原配置保留为上一版本）→ 等待决策任务切换
+ * 可在 MQTT 任务中调用
+ * @param cfg 新配置（version 必须大于当前版本与回滚下限）
+ * @param[out] field 校验失败的字段名（可为 NULL）
+ * @return 提交结果
+ */
+RuntimeConfigResult runtime_config_submit(const RuntimeConfig *cfg, const char **field);
+
+/**
+ * @brief 回滚到 NVS 中保存的上一版本配置
+ * 被撤下的版本记为下限（持久化），之后不高于下限的配置文档返回 RCFG_RESULT_STALE。
+ * 幂等：已回滚到 version 时再次调用不做任何修改，同样返回 RCFG_RESULT_ROLLED_BACK
+ * @param version 目标版本，必须等于上一版本（低于当前版本）
+ * @return RCFG_RESULT_ROLLED_BACK 成功，RCFG_RESULT_INVALID 上一版本不是 version 或不可用，
+ *         RCFG_RESULT_STORAGE_ERROR NVS 写入失败
+ */
+RuntimeConfigResult runtime_config_rollback(uint32_t version);
+
+/**
+ * @brief 回滚下限（0 = 未回滚过）
+ */
+uint32_t runtime_config_get_version_floor(void);
+
+/**
+ * @brief 切换到等待生效的配置（决策任务每周期调用）
+ * @return true 本周期切换了配置
+ */
+bool runtime_config_update(void);
+
+/**
+ * @brief RuntimeConfigResult 转字符串（用于 MQTT 上报）
+ */
+const char *runtime_config_result_to_string(RuntimeConfigResult result);
+
+#endif // RUNTIME_CONFIG_H
@@ -12,14 +12,30 @@
 #include "freertos/event_groups.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 #include "main.h"
 #include "sensors/sensor_manager.h"
 #include "actuators/fan_control.h"
+#include "actuators/fan_tach.h"
+#include "actuators/fan_energy.h"
 #include "algorithm/decision_engine.h"
+#include "algorithm/co2_predictor.h"
+#include "algorithm/vent_ident.h"
+#include "algorithm/occupancy_habit.h"
+#include "algorithm/schedule.h"
+#include "config/runtime_config.h"
 #include "network/wifi_manager.h"
 #include "network/mqtt_wrapper.h"
+#include "network/telemetry_buffer.h"
+#include "network/status_batch.h"
+#include "network/device_shadow.h"
+#include "network/report_policy.h"
+#include "network/conn_supervisor.h"
+#include "network/local_http.h"
+#include "system/power_manager.h"
+#include "system/diagnostics.h"
 #include "ui/oled_display.h"
 
 // ============================================================================
@@ -34,10 +50,11 @@ static const char *TAG = "MAIN";
 // 系统状态
 static SystemState current_state = STATE_INIT;
 static SystemMode current_mode = MODE_LOCAL;
+static ModeReason current_mode_reason = MODE_REASON_NO_LEASE;
 
 // 共享数据缓冲区
 static SensorData shared_sensor_data = {0};
-static FanState shared_fan_states[FAN_COUNT] = {FAN_OFF, FAN_OFF, FAN_OFF};
+static FanState shared_fan_states[FAN_MAX_COUNT] = {FAN_OFF};
 
 // 同步对象
 static SemaphoreHandle_t data_mutex = NULL;
@@ -62,24 +79,72 @@ SemaphoreHandle_t get_i2c_mutex(void) {
     return i2c_mutex;
 }
 
+bool is_time_valid(void) {
+    return time(NULL) >= TIME_VALID_EPOCH;
+}
+
+/**
+ * @brief 将风扇状态数组格式化为日志字符串，如 "[1,2,0]"
+ */
+static const char *format_fan_states(char *buf, size_t len, const FanState *states, uint8_t count) {
+    int pos = snprintf(buf, len, "[");
+    for (int i = 0; i < count && pos < (int)len; i++) {
+        pos += snprintf(buf + pos, len - pos, i == 0 ? "%d" : ",%d", states[i]);
+    }
+    if (pos < (int)len) {
+        snprintf(buf + pos, len - pos, "]");
+    }
+    return buf;
+}
+
+/**
+ * @brief 上报风扇转速告警（堵转/转速不足）到显示和 MQTT
+ * @param alarm_mask fan_tach_update() 返回的告警位掩码
+ */
+static void report_fan_tach_alarms(uint32_t alarm_mask) {
+    for (int i = 0; i < FAN_MAX_COUNT && alarm_mask; i++) {
+        if (!(alarm_mask & (1u << i))) {
+            continue;
+        }
+        alarm_mask &= ~(1u << i);
+
+        char alert_msg[64];
+        if (fan_tach_get_health((FanId)i) == FAN_TACH_STALL) {
+            snprintf(alert_msg, sizeof(alert_msg), "Fan%d 堵转/断线", i);
+        } else {
+            snprintf(alert_msg, sizeof(alert_msg), "Fan%d 转速不足: %d rpm", i, fan_tach_get_rpm((FanId)i));
+        }
+
+        xQueueSend(alert_queue, &alert_msg, 0);
+        if (wifi_manager_is_connected()) {
+            mqtt_publish_alert(alert_msg);
+        }
+    }
+}
+
 /**
- * @brief 判断当前是否为夜间模式
- * 夜间时间定义：22:00-8:00
- * 注意：需要通过 WiFi 连接后 SNTP 同步时间，或手动设置时间
- * @return true 夜间模式，false 白天模式
+ * @brief 记录运行模式切换；远程租约过期时上报故障转移延迟
+ * @param mode 新模式
+ * @param reason 新模式判定原因
+ * @param lease_expire_us 远程租约到期时刻（esp_timer 时基）
  */
-bool is_night_time(void) {
-    time_t now;
-    struct tm timeinfo;
-    
-    // 获取当前时间
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    
-    int hour = timeinfo.tm_hour;
-    
-    // 夜间时间：22:00-23:59 或 0:00-7:59
-    return (hour >= 22 || hour < 8);
+static void report_mode_change(SystemMode mode, ModeReason reason, int64_t lease_expire_us) {
+    ESP_LOGI(TAG, "运行模式切换: %d → %d（%s）",
+             current_mode, mode, decision_mode_reason_to_string(reason));
+
+    if (reason != MODE_REASON_LEASE_EXPIRED) {
+        return;
+    }
+
+    // 从租约到期到本周期切换本地控制的延迟（应不超过一个决策周期）
+    int64_t failover_ms = (esp_timer_get_time() - lease_expire_us) / 1000;
+    char alert_msg[64];
+    snprintf(alert_msg, sizeof(alert_msg), "远程租约过期，切换本地控制（%lld ms）", (long long)failover_ms);
+
+    xQueueSend(alert_queue, &alert_msg, 0);
+    if (wifi_manager_is_connected()) {
+        mqtt_publish_alert(alert_msg);
+    }
 }
 
 // ============================================================================
@@ -129,13 +194,13 @@ static void handle_preheating_state(void) {
 
     if (preheating_start == 0) {
         preheating_start = xTaskGetTickCount();
-        ESP_LOGI(TAG, "进入 PREHEATING 状态（60秒倒计时）");
+        ESP_LOGI(TAG, "进入 PREHEATING 状态（%d秒倒计时）", runtime_config_get()->preheat_sec);
         oled_display_alert("传感器预热中...");
     }
 
     // 检查是否超时
     uint32_t elapsed = (xTaskGetTickCount() - preheating_start) / configTICK_RATE_HZ;
-    if (elapsed >= PREHEATING_TIME_SEC) {
+    if (elapsed >= runtime_config_get()->preheat_sec) {
         ESP_LOGI(TAG, "预热完成");
         xEventGroupSetBits(system_events, EVENT_SENSOR_READY);
         preheating_start = 0;
@@ -151,13 +216,13 @@ static void handle_stabilizing_state(void) {
 
     if (stabilizing_start == 0) {
         stabilizing_start = xTaskGetTickCount();
-        ESP_LOGI(TAG, "进入 STABILIZING 状态（240秒倒计时）");
+        ESP_LOGI(TAG, "进入 STABILIZING 状态（%d秒倒计时）", runtime_config_get()->stabilize_sec);
         oled_display_alert("传感器稳定中...");
     }
 
     // 检查是否超时
     uint32_t elapsed = (xTaskGetTickCount() - stabilizing_start) / configTICK_RATE_HZ;
-    if (elapsed >= STABILIZING_TIME_SEC) {
+    if (elapsed >= runtime_config_get()->stabilize_sec) {
         ESP_LOGI(TAG, "稳定完成");
         xEventGroupSetBits(system_events, EVENT_SENSOR_STABLE);
         stabilizing_start = 0;
@@ -192,7 +257,7 @@ static void handle_error_state(void) {
 
         // 更新共享状态，确保 MQTT/UI 显示与硬件一致
         xSemaphoreTake(data_mutex, portMAX_DELAY);
-        for (int i = 0; i < FAN_COUNT; i++) {
+        for (int i = 0; i < FAN_MAX_COUNT; i++) {
             shared_fan_states[i] = FAN_OFF;
         }
         xSemaphoreGive(data_mutex);
@@ -256,7 +321,7 @@ static void sensor_task(void *pvParameters) {
         // 检查CO₂告警（基于显示值的 1/4）
         if (data.valid) {
             float effective_co2 = data.pollutants.co2 / 4.0f;
-            if (effective_co2 > CO2_ALERT_THRESHOLD) {
+            if (effective_co2 > runtime_config_get()->co2_alert) {
                 char alert_msg[64];
                 snprintf(alert_msg, sizeof(alert_msg), "CO₂浓度过高: %.0f ppm", effective_co2);
 
@@ -270,7 +335,7 @@ static void sensor_task(void *pvParameters) {
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 1Hz
+        power_manager_wait_period(1000); // 1Hz，与其他周期任务同一节拍唤醒
     }
 }
 
@@ -279,88 +344,168 @@ static void sensor_task(void *pvParameters) {
  */
 static void decision_task(void *pvParameters) {
     SensorData sensor;
-    FanState new_states[FAN_COUNT];
-    FanState remote_cmd[FAN_COUNT] = {FAN_OFF, FAN_OFF, FAN_OFF};
+    FanState new_states[FAN_MAX_COUNT] = {FAN_OFF};
+    FanState remote_cmd[FAN_MAX_COUNT] = {FAN_OFF};
+    const uint8_t fan_count = fan_control_get_count();
+
+    TickType_t last_tach_tick = xTaskGetTickCount();
 
-    ESP_LOGI(TAG, "决策任务启动");
+    ESP_LOGI(TAG, "决策任务启动（%d 个风扇）", fan_count);
 
     while (1) {
+        // 转速采样、堵转检测、转速闭环与能耗积分（与决策同周期，不受下方 continue 影响）
+        TickType_t now_tick = xTaskGetTickCount();
+        uint32_t elapsed_ms = pdTICKS_TO_MS(now_tick - last_tach_tick);
+        report_fan_tach_alarms(fan_tach_update(elapsed_ms));
+        fan_energy_update(elapsed_ms);
+        last_tach_tick = now_tick;
+
+        // 切换到 MQTT 下发的新配置（本周期起所有任务读取新快照）
+        bool config_changed = runtime_config_update();
+
         // 等待稳定状态完成
         if (current_state < STATE_RUNNING) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            power_manager_wait_period(1000);
             continue;
         }
 
         // 读取共享数据
         xSemaphoreTake(data_mutex, portMAX_DELAY);
         memcpy(&sensor, &shared_sensor_data, sizeof(SensorData));
-        FanState old_states[FAN_COUNT];
+        FanState old_states[FAN_MAX_COUNT];
         memcpy(old_states, shared_fan_states, sizeof(old_states));
         xSemaphoreGive(data_mutex);
 
+        // 记录 CO2 历史（任何模式下都采样，切换到本地模式时预测可立即生效）
+        if (sensor.valid) {
+            vent_ident_add_sample(sensor.pollutants.co2, old_states, fan_count);
+            if (co2_predictor_add_sample(sensor.pollutants.co2, old_states, fan_count)) {
+                // 每分钟按产生率判定是否有人，累计到周作息直方图
+                float generation;
+                if (co2_predictor_estimate_generation(&generation)) {
+                    occupancy_habit_add_minute(generation);
+                }
+            }
+        }
+
         // 检测运行模式
         bool wifi_ok = wifi_manager_is_connected();
         bool sensor_ok = sensor_manager_is_healthy();
-        current_mode = decision_detect_mode(wifi_ok, sensor_ok);
-
-        // MODE_REMOTE 时获取远程命令，无命令则保持当前状态
-        if (current_mode == MODE_REMOTE) {
-            if (!mqtt_get_remote_command(remote_cmd)) {
-                ESP_LOGD(TAG, "远程模式：无新命令，保持当前状态");
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                continue;
-            }
+        int64_t lease_expire_us;
+        RemoteLease lease = mqtt_get_remote_lease(&lease_expire_us);
+        ModeReason reason;
+        SystemMode mode = decision_detect_mode(wifi_ok, lease, sensor_ok, &reason);
+        if (mode != current_mode || reason != current_mode_reason) {
+            report_mode_change(mode, reason, lease_expire_us);
+            current_mode_reason = reason;
         }
+        current_mode = mode;
 
-        // 执行决策
-        decision_make(&sensor, remote_cmd, current_mode, new_states);
+        // MODE_REMOTE 时获取远程命令（租约在两次查询之间到期则保持当前状态，下周期切换）
+        if (current_mode == MODE_REMOTE && !mqtt_get_remote_command(remote_cmd, fan_count)) {
+            ESP_LOGD(TAG, "远程模式：无新命令，保持当前状态");
+            memcpy(new_states, old_states, sizeof(new_states));
+        } else {
+            // 执行决策
+            decision_make(&sensor, remote_cmd, fan_count, current_mode, new_states);
+        }
+
+        // 通风辨识阶跃测试进行中时覆盖决策结果
+        vent_ident_step_override(&sensor, current_mode, new_states, fan_count);
+
+        // 分时段调度：档位上限 / 禁用时段限制决策结果
+        bool schedule_changed = schedule_update();
+        ScheduleState sched;
+        schedule_get_state(&sched);
+        schedule_apply_cap(new_states, fan_count);
 
         // 设置风扇状态
-        bool is_night = is_night_time();
         bool state_changed = false;
-        
-        // 记录夜间模式状态（每分钟记录一次）
-        static uint32_t last_night_log = 0;
-        uint32_t now_sec = xTaskGetTickCount() / configTICK_RATE_HZ;
-        if (now_sec - last_night_log >= 60) {
-            time_t now;
-            struct tm timeinfo;
-            time(&now);
-            localtime_r(&now, &timeinfo);
-            ESP_LOGI(TAG, "当前时间: %02d:%02d:%02d, 夜间模式: %s", 
-                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec,
-                     is_night ? "是" : "否");
-            last_night_log = now_sec;
-        }
 
-        for (int i = 0; i < FAN_COUNT; i++) {
+        for (int i = 0; i < fan_count; i++) {
             if (new_states[i] != old_states[i]) {
-                fan_control_set_state((FanId)i, new_states[i], is_night);
                 state_changed = true;
             }
         }
 
-        if (state_changed) {
+        if (state_changed || schedule_changed || config_changed) {
+            // 批量下发：硬件渐变软启停，同时启动的风扇错峰（各通道不在同一 PWM 周期切换，
+            // 原子提交只用于 ERROR 状态的安全停机）
+            // 跨过时段边界或配置切换时即使档位不变也重新下发（占空比可能不同）
+            fan_control_set_states(new_states, fan_count, sched.quiet);
+
             xSemaphoreTake(data_mutex, portMAX_DELAY);
-            memcpy(shared_fan_states, new_states, sizeof(shared_fan_states));
+            memcpy(shared_fan_states, new_states, fan_count * sizeof(FanState));
             xSemaphoreGive(data_mutex);
 
-            ESP_LOGI(TAG, "风扇状态变化: [%d,%d,%d] → [%d,%d,%d]",
-                     old_states[0], old_states[1], old_states[2],
-                     new_states[0], new_states[1], new_states[2]);
+            char old_buf[3 * FAN_MAX_COUNT + 3];
+            char new_buf[3 * FAN_MAX_COUNT + 3];
+            ESP_LOGI(TAG, "风扇状态变化: %s → %s%s",
+                     format_fan_states(old_buf, sizeof(old_buf), old_states, fan_count),
+                     format_fan_states(new_buf, sizeof(new_buf), new_states, fan_count),
+                     sched.quiet ? "（静音时段）" : "");
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 1Hz
+        power_manager_wait_period(1000); // 1Hz
     }
 }
 
 /**
- * @brief 网络任务（MQTT 30秒周期上报）
+ * @brief 发布影子 reported 中变化的字段（连接建立或后端请求后发布完整状态）
+ */
+static void publish_shadow_reported(const FanState fans[], uint8_t fan_count) {
+    ShadowState state = {
+        .fan_count = fan_count,
+        .mode = current_mode,
+        .mode_reason = current_mode_reason,
+        .lease = mqtt_get_remote_lease(NULL),
+        .desired_version = device_shadow_get_desired_version(),
+        .config_version = runtime_config_get()->version,
+    };
+    memcpy(state.fans, fans, fan_count * sizeof(FanState));
+
+    bool full = device_shadow_take_full();
+    uint32_t fields = device_shadow_diff(&state);
+    if (full || fields == SHADOW_FIELD_ALL) {
+        full = true;
+        fields = SHADOW_FIELD_ALL;
+    } else if (fields == 0) {
+        return;
+    }
+
+    if (mqtt_publish_shadow(&state, fields, full) == ESP_OK) {
+        device_shadow_mark_reported(&state);
+    } else if (full) {
+        device_shadow_request_full();  // 下个周期重试
+    }
+}
+
+#if CONFIG_LOCAL_HTTP
+/**
+ * @brief 本地 HTTP 接口的状态快照（在 HTTP 服务器任务中调用，co2 使用 1/4 显示值，同 status 消息）
+ */
+static bool local_http_get_state(LocalHttpState *out) {
+    if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    memcpy(&out->sensor, &shared_sensor_data, sizeof(SensorData));
+    memcpy(out->fans, shared_fan_states, sizeof(out->fans));
+    xSemaphoreGive(data_mutex);
+    out->sensor.pollutants.co2 = out->sensor.pollutants.co2 / 4.0f;
+    out->fan_count = fan_control_get_count();
+    out->mode = current_mode;
+    out->mode_reason = current_mode_reason;
+    return true;
+}
+#endif
+
+/**
+ * @brief 网络任务（MQTT 状态上报：默认每 30 秒定时，可配置为变化上报）
  */
 static void network_task(void *pvParameters) {
     SensorData sensor;
-    FanState fans[FAN_COUNT];
-    uint32_t last_mqtt_publish = 0;
+    FanState fans[FAN_MAX_COUNT];
+    const uint8_t fan_count = fan_control_get_count();
 
     ESP_LOGI(TAG, "网络任务启动");
 
@@ -374,31 +519,84 @@ static void network_task(void *pvParameters) {
             xEventGroupClearBits(system_events, EVENT_WIFI_CONNECTED);
         }
 
-        // 检查是否需要发布 MQTT 状态（30 秒周期）
-        if (now - last_mqtt_publish >= MQTT_PUBLISH_INTERVAL_SEC) {
-            if (wifi_manager_is_connected()) {
-                if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                    memcpy(&sensor, &shared_sensor_data, sizeof(SensorData));
-                    memcpy(fans, shared_fan_states, sizeof(fans));
-                    xSemaphoreGive(data_mutex);
-
-                    // 仅在传感器数据有效时发布（发布的 co2 使用 1/4 显示值）
-                    if (sensor.valid) {
-                        SensorData pub_sensor = sensor;
-                        pub_sensor.pollutants.co2 = sensor.pollutants.co2 / 4.0f;
-                        esp_err_t ret = mqtt_publish_status(&pub_sensor, fans, current_mode);
-                        if (ret != ESP_OK) {
-                            ESP_LOGW(TAG, "MQTT 状态发布失败");
-                        }
-                    } else {
-                        ESP_LOGD(TAG, "传感器数据无效，跳过 MQTT 发布");
+        // 每秒取一次共享数据，供批量上报抽取（co2 使用 1/4 显示值）
+        bool have_data = false;
+        if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            memcpy(&sensor, &shared_sensor_data, sizeof(SensorData));
+            memcpy(fans, shared_fan_states, sizeof(fans));
+            xSemaphoreGive(data_mutex);
+            sensor.pollutants.co2 = sensor.pollutants.co2 / 4.0f;
+            status_batch_add(&sensor, fans, fan_count, current_mode);
+            have_data = true;
+        }
+
+        // 检查是否需要发布 MQTT 状态（定时，或按死区 / 风扇与模式变化，见 report_policy）
+        // 断网或发布失败时样本进入离线缓存，恢复后补传
+        ReportTrigger trigger = have_data ?
+            report_policy_check(&sensor, fans, fan_count, current_mode, current_mode_reason, now) :
+            REPORT_TRIGGER_NONE;
+        if (trigger != REPORT_TRIGGER_NONE) {
+            // 仅在传感器数据有效时发布
+            if (sensor.valid) {
+                esp_err_t ret = ESP_FAIL;
+                if (wifi_manager_is_connected()) {
+                    ret = mqtt_publish_status(&sensor, fans, fan_count, current_mode,
+                                              current_mode_reason, status_batch_get());
+                    if (ret != ESP_OK) {
+                        ESP_LOGW(TAG, "MQTT 状态发布失败，样本转入离线缓存");
                     }
                 }
+                if (ret != ESP_OK) {
+                    TelemetrySample sample;
+                    telemetry_sample_make(&sensor, fans, fan_count,
+                                          current_mode, current_mode_reason, &sample);
+                    telemetry_buffer_push(&sample);
+                }
+            } else {
+                ESP_LOGD(TAG, "传感器数据无效，跳过 MQTT 发布");
+            }
+            report_policy_commit(&sensor, fans, fan_count, current_mode, current_mode_reason,
+                                 now, sensor.valid);
+            status_batch_reset();
+        }
+
+        // 限速补传离线缓存（每批等待确认，发送队列积压时暂停，实时状态优先）
+        if (wifi_manager_is_connected()) {
+            telemetry_buffer_drain(mqtt_publish_backlog, mqtt_get_outbox_size());
+            mqtt_client_sync_group();
+        }
+
+        // 影子 reported 只在状态变化时发布（未发出的变化留到下个周期）
+        if (wifi_manager_is_connected() && have_data) {
+            publish_shadow_reported(fans, fan_count);
+        }
+
+        // 通风模型更新或收到上报请求时发布
+        if (wifi_manager_is_connected() && vent_ident_take_report_pending()) {
+            VentModel model;
+            vent_ident_get_model(&model);
+            if (mqtt_publish_vent_model(&model, vent_ident_get_state(),
+                                        vent_ident_get_step(), vent_ident_get_note()) != ESP_OK) {
+                vent_ident_request_report();  // 下个周期重试
+            }
+        }
+
+        // 收到导出请求时发布周作息直方图
+        if (wifi_manager_is_connected() && occupancy_habit_take_export_pending()) {
+            if (mqtt_publish_habit() != ESP_OK) {
+                occupancy_habit_request_export();  // 下个周期重试
+            }
+        }
+
+        // 运行诊断：定时采样，定时或出现新告警时上报
+        diagnostics_update(now);
+        if (wifi_manager_is_connected() && diagnostics_take_report_pending()) {
+            if (mqtt_publish_diag() != ESP_OK) {
+                diagnostics_request_report();  // 下个周期重试
             }
-            last_mqtt_publish = now;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        power_manager_wait_period(1000);
     }
 }
 
@@ -407,7 +605,8 @@ static void network_task(void *pvParameters) {
  */
 static void display_task(void *pvParameters) {
     SensorData sensor;
-    FanState fan;
+    FanState fans[FAN_MAX_COUNT];
+    const uint8_t fan_count = fan_control_get_count();
     char alert_msg[64];
 
     ESP_LOGI(TAG, "显示任务启动");
@@ -426,7 +625,7 @@ static void display_task(void *pvParameters) {
         if (current_state == STATE_RUNNING) {
             xSemaphoreTake(data_mutex, portMAX_DELAY);
             memcpy(&sensor, &shared_sensor_data, sizeof(SensorData));
-            fan = shared_fan_states[0];  // 暂时显示第一个风扇状态
+            memcpy(fans, shared_fan_states, sizeof(fans));
             xSemaphoreGive(data_mutex);
 
             // 启动后立即添加第一个数据点
@@ -436,7 +635,7 @@ static void display_task(void *pvParameters) {
                 ESP_LOGI(TAG, "添加初始历史数据点");
             }
 
-            oled_display_main_page(&sensor, fan, current_mode);
+            oled_display_main_page(&sensor, fans, fan_count, current_mode);
 
             // 每 10 分钟添加一个历史数据点（300 次循环 * 2秒 = 600秒 = 10分钟）
             history_counter++;
@@ -446,7 +645,7 @@ static void display_task(void *pvParameters) {
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(2000)); // 0.5Hz
+        power_manager_wait_period(2000); // 0.5Hz
     }
 }
 
@@ -494,6 +693,19 @@ static esp_err_t system_init(void) {
     }
     ESP_LOGI(TAG, "✓ 同步对象创建成功");
 
+    // 配置动态调频（失败时以固定频率运行）
+    ret = power_manager_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 功耗管理初始化失败（固定频率运行）");
+    } else {
+        ESP_LOGI(TAG, "✓ 功耗管理初始化成功");
+    }
+
+    // 运行诊断（登记堆内存指标，采样由网络任务驱动）
+    if (diagnostics_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 诊断指标登记失败");
+    }
+
     // 初始化传感器管理器
     ret = sensor_manager_init();
     if (ret != ESP_OK) {
@@ -510,6 +722,70 @@ static esp_err_t system_init(void) {
     }
     ESP_LOGI(TAG, "✓ 风扇控制初始化成功");
 
+    // 加载运行时配置（依赖风扇配置表解析各风扇占空比）
+    ret = runtime_config_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 运行时配置加载失败（使用编译期默认值）");
+    } else {
+        ESP_LOGI(TAG, "✓ 运行时配置加载成功");
+    }
+
+    // 初始化风扇转速反馈（无转速计的风扇按开环运行）
+    ret = fan_tach_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 风扇转速反馈初始化失败（继续运行）");
+    } else {
+        ESP_LOGI(TAG, "✓ 风扇转速反馈初始化成功");
+    }
+
+    // 加载风扇能耗与运行统计（无记录时从零开始累计）
+    ret = fan_energy_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 能耗统计加载失败（从零开始累计）");
+    } else {
+        ESP_LOGI(TAG, "✓ 能耗统计加载成功");
+    }
+
+    // 加载房间通风模型（无记录时使用默认参数）
+    ret = vent_ident_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 通风模型加载失败（使用默认参数）");
+    } else {
+        ESP_LOGI(TAG, "✓ 通风模型加载成功");
+    }
+
+    // 加载分时段调度表（无配置时默认每天 22:00-08:00 静音）
+    ret = schedule_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 时段表加载失败（使用默认配置）");
+    } else {
+        ESP_LOGI(TAG, "✓ 时段表加载成功");
+    }
+
+    // 加载周作息直方图（无记录时从零开始学习）
+    ret = occupancy_habit_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 作息直方图加载失败（从零开始学习）");
+    } else {
+        ESP_LOGI(TAG, "✓ 作息直方图加载成功");
+    }
+
+    // 初始化遥测离线缓存（恢复 Flash 中未补传的样本）
+    ret = telemetry_buffer_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 离线缓存初始化失败（继续运行）");
+    } else {
+        ESP_LOGI(TAG, "✓ 离线缓存初始化成功");
+    }
+
+    // 初始化连接监管（WiFi / MQTT 重连调度，须先于 WiFi 管理器）
+    ret = conn_supervisor_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 连接监管初始化失败（断线后不会自动重连）");
+    } else {
+        ESP_LOGI(TAG, "✓ 连接监管初始化成功");
+    }
+
     // 初始化 WiFi 管理器
     ret = wifi_manager_init();
     if (ret != ESP_OK) {
@@ -526,6 +802,16 @@ static esp_err_t system_init(void) {
         ESP_LOGI(TAG, "✓ MQTT客户端初始化成功");
     }
 
+#if CONFIG_LOCAL_HTTP
+    // 启动本地 HTTP 接口（局域网指标导出与本地命令）
+    ret = local_http_start(local_http_get_state);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ 本地 HTTP 接口启动失败（继续运行）");
+    } else {
+        ESP_LOGI(TAG, "✓ 本地 HTTP 接口启动成功");
+    }
+#endif
+
     // 初始化 OLED 显示
     ret = oled_display_init();
     if (ret != ESP_OK) {
@@ -600,6 +886,6 @@ void app_main(void) {
                 break;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 1Hz状态机循环
+        power_manager_wait_period(1000); // 1Hz状态机循环
     }
 }
@@ -28,28 +28,45 @@ typedef enum {
 } SystemState;
 
 /**
- * @brief 风扇数量
+ * @brief 风扇数量上限（受 LEDC 通道数限制，ESP32-S3 为 8 路）
+ * 实际风扇数量由 NVS 中的风扇配置表决定，见 fan_control_get_count()
  */
-#define FAN_COUNT 3
+#define FAN_MAX_COUNT 8
 
 /**
- * @brief 风扇ID枚举
+ * @brief 风扇ID（风扇配置表中的索引，0 ~ fan_control_get_count()-1）
  */
-typedef enum {
-    FAN_ID_0 = 0,  ///< 风扇0（GPIO26）
-    FAN_ID_1 = 1,  ///< 风扇1（GPIO27）
-    FAN_ID_2 = 2   ///< 风扇2（GPIO33）
-} FanId;
+typedef uint8_t FanId;
 
 /**
  * @brief 系统运行模式
  */
 typedef enum {
-    MODE_REMOTE,    ///< 远程模式（WiFi 连接，接收远程风扇控制命令）
-    MODE_LOCAL,     ///< 本地模式（网络离线，仅 CO2 决策）
+    MODE_REMOTE,    ///< 远程模式（WiFi 连接且远程命令租约有效）
+    MODE_LOCAL,     ///< 本地模式（网络离线或无有效租约，仅 CO2 决策）
     MODE_SAFE_STOP  ///< 安全停机（传感器故障）
 } SystemMode;
 
+/**
+ * @brief 远程命令租约状态
+ */
+typedef enum {
+    LEASE_NONE = 0, ///< 从未收到远程命令
+    LEASE_VALID,    ///< 租约有效
+    LEASE_EXPIRED,  ///< 租约已过期（或被 ttl=0 主动释放）
+} RemoteLease;
+
+/**
+ * @brief 运行模式判定原因（随状态上报）
+ */
+typedef enum {
+    MODE_REASON_LEASE = 0,      ///< 远程租约有效
+    MODE_REASON_NO_WIFI,        ///< WiFi 断开
+    MODE_REASON_NO_LEASE,       ///< 尚未收到远程命令
+    MODE_REASON_LEASE_EXPIRED,  ///< 远程租约过期
+    MODE_REASON_SENSOR_FAULT,   ///< 传感器故障
+} ModeReason;
+
 /**
  * @brief 风扇状态枚举
  */
@@ -59,11 +76,28 @@ typedef enum {
     FAN_HIGH = 2,   ///< 高速档位
 } FanState;
 
+/**
+ * @brief 状态 / 告警 / 补传消息的编码格式（按设备在运行时配置中选择）
+ */
+typedef enum {
+    PAYLOAD_FORMAT_JSON = 0,  ///< JSON（默认）
+    PAYLOAD_FORMAT_CBOR,      ///< CBOR（RFC 8949，键名与 JSON 相同）
+} PayloadFormat;
+
+/**
+ * @brief 状态上报方式（按设备在运行时配置中选择）
+ */
+typedef enum {
+    REPORT_MODE_INTERVAL = 0,  ///< 按 publish_interval 定时上报（默认）
+    REPORT_MODE_ON_CHANGE,     ///< 读数超出死区或风扇 / 模式变化时上报，静默超过 heartbeat 时补发
+} ReportMode;
+
 /**
  * @brief 多风扇状态结构
  */
 typedef struct {
-    FanState states[FAN_COUNT];  ///< 3个风扇的状态数组
+    FanState states[FAN_MAX_COUNT];  ///< 风扇状态数组（仅前 count 项有效）
+    uint8_t count;                   ///< 实际风扇数量
 } MultiFanState;
 
 // ============================================================================
@@ -106,6 +140,9 @@ typedef struct {
 // 系统常量定义
 // ============================================================================
 
+// 以下阈值、有效范围、上报间隔与预热时间均为编译期默认值，
+// 运行时可通过 MQTT 配置文档覆盖（见 runtime_config）
+
 // 预热和稳定时间常量
 #define PREHEATING_TIME_SEC     60      ///< CO2 传感器预热时间（秒）
 #define STABILIZING_TIME_SEC    240     ///< CO2 传感器稳定时间（秒）
@@ -132,6 +169,8 @@ typedef struct {
 // 网络和缓存常量
 #define WEATHER_CACHE_VALID_SEC 1800    ///< 天气数据缓存有效期（秒，30分钟）
 #define MQTT_PUBLISH_INTERVAL_SEC 30    ///< MQTT 状态上报间隔（秒）
+#define REMOTE_LEASE_DEFAULT_SEC  300   ///< 远程命令未携带 ttl 时的默认租约（秒）
+#define REMOTE_LEASE_MAX_SEC      3600  ///< 远程命令 ttl 上限（秒）
 #define WEATHER_FETCH_INTERVAL_SEC 600  ///< 天气数据获取间隔（秒，10分钟）
 
 // ============================================================================
@@ -152,6 +191,184 @@ typedef struct {
 #define VENTILATION_INDEX_HIGH  3.0f  ///< 高速风扇阈值
 #define VENTILATION_INDEX_LOW   1.0f  ///< 低速风扇阈值
 
+// ============================================================================
+// 预测式预通风常量（co2_predictor）
+// ============================================================================
+
+#define PREDICT_HISTORY_MIN      30      ///< 历史窗口长度（分钟，每分钟一个均值点）
+#define PREDICT_FIT_MIN          10      ///< 拟合使用的最近分钟数
+#define PREDICT_MIN_FIT_POINTS   5       ///< 拟合所需最少分钟点数
+#define PREDICT_HORIZON_MIN      15      ///< 预测时域（分钟）
+#define PREDICT_MARGIN_PPM       50.0f   ///< 预测峰值相对阈值的安全余量（ppm）
+#define PREDICT_MIN_HOLD_SEC     120     ///< 预测决策最短保持时间（秒，防止频繁启停）
+
+// 换气衰减率默认值（每分钟，dC/dt = G - k·(C - CO2_BASELINE)），运行中由 vent_ident 在线辨识
+#define PREDICT_DECAY_INFILTRATION  0.002f  ///< 无风扇时自然渗透衰减率
+#define PREDICT_DECAY_FAN_LOW       0.010f  ///< 单个风扇 LOW 档衰减率
+#define PREDICT_DECAY_FAN_HIGH      0.020f  ///< 单个风扇 HIGH 档衰减率
+#define PREDICT_GENERATION_DEFAULT  10.0f   ///< 有人时 CO2 产生率默认值（ppm/分钟）
+
+// 风扇运行成本（每风扇每分钟）
+#define PREDICT_COST_LOW         1.0f    ///< LOW 档成本
+#define PREDICT_COST_HIGH        2.5f    ///< HIGH 档成本
+
+// ============================================================================
+// 通风响应辨识常量（vent_ident）
+// ============================================================================
+
+#define IDENT_SETTLE_MIN          2       ///< 风扇组合变化后丢弃的过渡分钟数
+#define IDENT_MIN_SEGMENT_POINTS  6       ///< 片段拟合所需最少分钟点数
+#define IDENT_MAX_SEGMENT_MIN     30      ///< 片段最大长度（分钟，超过即拟合并开始新片段）
+#define IDENT_MIN_X_STD           10.0f   ///< 片段内 CO2 最小标准差（ppm，激励不足则不拟合）
+#define IDENT_MAX_DECAY           0.3f    ///< 衰减率合理上限（1/分钟）
+#define IDENT_MAX_DECAY_SE        0.01f   ///< 衰减率标准误上限（超过则拒绝本次估计）
+#define IDENT_LEARN_RATE          0.3f    ///< 参数平滑系数（累计片段足够后）
+#define IDENT_OCCUPIED_MIN_G      1.0f    ///< 判定有人的最小产生率（ppm/分钟）
+#define IDENT_SAVE_INTERVAL_MIN   60      ///< NVS 保存最小间隔（分钟，合并写入）
+#define IDENT_STEP_MIN            20      ///< 阶跃测试每步时长（分钟）
+#define IDENT_STEP_MIN_CO2        700.0f  ///< 启动阶跃测试所需最低 CO2（ppm）
+#define IDENT_MIN_SIGNAL_PPM      100.0f  ///< 测试中 CO2 距基准低于该值时信号不足，提前结束
+
+// ============================================================================
+// 作息学习常量（occupancy_habit）
+// ============================================================================
+
+#define HABIT_BINS               (7 * 24) ///< 一周按小时分桶
+#define HABIT_OBS_MAX            240      ///< 单桶观测分钟上限（约 4 周），达到后计数减半实现老化
+#define HABIT_MIN_OBS            120      ///< 单桶至少观测分钟数（约 2 周）才参与决策
+#define HABIT_OCCUPIED_G         2.0f     ///< 判定有人的 CO2 产生率（ppm/分钟）
+#define HABIT_OCCUPIED_PCT       60       ///< 有人概率 ≥ 该值视为通常有人（%）
+#define HABIT_VACANT_PCT         30       ///< 有人概率 < 该值视为通常无人（%）
+#define HABIT_LEAD_MIN           30       ///< 提前量（分钟）：到达前预通风、离开前提前停止
+#define HABIT_SAVE_INTERVAL_MIN  360      ///< NVS 保存最小间隔（分钟，合并写入）
+
+#define SNTP_SERVER              "ntp.aliyun.com"  ///< SNTP 时间服务器
+
+// ============================================================================
+// 风扇能耗与滤网寿命常量（fan_energy）
+// ============================================================================
+
+#define ENERGY_CURVE_POINTS       5        ///< 功率曲线点数（占空比 0 ~ 255 等分）
+#define ENERGY_DEFAULT_CURVE_MW   {0, 117, 239, 562, 1200}  ///< 默认功率曲线（mW，近似 P ∝ 转速³ + 电路底功耗）
+#define ENERGY_SAVE_INTERVAL_MIN  60       ///< NVS 保存最小间隔（分钟，合并写入）
+#define FILTER_LIFE_HOURS         2000     ///< 滤网寿命（满占空比等效运行小时）
+
+// ============================================================================
+// 遥测离线缓存常量（telemetry_buffer）
+// ============================================================================
+
+#define TELEMETRY_RAM_RECORDS       64     ///< RAM 环形缓冲条数（默认上报间隔下约 32 分钟）
+#define TELEMETRY_SPILL_BATCH       16     ///< RAM 满时一次移入 Flash 的条数（合并写入）
+#define TELEMETRY_BATCH_MAX         20     ///< 每条补传消息最多包含的样本数
+#define TELEMETRY_DRAIN_INTERVAL_MS 2000   ///< 补传消息最小间隔（毫秒）
+#define TELEMETRY_ACK_TIMEOUT_MS    10000  ///< 补传批次等待确认超时（毫秒，超时重发）
+#define TELEMETRY_OUTBOX_LIMIT      4096   ///< MQTT 发送队列积压超过该字节数时暂停补传
+#define TELEMETRY_ACK_SAVE_RECORDS  128    ///< Flash 补传进度每确认该条数保存一次到 NVS
+
+// ============================================================================
+// 批量状态上报常量（status_batch）
+// ============================================================================
+
+#define STATUS_BATCH_DECIMATION     0      ///< 默认抽取间隔（秒，0 = 关闭批量上报，1 = 保留全部 1 Hz 样本）
+#define STATUS_BATCH_MAX_SAMPLES    120    ///< 每条状态消息最多携带的样本数（超出时自动加大抽取间隔）
+
+// ============================================================================
+// 变化上报常量（report_policy，report_mode = on_change 时生效）
+// ============================================================================
+
+#define REPORT_HEARTBEAT_SEC        300    ///< 默认最长静默（秒），无变化时按此间隔补发
+#define REPORT_DEADBAND_CO2         25.0f  ///< 默认 CO2 死区（ppm，发布值）
+#define REPORT_DEADBAND_TEMP        0.2f   ///< 默认温度死区（℃）
+#define REPORT_DEADBAND_HUMI        2.0f   ///< 默认湿度死区（%）
+#define REPORT_MIN_GAP_SEC          5      ///< 死区触发的两次上报最小间隔（秒，风扇 / 模式变化不受限）
+#define REPORT_SMOOTH_SEC           30     ///< 死区比较用读数的平滑时间常数（秒，滤掉单点噪声）
+
+// ============================================================================
+// 连接监管常量（conn_supervisor）
+// ============================================================================
+
+#define CONN_LINK_BACKOFF_MIN_MS    1000    ///< WiFi 重连首次延迟（毫秒）
+#define CONN_LINK_BACKOFF_MAX_MS    30000   ///< WiFi 重连延迟上限（毫秒）
+#define CONN_BROKER_BACKOFF_MIN_MS  2000    ///< Broker 重连首次延迟（毫秒）
+#define CONN_BROKER_BACKOFF_MAX_MS  120000  ///< Broker 重连延迟上限（毫秒）
+#define CONN_LINK_UP_SPREAD_MS      1500    ///< 获得 IP 后连接 Broker 前的随机延迟上限（毫秒，错开整批设备）
+#define CONN_IP_TIMEOUT_MS          15000   ///< 关联后等待 DHCP 的超时（毫秒，超时断开重新关联）
+#define CONN_STABLE_SEC             60      ///< 连接保持该时长后才清零退避（秒，防止连上即断时按最短间隔重试）
+
+// ============================================================================
+// 功耗管理常量（power_manager）
+// ============================================================================
+
+#define POWER_CPU_MIN_MHZ           80      ///< 动态调频最低频率（MHz，不低于 80 使 APB 保持 80 MHz，UART 波特率与 LEDC PWM 不受影响）
+#define POWER_WIFI_LISTEN_INTERVAL  10      ///< Max modem sleep 时每隔多少个信标醒来接收（约 1 秒，下行命令最多延迟约 1 秒）
+#define MQTT_KEEPALIVE_MARGIN_SEC   10      ///< keepalive 取最长上报静默的 2 倍再加该余量（秒，正常上报时不发 PINGREQ）
+#define MQTT_KEEPALIVE_MIN_SEC      60      ///< keepalive 下限（秒）
+#define MQTT_KEEPALIVE_MAX_SEC      900     ///< keepalive 上限（秒，Broker 在 1.5 倍 keepalive 无报文后判定掉线）
+#define POWER_MEASURE_WINDOW_SEC    60      ///< 测量模式统计窗口（秒）
+
+// 电流估算系数（ESP32-S3 数据手册 Modem-sleep 典型值的约值，按 80 / 240 MHz；整机请用电流表校准）
+#define POWER_EST_IDLE_MIN_MA       22.0f   ///< 最低频率、CPU 空闲（mA）
+#define POWER_EST_ACTIVE_MIN_MA     28.0f   ///< 最低频率、CPU 运行（mA）
+#define POWER_EST_IDLE_MAX_MA       33.0f   ///< 最高频率、CPU 空闲（mA）
+#define POWER_EST_ACTIVE_MAX_MA     45.0f   ///< 最高频率、CPU 运行（mA）
+#define POWER_EST_RADIO_RX_MA       90.0f   ///< 射频接收（mA，叠加在 CPU 电流之上）
+#define POWER_EST_BEACON_WAKE_MS    4.0f    ///< Modem sleep 每次醒来接收信标的平均时长（毫秒）
+#define POWER_BEACON_INTERVAL_MS    102.4f  ///< 信标间隔（毫秒，AP 默认 100 TU）
+
+// ============================================================================
+// 运行诊断常量（diagnostics）
+// ============================================================================
+
+#define DIAG_SAMPLE_SEC             60      ///< 采样间隔（秒，即任务 CPU 占用的统计窗口）
+#define DIAG_PUBLISH_SEC            900     ///< 定时上报间隔（秒，新告警立即上报）
+#define DIAG_MAX_TASKS              32      ///< 最多统计的任务数（应用任务 + ESP-IDF 系统任务约 16 个）
+#define DIAG_TASK_NAME_LEN          16      ///< 任务名缓冲区长度（同 configMAX_TASK_NAME_LEN）
+#define DIAG_HEAP_LOW_BYTES         24576   ///< 堆空闲告警阈值（字节）
+#define DIAG_HEAP_LARGEST_MIN_BYTES 17408   ///< 最大连续块告警阈值（字节，TLS 重连需分配约 16 KB 接收缓冲区）
+#define DIAG_HEAP_HYST_BYTES        4096    ///< 堆告警解除回差（字节）
+#define DIAG_STACK_LOW_BYTES        512     ///< 任务栈剩余高水位告警阈值（字节）
+#define DIAG_TASK_CPU_HIGH_PCT      80.0f   ///< 任务 CPU 占用告警阈值（%，单核，空闲任务除外）
+
+// ============================================================================
+// 指标登记表常量（metrics）
+// ============================================================================
+
+#define METRICS_MAX                 24      ///< 最多登记的指标数（计数器组、直方图各算一项）
+#define METRICS_HIST_MAX_BOUNDS     8       ///< 直方图最多分桶上界数（另有一个超出上界的桶）
+
+// ============================================================================
+// 本地 HTTP 接口常量（local_http，CONFIG_LOCAL_HTTP）
+// ============================================================================
+
+#define LOCAL_HTTP_METRIC_PREFIX    "vent_" ///< 导出的 Prometheus 指标名前缀
+#define LOCAL_HTTP_CHUNK_SIZE       512     ///< /metrics 分块缓冲区（字节，单行不得超过）
+#define LOCAL_HTTP_BODY_MAX         256     ///< /command 请求体上限（字节）
+#define LOCAL_HTTP_MAX_SOCKETS      3       ///< 最多同时打开的连接数（超出时关闭最久未活动的）
+#define LOCAL_HTTP_RECV_RETRIES     3       ///< 接收请求体超时重试次数
+#define LOCAL_HTTP_AUTH_MAX_FAILS   5       ///< 同一客户端地址连续鉴权失败次数达到后锁定该地址
+#define LOCAL_HTTP_AUTH_LOCKOUT_SEC 30      ///< 鉴权锁定时间（秒，期间该地址的 /command 一律 429）
+#define LOCAL_HTTP_AUTH_CLIENTS     8       ///< 分别记录鉴权失败的客户端地址数（满时替换最久未失败的）
+
+// ============================================================================
+// 运行时配置常量（runtime_config）
+// ============================================================================
+
+#define RCFG_GRACE_MS            5000     ///< 两次配置切换最小间隔（毫秒，旧快照读者宽限期）
+#define RCFG_CO2_LIMIT           10000.0f ///< CO2 阈值与有效范围上限（ppm）
+#define RCFG_TEMP_LIMIT_MIN      -40.0f   ///< 温度有效范围下限（℃，SHT35 量程）
+#define RCFG_TEMP_LIMIT_MAX      125.0f   ///< 温度有效范围上限（℃，SHT35 量程）
+#define RCFG_PUBLISH_MIN_SEC     5        ///< 状态上报间隔下限（秒）
+#define RCFG_PUBLISH_MAX_SEC     3600     ///< 状态上报间隔上限（秒）
+#define RCFG_PREHEAT_MAX_SEC     600      ///< 预热时间上限（秒）
+#define RCFG_STABILIZE_MAX_SEC   1800     ///< 稳定时间上限（秒）
+#define RCFG_LEASE_MIN_SEC       10       ///< 默认租约下限（秒）
+#define RCFG_BATCH_MAX_SEC       60       ///< 批量上报抽取间隔上限（秒）
+#define RCFG_GROUP_MAX_LEN       15       ///< 设备分组名最大长度（字符限 A-Z a-z 0-9 _ -）
+#define RCFG_HEARTBEAT_MAX_SEC   3600     ///< 变化上报最长静默上限（秒，下限同 RCFG_PUBLISH_MIN_SEC）
+#define RCFG_DEADBAND_CO2_MAX    1000.0f  ///< CO2 死区上限（ppm）
+#define RCFG_DEADBAND_TEMP_MAX   10.0f    ///< 温度死区上限（℃）
+#define RCFG_DEADBAND_HUMI_MAX   20.0f    ///< 湿度死区上限（%）
+
 // 任务优先级定义
 #define TASK_PRIORITY_MAIN      4       ///< 主任务优先级（最高）
 #define TASK_PRIORITY_SENSOR    3       ///< 传感器任务优先级
@@ -173,11 +390,13 @@ typedef struct {
  */
 SemaphoreHandle_t get_i2c_mutex(void);
 
+#define TIME_VALID_EPOCH  1704067200  ///< 2024-01-01 00:00:00 UTC：系统时间不早于此视为已同步
+
 /**
- * @brief 判断当前是否为夜间模式
- * 夜间时间定义：22:00-8:00
- * @return true 夜间模式，false 白天模式
+ * @brief 判断系统时间是否已通过 SNTP 同步（不早于 TIME_VALID_EPOCH 视为有效）
+ * 只比较 time()，不做时区换算，可在每个决策周期调用
+ * @return true 时间有效
  */
-bool is_night_time(void);
+bool is_time_valid(void);
 
 #endif // MAIN_H
@@ -0,0 +1,395 @@
+/**
+ * @file cbor_lite.c
+ * @brief 精简 CBOR 编解码
+ *
+ * 只实现上报与命令解析用到的部分：整数、文本串、半 / 单精度浮点、简单值、
+ * 不定长 map / array 的写入，以及定长 / 不定长 map / array 的读取与跳过。
+ * 不支持字节串与标签（tag）的写入；读取时二者只能跳过，不定长文本串视为格式错误。
+ */
+
+#include "cbor_lite.h"
+#include <math.h>
+#include <string.h>
+
+// 主类型
+#define MT_UINT    0
+#define MT_NINT    1
+#define MT_BYTES   2
+#define MT_TEXT    3
+#define MT_ARRAY   4
+#define MT_MAP     5
+#define MT_TAG     6
+#define MT_SIMPLE  7
+
+#define AI_INDEFINITE  31
+#define CBOR_BREAK     0xFF
+#define CBOR_FALSE     0xF4
+#define CBOR_TRUE      0xF5
+#define CBOR_NULL      0xF6
+#define CBOR_FLOAT16   0xF9
+#define CBOR_FLOAT32   0xFA
+
+// ---------------------------------------------------------------------------
+// 写入
+// ---------------------------------------------------------------------------
+
+static void put_bytes(CborWriter *w, const void *data, size_t n) {
+    if (w->overflow) {
+        return;
+    }
+    if (w->len + n > w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+static void put_byte(CborWriter *w, uint8_t b) {
+    put_bytes(w, &b, 1);
+}
+
+/**
+ * @brief 写入头部：主类型 + 参数（按最短形式）
+ */
+static void put_head(CborWriter *w, uint8_t major, uint64_t arg) {
+    uint8_t head[9];
+    size_t n;
+    major <<= 5;
+    if (arg < 24) {
+        head[0] = major | (uint8_t)arg;
+        n = 1;
+    } else if (arg <= UINT8_MAX) {
+        head[0] = major | 24;
+        head[1] = (uint8_t)arg;
+        n = 2;
+    } else if (arg <= UINT16_MAX) {
+        head[0] = major | 25;
+        head[1] = (uint8_t)(arg >> 8);
+        head[2] = (uint8_t)arg;
+        n = 3;
+    } else if (arg <= UINT32_MAX) {
+        head[0] = major | 26;
+        for (int i = 0; i < 4; i++) {
+            head[1 + i] = (uint8_t)(arg >> (24 - 8 * i));
+        }
+        n = 5;
+    } else {
+        head[0] = major | 27;
+        for (int i = 0; i < 8; i++) {
+            head[1 + i] = (uint8_t)(arg >> (56 - 8 * i));
+        }
+        n = 9;
+    }
+    put_bytes(w, head, n);
+}
+
+static void put_text(CborWriter *w, const char *s) {
+    size_t n = strlen(s);
+    put_head(w, MT_TEXT, n);
+    put_bytes(w, s, n);
+}
+
+static void put_key(CborWriter *w, const char *key) {
+    if (key) {
+        put_text(w, key);
+    }
+}
+
+/**
+ * @brief 单精度转半精度，只处理可无损表示的规格化数与 0
+ * @return true 已写入 out
+ */
+static bool float_to_half(float f, uint16_t *out) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int exp = (int)((bits >> 23) & 0xFF) - 127;
+    uint32_t mant = bits & 0x7FFFFF;
+
+    if ((bits & 0x7FFFFFFF) == 0) {
+        *out = sign;
+        return true;
+    }
+    if (exp < -14 || exp > 15 || (mant & 0x1FFF) != 0) {
+        return false;
+    }
+    *out = sign | (uint16_t)((exp + 15) << 10) | (uint16_t)(mant >> 13);
+    return true;
+}
+
+void cbor_writer_init(CborWriter *w, uint8_t *buf, size_t size) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->depth = 0;
+    w->overflow = (buf == NULL || size == 0);
+}
+
+static void begin_container(CborWriter *w, const char *key, uint8_t major) {
+    put_key(w, key);
+    if (w->depth >= CBOR_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+    put_byte(w, (uint8_t)((major << 5) | AI_INDEFINITE));
+    w->depth++;
+}
+
+void cbor_writer_begin_map(CborWriter *w, const char *key) {
+    begin_container(w, key, MT_MAP);
+}
+
+void cbor_writer_begin_array(CborWriter *w, const char *key) {
+    begin_container(w, key, MT_ARRAY);
+}
+
+void cbor_writer_end(CborWriter *w) {
+    if (w->depth == 0) {
+        w->overflow = true;
+        return;
+    }
+    w->depth--;
+    put_byte(w, CBOR_BREAK);
+}
+
+void cbor_writer_add_text(CborWriter *w, const char *key, const char *value) {
+    put_key(w, key);
+    if (value) {
+        put_text(w, value);
+    } else {
+        put_byte(w, CBOR_NULL);
+    }
+}
+
+void cbor_writer_add_int(CborWriter *w, const char *key, int64_t value) {
+    put_key(w, key);
+    if (value >= 0) {
+        put_head(w, MT_UINT, (uint64_t)value);
+    } else {
+        put_head(w, MT_NINT, (uint64_t)(-1 - value));
+    }
+}
+
+void cbor_writer_add_null(CborWriter *w, const char *key) {
+    put_key(w, key);
+    put_byte(w, CBOR_NULL);
+}
+
+void cbor_writer_add_bool(CborWriter *w, const char *key, bool value) {
+    put_key(w, key);
+    put_byte(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_writer_add_fixed(CborWriter *w, const char *key, float value, int decimals) {
+    static const uint32_t scale_table[] = {1, 10, 100, 1000, 10000};
+    if (!isfinite(value)) {
+        cbor_writer_add_null(w, key);
+        return;
+    }
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 4) {
+        decimals = 4;
+    }
+
+    uint32_t scale = scale_table[decimals];
+    double scaled = round((double)value * scale);
+    if (fabs(scaled) < 9.0e18 && fmod(scaled, scale) == 0.0) {
+        cbor_writer_add_int(w, key, (int64_t)scaled / scale);
+        return;
+    }
+
+    float rounded = (float)(scaled / scale);
+    put_key(w, key);
+    uint16_t half;
+    if (float_to_half(rounded, &half)) {
+        uint8_t out[3] = {CBOR_FLOAT16, (uint8_t)(half >> 8), (uint8_t)half};
+        put_bytes(w, out, sizeof(out));
+        return;
+    }
+    uint32_t bits;
+    memcpy(&bits, &rounded, sizeof(bits));
+    uint8_t out[5] = {CBOR_FLOAT32, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16),
+                      (uint8_t)(bits >> 8), (uint8_t)bits};
+    put_bytes(w, out, sizeof(out));
+}
+
+int cbor_writer_finish(CborWriter *w) {
+    if (w->overflow || w->depth != 0) {
+        return -1;
+    }
+    return (int)w->len;
+}
+
+// ---------------------------------------------------------------------------
+// 读取
+// ---------------------------------------------------------------------------
+
+bool cbor_is_map_start(uint8_t first_byte) {
+    return (first_byte >> 5) == MT_MAP;
+}
+
+void cbor_reader_init(CborReader *r, const void *data, size_t len) {
+    r->p = (const uint8_t *)data;
+    r->end = r->p + len;
+    r->error = (data == NULL);
+}
+
+/**
+ * @brief 读取头部
+ * @param[out] indefinite 参数为不定长标记（31）
+ * @return true 成功
+ */
+static bool read_head(CborReader *r, int *major, uint64_t *arg, bool *indefinite) {
+    if (r->error || r->p >= r->end) {
+        r->error = true;
+        return false;
+    }
+    uint8_t ib = *r->p++;
+    *major = ib >> 5;
+    uint8_t ai = ib & 0x1F;
+    *indefinite = false;
+
+    if (ai < 24) {
+        *arg = ai;
+        return true;
+    }
+    if (ai == AI_INDEFINITE) {
+        *indefinite = true;
+        *arg = 0;
+        return true;
+    }
+    if (ai > 27) {
+        r->error = true;
+        return false;
+    }
+    size_t n = (size_t)1 << (ai - 24);  // 1 / 2 / 4 / 8 字节
+    if ((size_t)(r->end - r->p) < n) {
+        r->error = true;
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v = (v << 8) | *r->p++;
+    }
+    *arg = v;
+    return true;
+}
+
+bool cbor_reader_enter_map(CborReader *r, int32_t *count) {
+    int major;
+    uint64_t arg;
+    bool indefinite;
+    if (!read_head(r, &major, &arg, &indefinite) || major != MT_MAP || arg > INT32_MAX) {
+        r->error = true;
+        return false;
+    }
+    *count = indefinite ? -1 : (int32_t)arg;
+    return true;
+}
+
+bool cbor_reader_at_break(CborReader *r) {
+    if (!r->error && r->p < r->end && *r->p == CBOR_BREAK) {
+        r->p++;
+        return true;
+    }
+    return false;
+}
+
+int cbor_reader_peek_type(const CborReader *r) {
+    if (r->error || r->p >= r->end) {
+        return -1;
+    }
+    return *r->p >> 5;
+}
+
+bool cbor_reader_get_text(CborReader *r, const char **text, size_t *len) {
+    int major;
+    uint64_t arg;
+    bool indefinite;
+    if (!read_head(r, &major, &arg, &indefinite) || major != MT_TEXT || indefinite ||
+        arg > (uint64_t)(r->end - r->p)) {
+        r->error = true;
+        return false;
+    }
+    *text = (const char *)r->p;
+    *len = (size_t)arg;
+    r->p += arg;
+    return true;
+}
+
+bool cbor_reader_get_int(CborReader *r, int64_t *value) {
+    int major;
+    uint64_t arg;
+    bool indefinite;
+    if (!read_head(r, &major, &arg, &indefinite) || indefinite ||
+        (major != MT_UINT && major != MT_NINT) || arg > INT64_MAX) {
+        r->error = true;
+        return false;
+    }
+    *value = (major == MT_UINT) ? (int64_t)arg : -1 - (int64_t)arg;
+    return true;
+}
+
+static bool skip_item(CborReader *r, int depth) {
+    int major;
+    uint64_t arg;
+    bool indefinite;
+    if (depth > CBOR_MAX_DEPTH || !read_head(r, &major, &arg, &indefinite)) {
+        r->error = true;
+        return false;
+    }
+
+    switch (major) {
+        case MT_UINT:
+        case MT_NINT:
+            if (indefinite) {
+                r->error = true;
+                return false;
+            }
+            return true;
+        case MT_BYTES:
+        case MT_TEXT:
+            if (indefinite || arg > (uint64_t)(r->end - r->p)) {
+                r->error = true;
+                return false;
+            }
+            r->p += arg;
+            return true;
+        case MT_ARRAY:
+        case MT_MAP: {
+            uint64_t items = (major == MT_MAP) ? arg * 2 : arg;
+            if (indefinite) {
+                while (!cbor_reader_at_break(r)) {
+                    if (!skip_item(r, depth + 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            for (uint64_t i = 0; i < items; i++) {
+                if (!skip_item(r, depth + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case MT_TAG:
+            if (indefinite) {
+                r->error = true;
+                return false;
+            }
+            return skip_item(r, depth + 1);
+        default:  // MT_SIMPLE：简单值与浮点，参数已随头部读完
+            if (indefinite) {
+                r->error = true;  // 不在容器中的 break
+                return false;
+            }
+            return true;
+    }
+}
+
+bool cbor_reader_skip(CborReader *r) {
+    return skip_item(r, 0);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file cbor_lite.h
+ * @brief 精简 CBOR 编解码接口定义（RFC 8949）- 写入 / 读取调用方缓冲区，不分配堆内存
+ *
+ * 写入器接口与 json_writer 一一对应：对象写为不定长 map（0xBF ... 0xFF），
+ * 数组写为不定长 array（0x9F ... 0xFF），无需预先知道成员数量即可流式输出。
+ * 读取器只支持命令解析所需的子集：map / array、整数、定长文本串、简单值。
+ */
+
+#ifndef CBOR_LITE_H
+#define CBOR_LITE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CBOR_MAX_DEPTH  8     ///< 最大嵌套层数（写入与跳过）
+
+/**
+ * @brief 写入器状态（放在调用方栈上）
+ */
+typedef struct {
+    uint8_t *buf;         ///< 输出缓冲区
+    size_t size;          ///< 缓冲区大小
+    size_t len;           ///< 已写入长度
+    uint8_t depth;        ///< 当前嵌套层数
+    bool overflow;        ///< 缓冲区不足或嵌套错误
+} CborWriter;
+
+/**
+ * @brief 读取器状态（游标，直接引用输入数据）
+ */
+typedef struct {
+    const uint8_t *p;     ///< 当前位置
+    const uint8_t *end;   ///< 数据结尾
+    bool error;           ///< 数据格式错误或越界
+} CborReader;
+
+/**
+ * @brief 初始化写入器
+ */
+void cbor_writer_init(CborWriter *w, uint8_t *buf, size_t size);
+
+/**
+ * @brief 开始 map / array（不定长）
+ * @param key 成员名（map 内必须给出，数组元素或顶层传 NULL）
+ */
+void cbor_writer_begin_map(CborWriter *w, const char *key);
+void cbor_writer_begin_array(CborWriter *w, const char *key);
+
+/**
+ * @brief 结束 map / array（写入 break 0xFF）
+ */
+void cbor_writer_end(CborWriter *w);
+
+/**
+ * @brief 写入文本串 / 整数 / null / 布尔值
+ */
+void cbor_writer_add_text(CborWriter *w, const char *key, const char *value);
+void cbor_writer_add_int(CborWriter *w, const char *key, int64_t value);
+void cbor_writer_add_null(CborWriter *w, const char *key);
+void cbor_writer_add_bool(CborWriter *w, const char *key, bool value);
+
+/**
+ * @brief 写入定点小数：四舍五入到 decimals 位（0 ~ 4）
+ * 整数值写为整数；能无损表示时写为半精度浮点（3 字节），否则写为单精度（5 字节）。
+ * NaN / Inf 写为 null。
+ */
+void cbor_writer_add_fixed(CborWriter *w, const char *key, float value, int decimals);
+
+/**
+ * @brief 结束写入
+ * @return 输出长度，缓冲区不足或 map / array 未闭合时返回 -1
+ */
+int cbor_writer_finish(CborWriter *w);
+
+/**
+ * @brief 判断消息首字节是否为 CBOR map（JSON 以 '{' 开头，不会落在该范围）
+ */
+bool cbor_is_map_start(uint8_t first_byte);
+
+/**
+ * @brief 初始化读取器
+ */
+void cbor_reader_init(CborReader *r, const void *data, size_t len);
+
+/**
+ * @brief 读取 map 开头
+ * @param[out] count 成员数量，不定长 map 为 -1（以 cbor_reader_at_break() 判断结束）
+ * @return true 成功
+ */
+bool cbor_reader_enter_map(CborReader *r, int32_t *count);
+
+/**
+ * @brief 下一项是否为 break（0xFF）；是则消耗掉
+ */
+bool cbor_reader_at_break(CborReader *r);
+
+/**
+ * @brief 读取定长文本串（返回指向输入数据的指针，不以 '\0' 结尾）
+ * @return true 成功
+ */
+bool cbor_reader_get_text(CborReader *r, const char **text, size_t *len);
+
+/**
+ * @brief 读取整数（无符号或负整数）
+ * @return true 成功
+ */
+bool cbor_reader_get_int(CborReader *r, int64_t *value);
+
+/**
+ * @brief 下一项的主类型（0 ~ 7），数据结束或出错时返回 -1
+ */
+int cbor_reader_peek_type(const CborReader *r);
+
+/**
+ * @brief 跳过一项（含嵌套内容，最多 CBOR_MAX_DEPTH 层）
+ * @return true 成功
+ */
+bool cbor_reader_skip(CborReader *r);
+
+#endif // CBOR_LITE_H
@@ -0,0 +1,351 @@
+/**
+ * @file conn_supervisor.c
+ * @brief 连接监管
+ *
+ * 事件来自 WiFi 事件循环、MQTT 任务与定时器任务，状态在 s_lock 下更新；
+ * 定时器操作与重连动作在锁外执行（临界区内不能调用可能阻塞的接口）。
+ */
+
+#include "conn_supervisor.h"
+#include "mqtt_wrapper.h"
+#include "main.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include <string.h>
+
+static const char *TAG = "CONN_SUP";
+
+/**
+ * @brief 定时器到期时执行的动作
+ */
+typedef enum {
+    RETRY_NONE = 0,
+    RETRY_LINK,         ///< 重新关联 WiFi
+    RETRY_IP_TIMEOUT,   ///< DHCP 超时，断开后重新关联
+    RETRY_BROKER,       ///< 重连 Broker
+} RetryAction;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TimerHandle_t s_retry_timer = NULL;
+static RetryAction s_action = RETRY_NONE;
+
+static ConnPhase s_phase = CONN_PHASE_LINK;
+static int64_t s_phase_start_ms = 0;        ///< 当前阶段开始时刻
+static int64_t s_outage_start_ms = 0;       ///< 本次恢复开始时刻（断线或启动）
+static uint32_t s_outage_ms[CONN_PHASE_COUNT];  ///< 本次恢复中各阶段已用时间
+static int64_t s_up_since_ms = 0;           ///< MQTT 连接建立时刻
+static bool s_link_up = false;              ///< 已获得 IP
+static bool s_broker_up = false;            ///< MQTT 已连接
+static bool s_link_held = false;            ///< 配网期间暂停 WiFi 重连
+static bool s_broker_tls = false;           ///< Broker 使用 TLS（mqtts://）
+static uint32_t s_link_failures = 0;        ///< WiFi 连续失败次数
+static uint32_t s_broker_failures = 0;      ///< Broker 连续失败次数
+static ConnStats s_stats;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * @brief 退避延迟：上限从 min_ms 起每次失败翻倍直到 max_ms，在 [上限/2, 上限) 内随机取值
+ * @param failures 连续失败次数（≥ 1）
+ */
+static uint32_t backoff_ms(uint32_t min_ms, uint32_t max_ms, uint32_t failures)
+{
+    uint32_t ceiling = min_ms;
+    for (uint32_t i = 1; i < failures && ceiling < max_ms; i++) {
+        ceiling *= 2;
+    }
+    if (ceiling > max_ms) {
+        ceiling = max_ms;
+    }
+    uint32_t half = ceiling / 2;
+    return half + esp_random() % (ceiling - half);
+}
+
+/**
+ * @brief 切换阶段并累计上一阶段耗时（调用方持锁）
+ */
+static void set_phase_locked(ConnPhase phase)
+{
+    int64_t now = now_ms();
+    uint32_t spent = (uint32_t)(now - s_phase_start_ms);
+    s_stats.total_ms[s_phase] += spent;
+    if (s_phase != CONN_PHASE_UP) {
+        s_outage_ms[s_phase] += spent;
+    }
+    if (s_phase == CONN_PHASE_UP && phase != CONN_PHASE_UP) {
+        // 离开已连接状态，开始新一次恢复
+        s_outage_start_ms = now;
+        memset(s_outage_ms, 0, sizeof(s_outage_ms));
+    }
+    s_phase = phase;
+    s_phase_start_ms = now;
+    s_stats.phase = phase;
+}
+
+/**
+ * @brief Broker 连接阶段的起点（TLS 握手或直接 MQTT）
+ */
+static ConnPhase broker_phase(void)
+{
+    return s_broker_tls ? CONN_PHASE_TLS : CONN_PHASE_MQTT;
+}
+
+/**
+ * @brief 安排定时器动作（锁外调用；RETRY_NONE 取消已安排的动作）
+ */
+static void schedule(RetryAction action, uint32_t delay_ms)
+{
+    if (s_retry_timer == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_action = action;
+    if (action != RETRY_IP_TIMEOUT && action != RETRY_NONE) {
+        s_stats.next_delay_ms = delay_ms;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (action == RETRY_NONE) {
+        xTimerStop(s_retry_timer, 0);
+        return;
+    }
+    TickType_t ticks = pdMS_TO_TICKS(delay_ms);
+    xTimerChangePeriod(s_retry_timer, ticks > 0 ? ticks : 1, 0);  // 同时启动定时器
+}
+
+/**
+ * @brief 重试定时器回调（在定时器任务上下文中执行）
+ */
+static void retry_timer_callback(TimerHandle_t xTimer)
+{
+    portENTER_CRITICAL(&s_lock);
+    RetryAction action = s_action;
+    s_action = RETRY_NONE;
+    bool held = s_link_held;
+    if (action == RETRY_LINK && !held) {
+        s_stats.link_retries++;
+    } else if (action == RETRY_BROKER) {
+        s_stats.broker_retries++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    switch (action) {
+        case RETRY_LINK:
+            if (!held) {
+                ESP_LOGI(TAG, "重新关联 WiFi...");
+                esp_wifi_connect();
+            }
+            break;
+
+        case RETRY_IP_TIMEOUT:
+            // 断开后由 WIFI_EVENT_STA_DISCONNECTED 进入 WiFi 退避
+            ESP_LOGW(TAG, "%d 秒内未获得 IP，断开重新关联", CONN_IP_TIMEOUT_MS / 1000);
+            esp_wifi_disconnect();
+            break;
+
+        case RETRY_BROKER:
+            ESP_LOGI(TAG, "重连 MQTT Broker...");
+            mqtt_client_reconnect();
+            break;
+
+        default:
+            break;
+    }
+}
+
+esp_err_t conn_supervisor_init(void)
+{
+    if (s_retry_timer != NULL) {
+        return ESP_OK;
+    }
+    s_broker_tls = (strncmp(CONFIG_MQTT_BROKER_URL, "mqtts://", 8) == 0);
+    s_phase_start_ms = now_ms();
+    s_outage_start_ms = s_phase_start_ms;
+
+    s_retry_timer = xTimerCreate("conn_retry", pdMS_TO_TICKS(CONN_LINK_BACKOFF_MIN_MS),
+                                 pdFALSE,  // 单次触发
+                                 NULL, retry_timer_callback);
+    if (s_retry_timer == NULL) {
+        ESP_LOGE(TAG, "创建重试定时器失败");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void conn_supervisor_on_link_up(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    set_phase_locked(CONN_PHASE_IP);
+    portEXIT_CRITICAL(&s_lock);
+
+    schedule(RETRY_IP_TIMEOUT, CONN_IP_TIMEOUT_MS);
+}
+
+void conn_supervisor_on_link_down(uint8_t reason)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_link_up = false;
+    s_link_failures++;
+    s_stats.last_reason = reason;
+    if (s_phase != CONN_PHASE_LINK) {
+        set_phase_locked(CONN_PHASE_LINK);
+    }
+    uint32_t failures = s_link_failures;
+    bool held = s_link_held;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (held) {
+        schedule(RETRY_NONE, 0);
+        return;
+    }
+    uint32_t delay = backoff_ms(CONN_LINK_BACKOFF_MIN_MS, CONN_LINK_BACKOFF_MAX_MS, failures);
+    ESP_LOGI(TAG, "WiFi 未连接（原因 %u，连续 %lu 次），%lu ms 后重连", reason,
+             (unsigned long)failures, (unsigned long)delay);
+    schedule(RETRY_LINK, delay);
+}
+
+void conn_supervisor_on_ip_up(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_link_up = true;
+    s_link_failures = 0;
+    s_broker_failures = 0;  // 链路刚恢复，Broker 不可达多半是链路原因，不沿用之前的退避
+    if (s_stats.boot_ip_ms == 0) {
+        s_stats.boot_ip_ms = (uint32_t)now_ms();
+    }
+    bool broker_up = s_broker_up;
+    set_phase_locked(broker_up ? CONN_PHASE_UP : CONN_PHASE_MQTT);
+    portEXIT_CRITICAL(&s_lock);
+
+    if (broker_up) {
+        // 短暂断链，MQTT 连接仍在
+        schedule(RETRY_NONE, 0);
+        return;
+    }
+    schedule(RETRY_BROKER, esp_random() % CONN_LINK_UP_SPREAD_MS);
+}
+
+void conn_supervisor_on_broker_attempt(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    // 启动时 WiFi 尚未就绪的首次尝试不改变阶段
+    if (s_link_up && !s_broker_up) {
+        set_phase_locked(broker_phase());
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void conn_supervisor_on_tls_up(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (s_phase == CONN_PHASE_TLS) {
+        set_phase_locked(CONN_PHASE_MQTT);
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void conn_supervisor_on_broker_up(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_broker_up = true;
+    set_phase_locked(CONN_PHASE_UP);
+    s_up_since_ms = s_phase_start_ms;
+    memcpy(s_stats.last_ms, s_outage_ms, sizeof(s_stats.last_ms));
+    s_stats.last_ms[CONN_PHASE_UP] = (uint32_t)(s_up_since_ms - s_outage_start_ms);
+    bool first = (s_stats.boot_mqtt_ms == 0);
+    if (first) {
+        s_stats.boot_mqtt_ms = (uint32_t)s_up_since_ms;
+    }
+    ConnStats stats = s_stats;
+    bool cancel = (s_action == RETRY_BROKER);
+    portEXIT_CRITICAL(&s_lock);
+
+    if (cancel) {
+        schedule(RETRY_NONE, 0);
+    }
+    ESP_LOGI(TAG, "连接建立: 共 %lu ms（WiFi %lu，IP %lu，TLS %lu，MQTT %lu）",
+             (unsigned long)stats.last_ms[CONN_PHASE_UP],
+             (unsigned long)stats.last_ms[CONN_PHASE_LINK],
+             (unsigned long)stats.last_ms[CONN_PHASE_IP],
+             (unsigned long)stats.last_ms[CONN_PHASE_TLS],
+             (unsigned long)stats.last_ms[CONN_PHASE_MQTT]);
+    if (first) {
+        ESP_LOGI(TAG, "开机到获得 IP %lu ms，到 MQTT 连接 %lu ms",
+                 (unsigned long)stats.boot_ip_ms, (unsigned long)stats.boot_mqtt_ms);
+    }
+}
+
+void conn_supervisor_on_broker_down(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (s_broker_up) {
+        s_stats.outages++;
+        if (now_ms() - s_up_since_ms >= CONN_STABLE_SEC * 1000LL) {
+            s_broker_failures = 0;
+        }
+    }
+    s_broker_up = false;
+    bool link_up = s_link_up;
+    uint32_t failures = 0;
+    if (link_up) {
+        s_broker_failures++;
+        failures = s_broker_failures;
+        set_phase_locked(CONN_PHASE_MQTT);
+    } else if (s_phase == CONN_PHASE_UP) {
+        set_phase_locked(CONN_PHASE_LINK);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!link_up) {
+        return;  // 链路恢复（获得 IP）后再连接 Broker
+    }
+    uint32_t delay = backoff_ms(CONN_BROKER_BACKOFF_MIN_MS, CONN_BROKER_BACKOFF_MAX_MS, failures);
+    ESP_LOGI(TAG, "MQTT 未连接（连续 %lu 次），%lu ms 后重连", (unsigned long)failures,
+             (unsigned long)delay);
+    schedule(RETRY_BROKER, delay);
+}
+
+void conn_supervisor_hold_link(bool hold)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_link_held = hold;
+    bool cancel = hold && s_action == RETRY_LINK;
+    bool retry = !hold && s_phase == CONN_PHASE_LINK;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (cancel) {
+        schedule(RETRY_NONE, 0);
+    } else if (retry) {
+        schedule(RETRY_LINK, 0);
+    }
+}
+
+void conn_supervisor_get_stats(ConnStats *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    out->total_ms[s_phase] += (uint32_t)(now_ms() - s_phase_start_ms);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const char *conn_phase_to_string(ConnPhase phase)
+{
+    switch (phase) {
+        case CONN_PHASE_LINK: return "LINK";
+        case CONN_PHASE_IP:   return "IP";
+        case CONN_PHASE_TLS:  return "TLS";
+        case CONN_PHASE_MQTT: return "MQTT";
+        case CONN_PHASE_UP:   return "UP";
+        default:              return "UNKNOWN";
+    }
+}
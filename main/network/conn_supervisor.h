@@ -0,0 +1,112 @@
+/**
+ * @file conn_supervisor.h
+ * @brief 连接监管接口定义 - 按 WiFi → IP → TLS → MQTT 分层恢复连接，带上限的指数退避与随机抖动
+ *
+ * 所有重连都由本模块的一个单次定时器调度，WiFi 管理器与 MQTT 客户端不再各自定时重试
+ * （esp-mqtt 的内置自动重连已关闭）。同一时刻只有最下层未就绪的一层在重试：
+ * - WiFi 断开：按 CONN_LINK_BACKOFF_MIN_MS 起翻倍（上限 CONN_LINK_BACKOFF_MAX_MS）重新关联
+ * - 关联后 CONN_IP_TIMEOUT_MS 内未获得 IP：断开重新关联
+ * - 获得 IP：Broker 退避清零，在 CONN_LINK_UP_SPREAD_MS 内随机延迟后立即连接 Broker
+ * - Broker 断开或连接失败：按 CONN_BROKER_BACKOFF_MIN_MS 起翻倍（上限 CONN_BROKER_BACKOFF_MAX_MS）重连
+ * 每次延迟在 [上限/2, 上限) 内随机取值（esp_random），AP 重启后整批设备不会同时重连。
+ * 连接保持 CONN_STABLE_SEC 秒以上才清零退避。
+ *
+ * 同时统计各阶段（含退避等待）累计耗时与最近一次恢复中各阶段耗时。
+ * 事件接口可在任意任务中调用（内部加锁），不可在中断中调用。
+ */
+
+#ifndef CONN_SUPERVISOR_H
+#define CONN_SUPERVISOR_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 连接阶段（正在建立的最下层，UP 表示 MQTT 已连接）
+ */
+typedef enum {
+    CONN_PHASE_LINK = 0,    ///< WiFi 关联（含退避等待）
+    CONN_PHASE_IP,          ///< 等待 DHCP
+    CONN_PHASE_TLS,         ///< DNS、TCP 与 TLS 握手（mqtt:// 无此阶段）
+    CONN_PHASE_MQTT,        ///< MQTT CONNECT / CONNACK（含 Broker 退避等待）
+    CONN_PHASE_UP,          ///< 已连接
+    CONN_PHASE_COUNT,
+} ConnPhase;
+
+/**
+ * @brief 连接统计（启动以来）
+ */
+typedef struct {
+    ConnPhase phase;                        ///< 当前阶段
+    uint32_t total_ms[CONN_PHASE_COUNT];    ///< 各阶段累计耗时（毫秒，含当前阶段已进行的时间）
+    uint32_t last_ms[CONN_PHASE_COUNT];     ///< 最近一次恢复中各阶段耗时（毫秒，UP 项为恢复总耗时）
+    uint32_t outages;                       ///< 断线次数（MQTT 从已连接变为未连接）
+    uint32_t link_retries;                  ///< WiFi 重连次数
+    uint32_t broker_retries;                ///< Broker 重连次数
+    uint32_t next_delay_ms;                 ///< 最近一次安排的重试延迟（毫秒）
+    uint8_t last_reason;                    ///< 最近一次 WiFi 断开原因（wifi_err_reason_t）
+    uint32_t boot_ip_ms;                    ///< 开机到首次获得 IP（毫秒，esp_timer 计时，0 = 尚未获得）
+    uint32_t boot_mqtt_ms;                  ///< 开机到首次 MQTT 连接成功（毫秒，0 = 尚未连接）
+} ConnStats;
+
+/**
+ * @brief 初始化连接监管（须在 wifi_manager_init() 之前调用）
+ * @return ESP_OK 成功，ESP_FAIL 创建定时器失败
+ */
+esp_err_t conn_supervisor_init(void);
+
+/**
+ * @brief WiFi 关联成功（WIFI_EVENT_STA_CONNECTED）
+ */
+void conn_supervisor_on_link_up(void);
+
+/**
+ * @brief WiFi 断开或关联失败（WIFI_EVENT_STA_DISCONNECTED）
+ * @param reason 断开原因
+ */
+void conn_supervisor_on_link_down(uint8_t reason);
+
+/**
+ * @brief 获得 IP（IP_EVENT_STA_GOT_IP）
+ */
+void conn_supervisor_on_ip_up(void);
+
+/**
+ * @brief 开始连接 Broker（MQTT_EVENT_BEFORE_CONNECT）
+ */
+void conn_supervisor_on_broker_attempt(void);
+
+/**
+ * @brief TLS 握手完成（mqtt_tls 传输调用）
+ */
+void conn_supervisor_on_tls_up(void);
+
+/**
+ * @brief MQTT 已连接（MQTT_EVENT_CONNECTED）
+ */
+void conn_supervisor_on_broker_up(void);
+
+/**
+ * @brief MQTT 断开或连接失败（MQTT_EVENT_DISCONNECTED）
+ */
+void conn_supervisor_on_broker_down(void);
+
+/**
+ * @brief 暂停 / 恢复 WiFi 重连（SmartConfig 配网期间由配网流程自行连接）
+ * @param hold true 暂停，false 恢复（WiFi 未连接时立即重连）
+ */
+void conn_supervisor_hold_link(bool hold);
+
+/**
+ * @brief 获取连接统计
+ * @param[out] out 统计
+ */
+void conn_supervisor_get_stats(ConnStats *out);
+
+/**
+ * @brief ConnPhase 转字符串（用于日志与 MQTT 上报）
+ */
+const char *conn_phase_to_string(ConnPhase phase);
+
+#endif // CONN_SUPERVISOR_H
@@ -0,0 +1,108 @@
+/**
+ * @file device_shadow.c
+ * @brief 设备影子：desired 版本登记与 reported 变化检测
+ *
+ * desired 版本只保存在 RAM：断线重连期间版本号保留，Broker 重发的保留消息
+ * 被识别为重复；重启后版本归零，保留的 desired 会重新评估一次，由文档中的
+ * "expires" 判断是否已过期（见 mqtt_wrapper.c）。
+ *
+ * device_shadow_accept_desired() 在 MQTT 任务中调用，版本号加锁访问；
+ * reported 基准只在网络任务中读写，无需加锁。
+ */
+
+#include "device_shadow.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static uint32_t s_desired_version = 0;
+static portMUX_TYPE s_desired_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool s_full_pending = false;
+
+static ShadowState s_reported;              ///< 上次成功上报的状态
+static bool s_have_reported = false;
+
+ShadowDesiredResult device_shadow_accept_desired(uint32_t version)
+{
+    ShadowDesiredResult result;
+    portENTER_CRITICAL(&s_desired_lock);
+    if (version > s_desired_version) {
+        s_desired_version = version;
+        result = SHADOW_DESIRED_APPLY;
+    } else if (version == s_desired_version) {
+        result = SHADOW_DESIRED_DUPLICATE;
+    } else {
+        result = SHADOW_DESIRED_STALE;
+    }
+    portEXIT_CRITICAL(&s_desired_lock);
+    return result;
+}
+
+uint32_t device_shadow_get_desired_version(void)
+{
+    portENTER_CRITICAL(&s_desired_lock);
+    uint32_t version = s_desired_version;
+    portEXIT_CRITICAL(&s_desired_lock);
+    return version;
+}
+
+void device_shadow_request_full(void)
+{
+    s_full_pending = true;
+}
+
+bool device_shadow_take_full(void)
+{
+    bool pending = s_full_pending;
+    s_full_pending = false;
+    return pending;
+}
+
+uint32_t device_shadow_diff(const ShadowState *state)
+{
+    if (!s_have_reported || state->fan_count != s_reported.fan_count) {
+        return SHADOW_FIELD_ALL;
+    }
+
+    uint32_t fields = 0;
+    for (int i = 0; i < state->fan_count; i++) {
+        if (state->fans[i] != s_reported.fans[i]) {
+            fields |= SHADOW_FIELD_FAN(i);
+        }
+    }
+    if (state->mode != s_reported.mode) {
+        fields |= SHADOW_FIELD_MODE;
+    }
+    if (state->mode_reason != s_reported.mode_reason) {
+        fields |= SHADOW_FIELD_REASON;
+    }
+    if (state->lease != s_reported.lease) {
+        fields |= SHADOW_FIELD_LEASE;
+    }
+    if (state->desired_version != s_reported.desired_version) {
+        fields |= SHADOW_FIELD_DESIRED;
+    }
+    if (state->config_version != s_reported.config_version) {
+        fields |= SHADOW_FIELD_CONFIG;
+    }
+    return fields;
+}
+
+void device_shadow_mark_reported(const ShadowState *state)
+{
+    memcpy(&s_reported, state, sizeof(s_reported));
+    s_have_reported = true;
+}
+
+const char *device_shadow_desired_result_to_string(ShadowDesiredResult result)
+{
+    switch (result) {
+        case SHADOW_DESIRED_APPLY:
+            return "APPLY";
+        case SHADOW_DESIRED_DUPLICATE:
+            return "DUPLICATE";
+        case SHADOW_DESIRED_STALE:
+            return "STALE";
+        default:
+            return "UNKNOWN";
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file device_shadow.h
+ * @brief 设备影子接口定义 - desired（后端期望状态，带版本号）与 reported（设备实际状态，只报变化字段）
+ *
+ * desired 由后端以保留消息发布，版本号单调递增；设备只执行比已执行版本更新的文档，
+ * 重复投递（重连后 Broker 重发保留消息）不会再次续租。
+ * reported 由网络任务每周期比较一次，只发布与上次成功上报不同的字段；
+ * 重连或后端请求时发布一次完整状态，后端据此与 desired 对账。
+ */
+
+#ifndef DEVICE_SHADOW_H
+#define DEVICE_SHADOW_H
+
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// reported 字段位（device_shadow_diff() 返回值）
+#define SHADOW_FIELD_FAN(i)      (1u << (i))                     ///< fan_i（i < FAN_MAX_COUNT）
+#define SHADOW_FIELD_FANS        ((1u << FAN_MAX_COUNT) - 1)
+#define SHADOW_FIELD_MODE        (1u << FAN_MAX_COUNT)
+#define SHADOW_FIELD_REASON      (1u << (FAN_MAX_COUNT + 1))
+#define SHADOW_FIELD_LEASE       (1u << (FAN_MAX_COUNT + 2))
+#define SHADOW_FIELD_DESIRED     (1u << (FAN_MAX_COUNT + 3))     ///< 已执行的 desired 版本
+#define SHADOW_FIELD_CONFIG      (1u << (FAN_MAX_COUNT + 4))     ///< 当前配置版本
+#define SHADOW_FIELD_ALL         ((1u << (FAN_MAX_COUNT + 5)) - 1)
+
+/**
+ * @brief reported 状态（只含变化缓慢的字段，传感器读数仍走 status 主题）
+ */
+typedef struct {
+    FanState fans[FAN_MAX_COUNT];  ///< 风扇状态（仅前 fan_count 项有效）
+    uint8_t fan_count;             ///< 风扇数量
+    SystemMode mode;               ///< 系统运行模式
+    ModeReason mode_reason;        ///< 模式判定原因
+    RemoteLease lease;             ///< 远程租约状态
+    uint32_t desired_version;      ///< 已执行的 desired 版本（0 = 未收到）
+    uint32_t config_version;       ///< 当前配置版本
+} ShadowState;
+
+/**
+ * @brief desired 文档处理结果
+ */
+typedef enum {
+    SHADOW_DESIRED_APPLY = 0,      ///< 新版本，执行
+    SHADOW_DESIRED_DUPLICATE,      ///< 与已执行版本相同（重复投递），忽略
+    SHADOW_DESIRED_STALE,          ///< 比已执行版本旧，忽略
+} ShadowDesiredResult;
+
+/**
+ * @brief 登记收到的 desired 版本（MQTT 任务调用）
+ * 版本比已执行版本新时记为已执行并返回 SHADOW_DESIRED_APPLY；已过期的文档同样登记，
+ * 调用方不执行即可，避免之后再被重放
+ * @param version 文档版本（> 0）
+ * @return 处理结果
+ */
+ShadowDesiredResult device_shadow_accept_desired(uint32_t version);
+
+/**
+ * @brief 获取已执行的 desired 版本（重启后为 0）
+ */
+uint32_t device_shadow_get_desired_version(void);
+
+/**
+ * @brief 请求下一次上报完整 reported 状态（连接建立或收到后端请求时调用，可在 MQTT 任务中调用）
+ */
+void device_shadow_request_full(void);
+
+/**
+ * @brief 查询并清除"完整上报"请求
+ * @return true 需要完整上报（发布失败时调用方应再次 device_shadow_request_full()）
+ */
+bool device_shadow_take_full(void);
+
+/**
+ * @brief 比较当前状态与上次成功上报的状态（网络任务调用）
+ * @param state 当前状态
+ * @return 变化字段位（SHADOW_FIELD_*），从未上报过时为 SHADOW_FIELD_ALL
+ */
+uint32_t device_shadow_diff(const ShadowState *state);
+
+/**
+ * @brief 记录已成功上报的状态（发布成功后调用，之后的 diff 以此为基准）
+ * @param state 已上报的状态
+ */
+void device_shadow_mark_reported(const ShadowState *state);
+
+/**
+ * @brief ShadowDesiredResult 转字符串（用于日志）
+ */
+const char *device_shadow_desired_result_to_string(ShadowDesiredResult result);
+
+#endif // DEVICE_SHADOW_H
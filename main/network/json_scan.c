@@ -0,0 +1,354 @@
+/**
+ * @file json_scan.c
+ * @brief JSON 分词器（jsmn 风格，递归下降，嵌套深度受 JSON_SCAN_MAX_DEPTH 限制）
+ */
+
+#include "json_scan.h"
+#include <string.h>
+
+typedef struct {
+    const char *js;
+    size_t len;
+    size_t pos;
+    JsonToken *tokens;
+    unsigned max_tokens;
+    unsigned count;
+} Scanner;
+
+static int scan_value(Scanner *s, int depth);
+
+static void skip_space(Scanner *s) {
+    while (s->pos < s->len) {
+        char c = s->js[s->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        s->pos++;
+    }
+}
+
+/**
+ * @brief 分配一个 token
+ * @return token 序号，数组不足时返回 JSON_SCAN_ERROR_NOMEM
+ */
+static int alloc_token(Scanner *s, JsonTokenType type, size_t start) {
+    if (s->count >= s->max_tokens) {
+        return JSON_SCAN_ERROR_NOMEM;
+    }
+    JsonToken *tok = &s->tokens[s->count];
+    tok->type = (uint8_t)type;
+    tok->start = (uint16_t)start;
+    tok->end = (uint16_t)start;
+    tok->size = 0;
+    return (int)s->count++;
+}
+
+static bool is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int scan_string(Scanner *s) {
+    s->pos++;  // 开头引号
+    int index = alloc_token(s, JSON_TOK_STRING, s->pos);
+    if (index < 0) {
+        return index;
+    }
+
+    while (s->pos < s->len) {
+        unsigned char c = (unsigned char)s->js[s->pos];
+        if (c == '"') {
+            s->tokens[index].end = (uint16_t)s->pos;
+            s->pos++;
+            return index;
+        }
+        if (c < 0x20) {
+            return JSON_SCAN_ERROR_INVAL;
+        }
+        if (c == '\\') {
+            if (++s->pos >= s->len) {
+                break;
+            }
+            switch (s->js[s->pos]) {
+                case '"': case '\\': case '/': case 'b':
+                case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    for (int i = 0; i < 4; i++) {
+                        if (++s->pos >= s->len) {
+                            return JSON_SCAN_ERROR_PART;
+                        }
+                        if (!is_hex(s->js[s->pos])) {
+                            return JSON_SCAN_ERROR_INVAL;
+                        }
+                    }
+                    break;
+                default:
+                    return JSON_SCAN_ERROR_INVAL;
+            }
+        }
+        s->pos++;
+    }
+    return JSON_SCAN_ERROR_PART;
+}
+
+/**
+ * @brief 匹配字面量 true / false / null
+ */
+static int scan_literal(Scanner *s, const char *word) {
+    size_t n = strlen(word);
+    size_t avail = s->len - s->pos;
+    if (memcmp(s->js + s->pos, word, avail < n ? avail : n) != 0) {
+        return JSON_SCAN_ERROR_INVAL;
+    }
+    if (avail < n) {
+        return JSON_SCAN_ERROR_PART;
+    }
+    int index = alloc_token(s, JSON_TOK_PRIMITIVE, s->pos);
+    if (index < 0) {
+        return index;
+    }
+    s->pos += n;
+    s->tokens[index].end = (uint16_t)s->pos;
+    return index;
+}
+
+/**
+ * @brief 数字：-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static int scan_number(Scanner *s) {
+    size_t start = s->pos;
+    size_t p = s->pos;
+
+    if (p < s->len && s->js[p] == '-') {
+        p++;
+    }
+    if (p >= s->len) {
+        return JSON_SCAN_ERROR_PART;
+    }
+    if (s->js[p] == '0') {
+        p++;
+    } else if (is_digit(s->js[p])) {
+        while (p < s->len && is_digit(s->js[p])) {
+            p++;
+        }
+    } else {
+        return JSON_SCAN_ERROR_INVAL;
+    }
+
+    if (p < s->len && s->js[p] == '.') {
+        p++;
+        if (p >= s->len) {
+            return JSON_SCAN_ERROR_PART;
+        }
+        if (!is_digit(s->js[p])) {
+            return JSON_SCAN_ERROR_INVAL;
+        }
+        while (p < s->len && is_digit(s->js[p])) {
+            p++;
+        }
+    }
+
+    if (p < s->len && (s->js[p] == 'e' || s->js[p] == 'E')) {
+        p++;
+        if (p < s->len && (s->js[p] == '+' || s->js[p] == '-')) {
+            p++;
+        }
+        if (p >= s->len) {
+            return JSON_SCAN_ERROR_PART;
+        }
+        if (!is_digit(s->js[p])) {
+            return JSON_SCAN_ERROR_INVAL;
+        }
+        while (p < s->len && is_digit(s->js[p])) {
+            p++;
+        }
+    }
+
+    int index = alloc_token(s, JSON_TOK_PRIMITIVE, start);
+    if (index < 0) {
+        return index;
+    }
+    s->pos = p;
+    s->tokens[index].end = (uint16_t)p;
+    return index;
+}
+
+/**
+ * @brief 对象或数组
+ */
+static int scan_container(Scanner *s, int depth, bool object) {
+    if (depth >= JSON_SCAN_MAX_DEPTH) {
+        return JSON_SCAN_ERROR_INVAL;
+    }
+    int index = alloc_token(s, object ? JSON_TOK_OBJECT : JSON_TOK_ARRAY, s->pos);
+    if (index < 0) {
+        return index;
+    }
+    char close = object ? '}' : ']';
+    s->pos++;
+
+    skip_space(s);
+    if (s->pos < s->len && s->js[s->pos] == close) {
+        s->pos++;
+        s->tokens[index].end = (uint16_t)s->pos;
+        return index;
+    }
+
+    for (;;) {
+        int r;
+        skip_space(s);
+        if (s->pos >= s->len) {
+            return JSON_SCAN_ERROR_PART;
+        }
+        if (object) {
+            if (s->js[s->pos] != '"') {
+                return JSON_SCAN_ERROR_INVAL;
+            }
+            r = scan_string(s);
+            if (r < 0) {
+                return r;
+            }
+            s->tokens[r].size = 1;
+            skip_space(s);
+            if (s->pos >= s->len) {
+                return JSON_SCAN_ERROR_PART;
+            }
+            if (s->js[s->pos] != ':') {
+                return JSON_SCAN_ERROR_INVAL;
+            }
+            s->pos++;
+        }
+
+        r = scan_value(s, depth + 1);
+        if (r < 0) {
+            return r;
+        }
+        s->tokens[index].size++;
+
+        skip_space(s);
+        if (s->pos >= s->len) {
+            return JSON_SCAN_ERROR_PART;
+        }
+        if (s->js[s->pos] == close) {
+            s->pos++;
+            s->tokens[index].end = (uint16_t)s->pos;
+            return index;
+        }
+        if (s->js[s->pos] != ',') {
+            return JSON_SCAN_ERROR_INVAL;
+        }
+        s->pos++;
+    }
+}
+
+static int scan_value(Scanner *s, int depth) {
+    skip_space(s);
+    if (s->pos >= s->len) {
+        return JSON_SCAN_ERROR_PART;
+    }
+    switch (s->js[s->pos]) {
+        case '{':
+            return scan_container(s, depth, true);
+        case '[':
+            return scan_container(s, depth, false);
+        case '"':
+            return scan_string(s);
+        case 't':
+            return scan_literal(s, "true");
+        case 'f':
+            return scan_literal(s, "false");
+        case 'n':
+            return scan_literal(s, "null");
+        default:
+            return scan_number(s);
+    }
+}
+
+int json_scan(const char *js, size_t len, JsonToken *tokens, unsigned max_tokens) {
+    if (js == NULL || tokens == NULL || len > JSON_SCAN_MAX_LEN) {
+        return JSON_SCAN_ERROR_INVAL;
+    }
+
+    Scanner s = {
+        .js = js,
+        .len = len,
+        .pos = 0,
+        .tokens = tokens,
+        .max_tokens = max_tokens,
+        .count = 0,
+    };
+    int r = scan_value(&s, 0);
+    if (r < 0) {
+        return r;
+    }
+    skip_space(&s);
+    if (s.pos != len) {
+        return JSON_SCAN_ERROR_INVAL;
+    }
+    return (int)s.count;
+}
+
+int json_token_next(const JsonToken *tokens, int count, int index) {
+    if (index >= count) {
+        return count;
+    }
+    uint16_t end = tokens[index].end;
+    int next = index + 1;
+    while (next < count && tokens[next].start < end) {
+        next++;
+    }
+    return next;
+}
+
+bool json_token_equals(const char *js, const JsonToken *tok, const char *str) {
+    size_t n = strlen(str);
+    return tok->type == JSON_TOK_STRING && (size_t)(tok->end - tok->start) == n &&
+           memcmp(js + tok->start, str, n) == 0;
+}
+
+bool json_token_get_int(const char *js, const JsonToken *tok, int32_t *value) {
+    if (tok->type != JSON_TOK_PRIMITIVE) {
+        return false;
+    }
+    const char *p = js + tok->start;
+    const char *end = js + tok->end;
+    bool negative = (p < end && *p == '-');
+    if (negative) {
+        p++;
+    }
+    if (p >= end || !is_digit(*p)) {
+        return false;  // true / false / null
+    }
+
+    int64_t v = 0;
+    while (p < end && is_digit(*p)) {
+        if (v <= INT32_MAX) {
+            v = v * 10 + (*p - '0');
+        }
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && is_digit(*p)) {
+            p++;
+        }
+    }
+    if (p != end) {
+        return false;  // 指数形式
+    }
+
+    if (negative) {
+        v = -v;
+    }
+    if (v > INT32_MAX) {
+        v = INT32_MAX;
+    } else if (v < INT32_MIN) {
+        v = INT32_MIN;
+    }
+    *value = (int32_t)v;
+    return true;
+}
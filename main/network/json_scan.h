@@ -0,0 +1,77 @@
+/**
+ * @file json_scan.h
+ * @brief JSON 分词器接口定义（jsmn 风格）- 一次扫描输入，把结构写入调用方的 token 数组，不分配堆内存
+ *
+ * 用法：
+ *   JsonToken tok[16];
+ *   int n = json_scan(data, len, tok, 16);          // < 0 为错误码
+ *   if (n > 0 && tok[0].type == JSON_TOK_OBJECT) {
+ *       for (int i = 1; i < n; i = json_token_next(tok, n, i + 1)) {
+ *           // tok[i] 为键，tok[i + 1] 为值
+ *       }
+ *   }
+ *
+ * token 只记录在输入中的偏移，不复制、不反转义；字符串 token 不含两侧引号。
+ * 语法按 RFC 8259 严格校验，输入须为一个完整的 JSON 值（前后可有空白）。
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_SCAN_MAX_DEPTH   8       ///< 最大嵌套层数
+#define JSON_SCAN_MAX_LEN     65535   ///< 输入最大长度（token 偏移为 16 位）
+
+// json_scan() 错误码
+#define JSON_SCAN_ERROR_NOMEM  (-1)   ///< token 数组不足
+#define JSON_SCAN_ERROR_INVAL  (-2)   ///< 语法错误、嵌套过深或输入过长
+#define JSON_SCAN_ERROR_PART   (-3)   ///< 输入不完整
+
+typedef enum {
+    JSON_TOK_OBJECT = 1,
+    JSON_TOK_ARRAY,
+    JSON_TOK_STRING,
+    JSON_TOK_PRIMITIVE,       ///< 数字 / true / false / null
+} JsonTokenType;
+
+/**
+ * @brief token（8 字节）
+ */
+typedef struct {
+    uint8_t type;             ///< JsonTokenType
+    uint16_t start;           ///< 起始偏移
+    uint16_t end;             ///< 结束偏移（不含）；对象 / 数组为闭括号之后
+    uint16_t size;            ///< 对象为成员数，数组为元素数，键字符串为 1，其余为 0
+} JsonToken;
+
+/**
+ * @brief 分词
+ * @param js 输入（无需 '\0' 结尾）
+ * @param len 输入长度
+ * @param tokens token 数组（按出现顺序写入，键与值各占一个）
+ * @param max_tokens 数组容量
+ * @return token 数量，或 JSON_SCAN_ERROR_*
+ */
+int json_scan(const char *js, size_t len, JsonToken *tokens, unsigned max_tokens);
+
+/**
+ * @brief 跳过 tokens[index] 及其全部子 token
+ * @return 下一个兄弟 token 的序号（没有时返回 count）
+ */
+int json_token_next(const JsonToken *tokens, int count, int index);
+
+/**
+ * @brief 字符串 token 是否等于 str（按原文比较）
+ */
+bool json_token_equals(const char *js, const JsonToken *tok, const char *str);
+
+/**
+ * @brief 数字 token 转整数（小数部分截断，超出 int32 范围时饱和）
+ * @return false 不是数字或为指数形式
+ */
+bool json_token_get_int(const char *js, const JsonToken *tok, int32_t *value);
+
+#endif // JSON_SCAN_H
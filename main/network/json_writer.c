@@ -0,0 +1,229 @@
+/**
+ * @file json_writer.c
+ * @brief 流式 JSON 写入器
+ *
+ * 逐字节写入调用方缓冲区，不使用堆内存，也不调用 printf 系列函数；
+ * 栈占用只有写入器本身和一个 24 字节的数字转换缓冲。
+ */
+
+#include "json_writer.h"
+#include <math.h>
+#include <string.h>
+
+static void put_char(JsonWriter *w, char c) {
+    if (w->overflow) {
+        return;
+    }
+    if (w->len + 1 >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+static void put_raw(JsonWriter *w, const char *s, size_t n) {
+    if (w->overflow) {
+        return;
+    }
+    if (w->len + n >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_escaped(JsonWriter *w, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    put_char(w, '"');
+    for (const unsigned char *p = (const unsigned char *)s; *p; p++) {
+        switch (*p) {
+            case '"':  put_raw(w, "\\\"", 2); break;
+            case '\\': put_raw(w, "\\\\", 2); break;
+            case '\b': put_raw(w, "\\b", 2); break;
+            case '\f': put_raw(w, "\\f", 2); break;
+            case '\n': put_raw(w, "\\n", 2); break;
+            case '\r': put_raw(w, "\\r", 2); break;
+            case '\t': put_raw(w, "\\t", 2); break;
+            default:
+                if (*p < 0x20) {
+                    char esc[6] = {'\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 0xf]};
+                    put_raw(w, esc, sizeof(esc));
+                } else {
+                    put_char(w, (char)*p);
+                }
+                break;
+        }
+    }
+    put_char(w, '"');
+}
+
+/**
+ * @brief 成员前缀：必要时补逗号，写入 "key":
+ */
+static void begin_value(JsonWriter *w, const char *key) {
+    if (w->depth > 0) {
+        uint8_t bit = (uint8_t)(1u << (w->depth - 1));
+        if (w->first_mask & bit) {
+            w->first_mask &= (uint8_t)~bit;
+        } else {
+            put_char(w, ',');
+        }
+    }
+    if (key) {
+        put_escaped(w, key);
+        put_char(w, ':');
+    }
+}
+
+static void begin_container(JsonWriter *w, const char *key, char open) {
+    begin_value(w, key);
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+    put_char(w, open);
+    w->first_mask |= (uint8_t)(1u << w->depth);
+    w->depth++;
+}
+
+static void end_container(JsonWriter *w, char close) {
+    if (w->depth == 0) {
+        w->overflow = true;
+        return;
+    }
+    w->depth--;
+    w->first_mask &= (uint8_t)~(1u << w->depth);
+    put_char(w, close);
+}
+
+/**
+ * @brief 无符号整数转十进制（写入 end 之前，返回起始位置）
+ */
+static char *format_u64(uint64_t v, char *end) {
+    char *p = end;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return p;
+}
+
+void json_writer_init(JsonWriter *w, char *buf, size_t size) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->depth = 0;
+    w->first_mask = 0;
+    w->overflow = (buf == NULL || size == 0);
+}
+
+void json_writer_begin_object(JsonWriter *w, const char *key) {
+    begin_container(w, key, '{');
+}
+
+void json_writer_begin_array(JsonWriter *w, const char *key) {
+    begin_container(w, key, '[');
+}
+
+void json_writer_end_object(JsonWriter *w) {
+    end_container(w, '}');
+}
+
+void json_writer_end_array(JsonWriter *w) {
+    end_container(w, ']');
+}
+
+void json_writer_add_string(JsonWriter *w, const char *key, const char *value) {
+    begin_value(w, key);
+    if (value) {
+        put_escaped(w, value);
+    } else {
+        put_raw(w, "null", 4);
+    }
+}
+
+void json_writer_add_int(JsonWriter *w, const char *key, int64_t value) {
+    char num[24];
+    char *end = num + sizeof(num);
+    uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char *p = format_u64(mag, end);
+    if (value < 0) {
+        *--p = '-';
+    }
+    begin_value(w, key);
+    put_raw(w, p, (size_t)(end - p));
+}
+
+void json_writer_add_fixed(JsonWriter *w, const char *key, float value, int decimals) {
+    static const uint32_t scale_table[] = {1, 10, 100, 1000, 10000};
+    if (!isfinite(value)) {
+        json_writer_add_null(w, key);
+        return;
+    }
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 4) {
+        decimals = 4;
+    }
+
+    uint32_t scale = scale_table[decimals];
+    double scaled = round((double)value * scale);
+    if (fabs(scaled) >= 9.0e18) {
+        json_writer_add_null(w, key);
+        return;
+    }
+    int64_t v = (int64_t)scaled;
+    uint64_t mag = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+    uint64_t ipart = mag / scale;
+    uint32_t frac = (uint32_t)(mag % scale);
+
+    char num[24];
+    char *end = num + sizeof(num);
+    char *p = end;
+    if (frac) {
+        // 小数部分去掉末尾的 0
+        int digits = decimals;
+        while (frac % 10 == 0) {
+            frac /= 10;
+            digits--;
+        }
+        for (int i = 0; i < digits; i++) {
+            *--p = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        *--p = '.';
+    }
+    p = format_u64(ipart, p);
+    if (v < 0) {
+        *--p = '-';
+    }
+
+    begin_value(w, key);
+    put_raw(w, p, (size_t)(end - p));
+}
+
+void json_writer_add_null(JsonWriter *w, const char *key) {
+    begin_value(w, key);
+    put_raw(w, "null", 4);
+}
+
+void json_writer_add_bool(JsonWriter *w, const char *key, bool value) {
+    begin_value(w, key);
+    if (value) {
+        put_raw(w, "true", 4);
+    } else {
+        put_raw(w, "false", 5);
+    }
+}
+
+int json_writer_finish(JsonWriter *w) {
+    if (w->overflow || w->depth != 0) {
+        if (w->buf && w->size > 0) {
+            w->buf[0] = '\0';
+        }
+        return -1;
+    }
+    w->buf[w->len] = '\0';
+    return (int)w->len;
+}
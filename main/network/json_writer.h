@@ -0,0 +1,94 @@
+/**
+ * @file json_writer.h
+ * @brief 流式 JSON 写入器接口定义 - 直接写入调用方提供的缓冲区，不分配堆内存
+ *
+ * 用法：
+ *   JsonWriter w;
+ *   json_writer_init(&w, buf, sizeof(buf));
+ *   json_writer_begin_object(&w, NULL);
+ *   json_writer_add_fixed(&w, "temp", 24.53f, 2);
+ *   json_writer_add_string(&w, "mode", "LOCAL");
+ *   json_writer_end_object(&w);
+ *   int len = json_writer_finish(&w);   // -1 表示缓冲区不足
+ *
+ * 对象内的成员须给出 key，数组元素 key 传 NULL。
+ * 缓冲区不足后的写入全部忽略，只需在最后检查一次 json_writer_finish() 的返回值。
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_WRITER_MAX_DEPTH  8     ///< 最大嵌套层数
+
+/**
+ * @brief 写入器状态（放在调用方栈上，约 16 字节）
+ */
+typedef struct {
+    char *buf;            ///< 输出缓冲区
+    size_t size;          ///< 缓冲区大小（含结尾 '\0'）
+    size_t len;           ///< 已写入长度
+    uint8_t depth;        ///< 当前嵌套层数
+    uint8_t first_mask;   ///< bit d = 第 d 层尚未写入成员（不需要逗号）
+    bool overflow;        ///< 缓冲区不足或嵌套错误
+} JsonWriter;
+
+/**
+ * @brief 初始化写入器
+ * @param w 写入器
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ */
+void json_writer_init(JsonWriter *w, char *buf, size_t size);
+
+/**
+ * @brief 开始对象 / 数组
+ * @param w 写入器
+ * @param key 成员名（顶层或数组元素传 NULL）
+ */
+void json_writer_begin_object(JsonWriter *w, const char *key);
+void json_writer_begin_array(JsonWriter *w, const char *key);
+
+/**
+ * @brief 结束对象 / 数组
+ */
+void json_writer_end_object(JsonWriter *w);
+void json_writer_end_array(JsonWriter *w);
+
+/**
+ * @brief 写入字符串（按 JSON 规则转义，UTF-8 原样输出）
+ */
+void json_writer_add_string(JsonWriter *w, const char *key, const char *value);
+
+/**
+ * @brief 写入整数
+ */
+void json_writer_add_int(JsonWriter *w, const char *key, int64_t value);
+
+/**
+ * @brief 写入定点小数：四舍五入到 decimals 位，去掉末尾的 0（整数值不带小数点）
+ * NaN / Inf 写为 null。不经过 printf 浮点格式化，不会触发 newlib dtoa 的堆分配。
+ * @param decimals 小数位数（0 ~ 4）
+ */
+void json_writer_add_fixed(JsonWriter *w, const char *key, float value, int decimals);
+
+/**
+ * @brief 写入 null
+ */
+void json_writer_add_null(JsonWriter *w, const char *key);
+
+/**
+ * @brief 写入布尔值
+ */
+void json_writer_add_bool(JsonWriter *w, const char *key, bool value);
+
+/**
+ * @brief 结束写入并补 '\0'
+ * @return 输出长度（不含 '\0'），缓冲区不足或对象 / 数组未闭合时返回 -1
+ */
+int json_writer_finish(JsonWriter *w);
+
+#endif // JSON_WRITER_H
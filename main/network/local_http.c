@@ -0,0 +1,460 @@
+/**
+ * @file local_http.c
+ * @brief 本地 HTTP 接口实现
+ *
+ * /metrics 逐行格式化到一个 LOCAL_HTTP_CHUNK_SIZE 字节的静态缓冲区，满了就作为一个
+ * HTTP 分块发出，响应长度与登记的指标数无关，内存占用固定。请求由服务器任务串行处理，
+ * 静态缓冲区与鉴权失败记录只在该任务中访问，不加锁。
+ * 鉴权失败按客户端地址分别计数与锁定，局域网内其他主机猜错令牌不影响持有正确令牌的客户端。
+ */
+
+#include "local_http.h"
+
+#if CONFIG_LOCAL_HTTP
+
+#include "mqtt_wrapper.h"
+#include "metrics.h"
+#include "decision_engine.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "LOCAL_HTTP";
+
+// 运行模式与租约状态名（同 status 消息的 mode / lease 字段）
+static const char *const s_mode_names[] = {"REMOTE", "LOCAL", "SAFE_STOP"};
+static const char *const s_lease_names[] = {"NONE", "VALID", "EXPIRED"};
+
+static const char s_token[] = CONFIG_LOCAL_HTTP_TOKEN;
+
+static httpd_handle_t s_server = NULL;
+static LocalHttpStateFn s_get_state = NULL;
+
+static char s_chunk[LOCAL_HTTP_CHUNK_SIZE];
+static char s_body[LOCAL_HTTP_BODY_MAX + 1];
+
+/**
+ * @brief 一个客户端地址的鉴权失败记录
+ */
+typedef struct {
+    uint8_t addr[16];           ///< 客户端地址（IPv4 按 IPv4 映射的 IPv6 地址存放）
+    bool used;
+    uint8_t failures;           ///< 连续鉴权失败次数
+    int64_t last_fail_us;       ///< 最近一次失败时刻（满时替换最久未失败的记录）
+    int64_t lockout_until_us;   ///< 锁定截止时刻（esp_timer 时基）
+} AuthClient;
+
+static AuthClient s_auth_clients[LOCAL_HTTP_AUTH_CLIENTS];
+
+// 指标
+typedef enum {
+    HTTP_EP_METRICS = 0,
+    HTTP_EP_COMMAND,
+    HTTP_EP_COUNT,
+} HttpEndpoint;
+
+static const char *const s_endpoint_names[HTTP_EP_COUNT] = {"metrics", "command"};
+static MetricCounter s_requests[HTTP_EP_COUNT];
+static MetricCounter s_auth_rejects;
+static MetricHistogram s_metrics_send_us;
+static const uint32_t s_metrics_send_bounds[] = {5000, 10000, 20000, 50000, 100000, 250000};
+
+/**
+ * @brief 分块输出流
+ */
+typedef struct {
+    httpd_req_t *req;
+    int len;            ///< s_chunk 中待发送的字节数
+    esp_err_t err;      ///< 第一次发送失败的错误（之后的输出全部忽略）
+} ChunkStream;
+
+static void stream_flush(ChunkStream *s)
+{
+    if (s->err == ESP_OK && s->len > 0) {
+        s->err = httpd_resp_send_chunk(s->req, s_chunk, s->len);
+    }
+    s->len = 0;
+}
+
+/**
+ * @brief 格式化一行追加到分块缓冲区，放不下时先发出已有内容再重试
+ */
+static void stream_printf(ChunkStream *s, const char *fmt, ...)
+{
+    for (int attempt = 0; attempt < 2 && s->err == ESP_OK; attempt++) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(s_chunk + s->len, sizeof(s_chunk) - s->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            s->err = ESP_FAIL;
+        } else if (s->len + n < (int)sizeof(s_chunk)) {
+            s->len += n;
+            return;
+        } else if (s->len == 0) {
+            s->err = ESP_ERR_INVALID_SIZE;  // 单行超过缓冲区
+        } else {
+            stream_flush(s);
+        }
+    }
+}
+
+/**
+ * @brief 输出 HELP 与 TYPE 行（指标名加 LOCAL_HTTP_METRIC_PREFIX 前缀）
+ */
+static void write_family(ChunkStream *s, const char *name, const char *help, const char *type)
+{
+    stream_printf(s, "# HELP " LOCAL_HTTP_METRIC_PREFIX "%s %s\n# TYPE " LOCAL_HTTP_METRIC_PREFIX "%s %s\n",
+                  name, help, name, type);
+}
+
+/**
+ * @brief 输出实时状态：传感器、风扇档位、运行模式与远程租约
+ */
+static void write_state(ChunkStream *s, const LocalHttpState *st)
+{
+    write_family(s, "sensor_valid", "传感器数据有效（1 有效）", "gauge");
+    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "sensor_valid %d\n", st->sensor.valid ? 1 : 0);
+
+    // 数据无效时不输出数值，Prometheus 按缺失处理
+    if (st->sensor.valid) {
+        write_family(s, "co2_ppm", "CO2 浓度（ppm，同 status 消息）", "gauge");
+        stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "co2_ppm %.1f\n", st->sensor.pollutants.co2);
+        write_family(s, "temperature_celsius", "温度（℃）", "gauge");
+        stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "temperature_celsius %.2f\n", st->sensor.temperature);
+        write_family(s, "humidity_percent", "相对湿度（%）", "gauge");
+        stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "humidity_percent %.2f\n", st->sensor.humidity);
+    }
+
+    write_family(s, "fan_state", "风扇档位（0=OFF 1=LOW 2=HIGH）", "gauge");
+    for (int i = 0; i < st->fan_count && i < FAN_MAX_COUNT; i++) {
+        stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "fan_state{fan=\"%d\"} %d\n", i, (int)st->fans[i]);
+    }
+
+    write_family(s, "mode", "当前运行模式（当前模式为 1）", "gauge");
+    for (int m = 0; m < (int)(sizeof(s_mode_names) / sizeof(s_mode_names[0])); m++) {
+        stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "mode{mode=\"%s\"} %d\n", s_mode_names[m],
+                      (int)st->mode == m ? 1 : 0);
+    }
+    write_family(s, "mode_reason", "模式判定原因", "gauge");
+    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "mode_reason{reason=\"%s\"} 1\n",
+                  decision_mode_reason_to_string(st->mode_reason));
+
+    int64_t expire_us;
+    int64_t now = esp_timer_get_time();
+    RemoteLease lease = mqtt_get_remote_lease(&expire_us);
+    write_family(s, "remote_lease_seconds", "远程命令租约剩余时间（秒，无有效租约为 0）", "gauge");
+    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "remote_lease_seconds %lld\n",
+                  lease == LEASE_VALID ? (long long)((expire_us - now) / 1000000) : 0LL);
+
+    write_family(s, "uptime_seconds", "运行时间（秒）", "gauge");
+    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "uptime_seconds %lld\n", (long long)(now / 1000000));
+}
+
+/**
+ * @brief 输出指标登记表中的全部指标
+ * 直方图按 Prometheus 约定输出累计分桶（含 +Inf）、_sum 与 _count；
+ * 各桶计数先读出再累加，_count 与 +Inf 桶取同一累计值，保证同一次抓取内自洽
+ */
+static void write_registry(ChunkStream *s)
+{
+    int n = metrics_count();
+    for (int i = 0; i < n; i++) {
+        const MetricDesc *d = metrics_get(i);
+        write_family(s, d->name, d->help, metric_type_to_string(d->type));
+
+        if (d->type == METRIC_TYPE_COUNTER) {
+            for (int j = 0; j < d->count; j++) {
+                uint32_t v = metric_counter_get(&d->counters[j]);
+                if (d->label) {
+                    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s{%s=\"%s\"} %lu\n", d->name, d->label,
+                                  d->label_values[j], (unsigned long)v);
+                } else {
+                    stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s %lu\n", d->name, (unsigned long)v);
+                }
+            }
+        } else if (d->type == METRIC_TYPE_GAUGE) {
+            stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s %ld\n", d->name,
+                          (long)metric_gauge_get(d->gauge));
+        } else {
+            const MetricHistogram *h = d->histogram;
+            uint32_t cumulative = 0;
+            for (int b = 0; b < h->bound_count; b++) {
+                cumulative += metric_histogram_bucket(h, b);
+                stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s_bucket{le=\"%lu\"} %lu\n", d->name,
+                              (unsigned long)h->bounds[b], (unsigned long)cumulative);
+            }
+            cumulative += metric_histogram_bucket(h, h->bound_count);
+            stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s_bucket{le=\"+Inf\"} %lu\n", d->name,
+                          (unsigned long)cumulative);
+            stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s_sum %lu\n", d->name,
+                          (unsigned long)metric_histogram_sum(h));
+            stream_printf(s, LOCAL_HTTP_METRIC_PREFIX "%s_count %lu\n", d->name,
+                          (unsigned long)cumulative);
+        }
+    }
+}
+
+/**
+ * @brief GET /metrics
+ */
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    int64_t start = esp_timer_get_time();
+    metric_counter_inc(&s_requests[HTTP_EP_METRICS]);
+
+    LocalHttpState st;
+    if (!s_get_state(&st)) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+    ChunkStream s = {.req = req, .len = 0, .err = ESP_OK};
+    write_state(&s, &st);
+    write_registry(&s);
+    stream_flush(&s);
+    if (s.err != ESP_OK) {
+        ESP_LOGD(TAG, "指标发送中断: %s", esp_err_to_name(s.err));
+        return ESP_FAIL;  // 关闭连接
+    }
+    esp_err_t ret = httpd_resp_send_chunk(req, NULL, 0);
+
+    int64_t elapsed = esp_timer_get_time() - start;
+    metric_histogram_observe(&s_metrics_send_us, elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed);
+    return ret;
+}
+
+/**
+ * @brief 发送短响应
+ */
+static esp_err_t send_status(httpd_req_t *req, const char *status, const char *body)
+{
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
+/**
+ * @brief 校验 "Authorization: Bearer <token>"（比较时间与令牌内容无关）
+ */
+static bool check_bearer(httpd_req_t *req)
+{
+    static const char prefix[] = "Bearer ";
+    char value[sizeof(prefix) + sizeof(s_token)];
+
+    size_t len = httpd_req_get_hdr_value_len(req, "Authorization");
+    if (len == 0 || len >= sizeof(value) ||
+        httpd_req_get_hdr_value_str(req, "Authorization", value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    if (len != sizeof(prefix) - 1 + sizeof(s_token) - 1 ||
+        strncmp(value, prefix, sizeof(prefix) - 1) != 0) {
+        return false;
+    }
+
+    const char *given = value + sizeof(prefix) - 1;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < sizeof(s_token) - 1; i++) {
+        diff |= (uint8_t)(given[i] ^ s_token[i]);
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief 取请求的客户端地址
+ * 取不到时返回全零地址，这类请求共用一条失败记录
+ */
+static void client_addr(httpd_req_t *req, uint8_t addr[16])
+{
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    int fd = httpd_req_to_sockfd(req);
+
+    memset(addr, 0, 16);
+    if (fd < 0 || getpeername(fd, (struct sockaddr *)&ss, &len) != 0) {
+        return;
+    }
+    if (ss.ss_family == AF_INET) {
+        addr[10] = 0xff;
+        addr[11] = 0xff;
+        memcpy(addr + 12, &((struct sockaddr_in *)&ss)->sin_addr, 4);
+    } else if (ss.ss_family == AF_INET6) {
+        memcpy(addr, &((struct sockaddr_in6 *)&ss)->sin6_addr, 16);
+    }
+}
+
+/**
+ * @brief 表满时被替换的优先顺序：空闲 > 未锁定 > 锁定，同类中最久未失败的优先
+ * @return a 比 b 更应被替换
+ */
+static bool auth_client_evict_before(const AuthClient *a, const AuthClient *b, int64_t now)
+{
+    if (a->used != b->used) {
+        return !a->used;
+    }
+    bool a_locked = now < a->lockout_until_us;
+    bool b_locked = now < b->lockout_until_us;
+    if (a_locked != b_locked) {
+        return !a_locked;
+    }
+    return a->last_fail_us < b->last_fail_us;
+}
+
+/**
+ * @brief 查找客户端地址的失败记录
+ * @param create 没有记录时新建（表满时按 auth_client_evict_before() 替换一条）
+ * @return 记录，没有且 create 为 false 时返回 NULL
+ */
+static AuthClient *auth_client_find(const uint8_t addr[16], bool create, int64_t now)
+{
+    AuthClient *victim = &s_auth_clients[0];
+    for (int i = 0; i < LOCAL_HTTP_AUTH_CLIENTS; i++) {
+        AuthClient *c = &s_auth_clients[i];
+        if (c->used && memcmp(c->addr, addr, sizeof(c->addr)) == 0) {
+            return c;
+        }
+        if (auth_client_evict_before(c, victim, now)) {
+            victim = c;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    memset(victim, 0, sizeof(*victim));
+    memcpy(victim->addr, addr, sizeof(victim->addr));
+    victim->used = true;
+    return victim;
+}
+
+/**
+ * @brief POST /command：鉴权后按 MQTT command 主题的格式受理，响应当前租约状态
+ * 同一客户端地址连续 LOCAL_HTTP_AUTH_MAX_FAILS 次鉴权失败后锁定该地址 LOCAL_HTTP_AUTH_LOCKOUT_SEC 秒
+ */
+static esp_err_t command_post_handler(httpd_req_t *req)
+{
+    metric_counter_inc(&s_requests[HTTP_EP_COMMAND]);
+
+    if (sizeof(s_token) <= 1) {
+        return send_status(req, "403 Forbidden", "{\"error\":\"disabled\"}");
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint8_t addr[16];
+    client_addr(req, addr);
+    AuthClient *client = auth_client_find(addr, false, now);
+    if (client && now < client->lockout_until_us) {
+        char retry[24];
+        snprintf(retry, sizeof(retry), "%lld", (long long)((client->lockout_until_us - now) / 1000000 + 1));
+        httpd_resp_set_hdr(req, "Retry-After", retry);
+        return send_status(req, "429 Too Many Requests", "{\"error\":\"locked\"}");
+    }
+
+    if (!check_bearer(req)) {
+        metric_counter_inc(&s_auth_rejects);
+        client = client ? client : auth_client_find(addr, true, now);
+        client->last_fail_us = now;
+        if (++client->failures >= LOCAL_HTTP_AUTH_MAX_FAILS) {
+            client->failures = 0;
+            client->lockout_until_us = now + (int64_t)LOCAL_HTTP_AUTH_LOCKOUT_SEC * 1000000;
+            ESP_LOGW(TAG, "客户端连续 %d 次鉴权失败，锁定该地址 %d 秒", LOCAL_HTTP_AUTH_MAX_FAILS,
+                     LOCAL_HTTP_AUTH_LOCKOUT_SEC);
+        }
+        httpd_resp_set_hdr(req, "WWW-Authenticate", "Bearer");
+        return send_status(req, "401 Unauthorized", "{\"error\":\"unauthorized\"}");
+    }
+    if (client) {
+        client->used = false;  // 鉴权成功，清除该地址的失败记录
+    }
+
+    if (req->content_len == 0 || req->content_len > LOCAL_HTTP_BODY_MAX) {
+        return send_status(req, req->content_len == 0 ? "400 Bad Request" : "413 Payload Too Large",
+                           "{\"error\":\"length\"}");
+    }
+
+    int received = 0;
+    int timeouts = 0;
+    while (received < (int)req->content_len) {
+        int r = httpd_req_recv(req, s_body + received, req->content_len - received);
+        if (r == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < LOCAL_HTTP_RECV_RETRIES) {
+            continue;
+        }
+        if (r <= 0) {
+            ESP_LOGW(TAG, "接收命令失败 (%d)", r);
+            return ESP_FAIL;  // 关闭连接
+        }
+        received += r;
+    }
+    s_body[received] = '\0';
+
+    if (mqtt_submit_command(s_body, received) != ESP_OK) {
+        return send_status(req, "400 Bad Request", "{\"error\":\"format\"}");
+    }
+    ESP_LOGI(TAG, "受理本地命令（%d 字节）", received);
+
+    int64_t expire_us;
+    RemoteLease lease = mqtt_get_remote_lease(&expire_us);
+    long long remaining = lease == LEASE_VALID ? (expire_us - esp_timer_get_time()) / 1000000 : 0;
+    char resp[64];
+    snprintf(resp, sizeof(resp), "{\"lease\":\"%s\",\"remaining_s\":%lld}",
+             (unsigned)lease < sizeof(s_lease_names) / sizeof(s_lease_names[0]) ? s_lease_names[lease] : "NONE",
+             remaining);
+    return send_status(req, "200 OK", resp);
+}
+
+esp_err_t local_http_start(LocalHttpStateFn get_state)
+{
+    if (!get_state) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_server) {
+        return ESP_OK;
+    }
+    s_get_state = get_state;
+
+    metrics_register_counter(s_requests, HTTP_EP_COUNT, "http_requests_total", "本地 HTTP 请求数",
+                             "endpoint", s_endpoint_names);
+    metrics_register_counter(&s_auth_rejects, 1, "http_auth_failures_total", "本地命令鉴权失败次数",
+                             NULL, NULL);
+    metrics_register_histogram(&s_metrics_send_us, "http_metrics_send_us", "/metrics 生成并发送耗时（微秒）",
+                               s_metrics_send_bounds,
+                               sizeof(s_metrics_send_bounds) / sizeof(s_metrics_send_bounds[0]));
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_LOCAL_HTTP_PORT;
+    config.task_priority = TASK_PRIORITY_NETWORK;
+    config.stack_size = TASK_STACK_SIZE_SMALL;
+    config.max_open_sockets = LOCAL_HTTP_MAX_SOCKETS;
+    config.lru_purge_enable = true;  // 连接数满时关闭最久未活动的连接，而不是拒绝新的抓取
+
+    esp_err_t ret = httpd_start(&s_server, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP 服务器启动失败: %s", esp_err_to_name(ret));
+        s_server = NULL;
+        return ret;
+    }
+
+    const httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_get_handler,
+    };
+    const httpd_uri_t command_uri = {
+        .uri = "/command",
+        .method = HTTP_POST,
+        .handler = command_post_handler,
+    };
+    httpd_register_uri_handler(s_server, &metrics_uri);
+    httpd_register_uri_handler(s_server, &command_uri);
+
+    ESP_LOGI(TAG, "本地 HTTP 接口已启动（端口 %d，命令%s）", CONFIG_LOCAL_HTTP_PORT,
+             sizeof(s_token) > 1 ? "需令牌" : "已禁用");
+    return ESP_OK;
+}
+
+#endif // CONFIG_LOCAL_HTTP
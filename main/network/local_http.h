@@ -0,0 +1,48 @@
+/**
+ * @file local_http.h
+ * @brief 本地 HTTP 接口定义 - 局域网内的 Prometheus 指标导出与带令牌的风扇命令
+ *
+ * 为只接入局域网（或 Broker 不可达）的现场提供：
+ * - GET  /metrics：实时传感器数据、风扇状态、运行模式与指标登记表（metrics.h）中的全部指标，
+ *   Prometheus 文本格式（0.0.4），边生成边按 LOCAL_HTTP_CHUNK_SIZE 分块发送，不在内存中拼出完整文档
+ * - POST /command：与 MQTT command 主题相同的命令（JSON 或 CBOR），走同一解析与租约路径
+ *   （mqtt_submit_command()），需要 "Authorization: Bearer <CONFIG_LOCAL_HTTP_TOKEN>"
+ *
+ * 由 CONFIG_LOCAL_HTTP 启用。请求在 esp_http_server 的单个服务器任务中串行处理。
+ */
+
+#ifndef LOCAL_HTTP_H
+#define LOCAL_HTTP_H
+
+#include "main.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 导出用的当前状态快照
+ */
+typedef struct {
+    SensorData sensor;              ///< 传感器数据（co2 为发布值，同 status 消息）
+    FanState fans[FAN_MAX_COUNT];   ///< 各风扇当前档位
+    uint8_t fan_count;              ///< 风扇数量
+    SystemMode mode;                ///< 当前运行模式
+    ModeReason mode_reason;         ///< 模式判定原因
+} LocalHttpState;
+
+/**
+ * @brief 状态快照回调（在 HTTP 服务器任务中调用，须在短时间内返回）
+ * @param[out] out 快照
+ * @return false 暂时取不到数据（响应 503）
+ */
+typedef bool (*LocalHttpStateFn)(LocalHttpState *out);
+
+/**
+ * @brief 启动 HTTP 服务器并注册 /metrics 与 /command
+ * 网络未连接时也可启动，连上后即可访问
+ * @param get_state 状态快照回调
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误，其他为服务器启动失败
+ */
+esp_err_t local_http_start(LocalHttpStateFn get_state);
+
+#endif // LOCAL_HTTP_H
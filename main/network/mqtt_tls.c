@@ -0,0 +1,268 @@
+/**
+ * @file mqtt_tls.c
+ * @brief MQTT TLS 传输（esp-tls）
+ *
+ * 只服务一个 MQTT 客户端，连接状态放在模块静态变量中。传输函数都在 MQTT 任务中调用；
+ * 统计另由其他任务读取，加锁访问。
+ *
+ * 读写语义与 esp-mqtt 自带的 SSL 传输一致：超时返回 0，连接关闭或出错返回负值。
+ */
+
+#include "mqtt_tls.h"
+#include "conn_supervisor.h"
+#include "power_manager.h"
+#include "metrics.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <sys/select.h>
+
+static const char *TAG = "MQTT_TLS";
+
+#if CONFIG_MQTT_TLS_PINNED_CA
+// main/certs/mqtt_ca.pem（CMakeLists.txt 中 target_add_binary_data 嵌入，以 '\0' 结尾）
+extern const char mqtt_ca_pem_start[] asm("_binary_mqtt_ca_pem_start");
+extern const char mqtt_ca_pem_end[] asm("_binary_mqtt_ca_pem_end");
+#endif
+
+static esp_tls_t *s_tls = NULL;
+static int s_sockfd = -1;
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+static esp_tls_client_session_t *s_session = NULL;  ///< 上次握手保存的会话
+#endif
+
+static MqttTlsStats s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 成功握手耗时分布（微秒，含 DNS 与 TCP 连接）
+static const uint32_t s_handshake_bounds[] = {250000, 500000, 1000000, 2000000, 4000000, 8000000};
+static MetricHistogram s_handshake_us;
+
+/**
+ * @brief 等待套接字可读 / 可写
+ * @return 1 就绪，0 超时，-1 出错
+ */
+static int wait_socket(bool write, int timeout_ms)
+{
+    if (s_sockfd < 0) {
+        return -1;
+    }
+    fd_set set, errset;
+    FD_ZERO(&set);
+    FD_ZERO(&errset);
+    FD_SET(s_sockfd, &set);
+    FD_SET(s_sockfd, &errset);
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ret = select(s_sockfd + 1, write ? NULL : &set, write ? &set : NULL, &errset,
+                     timeout_ms < 0 ? NULL : &tv);
+    if (ret > 0 && FD_ISSET(s_sockfd, &errset)) {
+        return -1;
+    }
+    return ret < 0 ? -1 : (ret > 0 ? 1 : 0);
+}
+
+static int tls_close(esp_transport_handle_t t)
+{
+    if (s_tls != NULL) {
+        esp_tls_conn_destroy(s_tls);
+        s_tls = NULL;
+    }
+    s_sockfd = -1;
+    return 0;
+}
+
+static int tls_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    tls_close(t);
+
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+#if CONFIG_MQTT_TLS_PINNED_CA
+        .cacert_buf = (const unsigned char *)mqtt_ca_pem_start,
+        .cacert_bytes = mqtt_ca_pem_end - mqtt_ca_pem_start,
+#else
+        .crt_bundle_attach = esp_crt_bundle_attach,
+#endif
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+        .client_session = s_session,
+#endif
+    };
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+    bool offered = (s_session != NULL);
+#else
+    bool offered = false;
+#endif
+
+    s_tls = esp_tls_init();
+    if (s_tls == NULL) {
+        ESP_LOGE(TAG, "esp_tls_init 失败（内存不足）");
+        return -1;
+    }
+
+    // 堆占用：握手期间的局部最低空闲量与握手前之差为峰值，握手后之差为连接常驻
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    heap_caps_monitor_local_minimum_free_size_start();
+    power_manager_burst_begin();  // 握手的签名校验与密钥交换以最高频率完成
+    int64_t start = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, s_tls);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    power_manager_burst_end();
+    size_t free_min = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+    size_t free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    if (ret != 1 || esp_tls_get_conn_sockfd(s_tls, &s_sockfd) != ESP_OK) {
+        // 区分 TLS 层失败与 DNS / TCP 失败：只有前者才可能是提交的会话导致的
+        esp_tls_error_handle_t err_handle = NULL;
+        int tls_code = 0, cert_flags = 0;
+        esp_err_t last_err = ESP_FAIL;
+        if (esp_tls_get_error_handle(s_tls, &err_handle) == ESP_OK) {
+            last_err = esp_tls_get_and_clear_last_error(err_handle, &tls_code, &cert_flags);
+        }
+        ESP_LOGW(TAG, "TLS 握手失败（%lu ms）: %s，mbedtls -0x%04x", (unsigned long)elapsed_ms,
+                 esp_err_to_name(last_err), (unsigned)-tls_code);
+        tls_close(t);
+        // 会话可能已失效或不被接受，下次改为完整握手，避免反复失败；网络不通时保留会话
+        if (offered && last_err == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED) {
+            mqtt_tls_forget_session();
+        }
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.failures++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return -1;
+    }
+
+    conn_supervisor_on_tls_up();
+
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+    // 服务器拒绝复用时握手回退为完整握手，此处总是换成本次协商出的会话
+    esp_tls_client_session_t *session = esp_tls_get_client_session(s_tls);
+    if (session != NULL) {
+        mqtt_tls_forget_session();
+        s_session = session;
+    }
+#endif
+
+    metric_histogram_observe(&s_handshake_us, elapsed_ms * 1000u);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.handshakes++;
+    s_stats.last_ms = elapsed_ms;
+    if (offered) {
+        s_stats.resume_offered++;
+        s_stats.last_resume_ms = elapsed_ms;
+    } else {
+        s_stats.last_full_ms = elapsed_ms;
+    }
+    s_stats.last_heap_peak = free_before > free_min ? free_before - free_min : 0;
+    s_stats.last_heap_held = free_before > free_after ? free_before - free_after : 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    ESP_LOGI(TAG, "TLS 握手完成: %lu ms，%s，堆峰值 %u 字节，常驻 %u 字节", (unsigned long)elapsed_ms,
+             offered ? "提交已保存会话" : "完整握手",
+             (unsigned)(free_before > free_min ? free_before - free_min : 0),
+             (unsigned)(free_before > free_after ? free_before - free_after : 0));
+    return 0;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    if (s_tls == NULL) {
+        return -1;
+    }
+    if (esp_tls_get_bytes_avail(s_tls) > 0) {
+        return 1;  // mbedtls 缓冲区中还有已解密数据
+    }
+    return wait_socket(false, timeout_ms);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    return wait_socket(true, timeout_ms);
+}
+
+static int tls_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    int poll = tls_poll_read(t, timeout_ms);
+    if (poll <= 0) {
+        return poll;
+    }
+    ssize_t ret = esp_tls_conn_read(s_tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret < 0 ? -1 : (int)ret;
+}
+
+static int tls_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    int poll = tls_poll_write(t, timeout_ms);
+    if (poll <= 0) {
+        return poll;
+    }
+    ssize_t ret = esp_tls_conn_write(s_tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    return ret < 0 ? -1 : (int)ret;
+}
+
+static int tls_destroy(esp_transport_handle_t t)
+{
+    return tls_close(t);
+}
+
+esp_transport_handle_t mqtt_tls_transport_create(int default_port)
+{
+    esp_transport_handle_t t = esp_transport_init();
+    if (t == NULL) {
+        return NULL;
+    }
+    esp_transport_set_func(t, tls_connect, tls_read, tls_write, tls_close,
+                           tls_poll_read, tls_poll_write, tls_destroy);
+    esp_transport_set_default_port(t, default_port);
+    metrics_register_histogram(&s_handshake_us, "mqtt_tls_handshake_us", "MQTT TLS 握手耗时（微秒）",
+                               s_handshake_bounds, sizeof(s_handshake_bounds) / sizeof(s_handshake_bounds[0]));
+#if CONFIG_MQTT_TLS_PINNED_CA
+    const char *trust = "固定 CA";
+#else
+    const char *trust = "证书包";
+#endif
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+    const char *resume = "开启";
+#else
+    const char *resume = "关闭";
+#endif
+    ESP_LOGI(TAG, "TLS 传输: %s，会话复用%s", trust, resume);
+    return t;
+}
+
+void mqtt_tls_forget_session(void)
+{
+#if CONFIG_MQTT_TLS_SESSION_RESUMPTION
+    if (s_session != NULL) {
+        esp_tls_free_client_session(s_session);
+        s_session = NULL;
+    }
+#endif
+}
+
+void mqtt_tls_get_stats(MqttTlsStats *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
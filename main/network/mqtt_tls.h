@@ -0,0 +1,54 @@
+/**
+ * @file mqtt_tls.h
+ * @brief MQTT TLS 传输接口定义 - 重连复用 TLS 会话，可选只信任固定 CA
+ *
+ * esp-mqtt 自带的 SSL 传输每次重连都做完整握手，且不提供会话复用接口。
+ * 本模块基于 esp-tls 实现一个 esp_transport，作为 esp_mqtt_client_config_t.network.transport
+ * 交给 MQTT 客户端：
+ * - 每次握手成功后保存 TLS 会话（会话 ID 或会话票据），下次连接时提交给服务器，
+ *   服务器接受时省去证书链传输、证书校验与密钥交换（CONFIG_MQTT_TLS_SESSION_RESUMPTION）
+ * - CONFIG_MQTT_TLS_PINNED_CA 时只信任 main/certs/mqtt_ca.pem，否则使用 esp_crt_bundle
+ * 会话只保存在 RAM 中，重启后第一次连接为完整握手。
+ */
+
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include "esp_err.h"
+#include "esp_transport.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 握手统计
+ */
+typedef struct {
+    uint32_t handshakes;        ///< 成功握手次数
+    uint32_t failures;          ///< 失败次数
+    uint32_t resume_offered;    ///< 提交了已保存会话的握手次数
+    uint32_t last_ms;           ///< 最近一次握手耗时（毫秒，含 TCP 连接与 DNS）
+    uint32_t last_full_ms;      ///< 最近一次未提交会话的握手耗时（毫秒）
+    uint32_t last_resume_ms;    ///< 最近一次提交会话的握手耗时（毫秒）
+    uint32_t last_heap_peak;    ///< 最近一次握手期间堆占用峰值（字节）
+    uint32_t last_heap_held;    ///< 最近一次握手后连接常驻的堆（字节）
+} MqttTlsStats;
+
+/**
+ * @brief 创建 TLS 传输（交给 MQTT 客户端，由 esp_mqtt_client_destroy() 释放）
+ * @param default_port URI 未指定端口时使用的端口
+ * @return 传输句柄，内存不足时返回 NULL
+ */
+esp_transport_handle_t mqtt_tls_transport_create(int default_port);
+
+/**
+ * @brief 丢弃已保存的 TLS 会话（下次连接做完整握手）
+ */
+void mqtt_tls_forget_session(void);
+
+/**
+ * @brief 获取握手统计
+ * @param[out] out 统计
+ */
+void mqtt_tls_get_stats(MqttTlsStats *out);
+
+#endif // MQTT_TLS_H
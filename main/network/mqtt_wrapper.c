@@ -4,34 +4,141 @@
  */
 
 #include "mqtt_wrapper.h"
+#include "fan_control.h"
+#include "fan_tach.h"
+#include "fan_energy.h"
+#include "vent_ident.h"
+#include "occupancy_habit.h"
+#include "schedule.h"
+#include "decision_engine.h"
+#include "runtime_config.h"
+#include "telemetry_buffer.h"
+#include "status_batch.h"
+#include "payload_writer.h"
+#include "json_scan.h"
+#include "device_shadow.h"
+#include "report_policy.h"
+#include "mqtt_tls.h"
+#include "conn_supervisor.h"
+#include "wifi_manager.h"
+#include "power_manager.h"
+#include "diagnostics.h"
+#include "metrics.h"
+#include "oled_display.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "mqtt_client.h"    // ESP-IDF MQTT 库
-#include "esp_crt_bundle.h"
 #include "esp_mac.h"
+#include "esp_system.h"
 #include "cJSON.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/timers.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <sys/time.h>
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "MQTT_CLIENT";
 
-// MQTT 主题定义
-#define MQTT_TOPIC_STATUS   "home/ventilation/status"
-#define MQTT_TOPIC_ALERT    "home/ventilation/alert"
-#define MQTT_TOPIC_COMMAND  "home/ventilation/command/#"
+// MQTT 主题定义：每台设备的主题都在 home/ventilation/<client_id>/ 下，
+// 命令另可发往所在分组或全体设备：<命名空间>/command[/子命令]
+#define MQTT_TOPIC_ROOT        "home/ventilation"
+#define MQTT_TOPIC_BROADCAST   MQTT_TOPIC_ROOT "/all"       // 广播命名空间
+#define MQTT_TOPIC_GROUP_FMT   MQTT_TOPIC_ROOT "/group/%s"  // 分组命名空间（分组名来自运行时配置）
+#define MQTT_SUFFIX_STATUS     "/status"
+#define MQTT_SUFFIX_BACKLOG    "/status/backlog"
+#define MQTT_SUFFIX_ALERT      "/alert"
+#define MQTT_SUFFIX_MODEL      "/model"
+#define MQTT_SUFFIX_HABIT      "/habit"
+#define MQTT_SUFFIX_DIAG       "/diag"                      // 运行诊断
+#define MQTT_SUFFIX_ONLINE     "/online"                    // 在线状态（保留消息，遗嘱）
+#define MQTT_SUFFIX_CONFIG     "/config"
+#define MQTT_SUFFIX_COMMAND    "/command"
+#define MQTT_SUFFIX_DESIRED    "/shadow/desired"            // 影子期望状态（保留消息，后端 → 设备）
+#define MQTT_SUFFIX_REPORTED   "/shadow/reported"           // 影子实际状态（设备 → 后端）
+#define MQTT_SUFFIX_SHADOW_GET "/shadow/get"                // 请求完整 reported
+#define MQTT_SUFFIX_IDENT_CMD  "/ident"                     // 以下为 command 的子命令
+#define MQTT_SUFFIX_HABIT_CMD  "/habit"
+#define MQTT_SUFFIX_SCHEDULE   "/schedule"
+#define MQTT_SUFFIX_ENERGY_CMD "/energy"
+#define MQTT_SUFFIX_DIAG_CMD   "/diag"
+#define MQTT_SUFFIX_FAN_CONFIG "/fan_config"                // 风扇配置表（只接受发往本设备的命令）
+#define MQTT_TOPIC_MAX_LEN     72
+#define MQTT_ONLINE_MSG        "{\"online\": true}"
+#define MQTT_OFFLINE_MSG       "{\"online\": false}"
 
-// MQTT 重连配置
-#define MQTT_RECONNECT_DELAY_MS  30000  // 30 秒重连间隔
+// MQTT 连接配置（重连由 conn_supervisor 调度）
+#define MQTT_TLS_DEFAULT_PORT    8883   // mqtts:// 未指定端口时使用
+
+// 消息缓冲区（流式写入 JSON / CBOR，不分配堆内存）
+#define MQTT_STATUS_BUF_SIZE     4096   // 状态消息（含最多 STATUS_BATCH_MAX_SAMPLES 个批量样本）
+#define MQTT_ALERT_BUF_SIZE      256    // 告警消息（栈上）
+#define MQTT_BACKLOG_BUF_SIZE    4096   // 补传消息（最多 TELEMETRY_BATCH_MAX 个样本）
+#define MQTT_SHADOW_BUF_SIZE     384    // 影子 reported 消息（完整状态，FAN_MAX_COUNT 个风扇）
+#define MQTT_DIAG_BUF_SIZE       4608   // 诊断消息（最多 DIAG_MAX_TASKS 个任务，每个约 70 字节，另含全部指标）
+#define MQTT_FAN_CONFIG_RESTART_DELAY_MS 500  // 风扇配置表保存后重启前的等待（让告警消息发出）
+
+// 接收（消息超过 esp-mqtt 接收缓冲区时分多次投递 MQTT_EVENT_DATA，在此重组）
+#define MQTT_RX_BUF_SIZE         4096   // 分片消息重组缓冲区（更大的消息丢弃）
+#define MQTT_RX_TOPIC_MAX        96     // 分片消息主题最大长度
+#define MQTT_COMMAND_MAX_TOKENS  32     // 远程命令 JSON 最多 token 数（栈上，每个 8 字节）
 
 // 全局变量
 static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 static bool s_mqtt_connected = false;
-static TimerHandle_t s_reconnect_timer = NULL;
-static FanState s_remote_command[FAN_COUNT] = {FAN_OFF, FAN_OFF, FAN_OFF};
+static FanState s_remote_command[FAN_MAX_COUNT] = {FAN_OFF};
 static bool s_command_received = false;
 
+// 发布失败计数（esp_mqtt_client_publish 返回错误，按主题）与连接状态
+enum {
+    PUB_TOPIC_STATUS = 0,
+    PUB_TOPIC_BACKLOG,
+    PUB_TOPIC_ALERT,
+    PUB_TOPIC_SHADOW,
+    PUB_TOPIC_DIAG,
+    PUB_TOPIC_OTHER,    ///< model / habit / online / config/state
+    PUB_TOPIC_COUNT,
+};
+static const char *const s_pub_topic_labels[PUB_TOPIC_COUNT] = {
+    "status", "backlog", "alert", "shadow", "diag", "other",
+};
+static MetricCounter s_publish_failures[PUB_TOPIC_COUNT];
+static MetricGauge s_connected_gauge;
+static int64_t s_lease_expire_us = 0;          ///< 租约到期时刻（esp_timer 时基）
+static portMUX_TYPE s_command_lock = portMUX_INITIALIZER_UNLOCKED;
+// 远程命令的"读取当前命令 → 解析 → 生效"整个过程持有（MQTT 任务与本地 HTTP 任务都会提交命令，
+// 只改部分风扇的命令须以最新命令为底，否则并发时后生效的一条会用旧快照覆盖另一条）
+static SemaphoreHandle_t s_command_mutex = NULL;
+// 风扇配置表保存后的延迟重启（单次定时器，MQTT 事件处理函数先返回，告警消息得以发出）
+static esp_timer_handle_t s_restart_timer = NULL;
+
+// 本设备主题（mqtt_client_init 中按 Client ID 生成）
+static char s_device_topic[48];                ///< home/ventilation/<client_id>
+static char s_status_topic[MQTT_TOPIC_MAX_LEN];
+static char s_backlog_topic[MQTT_TOPIC_MAX_LEN];
+static char s_alert_topic[MQTT_TOPIC_MAX_LEN];
+static char s_model_topic[MQTT_TOPIC_MAX_LEN];
+static char s_habit_topic[MQTT_TOPIC_MAX_LEN];
+static char s_diag_topic[MQTT_TOPIC_MAX_LEN];
+static char s_online_topic[MQTT_TOPIC_MAX_LEN];
+static char s_config_topic[MQTT_TOPIC_MAX_LEN];       ///< 本设备配置主题
+static char s_config_state_topic[MQTT_TOPIC_MAX_LEN]; ///< 本设备配置结果主题
+static char s_desired_topic[MQTT_TOPIC_MAX_LEN];
+static char s_reported_topic[MQTT_TOPIC_MAX_LEN];
+static char s_shadow_get_topic[MQTT_TOPIC_MAX_LEN];
+
+// 分组订阅（只在网络任务中访问；s_group_resubscribe 由 MQTT 任务在重连后置位）
+static char s_group_subscribed[RCFG_GROUP_MAX_LEN + 1];
+static volatile bool s_group_resubscribe = false;
+
+// 分片消息重组状态（只在 MQTT 任务中访问）
+static char s_rx_buf[MQTT_RX_BUF_SIZE];
+static char s_rx_topic[MQTT_RX_TOPIC_MAX];
+static int s_rx_topic_len = 0;
+static int s_rx_total = 0;                     ///< 正在重组的消息总长度，0 表示空闲
+static int s_rx_received = 0;
+
 /**
  * @brief FanState 转字符串
  */
@@ -66,58 +173,1078 @@ static const char* system_mode_to_string(SystemMode mode)
     }
 }
 
+/**
+ * @brief RemoteLease 转字符串
+ */
+static const char* remote_lease_to_string(RemoteLease lease)
+{
+    switch (lease) {
+        case LEASE_NONE:
+            return "NONE";
+        case LEASE_VALID:
+            return "VALID";
+        case LEASE_EXPIRED:
+            return "EXPIRED";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief 文本转 FanState（无需 '\0' 结尾，无法识别时为 FAN_OFF）
+ */
+static FanState text_to_fan_state(const char *text, size_t len)
+{
+    if (len == 3 && memcmp(text, "LOW", 3) == 0) return FAN_LOW;
+    if (len == 4 && memcmp(text, "HIGH", 4) == 0) return FAN_HIGH;
+    return FAN_OFF;
+}
+
 /**
  * @brief 字符串转 FanState
  */
 static FanState string_to_fan_state(const char *str)
 {
-    if (strcmp(str, "OFF") == 0) return FAN_OFF;
-    if (strcmp(str, "LOW") == 0) return FAN_LOW;
-    if (strcmp(str, "HIGH") == 0) return FAN_HIGH;
-    return FAN_OFF;
+    return text_to_fan_state(str, strlen(str));
+}
+
+/**
+ * @brief 是否为可识别的档位字符串 "OFF" / "LOW" / "HIGH"
+ */
+static bool is_fan_state_string(const char *str)
+{
+    return strcmp(str, "OFF") == 0 || strcmp(str, "LOW") == 0 || strcmp(str, "HIGH") == 0;
+}
+
+/**
+ * @brief 远程命令键 "fan_N" 对应的风扇编号
+ * @return 风扇编号，不是风扇键或超出风扇数量时返回 -1
+ */
+static int command_fan_index(const char *key, size_t len, uint8_t fan_count)
+{
+    if (len == 5 && memcmp(key, "fan_", 4) == 0 && key[4] >= '0' && key[4] < '0' + fan_count) {
+        return key[4] - '0';
+    }
+    return -1;
+}
+
+/**
+ * @brief 生效远程命令：更新风扇命令并按 ttl 续租（ttl=0 立即释放）
+ */
+static void commit_remote_command(const FanState command[FAN_MAX_COUNT], int ttl)
+{
+    if (ttl < 0) {
+        ttl = 0;
+    } else if (ttl > REMOTE_LEASE_MAX_SEC) {
+        ttl = REMOTE_LEASE_MAX_SEC;
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_command_lock);
+    memcpy(s_remote_command, command, sizeof(s_remote_command));
+    s_lease_expire_us = now + (int64_t)ttl * 1000000;
+    s_command_received = true;
+    portEXIT_CRITICAL(&s_command_lock);
+    ESP_LOGI(TAG, "远程租约%s: %d 秒", ttl > 0 ? "续期" : "释放", ttl);
 }
 
 /**
- * @brief 解析远程命令 JSON（支持多风扇）
+ * @brief 远程命令与 desired 文档共用的字段
  */
-static void parse_remote_command(const char *data, int len)
+typedef struct {
+    FanState command[FAN_MAX_COUNT];  ///< 风扇命令（未出现的风扇沿用当前命令）
+    bool has_command;                 ///< 携带了 fan_N 或 ttl
+    int ttl;                          ///< 租约（秒），未携带时为运行时配置的默认租约
+    int64_t version;                  ///< desired 版本（未携带为 0）
+    int64_t expires;                  ///< desired 到期 Unix 时间（未携带为 0）
+} CommandFields;
+
+static void command_fields_init(CommandFields *f)
+{
+    portENTER_CRITICAL(&s_command_lock);
+    memcpy(f->command, s_remote_command, sizeof(f->command));
+    portEXIT_CRITICAL(&s_command_lock);
+    f->has_command = false;
+    f->ttl = runtime_config_get()->lease_default_sec;
+    f->version = 0;
+    f->expires = 0;
+}
+
+/**
+ * @brief 记录整数字段 ttl / version / expires，其余键忽略
+ */
+static void command_fields_set_int(CommandFields *f, const char *key, size_t len, int64_t value)
+{
+    if (len == 3 && memcmp(key, "ttl", 3) == 0) {
+        f->ttl = value > REMOTE_LEASE_MAX_SEC ? REMOTE_LEASE_MAX_SEC : (int)(value < 0 ? 0 : value);
+        f->has_command = true;
+    } else if (len == 7 && memcmp(key, "version", 7) == 0) {
+        f->version = value;
+    } else if (len == 7 && memcmp(key, "expires", 7) == 0) {
+        f->expires = value;
+    }
+}
+
+/**
+ * @brief 解析 CBOR 远程命令，结构与 JSON 相同：{"fan_0":"HIGH", ..., "ttl":120}
+ * @return false 格式错误
+ */
+static bool parse_command_fields_cbor(const char *data, int len, CommandFields *f)
+{
+    uint8_t fan_count = fan_control_get_count();
+
+    CborReader r;
+    int32_t count;
+    cbor_reader_init(&r, data, len);
+    if (!cbor_reader_enter_map(&r, &count)) {
+        return false;
+    }
+
+    for (int32_t n = 0; count < 0 ? !cbor_reader_at_break(&r) : n < count; n++) {
+        const char *key;
+        size_t key_len;
+        if (!cbor_reader_get_text(&r, &key, &key_len)) {
+            break;
+        }
+
+        int fan = command_fan_index(key, key_len, fan_count);
+        if (fan >= 0 && cbor_reader_peek_type(&r) == 3) {
+            const char *value;
+            size_t value_len;
+            if (!cbor_reader_get_text(&r, &value, &value_len)) {
+                break;
+            }
+            f->command[fan] = text_to_fan_state(value, value_len);
+            f->has_command = true;
+            ESP_LOGI(TAG, "收到远程命令: fan_%d=%s", fan, fan_state_to_string(f->command[fan]));
+        } else if (cbor_reader_peek_type(&r) <= 1) {
+            int64_t value;
+            if (!cbor_reader_get_int(&r, &value)) {
+                break;
+            }
+            command_fields_set_int(f, key, key_len, value);
+        } else if (!cbor_reader_skip(&r)) {
+            break;
+        }
+    }
+    return !r.error;
+}
+
+/**
+ * @brief 解析 JSON 远程命令：一次分词，只提取 fan_N 与整数字段，其余键跳过
+ * @return false 格式错误
+ */
+static bool parse_command_fields_json(const char *data, int len, CommandFields *f)
+{
+    JsonToken tokens[MQTT_COMMAND_MAX_TOKENS];
+    int count = json_scan(data, len, tokens, MQTT_COMMAND_MAX_TOKENS);
+    if (count < 1 || tokens[0].type != JSON_TOK_OBJECT) {
+        ESP_LOGD(TAG, "JSON 分词失败 (%d)", count);
+        return false;
+    }
+
+    uint8_t fan_count = fan_control_get_count();
+
+    // 顶层成员：tokens[i] 为键，tokens[i + 1] 为值
+    for (int i = 1; i + 1 < count; i = json_token_next(tokens, count, i + 1)) {
+        const JsonToken *key = &tokens[i];
+        const JsonToken *value = &tokens[i + 1];
+        int fan = command_fan_index(data + key->start, key->end - key->start, fan_count);
+
+        if (fan >= 0 && value->type == JSON_TOK_STRING) {
+            f->command[fan] = text_to_fan_state(data + value->start, value->end - value->start);
+            f->has_command = true;
+            ESP_LOGI(TAG, "收到远程命令: fan_%d=%s", fan, fan_state_to_string(f->command[fan]));
+        } else {
+            int32_t value_int;
+            if (json_token_get_int(data, value, &value_int)) {
+                command_fields_set_int(f, data + key->start, key->end - key->start, value_int);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析远程命令或 desired 文档（JSON 或 CBOR，按首字节区分）
+ * 直接在接收缓冲区上解析，不分配内存
+ * @return false 格式错误
+ */
+static bool parse_command_fields(const char *data, int len, CommandFields *f)
+{
+    command_fields_init(f);
+    if (len > 0 && cbor_is_map_start((uint8_t)data[0])) {
+        return parse_command_fields_cbor(data, len, f);
+    }
+    return parse_command_fields_json(data, len, f);
+}
+
+/**
+ * @brief 解析远程命令（支持多风扇）
+ * 每条命令续租：携带 "ttl"（秒）时使用该值，否则使用 REMOTE_LEASE_DEFAULT_SEC；
+ * ttl=0 表示立即释放租约，设备回退本地控制
+ */
+static bool parse_remote_command(const char *data, int len)
+{
+    CommandFields f;
+    xSemaphoreTake(s_command_mutex, portMAX_DELAY);
+    bool ok = parse_command_fields(data, len, &f);
+    if (ok && f.has_command) {
+        commit_remote_command(f.command, f.ttl);
+    }
+    xSemaphoreGive(s_command_mutex);
+    if (!ok) {
+        ESP_LOGW(TAG, "远程命令格式错误，忽略");
+    }
+    return ok;
+}
+
+/**
+ * @brief 解析 desired 文档（本设备 shadow/desired 主题，保留消息）
+ * {"version":12, "fan_0":"HIGH", ..., "ttl":600, "expires":1760000000}
+ * 只执行比已执行版本新的文档，重连后 Broker 重发的同一版本不会再次续租；
+ * 携带 "expires"（Unix 时间）且时间已同步时，租约不超过剩余时间，已过期的只登记版本不执行
+ */
+static void apply_shadow_desired(const char *data, int len)
+{
+    CommandFields f;
+    if (!parse_command_fields(data, len, &f) || f.version <= 0 || f.version > UINT32_MAX) {
+        ESP_LOGW(TAG, "desired 文档格式错误或缺少 version，忽略");
+        return;
+    }
+
+    uint32_t version = (uint32_t)f.version;
+    ShadowDesiredResult result = device_shadow_accept_desired(version);
+    if (result != SHADOW_DESIRED_APPLY) {
+        ESP_LOGI(TAG, "desired 版本 %lu %s（已执行 %lu），忽略", (unsigned long)version,
+                 device_shadow_desired_result_to_string(result),
+                 (unsigned long)device_shadow_get_desired_version());
+        return;
+    }
+    if (!f.has_command) {
+        return;
+    }
+
+    int ttl = f.ttl;
+    if (f.expires > 0 && is_time_valid()) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        int64_t remaining = f.expires - tv.tv_sec;
+        if (remaining <= 0) {
+            ESP_LOGW(TAG, "desired 版本 %lu 已过期 %lld 秒，不执行", (unsigned long)version,
+                     (long long)-remaining);
+            return;
+        }
+        if (remaining < ttl) {
+            ttl = (int)remaining;
+        }
+    }
+    ESP_LOGI(TAG, "执行 desired 版本 %lu", (unsigned long)version);
+    commit_remote_command(f.command, ttl);
+}
+
+/**
+ * @brief desired 文档入口：版本判断与生效在 s_command_mutex 内完成
+ */
+static void parse_shadow_desired(const char *data, int len)
+{
+    if (len == 0) {
+        return;  // 后端清除了保留消息
+    }
+    xSemaphoreTake(s_command_mutex, portMAX_DELAY);
+    apply_shadow_desired(data, len);
+    xSemaphoreGive(s_command_mutex);
+}
+
+/**
+ * @brief 解析通风辨识命令 {"action":"start"|"stop"|"reset"|"report"}
+ */
+static void parse_ident_command(const char *data, int len)
 {
     cJSON *root = cJSON_ParseWithLength(data, len);
     if (!root) {
-        ESP_LOGW(TAG, "远程命令 JSON 解析失败");
+        ESP_LOGW(TAG, "辨识命令 JSON 解析失败");
         return;
     }
 
-    bool has_command = false;
+    cJSON *action = cJSON_GetObjectItem(root, "action");
+    if (cJSON_IsString(action)) {
+        ESP_LOGI(TAG, "收到辨识命令: %s", action->valuestring);
+        if (strcmp(action->valuestring, "start") == 0) {
+            vent_ident_request_start();
+        } else if (strcmp(action->valuestring, "stop") == 0) {
+            vent_ident_request_stop();
+        } else if (strcmp(action->valuestring, "reset") == 0) {
+            vent_ident_request_reset();
+        } else if (strcmp(action->valuestring, "report") == 0) {
+            vent_ident_request_report();
+        } else {
+            ESP_LOGW(TAG, "未知辨识命令: %s", action->valuestring);
+        }
+    }
 
-    // 解析 fan_0, fan_1, fan_2
-    for (int i = 0; i < FAN_COUNT; i++) {
-        char key[16];
-        snprintf(key, sizeof(key), "fan_%d", i);
+    cJSON_Delete(root);
+}
+
+/**
+ * @brief 读取 24 项整数数组，超出 [0, max] 返回 false
+ */
+static bool parse_habit_array(cJSON *root, const char *key, int max, int out[24])
+{
+    cJSON *arr = cJSON_GetObjectItem(root, key);
+    if (!cJSON_IsArray(arr) || cJSON_GetArraySize(arr) != 24) {
+        return false;
+    }
+    for (int i = 0; i < 24; i++) {
+        cJSON *item = cJSON_GetArrayItem(arr, i);
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > max) {
+            return false;
+        }
+        out[i] = item->valueint;
+    }
+    return true;
+}
+
+/**
+ * @brief 解析作息命令
+ * {"action":"export"} / {"action":"clear"} /
+ * {"action":"import","day":1,"obs":[24项],"occ":[24项],"gen":[24项]}
+ */
+static void parse_habit_command(const char *data, int len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) {
+        ESP_LOGW(TAG, "作息命令 JSON 解析失败");
+        return;
+    }
+
+    cJSON *action = cJSON_GetObjectItem(root, "action");
+    if (!cJSON_IsString(action)) {
+        ESP_LOGW(TAG, "作息命令缺少 action");
+    } else if (strcmp(action->valuestring, "export") == 0) {
+        occupancy_habit_request_export();
+    } else if (strcmp(action->valuestring, "clear") == 0) {
+        occupancy_habit_clear();
+    } else if (strcmp(action->valuestring, "import") == 0) {
+        cJSON *day = cJSON_GetObjectItem(root, "day");
+        int obs[24], occ[24], gen[24];
+        if (!cJSON_IsNumber(day) ||
+            !parse_habit_array(root, "obs", UINT8_MAX, obs) ||
+            !parse_habit_array(root, "occ", UINT8_MAX, occ) ||
+            !parse_habit_array(root, "gen", UINT16_MAX, gen)) {
+            ESP_LOGW(TAG, "作息导入数据格式错误");
+        } else {
+            HabitBin bins[24];
+            for (int i = 0; i < 24; i++) {
+                bins[i].observed = (uint8_t)obs[i];
+                bins[i].occupied = (uint8_t)occ[i];
+                bins[i].gen_sum = (uint16_t)gen[i];
+            }
+            if (day->valueint < 0 || day->valueint > 6 ||
+                occupancy_habit_import_day((uint8_t)day->valueint, bins) != ESP_OK) {
+                ESP_LOGW(TAG, "作息导入被拒绝: day=%d", day->valueint);
+            }
+        }
+    } else {
+        ESP_LOGW(TAG, "未知作息命令: %s", action->valuestring);
+    }
+
+    cJSON_Delete(root);
+}
+
+/**
+ * @brief 解析 "HH:MM" 为当日分钟数
+ * @param is_end 结束时刻另接受 "24:00"（当天结束，返回 1440）
+ * @return 分钟数，格式错误返回 -1
+ */
+static int parse_clock(const cJSON *item, bool is_end)
+{
+    int hour, minute;
+    if (!cJSON_IsString(item) || sscanf(item->valuestring, "%d:%d", &hour, &minute) != 2) {
+        return -1;
+    }
+    if (is_end && hour == 24 && minute == 0) {
+        return 24 * 60;
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        return -1;
+    }
+    return hour * 60 + minute;
+}
+
+/**
+ * @brief 解析时段表命令
+ * {"periods":[{"days":127,"start":"22:00","end":"08:00","type":"QUIET"},
+ *             {"days":62,"start":"12:00","end":"13:30","type":"CAP","level":"LOW"},
+ *             {"days":1,"start":"00:00","end":"06:00","type":"DISABLED"}]}
+ */
+static void parse_schedule_command(const char *data, int len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) {
+        ESP_LOGW(TAG, "时段表 JSON 解析失败");
+        return;
+    }
+
+    cJSON *list = cJSON_GetObjectItem(root, "periods");
+    int count = cJSON_IsArray(list) ? cJSON_GetArraySize(list) : -1;
+    if (count < 0 || count > SCHEDULE_MAX_PERIODS) {
+        ESP_LOGW(TAG, "时段表格式错误或时段过多（最多 %d 个）", SCHEDULE_MAX_PERIODS);
+        cJSON_Delete(root);
+        return;
+    }
+
+    SchedulePeriod periods[SCHEDULE_MAX_PERIODS];
+    bool valid = true;
+    for (int i = 0; i < count && valid; i++) {
+        cJSON *item = cJSON_GetArrayItem(list, i);
+        cJSON *days = cJSON_GetObjectItem(item, "days");
+        cJSON *type = cJSON_GetObjectItem(item, "type");
+        cJSON *level = cJSON_GetObjectItem(item, "level");
+        int start = parse_clock(cJSON_GetObjectItem(item, "start"), false);
+        int end = parse_clock(cJSON_GetObjectItem(item, "end"), true);
+
+        SchedulePeriod *p = &periods[i];
+        // 先校验范围再收窄（否则 257 截断成 1）
+        bool days_ok = days == NULL || (cJSON_IsNumber(days) && days->valuedouble >= 1 &&
+                                        days->valuedouble <= SCHEDULE_ALL_DAYS &&
+                                        days->valuedouble == (double)days->valueint);
+        p->days = (days != NULL && days_ok) ? (uint8_t)days->valueint : SCHEDULE_ALL_DAYS;
+        p->max_level = cJSON_IsString(level) ? string_to_fan_state(level->valuestring) : FAN_HIGH;
+        p->start_min = (uint16_t)start;
+        p->end_min = (uint16_t)end;
 
-        cJSON *fan_state = cJSON_GetObjectItem(root, key);
-        if (cJSON_IsString(fan_state)) {
-            s_remote_command[i] = string_to_fan_state(fan_state->valuestring);
-            has_command = true;
-            ESP_LOGI(TAG, "收到远程命令: %s=%s", key, fan_state->valuestring);
+        // 无法识别的档位会被 string_to_fan_state 当作 OFF，须整表拒绝
+        bool level_ok = level == NULL || (cJSON_IsString(level) && is_fan_state_string(level->valuestring));
+
+        // 起止相同有歧义（空时段还是全天），须整表拒绝；全天写作 "00:00"-"24:00"
+        if (!cJSON_IsString(type) || start < 0 || end < 0 || start == end || !days_ok || !level_ok) {
+            valid = false;
+        } else if (strcmp(type->valuestring, "QUIET") == 0) {
+            p->type = SCHED_QUIET;
+        } else if (strcmp(type->valuestring, "CAP") == 0) {
+            p->type = SCHED_CAP;
+        } else if (strcmp(type->valuestring, "DISABLED") == 0) {
+            p->type = SCHED_DISABLED;
+        } else {
+            valid = false;
         }
     }
 
-    if (has_command) {
-        s_command_received = true;
+    if (!valid || schedule_set_periods(periods, (uint8_t)count) != ESP_OK) {
+        ESP_LOGW(TAG, "时段表无效，保持原配置");
+    } else {
+        ESP_LOGI(TAG, "收到时段表（%d 个时段）", count);
     }
 
     cJSON_Delete(root);
 }
 
 /**
- * @brief 重连定时器回调（在定时器任务上下文中执行）
+ * @brief 读取可选浮点字段（缺省时保持原值）
+ * @return false 字段存在但不是数字
  */
-static void reconnect_timer_callback(TimerHandle_t xTimer)
+static bool config_get_float(const cJSON *root, const char *key, float *out)
 {
-    if (s_mqtt_client != NULL && !s_mqtt_connected) {
-        ESP_LOGI(TAG, "执行 MQTT 重连...");
-        esp_mqtt_client_reconnect(s_mqtt_client);
+    const cJSON *item = cJSON_GetObjectItem(root, key);
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsNumber(item)) {
+        return false;
+    }
+    *out = (float)item->valuedouble;
+    return true;
+}
+
+/**
+ * @brief 读取可选整数字段（缺省时保持原值）
+ * @return false 字段存在但不是数字或超出 0 ~ max
+ */
+static bool config_get_uint(const cJSON *root, const char *key, int max, uint16_t *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(root, key);
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble < 0 || item->valuedouble > max) {
+        return false;
+    }
+    *out = (uint16_t)item->valueint;
+    return true;
+}
+
+/**
+ * @brief 读取配置版本号（"version" / "rollback"）：1 ~ UINT32_MAX 的整数
+ * 先检查范围再转换，越界或带小数的 double 转 uint32_t 是未定义行为
+ * @return false 缺失、不是数字、不是整数或超出范围
+ */
+static bool config_get_version(const cJSON *item, uint32_t *out)
+{
+    if (!cJSON_IsNumber(item)) {
+        return false;
+    }
+    double v = item->valuedouble;
+    if (!(v >= 1 && v <= UINT32_MAX) || (double)(uint32_t)v != v) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+/**
+ * @brief 读取上报编码 "payload_format": "json" | "cbor"（未出现时保持当前值）
+ * @return false 存在但取值无效
+ */
+static bool config_get_format(const cJSON *root, uint8_t *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(root, "payload_format");
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsString(item)) {
+        return false;
+    }
+    if (strcmp(item->valuestring, "json") == 0) {
+        *out = PAYLOAD_FORMAT_JSON;
+    } else if (strcmp(item->valuestring, "cbor") == 0) {
+        *out = PAYLOAD_FORMAT_CBOR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取上报方式 "report_mode": "interval" | "on_change"（缺省时保持原值）
+ * @return false 字段存在但取值无效
+ */
+static bool config_get_report_mode(const cJSON *root, uint8_t *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(root, "report_mode");
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsString(item)) {
+        return false;
+    }
+    if (strcmp(item->valuestring, report_mode_to_string(REPORT_MODE_INTERVAL)) == 0) {
+        *out = REPORT_MODE_INTERVAL;
+    } else if (strcmp(item->valuestring, report_mode_to_string(REPORT_MODE_ON_CHANGE)) == 0) {
+        *out = REPORT_MODE_ON_CHANGE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取分组名 "group": "floor2"（空串表示退出分组，未出现时保持当前值）
+ * @return false 存在但不是字符串或超长；字符合法性由 runtime_config_validate() 检查
+ */
+static bool config_get_group(const cJSON *root, char out[RCFG_GROUP_MAX_LEN + 1])
+{
+    const cJSON *item = cJSON_GetObjectItem(root, "group");
+    if (!item) {
+        return true;
+    }
+    if (!cJSON_IsString(item) || strlen(item->valuestring) > RCFG_GROUP_MAX_LEN) {
+        return false;
+    }
+    strlcpy(out, item->valuestring, RCFG_GROUP_MAX_LEN + 1);
+    return true;
+}
+
+/**
+ * @brief 解析风扇占空比覆盖
+ * [{"id":0,"low":180,"high":255,"night_low":150,"night_high":200}, {"id":1,"default":true}]
+ * @return false 格式错误
+ */
+static bool config_get_fans(const cJSON *root, RuntimeConfig *cfg)
+{
+    const cJSON *list = cJSON_GetObjectItem(root, "fans");
+    if (!list) {
+        return true;
+    }
+    if (!cJSON_IsArray(list)) {
+        return false;
+    }
+
+    int n = cJSON_GetArraySize(list);
+    for (int i = 0; i < n; i++) {
+        const cJSON *item = cJSON_GetArrayItem(list, i);
+        const cJSON *id = cJSON_GetObjectItem(item, "id");
+        if (!cJSON_IsNumber(id) || id->valueint < 0 || id->valueint >= cfg->fan_count) {
+            return false;
+        }
+        uint8_t bit = 1u << id->valueint;
+
+        // 恢复为风扇配置表中的占空比（提交时重新解析）
+        if (cJSON_IsTrue(cJSON_GetObjectItem(item, "default"))) {
+            cfg->duty_mask &= ~bit;
+            continue;
+        }
+
+        FanDuty *d = &cfg->fan_duty[id->valueint];
+        uint16_t low = d->low, high = d->high, night_low = d->night_low, night_high = d->night_high;
+        if (!config_get_uint(item, "low", UINT8_MAX, &low) ||
+            !config_get_uint(item, "high", UINT8_MAX, &high) ||
+            !config_get_uint(item, "night_low", UINT8_MAX, &night_low) ||
+            !config_get_uint(item, "night_high", UINT8_MAX, &night_high)) {
+            return false;
+        }
+        d->low = (uint8_t)low;
+        d->high = (uint8_t)high;
+        d->night_low = (uint8_t)night_low;
+        d->night_high = (uint8_t)night_high;
+        cfg->duty_mask |= bit;
+    }
+    return true;
+}
+
+/**
+ * @brief 发布配置处理结果（保留消息，后端可随时查询设备当前配置版本）
+ */
+static void publish_config_state(RuntimeConfigResult result, uint32_t requested, const char *field)
+{
+    RuntimeConfig current;
+    runtime_config_copy(&current);
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        return;
+    }
+    cJSON_AddNumberToObject(root, "version", current.version);
+    cJSON_AddNumberToObject(root, "requested", requested);
+    cJSON_AddStringToObject(root, "result", runtime_config_result_to_string(result));
+    if (runtime_config_get_version_floor() > 0) {
+        cJSON_AddNumberToObject(root, "min_version", runtime_config_get_version_floor());
+    }
+    cJSON_AddStringToObject(root, "payload_format",
+                            payload_format_to_string((PayloadFormat)current.payload_format));
+    cJSON_AddStringToObject(root, "group", current.group);
+    cJSON_AddStringToObject(root, "report_mode", report_mode_to_string((ReportMode)current.report_mode));
+    if (field) {
+        cJSON_AddStringToObject(root, "field", field);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json_str) {
+        return;
+    }
+    if (esp_mqtt_client_publish(s_mqtt_client, s_config_state_topic, json_str, 0, 1, 1) < 0) {
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_OTHER]);
+    }
+    cJSON_free(json_str);
+}
+
+/**
+ * @brief 解析配置文档（本设备配置主题）
+ * {"version":7, "co2_low":1000, "co2_high":1200, "publish_interval":60, "fans":[...]}
+ * 未出现的字段保持当前值；{"rollback":6} 回滚到上一版本 v6（幂等，不应以保留消息发送）
+ */
+static void parse_config_command(const char *data, int len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) {
+        ESP_LOGW(TAG, "配置 JSON 解析失败");
+        publish_config_state(RCFG_RESULT_INVALID, 0, "json");
+        return;
+    }
+
+    const cJSON *rollback = cJSON_GetObjectItem(root, "rollback");
+    if (rollback) {
+        uint32_t target;
+        if (config_get_version(rollback, &target)) {
+            publish_config_state(runtime_config_rollback(target), target, NULL);
+        } else {
+            publish_config_state(RCFG_RESULT_INVALID, 0, "rollback");
+        }
+        cJSON_Delete(root);
+        return;
+    }
+
+    RuntimeConfig cfg;
+    runtime_config_copy(&cfg);
+
+    const char *field = NULL;
+    uint32_t requested = 0;
+    if (!config_get_version(cJSON_GetObjectItem(root, "version"), &requested)) {
+        requested = 0;
+        field = "version";
+    } else if (!config_get_float(root, "co2_low", &cfg.co2_low)) {
+        field = "co2_low";
+    } else if (!config_get_float(root, "co2_high", &cfg.co2_high)) {
+        field = "co2_high";
+    } else if (!config_get_float(root, "co2_alert", &cfg.co2_alert)) {
+        field = "co2_alert";
+    } else if (!config_get_float(root, "co2_min_valid", &cfg.co2_min_valid) ||
+               !config_get_float(root, "co2_max_valid", &cfg.co2_max_valid)) {
+        field = "co2_valid";
+    } else if (!config_get_float(root, "temp_min_valid", &cfg.temp_min_valid) ||
+               !config_get_float(root, "temp_max_valid", &cfg.temp_max_valid)) {
+        field = "temp_valid";
+    } else if (!config_get_float(root, "humi_min_valid", &cfg.humi_min_valid) ||
+               !config_get_float(root, "humi_max_valid", &cfg.humi_max_valid)) {
+        field = "humi_valid";
+    } else if (!config_get_uint(root, "publish_interval", UINT16_MAX, &cfg.publish_interval_sec)) {
+        field = "publish_interval";
+    } else if (!config_get_uint(root, "preheat", UINT16_MAX, &cfg.preheat_sec)) {
+        field = "preheat";
+    } else if (!config_get_uint(root, "stabilize", UINT16_MAX, &cfg.stabilize_sec)) {
+        field = "stabilize";
+    } else if (!config_get_uint(root, "lease_default", UINT16_MAX, &cfg.lease_default_sec)) {
+        field = "lease_default";
+    } else if (!config_get_uint(root, "status_batch", UINT16_MAX, &cfg.status_batch_sec)) {
+        field = "status_batch";
+    } else if (!config_get_format(root, &cfg.payload_format)) {
+        field = "payload_format";
+    } else if (!config_get_group(root, cfg.group)) {
+        field = "group";
+    } else if (!config_get_report_mode(root, &cfg.report_mode)) {
+        field = "report_mode";
+    } else if (!config_get_uint(root, "heartbeat", UINT16_MAX, &cfg.heartbeat_sec)) {
+        field = "heartbeat";
+    } else if (!config_get_float(root, "co2_deadband", &cfg.co2_deadband) ||
+               !config_get_float(root, "temp_deadband", &cfg.temp_deadband) ||
+               !config_get_float(root, "humi_deadband", &cfg.humi_deadband)) {
+        field = "deadband";
+    } else if (!config_get_fans(root, &cfg)) {
+        field = "fans";
+    }
+    cJSON_Delete(root);
+
+    RuntimeConfigResult result = RCFG_RESULT_INVALID;
+    if (!field) {
+        cfg.version = requested;
+        result = runtime_config_submit(&cfg, &field);
+    } else {
+        ESP_LOGW(TAG, "配置文档字段 %s 格式错误，保持当前配置", field);
+    }
+    publish_config_state(result, requested, field);
+}
+
+/**
+ * @brief 解析能耗命令
+ * {"filter_reset":[0,2]} 更换滤网后清零滤网计时（"all" 表示所有风扇）
+ * {"curve":{"fan":0,"mw":[0,117,239,562,1200]}} 设置风扇功率曲线
+ */
+static void parse_energy_command(const char *data, int len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) {
+        ESP_LOGW(TAG, "能耗命令 JSON 解析失败");
+        return;
+    }
+
+    cJSON *reset = cJSON_GetObjectItem(root, "filter_reset");
+    if (cJSON_IsString(reset) && strcmp(reset->valuestring, "all") == 0) {
+        fan_energy_reset_filter(UINT32_MAX);
+    } else if (cJSON_IsArray(reset)) {
+        uint32_t mask = 0;
+        int n = cJSON_GetArraySize(reset);
+        for (int i = 0; i < n; i++) {
+            cJSON *id = cJSON_GetArrayItem(reset, i);
+            if (cJSON_IsNumber(id) && id->valueint >= 0 && id->valueint < FAN_MAX_COUNT) {
+                mask |= 1u << id->valueint;
+            }
+        }
+        fan_energy_reset_filter(mask);
+    }
+
+    cJSON *curve = cJSON_GetObjectItem(root, "curve");
+    if (curve) {
+        cJSON *fan = cJSON_GetObjectItem(curve, "fan");
+        cJSON *mw = cJSON_GetObjectItem(curve, "mw");
+        uint16_t points[ENERGY_CURVE_POINTS];
+        bool valid = cJSON_IsNumber(fan) && cJSON_IsArray(mw) && cJSON_GetArraySize(mw) == ENERGY_CURVE_POINTS;
+        for (int i = 0; valid && i < ENERGY_CURVE_POINTS; i++) {
+            cJSON *p = cJSON_GetArrayItem(mw, i);
+            valid = cJSON_IsNumber(p) && p->valuedouble >= 0 && p->valuedouble <= UINT16_MAX;
+            if (valid) {
+                points[i] = (uint16_t)p->valueint;
+            }
+        }
+        if (!valid || fan_energy_set_curve((FanId)fan->valueint, points) != ESP_OK) {
+            ESP_LOGW(TAG, "功率曲线无效（需 %d 个单调不减的 mW 值），保持原曲线", ENERGY_CURVE_POINTS);
+        }
+    }
+
+    cJSON_Delete(root);
+}
+
+/**
+ * @brief 读取风扇配置表中一个整数字段
+ * @param required 必填字段（未出现时返回 false）；选填字段未出现时保持原值
+ * @return false 缺少必填字段，或不是数字、超出 0 ~ max
+ */
+static bool fan_config_get_field(const cJSON *fan, const char *key, int max, bool required, uint16_t *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(fan, key);
+    if (!item) {
+        return !required;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble < 0 || item->valuedouble > max ||
+        item->valuedouble != (double)item->valueint) {
+        return false;
+    }
+    *out = (uint16_t)item->valueint;
+    return true;
+}
+
+/**
+ * @brief 解析风扇配置表命令，校验后写入 NVS fan_config/table（重启后生效）
+ * {"fans":[{"gpio":36,"channel":0,"min_duty":150,"max_duty":255,"low_duty":180,"high_duty":255,
+ *           "night_low_duty":150,"night_high_duty":200,"tach_gpio":4,"pulses_per_rev":2,
+ *           "low_rpm":0,"high_rpm":0,"night_low_rpm":0,"night_high_rpm":0}, ...], "restart":true}
+ * tach_gpio 缺省为无转速计，pulses_per_rev 缺省 2，各 *_rpm 缺省 0（开环）；
+ * 处理结果以告警消息上报，"restart":true 时保存成功后重启使新表生效
+ */
+static void parse_fan_config_command(const char *data, int len)
+{
+    static const char *const duty_keys[] = {
+        "gpio", "channel", "min_duty", "max_duty", "low_duty", "high_duty", "night_low_duty", "night_high_duty",
+    };
+    static const char *const rpm_keys[] = {"low_rpm", "high_rpm", "night_low_rpm", "night_high_rpm"};
+    char msg[96];
+
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) {
+        ESP_LOGW(TAG, "风扇配置表 JSON 解析失败");
+        mqtt_publish_alert("风扇配置表无效（json），未保存");
+        return;
+    }
+
+    const cJSON *list = cJSON_GetObjectItem(root, "fans");
+    int count = cJSON_IsArray(list) ? cJSON_GetArraySize(list) : 0;
+    FanConfig fans[FAN_MAX_COUNT];
+    const char *field = (count < 1 || count > FAN_MAX_COUNT) ? "fans" : NULL;
+    int bad_fan = -1;
+
+    for (int i = 0; field == NULL && i < count; i++) {
+        const cJSON *fan = cJSON_GetArrayItem(list, i);
+        uint16_t v[8];
+        uint16_t tach = FAN_TACH_GPIO_NONE;
+        uint16_t ppr = 2;
+        uint16_t rpm[4] = {0};
+
+        for (int k = 0; field == NULL && k < 8; k++) {
+            if (!fan_config_get_field(fan, duty_keys[k], UINT8_MAX, true, &v[k])) {
+                field = duty_keys[k];
+            }
+        }
+        if (field == NULL && !fan_config_get_field(fan, "tach_gpio", UINT8_MAX, false, &tach)) {
+            field = "tach_gpio";
+        }
+        if (field == NULL && !fan_config_get_field(fan, "pulses_per_rev", UINT8_MAX, false, &ppr)) {
+            field = "pulses_per_rev";
+        }
+        for (int k = 0; field == NULL && k < 4; k++) {
+            if (!fan_config_get_field(fan, rpm_keys[k], UINT16_MAX, false, &rpm[k])) {
+                field = rpm_keys[k];
+            }
+        }
+        if (field != NULL) {
+            bad_fan = i;
+            break;
+        }
+
+        fans[i] = (FanConfig){
+            .gpio = v[0], .channel = v[1], .min_duty = v[2], .max_duty = v[3],
+            .low_duty = v[4], .high_duty = v[5], .night_low_duty = v[6], .night_high_duty = v[7],
+            .tach_gpio = tach, .pulses_per_rev = ppr,
+            .low_rpm = rpm[0], .high_rpm = rpm[1], .night_low_rpm = rpm[2], .night_high_rpm = rpm[3],
+        };
+    }
+    bool restart = cJSON_IsTrue(cJSON_GetObjectItem(root, "restart"));
+    cJSON_Delete(root);
+
+    if (field != NULL) {
+        if (bad_fan >= 0) {
+            snprintf(msg, sizeof(msg), "风扇配置表无效（fan_%d.%s），未保存", bad_fan, field);
+        } else {
+            snprintf(msg, sizeof(msg), "风扇配置表无效（%s），未保存", field);
+        }
+        ESP_LOGW(TAG, "%s", msg);
+        mqtt_publish_alert(msg);
+        return;
+    }
+
+    // GPIO / 通道 / 占空比 / 转速计的组合校验与开机加载相同（fan_validate_config）
+    esp_err_t err = fan_control_save_config(fans, (uint8_t)count);
+    if (err != ESP_OK) {
+        snprintf(msg, sizeof(msg), "风扇配置表%s，未保存", err == ESP_ERR_INVALID_ARG ? "校验失败" : "写入失败");
+        mqtt_publish_alert(msg);
+        return;
+    }
+    // 不在事件处理函数中等待：重启交给单次定时器，处理函数返回后 MQTT 任务才能把告警发出去
+    // （ESP_ERR_INVALID_STATE：上一条命令的重启已在等待）
+    if (restart) {
+        err = esp_timer_start_once(s_restart_timer, (uint64_t)MQTT_FAN_CONFIG_RESTART_DELAY_MS * 1000);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "重启定时器启动失败 (%d)，风扇配置表重启后生效", err);
+            restart = false;
+        }
+    }
+    snprintf(msg, sizeof(msg), "风扇配置表已保存（%d 个风扇），%s", count, restart ? "即将重启" : "重启后生效");
+    mqtt_publish_alert(msg);
+}
+
+/**
+ * @brief 风扇配置表延迟重启定时器回调（esp_timer 任务上下文）
+ */
+static void fan_config_restart_callback(void *arg)
+{
+    ESP_LOGW(TAG, "风扇配置表已更新，重启");
+    esp_restart();
+}
+
+/**
+ * @brief 判断事件主题是否与给定主题完全一致（事件主题不以 '\0' 结尾）
+ */
+static bool topic_equals(const char *topic, int topic_len, const char *expected)
+{
+    size_t len = strlen(expected);
+    return topic_len == (int)len && strncmp(topic, expected, len) == 0;
+}
+
+/**
+ * @brief 主题是否为 <ns>/command 或 <ns>/command/...
+ * @param[out] sub 子命令部分（风扇命令为空串，不以 '\0' 结尾）
+ * @param[out] sub_len 子命令长度
+ */
+static bool match_command_ns(const char *topic, int topic_len, const char *ns,
+                             const char **sub, int *sub_len)
+{
+    int ns_len = strlen(ns);
+    int cmd_len = sizeof(MQTT_SUFFIX_COMMAND) - 1;
+    if (topic_len < ns_len + cmd_len || strncmp(topic, ns, ns_len) != 0 ||
+        strncmp(topic + ns_len, MQTT_SUFFIX_COMMAND, cmd_len) != 0) {
+        return false;
+    }
+    *sub = topic + ns_len + cmd_len;
+    *sub_len = topic_len - ns_len - cmd_len;
+    return *sub_len == 0 || **sub == '/';
+}
+
+/**
+ * @brief 判断命令主题发往本设备、所在分组还是全体设备
+ * @return 命名空间名称（日志用），不是发给本设备的命令时返回 NULL
+ */
+static const char *match_command_topic(const char *topic, int topic_len, const char **sub, int *sub_len)
+{
+    if (match_command_ns(topic, topic_len, s_device_topic, sub, sub_len)) {
+        return "device";
+    }
+
+    const char *group = runtime_config_get()->group;
+    if (group[0] != '\0') {
+        char ns[MQTT_TOPIC_MAX_LEN];
+        snprintf(ns, sizeof(ns), MQTT_TOPIC_GROUP_FMT, group);
+        if (match_command_ns(topic, topic_len, ns, sub, sub_len)) {
+            return "group";
+        }
+    }
+
+#if CONFIG_MQTT_BROADCAST_COMMANDS
+    if (match_command_ns(topic, topic_len, MQTT_TOPIC_BROADCAST, sub, sub_len)) {
+        return "broadcast";
+    }
+#endif
+    return NULL;
+}
+
+/**
+ * @brief 按主题分发一条完整消息
+ * 分组命令按当前配置的分组名匹配，切换分组后旧分组残留的消息会被忽略
+ */
+static void dispatch_message(const char *topic, int topic_len, const char *data, int len)
+{
+    if (topic_equals(topic, topic_len, s_config_topic)) {
+        parse_config_command(data, len);
+        return;
+    }
+    if (topic_equals(topic, topic_len, s_desired_topic)) {
+        parse_shadow_desired(data, len);
+        return;
+    }
+    if (topic_equals(topic, topic_len, s_shadow_get_topic)) {
+        device_shadow_request_full();
+        return;
+    }
+
+    const char *sub;
+    int sub_len;
+    const char *scope = match_command_topic(topic, topic_len, &sub, &sub_len);
+    if (scope == NULL) {
+        ESP_LOGD(TAG, "忽略主题 %.*s", topic_len, topic);
+        return;
+    }
+    ESP_LOGD(TAG, "收到%s命令: %.*s", scope, topic_len, topic);
+
+    if (sub_len == 0) {
+        parse_remote_command(data, len);
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_IDENT_CMD)) {
+        parse_ident_command(data, len);
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_HABIT_CMD)) {
+        parse_habit_command(data, len);
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_SCHEDULE)) {
+        parse_schedule_command(data, len);
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_ENERGY_CMD)) {
+        parse_energy_command(data, len);
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_DIAG_CMD)) {
+        diagnostics_request_report();  // 消息内容忽略
+    } else if (topic_equals(sub, sub_len, MQTT_SUFFIX_FAN_CONFIG)) {
+        // 接线与设备一一对应，分组与广播命令不执行
+        if (strcmp(scope, "device") == 0) {
+            parse_fan_config_command(data, len);
+        } else {
+            ESP_LOGW(TAG, "风扇配置表只接受发往本设备的命令，忽略%s命令", scope);
+        }
+    }
+}
+
+/**
+ * @brief 处理 MQTT_EVENT_DATA
+ * 完整消息直接在 esp-mqtt 接收缓冲区上解析；超过接收缓冲区的消息分多次投递，
+ * 只有第一片带主题，按 current_data_offset 拼接到 s_rx_buf，收齐后再分发。
+ */
+static void handle_data_event(esp_mqtt_event_handle_t event)
+{
+    if (event->current_data_offset == 0 && event->data_len >= event->total_data_len) {
+        s_rx_total = 0;
+        dispatch_message(event->topic, event->topic_len, event->data, event->data_len);
+        return;
+    }
+
+    if (event->current_data_offset == 0) {
+        // 第一片：记录主题（后续分片不带主题）
+        s_rx_total = 0;
+        if (event->total_data_len > MQTT_RX_BUF_SIZE || event->topic_len > MQTT_RX_TOPIC_MAX) {
+            ESP_LOGW(TAG, "消息过大（%d 字节），丢弃", event->total_data_len);
+            return;
+        }
+        memcpy(s_rx_topic, event->topic, event->topic_len);
+        s_rx_topic_len = event->topic_len;
+        s_rx_total = event->total_data_len;
+        s_rx_received = 0;
+    } else if (s_rx_total == 0) {
+        return;  // 所属消息已丢弃
+    }
+
+    if (event->current_data_offset != s_rx_received ||
+        event->data_len > s_rx_total - s_rx_received) {
+        ESP_LOGW(TAG, "分片不连续（偏移 %d，已收 %d），丢弃", event->current_data_offset, s_rx_received);
+        s_rx_total = 0;
+        return;
+    }
+    memcpy(s_rx_buf + s_rx_received, event->data, event->data_len);
+    s_rx_received += event->data_len;
+
+    if (s_rx_received == s_rx_total) {
+        s_rx_total = 0;
+        dispatch_message(s_rx_topic, s_rx_topic_len, s_rx_buf, s_rx_received);
     }
 }
 
@@ -129,28 +1256,52 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t) event_data;
 
     switch (event_id) {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            conn_supervisor_on_broker_attempt();
+            break;
+
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT 连接成功");
             s_mqtt_connected = true;
+            metric_gauge_set(&s_connected_gauge, 1);
+            conn_supervisor_on_broker_up();
 
-            // 停止重连定时器（如果正在运行）
-            if (s_reconnect_timer != NULL && xTimerIsTimerActive(s_reconnect_timer)) {
-                xTimerStop(s_reconnect_timer, 0);
+            // 在线状态（保留消息，异常掉线时由遗嘱覆盖为 false）
+            if (esp_mqtt_client_publish(s_mqtt_client, s_online_topic, MQTT_ONLINE_MSG, 0, 1, 1) < 0) {
+                metric_counter_inc(&s_publish_failures[PUB_TOPIC_OTHER]);
             }
 
-            // 订阅远程命令主题
-            esp_mqtt_client_subscribe(s_mqtt_client, MQTT_TOPIC_COMMAND, 1);
+            // 订阅本设备命令、配置与 desired 主题（配置与 desired 为保留消息，重连后自动补收）
+            {
+                char filter[MQTT_TOPIC_MAX_LEN];
+                snprintf(filter, sizeof(filter), "%s" MQTT_SUFFIX_COMMAND "/#", s_device_topic);
+                esp_mqtt_client_subscribe(s_mqtt_client, filter, 1);
+            }
+            esp_mqtt_client_subscribe(s_mqtt_client, s_config_topic, 1);
+            esp_mqtt_client_subscribe(s_mqtt_client, s_desired_topic, 1);
+            esp_mqtt_client_subscribe(s_mqtt_client, s_shadow_get_topic, 1);
+#if CONFIG_MQTT_BROADCAST_COMMANDS
+            esp_mqtt_client_subscribe(s_mqtt_client, MQTT_TOPIC_BROADCAST MQTT_SUFFIX_COMMAND "/#", 1);
+#endif
+            // 分组主题由网络任务在 mqtt_client_sync_group() 中订阅
+            s_group_resubscribe = true;
+
+            // 连接后上报一次通风模型与完整 reported（后端据此与 desired 对账）
+            vent_ident_request_report();
+            device_shadow_request_full();
             break;
 
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "MQTT 连接断开");
             s_mqtt_connected = false;
+            metric_gauge_set(&s_connected_gauge, 0);
+            s_rx_total = 0;  // 未收齐的分片消息作废
 
-            // 启动重连定时器（30 秒后重连）
-            if (s_reconnect_timer != NULL) {
-                ESP_LOGI(TAG, "将在 %d 秒后重连 MQTT...", MQTT_RECONNECT_DELAY_MS / 1000);
-                xTimerStart(s_reconnect_timer, 0);
-            }
+            // 未确认的补传批次重连后重新发送
+            telemetry_buffer_on_disconnected();
+
+            // 连接失败也会收到本事件，由连接监管按退避安排重连
+            conn_supervisor_on_broker_down();
             break;
 
         case MQTT_EVENT_SUBSCRIBED:
@@ -158,14 +1309,12 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             break;
 
         case MQTT_EVENT_DATA:
-            // 处理接收到的消息
-            if (event->topic_len > 0 && strncmp(event->topic, MQTT_TOPIC_COMMAND, event->topic_len) == 0) {
-                parse_remote_command(event->data, event->data_len);
-            }
+            handle_data_event(event);
             break;
 
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "MQTT 发布成功，msg_id=%d", event->msg_id);
+            telemetry_buffer_on_published(event->msg_id);
             break;
 
         case MQTT_EVENT_ERROR:
@@ -183,6 +1332,27 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
+/**
+ * @brief 按状态上报节奏选择 keepalive（秒）
+ *
+ * esp-mqtt 距上次发送报文满 keepalive / 2 才发 PINGREQ。取最长上报静默（定时模式为
+ * publish_interval，变化模式为 heartbeat）的 2 倍再加余量，正常上报时不再为心跳单独唤醒射频。
+ * keepalive 随 CONNECT 报文发给 Broker，运行中修改上报间隔要到重启后才更新（期间按旧值，
+ * 静默超过旧值一半时照常发 PINGREQ，不影响连接）。
+ */
+static int keepalive_for_report_cadence(void)
+{
+    const RuntimeConfig *cfg = runtime_config_get();
+    uint32_t silence = cfg->report_mode == REPORT_MODE_ON_CHANGE ? cfg->heartbeat_sec : cfg->publish_interval_sec;
+    uint32_t keepalive = 2 * silence + MQTT_KEEPALIVE_MARGIN_SEC;
+    if (keepalive < MQTT_KEEPALIVE_MIN_SEC) {
+        keepalive = MQTT_KEEPALIVE_MIN_SEC;
+    } else if (keepalive > MQTT_KEEPALIVE_MAX_SEC) {
+        keepalive = MQTT_KEEPALIVE_MAX_SEC;
+    }
+    return (int)keepalive;
+}
+
 esp_err_t mqtt_client_init(void)
 {
     ESP_LOGI(TAG, "初始化 MQTT 客户端（EMQX Cloud TLS）");
@@ -201,8 +1371,55 @@ esp_err_t mqtt_client_init(void)
 
     ESP_LOGI(TAG, "MQTT Client ID: %s", client_id);
 
-    // 配置遗嘱消息（设备异常掉线时发送）
-    static const char *lwt_msg = "{\"online\": false}";
+    if (s_command_mutex == NULL) {
+        s_command_mutex = xSemaphoreCreateMutex();
+        if (s_command_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_restart_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = fan_config_restart_callback,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "fan_cfg_restart",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &s_restart_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "创建重启定时器失败 (%d)", err);
+            return err;
+        }
+    }
+
+    metrics_register_counter(s_publish_failures, PUB_TOPIC_COUNT, "mqtt_publish_failures_total",
+                             "MQTT 发布调用失败次数", "topic", s_pub_topic_labels);
+    metrics_register_gauge(&s_connected_gauge, "mqtt_connected", "MQTT 是否已连接（1 / 0）");
+
+    snprintf(s_device_topic, sizeof(s_device_topic), MQTT_TOPIC_ROOT "/%s", client_id);
+    snprintf(s_status_topic, sizeof(s_status_topic), "%s" MQTT_SUFFIX_STATUS, s_device_topic);
+    snprintf(s_backlog_topic, sizeof(s_backlog_topic), "%s" MQTT_SUFFIX_BACKLOG, s_device_topic);
+    snprintf(s_alert_topic, sizeof(s_alert_topic), "%s" MQTT_SUFFIX_ALERT, s_device_topic);
+    snprintf(s_model_topic, sizeof(s_model_topic), "%s" MQTT_SUFFIX_MODEL, s_device_topic);
+    snprintf(s_habit_topic, sizeof(s_habit_topic), "%s" MQTT_SUFFIX_HABIT, s_device_topic);
+    snprintf(s_diag_topic, sizeof(s_diag_topic), "%s" MQTT_SUFFIX_DIAG, s_device_topic);
+    snprintf(s_online_topic, sizeof(s_online_topic), "%s" MQTT_SUFFIX_ONLINE, s_device_topic);
+    snprintf(s_config_topic, sizeof(s_config_topic), "%s" MQTT_SUFFIX_CONFIG, s_device_topic);
+    snprintf(s_config_state_topic, sizeof(s_config_state_topic), "%s/state", s_config_topic);
+    snprintf(s_desired_topic, sizeof(s_desired_topic), "%s" MQTT_SUFFIX_DESIRED, s_device_topic);
+    snprintf(s_reported_topic, sizeof(s_reported_topic), "%s" MQTT_SUFFIX_REPORTED, s_device_topic);
+    snprintf(s_shadow_get_topic, sizeof(s_shadow_get_topic), "%s" MQTT_SUFFIX_SHADOW_GET, s_device_topic);
+
+    // mqtts:// 使用自定义 TLS 传输（重连复用会话，证书校验见 mqtt_tls.c）
+    esp_transport_handle_t transport = NULL;
+    if (strncmp(broker_url, "mqtts://", 8) == 0) {
+        transport = mqtt_tls_transport_create(MQTT_TLS_DEFAULT_PORT);
+        if (transport == NULL) {
+            ESP_LOGE(TAG, "创建 TLS 传输失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    int keepalive = keepalive_for_report_cadence();
+    ESP_LOGI(TAG, "MQTT keepalive: %d 秒", keepalive);
 
     // 配置 MQTT 客户端（简化配置，参考 ESP-IDF 示例）
     const esp_mqtt_client_config_t mqtt_cfg = {
@@ -210,9 +1427,10 @@ esp_err_t mqtt_client_init(void)
             .address = {
                 .uri = broker_url,
             },
-            .verification = {
-                .crt_bundle_attach = esp_crt_bundle_attach,
-            },
+        },
+        .network = {
+            .transport = transport,  // 由 esp_mqtt_client_destroy() 释放
+            .disable_auto_reconnect = true,  // 重连由 conn_supervisor 调度
         },
         .credentials = {
             .username = username,
@@ -222,12 +1440,14 @@ esp_err_t mqtt_client_init(void)
             },
         },
         .session = {
+            .keepalive = keepalive,
+            // 遗嘱消息（设备异常掉线时由 Broker 发布到本设备 online 主题）
             .last_will = {
-                .topic = MQTT_TOPIC_STATUS,
-                .msg = lwt_msg,
-                .msg_len = strlen(lwt_msg),
+                .topic = s_online_topic,
+                .msg = MQTT_OFFLINE_MSG,
+                .msg_len = sizeof(MQTT_OFFLINE_MSG) - 1,
                 .qos = 1,
-                .retain = 0,  // int 类型
+                .retain = 1,  // int 类型
             },
         },
     };
@@ -235,31 +1455,19 @@ esp_err_t mqtt_client_init(void)
     s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
     if (s_mqtt_client == NULL) {
         ESP_LOGE(TAG, "MQTT 客户端初始化失败");
+        if (transport != NULL) {
+            esp_transport_destroy(transport);
+        }
         return ESP_FAIL;
     }
 
     // 注册事件处理器
     esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
 
-    // 创建重连定时器（30 秒超时，单次触发）
-    s_reconnect_timer = xTimerCreate("mqtt_reconnect",
-                                     pdMS_TO_TICKS(MQTT_RECONNECT_DELAY_MS),
-                                     pdFALSE,  // 单次触发
-                                     NULL,
-                                     reconnect_timer_callback);
-    if (s_reconnect_timer == NULL) {
-        ESP_LOGE(TAG, "创建重连定时器失败");
-        esp_mqtt_client_destroy(s_mqtt_client);
-        s_mqtt_client = NULL;
-        return ESP_FAIL;
-    }
-
     // 启动 MQTT 客户端
     esp_err_t err = esp_mqtt_client_start(s_mqtt_client);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "MQTT 客户端启动失败: %s", esp_err_to_name(err));
-        xTimerDelete(s_reconnect_timer, 0);
-        s_reconnect_timer = NULL;
         esp_mqtt_client_destroy(s_mqtt_client);
         s_mqtt_client = NULL;
         return ESP_FAIL;
@@ -269,63 +1477,221 @@ esp_err_t mqtt_client_init(void)
     return ESP_OK;
 }
 
-esp_err_t mqtt_publish_status(SensorData *sensor, const FanState fans[FAN_COUNT], SystemMode mode)
+esp_err_t mqtt_client_reconnect(void)
 {
-    if (!sensor) {
-        return ESP_ERR_INVALID_ARG;
+    if (s_mqtt_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
+    if (s_mqtt_connected) {
+        return ESP_OK;
+    }
+    // 客户端正在连接（不处于等待重连状态）时返回失败，本次尝试的结果仍会通知连接监管
+    return esp_mqtt_client_reconnect(s_mqtt_client);
+}
 
-    if (!s_mqtt_connected) {
-        ESP_LOGW(TAG, "MQTT 未连接，跳过状态发布");
-        return ESP_FAIL;
+/**
+ * @brief 输出增量编码列：第一个值为绝对值，其后为与上一个有效值之差，缺测为 null
+ */
+static void write_delta_column(PayloadWriter *w, const char *key, const int16_t col[], int count)
+{
+    payload_writer_begin_array(w, key);
+    bool have_prev = false;
+    int prev = 0;
+    for (int i = 0; i < count; i++) {
+        if (col[i] == STATUS_BATCH_GAP) {
+            payload_writer_add_null(w, NULL);
+            continue;
+        }
+        payload_writer_add_int(w, NULL, have_prev ? col[i] - prev : col[i]);
+        prev = col[i];
+        have_prev = true;
     }
+    payload_writer_end_array(w);
+}
 
-    // 构建 JSON 消息
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        ESP_LOGE(TAG, "创建 JSON 对象失败");
-        return ESP_FAIL;
+/**
+ * @brief 输出批量样本 "series"：数值列增量编码，风扇与模式只输出变化点 [样本序号, 状态...]
+ */
+static void write_status_series(PayloadWriter *w, const StatusBatch *batch, uint8_t fan_count)
+{
+    payload_writer_begin_object(w, "series");
+    payload_writer_add_int(w, "t0", batch->t0);
+    payload_writer_add_int(w, "step", batch->step_sec);
+    write_delta_column(w, "co2", batch->co2, batch->count);
+    write_delta_column(w, "temp", batch->temp, batch->count);
+    write_delta_column(w, "humi", batch->humi, batch->count);
+
+    payload_writer_begin_array(w, "fans");
+    for (int i = 0; i < batch->count; i++) {
+        if (i == 0 || batch->fans[i] != batch->fans[i - 1]) {
+            payload_writer_begin_array(w, NULL);
+            payload_writer_add_int(w, NULL, i);
+            for (int f = 0; f < fan_count; f++) {
+                payload_writer_add_string(w, NULL,
+                                          fan_state_to_string(status_batch_get_fan(batch, i, (FanId)f)));
+            }
+            payload_writer_end_array(w);
+        }
     }
+    payload_writer_end_array(w);
 
-    cJSON_AddNumberToObject(root, "co2", sensor->pollutants.co2);
-    cJSON_AddNumberToObject(root, "temp", sensor->temperature);
-    cJSON_AddNumberToObject(root, "humi", sensor->humidity);
+    payload_writer_begin_array(w, "mode");
+    for (int i = 0; i < batch->count; i++) {
+        if (i == 0 || batch->mode[i] != batch->mode[i - 1]) {
+            payload_writer_begin_array(w, NULL);
+            payload_writer_add_int(w, NULL, i);
+            payload_writer_add_string(w, NULL, system_mode_to_string((SystemMode)batch->mode[i]));
+            payload_writer_end_array(w);
+        }
+    }
+    payload_writer_end_array(w);
+    payload_writer_end_object(w);
+}
+
+/**
+ * @brief 生成状态消息（JSON 或 CBOR）
+ * @return 长度，缓冲区不足时返回 -1
+ */
+static int build_status(PayloadFormat format, void *buf, size_t size, const SensorData *sensor,
+                        const FanState fans[], uint8_t fan_count, SystemMode mode, ModeReason reason,
+                        const StatusBatch *batch)
+{
+    PayloadWriter w;
+    payload_writer_init(&w, format, buf, size);
+    payload_writer_begin_object(&w, NULL);
+
+    payload_writer_add_fixed(&w, "co2", sensor->pollutants.co2, 2);
+    payload_writer_add_fixed(&w, "temp", sensor->temperature, 2);
+    payload_writer_add_fixed(&w, "humi", sensor->humidity, 2);
 
-    // 添加3个风扇状态
-    for (int i = 0; i < FAN_COUNT; i++) {
+    // 添加各风扇状态（配置了转速计的风扇附带实测转速和健康状态）
+    for (int i = 0; i < fan_count; i++) {
         char key[16];
         snprintf(key, sizeof(key), "fan_%d", i);
-        cJSON_AddStringToObject(root, key, fan_state_to_string(fans[i]));
+        payload_writer_add_string(&w, key, fan_state_to_string(fans[i]));
+
+        const char *health = fan_tach_health_to_string(fan_tach_get_health((FanId)i));
+        if (health != NULL) {
+            snprintf(key, sizeof(key), "fan_%d_rpm", i);
+            payload_writer_add_int(&w, key, fan_tach_get_rpm((FanId)i));
+            snprintf(key, sizeof(key), "fan_%d_tach", i);
+            payload_writer_add_string(&w, key, health);
+        }
+
+        FanEnergyStats energy;
+        if (fan_energy_get((FanId)i, &energy) == ESP_OK) {
+            snprintf(key, sizeof(key), "fan_%d_on_h", i);
+            payload_writer_add_fixed(&w, key, energy.on_hours, 1);
+            snprintf(key, sizeof(key), "fan_%d_wh", i);
+            payload_writer_add_fixed(&w, key, energy.energy_wh, 1);
+            snprintf(key, sizeof(key), "fan_%d_starts", i);
+            payload_writer_add_int(&w, key, energy.starts);
+            snprintf(key, sizeof(key), "fan_%d_filter", i);
+            payload_writer_add_int(&w, key, energy.filter_remaining);
+        }
+    }
+
+    payload_writer_add_string(&w, "mode", system_mode_to_string(mode));
+    payload_writer_add_string(&w, "mode_reason", decision_mode_reason_to_string(reason));
+
+    TelemetryStats backlog;
+    telemetry_buffer_get_stats(&backlog);
+    payload_writer_add_int(&w, "backlog", backlog.ram_depth + backlog.flash_depth);
+    payload_writer_add_int(&w, "backlog_dropped", backlog.dropped);
+
+    // 上报统计：trigger 为本条的触发原因，report_sent 为此前已生成的条数，
+    // report_baseline 为定时模式同期应生成的条数
+    ReportStats report;
+    report_policy_get_stats(&report);
+    payload_writer_add_string(&w, "trigger", report_trigger_to_string(report.last_trigger));
+    payload_writer_add_int(&w, "report_sent", report.sent);
+    payload_writer_add_int(&w, "report_baseline", report.baseline);
+
+    // 连接统计：outages 为断线次数，其余为最近一次恢复中各阶段耗时（毫秒）
+    ConnStats conn;
+    conn_supervisor_get_stats(&conn);
+    payload_writer_begin_object(&w, "conn");
+    payload_writer_add_int(&w, "outages", conn.outages);
+    payload_writer_add_int(&w, "restore_ms", conn.last_ms[CONN_PHASE_UP]);
+    payload_writer_add_int(&w, "wifi_ms", conn.last_ms[CONN_PHASE_LINK]);
+    payload_writer_add_int(&w, "ip_ms", conn.last_ms[CONN_PHASE_IP]);
+    payload_writer_add_int(&w, "tls_ms", conn.last_ms[CONN_PHASE_TLS]);
+    payload_writer_add_int(&w, "mqtt_ms", conn.last_ms[CONN_PHASE_MQTT]);
+    payload_writer_add_int(&w, "boot_ip_ms", conn.boot_ip_ms);
+    payload_writer_add_int(&w, "boot_mqtt_ms", conn.boot_mqtt_ms);
+    WifiFastStats fast;
+    wifi_manager_get_fast_stats(&fast);
+    payload_writer_add_bool(&w, "wifi_fast", fast.last_fast);
+    payload_writer_add_int(&w, "wifi_fast_fallbacks", fast.fallbacks);
+    payload_writer_end_object(&w);
+
+#if CONFIG_POWER_MEASURE
+    // 功耗测量：最近一个统计窗口的 CPU 空闲率、高频占比与估算电流（首个窗口结束前不附带）
+    PowerStats power;
+    power_manager_get_stats(&power);
+    if (power.measured) {
+        payload_writer_begin_object(&w, "power");
+        payload_writer_add_int(&w, "cpu_mhz_min", power.cpu_min_mhz);
+        payload_writer_add_int(&w, "cpu_mhz_max", power.cpu_max_mhz);
+        payload_writer_add_fixed(&w, "idle_pct", power.idle_pct, 1);
+        payload_writer_add_fixed(&w, "burst_pct", power.burst_pct, 2);
+        payload_writer_add_fixed(&w, "est_ma", power.est_ma, 1);
+        payload_writer_add_int(&w, "oled_skipped", oled_display_get_skipped_frames());
+        payload_writer_end_object(&w);
     }
+#endif
 
-    cJSON_AddStringToObject(root, "mode", system_mode_to_string(mode));
+    if (batch) {
+        write_status_series(&w, batch, fan_count);
+    }
 
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    cJSON_AddNumberToObject(root, "timestamp", tv.tv_sec);
+    payload_writer_add_int(&w, "timestamp", tv.tv_sec);
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    if (json_str == NULL) {
-        ESP_LOGE(TAG, "序列化 JSON 失败");
-        cJSON_Delete(root);
+    payload_writer_end_object(&w);
+    return payload_writer_finish(&w);
+}
+
+esp_err_t mqtt_publish_status(SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                              SystemMode mode, ModeReason reason, const StatusBatch *batch)
+{
+    if (!sensor || !fans || fan_count > FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_mqtt_connected) {
+        ESP_LOGW(TAG, "MQTT 未连接，跳过状态发布");
+        return ESP_FAIL;
+    }
+
+    // 只由网络任务调用，使用静态缓冲区
+    static char s_status_buf[MQTT_STATUS_BUF_SIZE];
+    PayloadFormat format = (PayloadFormat)runtime_config_get()->payload_format;
+    int len = build_status(format, s_status_buf, sizeof(s_status_buf), sensor, fans, fan_count,
+                           mode, reason, batch);
+    if (len < 0 && batch) {
+        ESP_LOGW(TAG, "状态消息超出 %d 字节，本次不附带批量样本", MQTT_STATUS_BUF_SIZE);
+        len = build_status(format, s_status_buf, sizeof(s_status_buf), sensor, fans, fan_count,
+                           mode, reason, NULL);
+    }
+    if (len < 0) {
+        ESP_LOGE(TAG, "生成状态消息失败（缓冲区不足）");
         return ESP_FAIL;
     }
 
     // 发布消息（QoS 0）
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, MQTT_TOPIC_STATUS, json_str, 0, 0, 0);
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_status_topic, s_status_buf, len, 0, 0);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "MQTT 发布状态失败");
-        cJSON_free(json_str);
-        cJSON_Delete(root);
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_STATUS]);
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "发布状态: %s (msg_id=%d)", json_str, msg_id);
-
-    // 释放资源
-    cJSON_free(json_str);
-    cJSON_Delete(root);
-
+    ESP_LOGI(TAG, "发布状态 %d 字节 %s (msg_id=%d)", len, payload_format_to_string(format), msg_id);
+    if (format == PAYLOAD_FORMAT_JSON) {
+        ESP_LOGD(TAG, "状态内容: %s", s_status_buf);
+    }
     return ESP_OK;
 }
 
@@ -340,15 +1706,385 @@ esp_err_t mqtt_publish_alert(const char *message)
         return ESP_FAIL;
     }
 
-    // 构建 JSON 消息
+    // 多个任务都会发布告警，缓冲区放在调用方栈上
+    char buf[MQTT_ALERT_BUF_SIZE];
+    PayloadWriter w;
+    payload_writer_init(&w, (PayloadFormat)runtime_config_get()->payload_format, buf, sizeof(buf));
+    payload_writer_begin_object(&w, NULL);
+    payload_writer_add_string(&w, "alert", message);
+    payload_writer_add_string(&w, "level", "WARNING");
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    payload_writer_add_int(&w, "timestamp", tv.tv_sec);
+    payload_writer_end_object(&w);
+
+    int len = payload_writer_finish(&w);
+    if (len < 0) {
+        ESP_LOGE(TAG, "生成告警消息失败（缓冲区不足）");
+        return ESP_FAIL;
+    }
+
+    // 发布消息（QoS 1，保证送达）
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_alert_topic, buf, len, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "MQTT 发布告警失败");
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_ALERT]);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGW(TAG, "发布告警: %s (msg_id=%d, QoS=1)", message, msg_id);
+    return ESP_OK;
+}
+
+/**
+ * @brief 写入告警位掩码对应的字符串数组
+ */
+static void write_diag_alarms(PayloadWriter *w, uint8_t alarms)
+{
+    payload_writer_begin_array(w, "alarms");
+    for (int bit = 0; bit < 8; bit++) {
+        if (alarms & (1 << bit)) {
+            payload_writer_add_string(w, NULL, diag_alarm_to_string((DiagAlarm)(1 << bit)));
+        }
+    }
+    payload_writer_end_array(w);
+}
+
+/**
+ * @brief 写入指标登记表快照
+ * "metrics": {"计数器": N, "计数器组": {"标签值": N, ...}, "仪表": N,
+ *             "直方图": {"le": [上界...], "counts": [各桶计数..., 超出上界], "sum": N}}
+ */
+static void write_metrics(PayloadWriter *w)
+{
+    payload_writer_begin_object(w, "metrics");
+    int n = metrics_count();
+    for (int i = 0; i < n; i++) {
+        const MetricDesc *m = metrics_get(i);
+        switch (m->type) {
+            case METRIC_TYPE_COUNTER:
+                if (m->label == NULL) {
+                    payload_writer_add_int(w, m->name, metric_counter_get(&m->counters[0]));
+                    break;
+                }
+                payload_writer_begin_object(w, m->name);
+                for (int j = 0; j < m->count; j++) {
+                    payload_writer_add_int(w, m->label_values[j], metric_counter_get(&m->counters[j]));
+                }
+                payload_writer_end_object(w);
+                break;
+            case METRIC_TYPE_GAUGE:
+                payload_writer_add_int(w, m->name, metric_gauge_get(m->gauge));
+                break;
+            case METRIC_TYPE_HISTOGRAM: {
+                const MetricHistogram *h = m->histogram;
+                payload_writer_begin_object(w, m->name);
+                payload_writer_begin_array(w, "le");
+                for (int j = 0; j < h->bound_count; j++) {
+                    payload_writer_add_int(w, NULL, h->bounds[j]);
+                }
+                payload_writer_end_array(w);
+                payload_writer_begin_array(w, "counts");
+                for (int j = 0; j <= h->bound_count; j++) {
+                    payload_writer_add_int(w, NULL, metric_histogram_bucket(h, j));
+                }
+                payload_writer_end_array(w);
+                payload_writer_add_int(w, "sum", metric_histogram_sum(h));
+                payload_writer_end_object(w);
+                break;
+            }
+        }
+    }
+    payload_writer_end_object(w);
+}
+
+esp_err_t mqtt_publish_diag(void)
+{
+    if (!s_mqtt_connected) {
+        return ESP_FAIL;
+    }
+
+    // 只由网络任务调用，快照与消息都使用静态缓冲区
+    static DiagSnapshot s_diag;
+    static char s_diag_buf[MQTT_DIAG_BUF_SIZE];
+    diagnostics_get_snapshot(&s_diag);
+
+    PayloadFormat format = (PayloadFormat)runtime_config_get()->payload_format;
+    PayloadWriter w;
+    payload_writer_init(&w, format, s_diag_buf, sizeof(s_diag_buf));
+    payload_writer_begin_object(&w, NULL);
+    payload_writer_add_int(&w, "window_s", s_diag.window_sec);
+    payload_writer_add_fixed(&w, "cpu_busy_pct", s_diag.cpu_busy_pct, 1);
+
+    payload_writer_begin_object(&w, "heap");
+    payload_writer_add_int(&w, "free", s_diag.heap_free);
+    payload_writer_add_int(&w, "min_free", s_diag.heap_min_free);
+    payload_writer_add_int(&w, "largest", s_diag.heap_largest);
+    payload_writer_add_fixed(&w, "frag_pct", s_diag.heap_frag_pct, 1);
+    payload_writer_add_int(&w, "internal_free", s_diag.internal_free);
+    payload_writer_end_object(&w);
+
+    payload_writer_begin_array(&w, "tasks");
+    for (int i = 0; i < s_diag.task_count; i++) {
+        const DiagTask *t = &s_diag.tasks[i];
+        payload_writer_begin_object(&w, NULL);
+        payload_writer_add_string(&w, "name", t->name);
+        payload_writer_add_int(&w, "prio", t->priority);
+        payload_writer_add_fixed(&w, "cpu_pct", t->cpu_pct, 2);
+        payload_writer_add_int(&w, "stack_free", t->stack_free);
+        if (t->alarms) {
+            write_diag_alarms(&w, t->alarms);
+        }
+        payload_writer_end_object(&w);
+    }
+    payload_writer_end_array(&w);
+    if (s_diag.tasks_truncated) {
+        payload_writer_add_bool(&w, "tasks_truncated", true);
+    }
+
+    write_diag_alarms(&w, s_diag.alarms);
+    write_metrics(&w);
+    payload_writer_add_int(&w, "uptime_s", esp_timer_get_time() / 1000000);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    payload_writer_add_int(&w, "timestamp", tv.tv_sec);
+    payload_writer_end_object(&w);
+
+    int len = payload_writer_finish(&w);
+    if (len < 0) {
+        ESP_LOGE(TAG, "生成诊断消息失败（缓冲区不足）");
+        return ESP_FAIL;
+    }
+
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_diag_topic, s_diag_buf, len, 0, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "MQTT 发布诊断失败");
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_DIAG]);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "发布诊断 %d 字节（任务 %d 个，告警 0x%02x）", len, s_diag.task_count, s_diag.alarms);
+    return ESP_OK;
+}
+
+int mqtt_publish_backlog(const TelemetrySample *samples, int count)
+{
+    if (!samples || count <= 0) {
+        return -1;
+    }
+
+    if (!s_mqtt_connected) {
+        return -1;
+    }
+
+    // 只由网络任务调用，使用静态缓冲区
+    static char s_backlog_buf[MQTT_BACKLOG_BUF_SIZE];
+    PayloadFormat format = (PayloadFormat)runtime_config_get()->payload_format;
+    PayloadWriter w;
+    payload_writer_init(&w, format, s_backlog_buf, sizeof(s_backlog_buf));
+    payload_writer_begin_object(&w, NULL);
+
+    uint8_t fan_count = fan_control_get_count();
+    payload_writer_begin_array(&w, "samples");
+    for (int i = 0; i < count; i++) {
+        const TelemetrySample *s = &samples[i];
+        payload_writer_begin_object(&w, NULL);
+        payload_writer_add_int(&w, "timestamp", s->timestamp);
+        payload_writer_add_fixed(&w, "co2", s->co2, 2);
+        payload_writer_add_fixed(&w, "temp", s->temperature, 2);
+        payload_writer_add_fixed(&w, "humi", s->humidity, 2);
+        payload_writer_begin_array(&w, "fans");
+        for (int f = 0; f < fan_count; f++) {
+            payload_writer_add_string(&w, NULL, fan_state_to_string(telemetry_sample_get_fan(s, (FanId)f)));
+        }
+        payload_writer_end_array(&w);
+        payload_writer_add_string(&w, "mode", system_mode_to_string((SystemMode)s->mode));
+        payload_writer_add_string(&w, "mode_reason",
+                                  decision_mode_reason_to_string((ModeReason)s->mode_reason));
+        payload_writer_end_object(&w);
+    }
+    payload_writer_end_array(&w);
+
+    TelemetryStats stats;
+    telemetry_buffer_get_stats(&stats);
+    payload_writer_add_int(&w, "backlog", stats.ram_depth + stats.flash_depth);
+    payload_writer_add_int(&w, "dropped", stats.dropped);
+    payload_writer_end_object(&w);
+
+    int len = payload_writer_finish(&w);
+    if (len < 0) {
+        ESP_LOGE(TAG, "生成补传消息失败（缓冲区不足）");
+        return -1;
+    }
+
+    // 补传使用 QoS 1，收到 PUBACK 后才从缓存移除
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_backlog_topic, s_backlog_buf, len, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGW(TAG, "MQTT 补传发布失败");
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_BACKLOG]);
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "补传 %d 条缓存样本（剩余 %lu 条，msg_id=%d）", count,
+             (unsigned long)(stats.ram_depth + stats.flash_depth), msg_id);
+    return msg_id;
+}
+
+esp_err_t mqtt_publish_shadow(const ShadowState *state, uint32_t fields, bool full)
+{
+    if (!state || state->fan_count > FAN_MAX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_mqtt_connected) {
+        return ESP_FAIL;
+    }
+
+    // 只由网络任务调用，使用静态缓冲区
+    static char s_shadow_buf[MQTT_SHADOW_BUF_SIZE];
+    static uint32_t s_shadow_seq = 0;
+    PayloadFormat format = (PayloadFormat)runtime_config_get()->payload_format;
+    PayloadWriter w;
+    payload_writer_init(&w, format, s_shadow_buf, sizeof(s_shadow_buf));
+    payload_writer_begin_object(&w, NULL);
+    payload_writer_add_int(&w, "seq", s_shadow_seq + 1);
+    payload_writer_add_bool(&w, "full", full);
+
+    payload_writer_begin_object(&w, "state");
+    for (int i = 0; i < state->fan_count; i++) {
+        if (fields & SHADOW_FIELD_FAN(i)) {
+            char key[8];
+            snprintf(key, sizeof(key), "fan_%d", i);
+            payload_writer_add_string(&w, key, fan_state_to_string(state->fans[i]));
+        }
+    }
+    if (fields & SHADOW_FIELD_MODE) {
+        payload_writer_add_string(&w, "mode", system_mode_to_string(state->mode));
+    }
+    if (fields & SHADOW_FIELD_REASON) {
+        payload_writer_add_string(&w, "mode_reason", decision_mode_reason_to_string(state->mode_reason));
+    }
+    if (fields & SHADOW_FIELD_LEASE) {
+        payload_writer_add_string(&w, "lease", remote_lease_to_string(state->lease));
+    }
+    if (fields & SHADOW_FIELD_DESIRED) {
+        payload_writer_add_int(&w, "desired_version", state->desired_version);
+    }
+    if (fields & SHADOW_FIELD_CONFIG) {
+        payload_writer_add_int(&w, "config_version", state->config_version);
+    }
+    payload_writer_end_object(&w);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    payload_writer_add_int(&w, "timestamp", tv.tv_sec);
+    payload_writer_end_object(&w);
+
+    int len = payload_writer_finish(&w);
+    if (len < 0) {
+        ESP_LOGE(TAG, "生成 reported 消息失败（缓冲区不足）");
+        return ESP_FAIL;
+    }
+
+    // QoS 1，不保留：变化消息依赖前序消息，后端需要快照时发 shadow/get
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_reported_topic, s_shadow_buf, len, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGW(TAG, "MQTT 发布 reported 失败");
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_SHADOW]);
+        return ESP_FAIL;
+    }
+
+    s_shadow_seq++;
+    ESP_LOGI(TAG, "发布 reported%s seq=%lu %d 字节 (msg_id=%d)", full ? "（完整）" : "",
+             (unsigned long)s_shadow_seq, len, msg_id);
+    return ESP_OK;
+}
+
+int mqtt_get_outbox_size(void)
+{
+    if (s_mqtt_client == NULL) {
+        return 0;
+    }
+    return esp_mqtt_client_get_outbox_size(s_mqtt_client);
+}
+
+void mqtt_client_sync_group(void)
+{
+    if (s_mqtt_client == NULL || !s_mqtt_connected) {
+        return;
+    }
+
+    const char *group = runtime_config_get()->group;
+    bool resubscribe = s_group_resubscribe;
+    if (!resubscribe && strcmp(group, s_group_subscribed) == 0) {
+        return;
+    }
+    s_group_resubscribe = false;
+
+    char filter[MQTT_TOPIC_MAX_LEN];
+    if (s_group_subscribed[0] != '\0' && !resubscribe) {
+        snprintf(filter, sizeof(filter), MQTT_TOPIC_GROUP_FMT MQTT_SUFFIX_COMMAND "/#", s_group_subscribed);
+        esp_mqtt_client_unsubscribe(s_mqtt_client, filter);
+        ESP_LOGI(TAG, "退出分组: %s", s_group_subscribed);
+    }
+    if (group[0] != '\0') {
+        snprintf(filter, sizeof(filter), MQTT_TOPIC_GROUP_FMT MQTT_SUFFIX_COMMAND "/#", group);
+        esp_mqtt_client_subscribe(s_mqtt_client, filter, 1);
+        ESP_LOGI(TAG, "加入分组: %s", group);
+    }
+    strlcpy(s_group_subscribed, group, sizeof(s_group_subscribed));
+}
+
+/**
+ * @brief 输出单个辨识参数 {"v":..,"r2":..,"n":..}
+ */
+static void add_vent_param(cJSON *parent, const char *key, const VentParam *param)
+{
+    cJSON *obj = cJSON_AddObjectToObject(parent, key);
+    if (obj == NULL) {
+        return;
+    }
+    cJSON_AddNumberToObject(obj, "v", param->value);
+    cJSON_AddNumberToObject(obj, "r2", param->r2);
+    cJSON_AddNumberToObject(obj, "n", param->segments);
+}
+
+esp_err_t mqtt_publish_vent_model(const VentModel *model, VentIdentState state,
+                                  uint8_t step, const char *note)
+{
+    if (!model) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_mqtt_connected) {
+        return ESP_FAIL;
+    }
+
     cJSON *root = cJSON_CreateObject();
     if (root == NULL) {
         ESP_LOGE(TAG, "创建 JSON 对象失败");
         return ESP_FAIL;
     }
 
-    cJSON_AddStringToObject(root, "alert", message);
-    cJSON_AddStringToObject(root, "level", "WARNING");
+    add_vent_param(root, "infiltration", &model->infiltration);
+    add_vent_param(root, "generation", &model->generation);
+
+    cJSON *fans = cJSON_AddArrayToObject(root, "fans");
+    for (int i = 0; fans != NULL && i < model->fan_count && i < FAN_MAX_COUNT; i++) {
+        cJSON *fan = cJSON_CreateObject();
+        if (fan == NULL) {
+            break;
+        }
+        add_vent_param(fan, "low", &model->fan[i][0]);
+        add_vent_param(fan, "high", &model->fan[i][1]);
+        cJSON_AddItemToArray(fans, fan);
+    }
+
+    cJSON_AddStringToObject(root, "ident", state == VENT_IDENT_RUNNING ? "RUNNING" : "IDLE");
+    cJSON_AddNumberToObject(root, "step", step);
+    cJSON_AddStringToObject(root, "note", note ? note : "NONE");
 
     struct timeval tv;
     gettimeofday(&tv, NULL);
@@ -361,31 +2097,109 @@ esp_err_t mqtt_publish_alert(const char *message)
         return ESP_FAIL;
     }
 
-    // 发布消息（QoS 1，保证送达）
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, MQTT_TOPIC_ALERT, json_str, 0, 1, 0);
+    // 保留消息（QoS 1），新订阅者可直接获得最新模型
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_model_topic, json_str, 0, 1, 1);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+
     if (msg_id < 0) {
-        ESP_LOGE(TAG, "MQTT 发布告警失败");
-        cJSON_free(json_str);
-        cJSON_Delete(root);
+        ESP_LOGE(TAG, "MQTT 发布通风模型失败");
+        metric_counter_inc(&s_publish_failures[PUB_TOPIC_OTHER]);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "发布通风模型 (msg_id=%d)", msg_id);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_publish_habit(void)
+{
+    if (!s_mqtt_connected) {
         return ESP_FAIL;
     }
 
-    ESP_LOGW(TAG, "发布告警: %s (msg_id=%d, QoS=1)", json_str, msg_id);
+    // 每天一条消息，单条约 300 字节，可直接作为 import 命令回灌到其他设备
+    for (uint8_t day = 0; day < 7; day++) {
+        HabitBin bins[24];
+        occupancy_habit_export_day(day, bins);
 
-    // 释放资源
-    cJSON_free(json_str);
-    cJSON_Delete(root);
+        int obs[24], occ[24], gen[24];
+        for (int i = 0; i < 24; i++) {
+            obs[i] = bins[i].observed;
+            occ[i] = bins[i].occupied;
+            gen[i] = bins[i].gen_sum;
+        }
+
+        cJSON *root = cJSON_CreateObject();
+        if (root == NULL) {
+            ESP_LOGE(TAG, "创建 JSON 对象失败");
+            return ESP_FAIL;
+        }
+        cJSON_AddNumberToObject(root, "day", day);
+        cJSON_AddItemToObject(root, "obs", cJSON_CreateIntArray(obs, 24));
+        cJSON_AddItemToObject(root, "occ", cJSON_CreateIntArray(occ, 24));
+        cJSON_AddItemToObject(root, "gen", cJSON_CreateIntArray(gen, 24));
+
+        char *json_str = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+        if (json_str == NULL) {
+            ESP_LOGE(TAG, "序列化 JSON 失败");
+            return ESP_FAIL;
+        }
+
+        int msg_id = esp_mqtt_client_publish(s_mqtt_client, s_habit_topic, json_str, 0, 1, 0);
+        cJSON_free(json_str);
+        if (msg_id < 0) {
+            ESP_LOGE(TAG, "MQTT 发布作息直方图失败（day=%d）", day);
+            metric_counter_inc(&s_publish_failures[PUB_TOPIC_OTHER]);
+            return ESP_FAIL;
+        }
+    }
 
+    ESP_LOGI(TAG, "发布作息直方图（7 条）");
     return ESP_OK;
 }
 
-bool mqtt_get_remote_command(FanState cmd[FAN_COUNT])
+esp_err_t mqtt_submit_command(const char *data, int len)
+{
+    if (!data || len <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_command_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;  // mqtt_client_init() 之前
+    }
+    return parse_remote_command(data, len) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+bool mqtt_get_remote_command(FanState cmd[], uint8_t fan_count)
 {
-    if (!cmd || !s_mqtt_connected || !s_command_received) {
+    if (!cmd || mqtt_get_remote_lease(NULL) != LEASE_VALID) {
         return false;
     }
-    for (int i = 0; i < FAN_COUNT; i++) {
+    if (fan_count > FAN_MAX_COUNT) {
+        fan_count = FAN_MAX_COUNT;
+    }
+    portENTER_CRITICAL(&s_command_lock);
+    for (int i = 0; i < fan_count; i++) {
         cmd[i] = s_remote_command[i];
     }
+    portEXIT_CRITICAL(&s_command_lock);
     return true;
 }
+
+RemoteLease mqtt_get_remote_lease(int64_t *expire_us)
+{
+    portENTER_CRITICAL(&s_command_lock);
+    bool received = s_command_received;
+    int64_t expire = s_lease_expire_us;
+    portEXIT_CRITICAL(&s_command_lock);
+
+    if (expire_us) {
+        *expire_us = expire;
+    }
+    if (!received) {
+        return LEASE_NONE;
+    }
+    // 租约只看时间，不看 MQTT 连接状态：短暂断线期间仍执行最后一条命令直至到期
+    return (esp_timer_get_time() < expire) ? LEASE_VALID : LEASE_EXPIRED;
+}
@@ -8,6 +8,10 @@
 
 #include "esp_err.h"
 #include "main.h"
+#include "vent_ident.h"
+#include "telemetry_buffer.h"
+#include "status_batch.h"
+#include "device_shadow.h"
 
 /**
  * @brief 初始化 MQTT 客户端
@@ -18,7 +22,13 @@
 esp_err_t mqtt_client_init(void);
 
 /**
- * @brief 发布状态到 home/ventilation/status
+ * @brief 重连 Broker（由连接监管调用，esp-mqtt 内置自动重连已关闭）
+ * @return ESP_OK 已请求重连或已连接，ESP_ERR_INVALID_STATE 未初始化，ESP_FAIL 正在连接中
+ */
+esp_err_t mqtt_client_reconnect(void);
+
+/**
+ * @brief 发布状态到 home/ventilation/<client_id>/status
  * JSON 格式:
  * {
  *   "co2": 850,
@@ -27,31 +37,145 @@ esp_err_t mqtt_client_init(void);
  *   "fan_0": "LOW",
  *   "fan_1": "HIGH",
  *   "fan_2": "OFF",
- *   "mode": "NORMAL"
+ *   "mode": "REMOTE",
+ *   "mode_reason": "LEASE"
  * }
  * QoS: 0
+ * 风扇字段 fan_0 ~ fan_{N-1} 按实际风扇数量输出
  * @param sensor 传感器数据
- * @param fans 3个风扇的状态数组
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量（1 ~ FAN_MAX_COUNT）
  * @param mode 系统运行模式
+ * @param reason 模式判定原因
+ * @param batch 上报间隔内的批量样本（附加为 "series"，NULL 表示不附加）
  * @return ESP_OK 成功，ESP_FAIL 失败
  */
-esp_err_t mqtt_publish_status(SensorData *sensor, const FanState fans[FAN_COUNT], SystemMode mode);
+esp_err_t mqtt_publish_status(SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                              SystemMode mode, ModeReason reason, const StatusBatch *batch);
 
 /**
- * @brief 发布告警到 home/ventilation/alert
+ * @brief 发布告警到 home/ventilation/<client_id>/alert
  * QoS: 1
  * @param message 告警消息
  * @return ESP_OK 成功，ESP_FAIL 失败
  */
 esp_err_t mqtt_publish_alert(const char *message);
 
+/**
+ * @brief 发布房间通风模型到 home/ventilation/<client_id>/model（保留消息）
+ * JSON 格式:
+ * {
+ *   "infiltration": {"v": 0.002, "r2": 0.8, "n": 3},
+ *   "generation": {"v": 12.5, "r2": 0.7, "n": 5},
+ *   "fans": [{"low": {...}, "high": {...}}, ...],
+ *   "ident": "IDLE",
+ *   "step": 0,
+ *   "note": "COMPLETED"
+ * }
+ * v 为参数值（衰减率 1/分钟，产生率 ppm/分钟），r2 为拟合优度，n 为参与更新的片段数（0 = 默认值）
+ * QoS: 1
+ * @param model 通风模型
+ * @param state 阶跃测试状态
+ * @param step 当前测试步骤
+ * @param note 最近一次测试结束原因
+ * @return ESP_OK 成功，ESP_FAIL 失败
+ */
+esp_err_t mqtt_publish_vent_model(const VentModel *model, VentIdentState state,
+                                  uint8_t step, const char *note);
+
+/**
+ * @brief 发布周作息直方图到 home/ventilation/<client_id>/habit
+ * 每天一条消息（共 7 条）:
+ * {"day": 1, "obs": [24 项], "occ": [24 项], "gen": [24 项]}
+ * day 为星期（0 = 星期日），数组下标为小时；obs 观测分钟数，occ 有人分钟数，
+ * gen 有人分钟的产生率累计（ppm/分钟）。消息加上 "action":"import" 即可导入到其他设备。
+ * QoS: 1
+ * @return ESP_OK 成功，ESP_FAIL 失败
+ */
+esp_err_t mqtt_publish_habit(void);
+
+/**
+ * @brief 发布运行诊断到 home/ventilation/<client_id>/diag（JSON 或 CBOR，由 payload_format 决定）
+ * {"window_s": 60, "cpu_busy_pct": 3.2,
+ *  "heap": {"free": 182340, "min_free": 151200, "largest": 110592, "frag_pct": 39.3, "internal_free": 182340},
+ *  "tasks": [{"name": "network", "prio": 3, "cpu_pct": 1.25, "stack_free": 5120}, ...],
+ *  "alarms": ["STACK_LOW"], "metrics": {"sht35_errors_total": {"i2c": 0, "crc": 1}, ...},
+ *  "uptime_s": 3600, "timestamp": 1234567890}
+ * tasks 按 CPU 占用降序，有告警的任务带 "alarms" 数组；顶层 alarms 为全部当前告警；
+ * metrics 为指标登记表快照（见 metrics.h）
+ * 只由网络任务调用（使用静态缓冲区）
+ * QoS: 0
+ * @return ESP_OK 成功，ESP_FAIL 失败
+ */
+esp_err_t mqtt_publish_diag(void);
+
+/**
+ * @brief 补传离线缓存样本到 home/ventilation/<client_id>/status/backlog（QoS 1）
+ * 可直接作为 telemetry_buffer_drain() 的发送回调
+ * @param samples 样本数组（按时间先后）
+ * @param count 样本数量
+ * @return MQTT msg_id，-1 表示未连接或发送失败
+ */
+int mqtt_publish_backlog(const TelemetrySample *samples, int count);
+
+/**
+ * @brief 发布影子 reported 到 home/ventilation/<client_id>/shadow/reported
+ * JSON 格式（只含 fields 中的字段）:
+ * {
+ *   "seq": 42,
+ *   "full": false,
+ *   "state": {"fan_0": "HIGH", "mode": "REMOTE", "mode_reason": "LEASE",
+ *             "lease": "VALID", "desired_version": 12, "config_version": 3},
+ *   "timestamp": 1760000000
+ * }
+ * seq 每次成功发布加 1（重启归零）；full 为 true 时 state 为完整状态
+ * QoS: 1
+ * @param state 当前状态
+ * @param fields 要发布的字段（SHADOW_FIELD_*）
+ * @param full 是否为完整状态
+ * @return ESP_OK 成功，ESP_FAIL 未连接或发送失败
+ */
+esp_err_t mqtt_publish_shadow(const ShadowState *state, uint32_t fields, bool full);
+
+/**
+ * @brief 获取 MQTT 发送队列（outbox）当前字节数
+ * @return 字节数，客户端未初始化时为 0
+ */
+int mqtt_get_outbox_size(void);
+
+/**
+ * @brief 按运行时配置的分组名更新分组命令订阅（网络任务每周期调用）
+ * 分组变化或重连后退订旧分组、订阅 home/ventilation/group/<group>/command/#
+ */
+void mqtt_client_sync_group(void);
+
 /**
  * @brief 获取远程风扇控制命令
- * 从 home/ventilation/command 主题接收的最新命令
- * 命令格式: {"fan_0":"HIGH", "fan_1":"LOW", "fan_2":"OFF"}
- * @param[out] cmd 输出3个风扇状态数组
- * @return true 有新命令，false 无命令或未连接
+ * 从本设备、所在分组或广播的 command 主题接收的最新命令
+ * 命令格式: {"fan_0":"HIGH", "fan_1":"LOW", "fan_2":"OFF", "ttl":120}（键数量随风扇数量）
+ * @param[out] cmd 输出风扇状态数组
+ * @param fan_count 风扇数量（1 ~ FAN_MAX_COUNT）
+ * @return true 租约有效，false 无命令或租约已过期
+ */
+bool mqtt_get_remote_command(FanState cmd[], uint8_t fan_count);
+
+/**
+ * @brief 提交一条本地来源的远程命令（本地 HTTP 接口）
+ * 与 command 主题收到的消息走同一解析与租约路径，格式同上（JSON 或 CBOR）；
+ * 不依赖 MQTT 连接，只连局域网的设备也可下发；可与 MQTT 任务并发调用（只改部分风扇的命令以最新命令为底）
+ * @param data 命令内容
+ * @param len 长度
+ * @return ESP_OK 已受理（不含 fan_N / ttl 的命令不改变租约），ESP_ERR_INVALID_ARG 格式错误，
+ *         ESP_ERR_INVALID_STATE 尚未调用 mqtt_client_init()
+ */
+esp_err_t mqtt_submit_command(const char *data, int len);
+
+/**
+ * @brief 查询远程命令租约状态
+ * 每条远程命令续租 ttl 秒（缺省 REMOTE_LEASE_DEFAULT_SEC，上限 REMOTE_LEASE_MAX_SEC）
+ * @param[out] expire_us 租约到期时刻（esp_timer_get_time() 时基，可为 NULL）
+ * @return 租约状态
  */
-bool mqtt_get_remote_command(FanState cmd[FAN_COUNT]);
+RemoteLease mqtt_get_remote_lease(int64_t *expire_us);
 
 #endif // MQTT_WRAPPER_H
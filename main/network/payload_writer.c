@@ -0,0 +1,98 @@
+/**
+ * @file payload_writer.c
+ * @brief 上报消息写入器：按格式分派到 json_writer / cbor_lite
+ */
+
+#include "payload_writer.h"
+
+void payload_writer_init(PayloadWriter *w, PayloadFormat format, void *buf, size_t size) {
+    w->format = format;
+    if (format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_init(&w->cbor, (uint8_t *)buf, size);
+    } else {
+        json_writer_init(&w->json, (char *)buf, size);
+    }
+}
+
+void payload_writer_begin_object(PayloadWriter *w, const char *key) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_begin_map(&w->cbor, key);
+    } else {
+        json_writer_begin_object(&w->json, key);
+    }
+}
+
+void payload_writer_end_object(PayloadWriter *w) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_end(&w->cbor);
+    } else {
+        json_writer_end_object(&w->json);
+    }
+}
+
+void payload_writer_begin_array(PayloadWriter *w, const char *key) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_begin_array(&w->cbor, key);
+    } else {
+        json_writer_begin_array(&w->json, key);
+    }
+}
+
+void payload_writer_end_array(PayloadWriter *w) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_end(&w->cbor);
+    } else {
+        json_writer_end_array(&w->json);
+    }
+}
+
+void payload_writer_add_string(PayloadWriter *w, const char *key, const char *value) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_add_text(&w->cbor, key, value);
+    } else {
+        json_writer_add_string(&w->json, key, value);
+    }
+}
+
+void payload_writer_add_int(PayloadWriter *w, const char *key, int64_t value) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_add_int(&w->cbor, key, value);
+    } else {
+        json_writer_add_int(&w->json, key, value);
+    }
+}
+
+void payload_writer_add_fixed(PayloadWriter *w, const char *key, float value, int decimals) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_add_fixed(&w->cbor, key, value, decimals);
+    } else {
+        json_writer_add_fixed(&w->json, key, value, decimals);
+    }
+}
+
+void payload_writer_add_null(PayloadWriter *w, const char *key) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_add_null(&w->cbor, key);
+    } else {
+        json_writer_add_null(&w->json, key);
+    }
+}
+
+void payload_writer_add_bool(PayloadWriter *w, const char *key, bool value) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        cbor_writer_add_bool(&w->cbor, key, value);
+    } else {
+        json_writer_add_bool(&w->json, key, value);
+    }
+}
+
+int payload_writer_finish(PayloadWriter *w) {
+    if (w->format == PAYLOAD_FORMAT_CBOR) {
+        return cbor_writer_finish(&w->cbor);
+    }
+    return json_writer_finish(&w->json);
+}
+
+const char *payload_format_to_string(PayloadFormat format) {
+    return format == PAYLOAD_FORMAT_CBOR ? "cbor" : "json";
+}
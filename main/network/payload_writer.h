@@ -0,0 +1,57 @@
+/**
+ * @file payload_writer.h
+ * @brief 上报消息写入器接口定义 - 同一套构建代码按设备配置输出 JSON 或 CBOR
+ *
+ * 接口与 json_writer 相同；对象在 CBOR 中写为 map，字符串写为文本串，键名不变，
+ * 因此两种编码描述的是同一份消息结构。
+ */
+
+#ifndef PAYLOAD_WRITER_H
+#define PAYLOAD_WRITER_H
+
+#include "main.h"
+#include "json_writer.h"
+#include "cbor_lite.h"
+
+/**
+ * @brief 写入器（放在调用方栈上）
+ */
+typedef struct {
+    PayloadFormat format;
+    union {
+        JsonWriter json;
+        CborWriter cbor;
+    };
+} PayloadWriter;
+
+/**
+ * @brief 初始化写入器
+ * @param w 写入器
+ * @param format 编码格式
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小（JSON 需为结尾 '\0' 预留 1 字节）
+ */
+void payload_writer_init(PayloadWriter *w, PayloadFormat format, void *buf, size_t size);
+
+void payload_writer_begin_object(PayloadWriter *w, const char *key);
+void payload_writer_end_object(PayloadWriter *w);
+void payload_writer_begin_array(PayloadWriter *w, const char *key);
+void payload_writer_end_array(PayloadWriter *w);
+void payload_writer_add_string(PayloadWriter *w, const char *key, const char *value);
+void payload_writer_add_int(PayloadWriter *w, const char *key, int64_t value);
+void payload_writer_add_fixed(PayloadWriter *w, const char *key, float value, int decimals);
+void payload_writer_add_null(PayloadWriter *w, const char *key);
+void payload_writer_add_bool(PayloadWriter *w, const char *key, bool value);
+
+/**
+ * @brief 结束写入
+ * @return 输出长度，缓冲区不足或对象 / 数组未闭合时返回 -1
+ */
+int payload_writer_finish(PayloadWriter *w);
+
+/**
+ * @brief PayloadFormat 转字符串（"json" / "cbor"）
+ */
+const char *payload_format_to_string(PayloadFormat format);
+
+#endif // PAYLOAD_WRITER_H
@@ -0,0 +1,150 @@
+/**
+ * @file report_policy.c
+ * @brief 状态上报策略
+ *
+ * 定时模式（默认）与原行为一致：距上次上报满 publish_interval 秒即上报。
+ * 变化模式按以下顺序判断，任一成立即上报：
+ *   1. 风扇档位、运行模式或模式原因与上次上报不同（立即，不受最小间隔限制）
+ *   2. CO2 / 温度 / 湿度与上次上报时之差达到死区，且距上次上报至少 REPORT_MIN_GAP_SEC 秒
+ *   3. 距上次上报满 heartbeat 秒
+ * 死区比较使用时间常数 REPORT_SMOOTH_SEC 的指数平滑值：单点噪声（CO2 传感器约 ±10 ppm）
+ * 与死区同量级，直接比较原始读数几乎每次都会越界；上报的仍是原始读数。
+ * 读数基准只在传感器有效时更新，传感器无效期间的上报不会把基准改成无效值。
+ */
+
+#include "report_policy.h"
+#include "runtime_config.h"
+#include <math.h>
+#include <string.h>
+
+static bool s_have_ref = false;           ///< 是否已有上报基准
+static bool s_have_values = false;        ///< 读数基准是否有效
+static uint32_t s_last_sec = 0;           ///< 上次上报时刻
+static FanState s_ref_fans[FAN_MAX_COUNT];
+static uint8_t s_ref_fan_count = 0;
+static SystemMode s_ref_mode;
+static ModeReason s_ref_reason;
+static float s_ref_co2, s_ref_temp, s_ref_humi;
+
+static bool s_have_smooth = false;        ///< 平滑值是否已初始化
+static float s_smooth_co2, s_smooth_temp, s_smooth_humi;
+
+static uint32_t s_baseline_sec = 0;       ///< 定时模式统计的上一个到期时刻
+static ReportStats s_stats;
+
+/**
+ * @brief 读数是否超出死区（死区为 0 时任何变化都算）
+ */
+static bool outside_deadband(float value, float ref, float band) {
+    float diff = fabsf(value - ref);
+    return band > 0.0f ? diff >= band : diff > 0.0f;
+}
+
+/**
+ * @brief 更新平滑读数（每个有效样本调用一次）
+ */
+static void smooth_update(const SensorData *sensor) {
+    if (!s_have_smooth) {
+        s_smooth_co2 = sensor->pollutants.co2;
+        s_smooth_temp = sensor->temperature;
+        s_smooth_humi = sensor->humidity;
+        s_have_smooth = true;
+        return;
+    }
+    const float alpha = 1.0f / REPORT_SMOOTH_SEC;
+    s_smooth_co2 += alpha * (sensor->pollutants.co2 - s_smooth_co2);
+    s_smooth_temp += alpha * (sensor->temperature - s_smooth_temp);
+    s_smooth_humi += alpha * (sensor->humidity - s_smooth_humi);
+}
+
+static bool is_transition(const FanState fans[], uint8_t fan_count, SystemMode mode, ModeReason reason) {
+    return fan_count != s_ref_fan_count || memcmp(fans, s_ref_fans, fan_count * sizeof(FanState)) != 0 ||
+           mode != s_ref_mode || reason != s_ref_reason;
+}
+
+ReportTrigger report_policy_check(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                                  SystemMode mode, ModeReason reason, uint32_t now_sec) {
+    const RuntimeConfig *cfg = runtime_config_get();
+
+    // 定时模式同期应上报的条数（与 report_mode 无关，用于比较）
+    if (now_sec - s_baseline_sec >= cfg->publish_interval_sec) {
+        s_stats.baseline++;
+        s_baseline_sec = now_sec;
+    }
+
+    if (sensor->valid) {
+        smooth_update(sensor);
+    }
+
+    uint32_t silent = now_sec - s_last_sec;
+    ReportTrigger trigger = REPORT_TRIGGER_NONE;
+
+    if (cfg->report_mode != REPORT_MODE_ON_CHANGE) {
+        if (silent >= cfg->publish_interval_sec) {
+            trigger = REPORT_TRIGGER_INTERVAL;
+        }
+    } else if (!s_have_ref) {
+        trigger = REPORT_TRIGGER_HEARTBEAT;
+    } else if (is_transition(fans, fan_count, mode, reason)) {
+        trigger = REPORT_TRIGGER_TRANSITION;
+    } else if (sensor->valid && silent >= REPORT_MIN_GAP_SEC &&
+               (!s_have_values ||
+                outside_deadband(s_smooth_co2, s_ref_co2, cfg->co2_deadband) ||
+                outside_deadband(s_smooth_temp, s_ref_temp, cfg->temp_deadband) ||
+                outside_deadband(s_smooth_humi, s_ref_humi, cfg->humi_deadband))) {
+        trigger = REPORT_TRIGGER_DEADBAND;
+    } else if (silent >= cfg->heartbeat_sec) {
+        trigger = REPORT_TRIGGER_HEARTBEAT;
+    }
+
+    if (trigger != REPORT_TRIGGER_NONE) {
+        s_stats.last_trigger = trigger;
+    }
+    return trigger;
+}
+
+void report_policy_commit(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                          SystemMode mode, ModeReason reason, uint32_t now_sec, bool sent) {
+    if (fan_count > FAN_MAX_COUNT) {
+        fan_count = FAN_MAX_COUNT;
+    }
+    s_have_ref = true;
+    s_last_sec = now_sec;
+    memcpy(s_ref_fans, fans, fan_count * sizeof(FanState));
+    s_ref_fan_count = fan_count;
+    s_ref_mode = mode;
+    s_ref_reason = reason;
+
+    if (sensor->valid && s_have_smooth) {
+        s_ref_co2 = s_smooth_co2;
+        s_ref_temp = s_smooth_temp;
+        s_ref_humi = s_smooth_humi;
+        s_have_values = true;
+    }
+
+    if (sent) {
+        s_stats.sent++;
+        s_stats.by_trigger[s_stats.last_trigger]++;
+    }
+}
+
+void report_policy_get_stats(ReportStats *out) {
+    if (out) {
+        *out = s_stats;
+    }
+}
+
+const char *report_trigger_to_string(ReportTrigger trigger) {
+    switch (trigger) {
+        case REPORT_TRIGGER_NONE:       return "NONE";
+        case REPORT_TRIGGER_INTERVAL:   return "INTERVAL";
+        case REPORT_TRIGGER_HEARTBEAT:  return "HEARTBEAT";
+        case REPORT_TRIGGER_TRANSITION: return "TRANSITION";
+        case REPORT_TRIGGER_DEADBAND:   return "DEADBAND";
+        default:                        return "UNKNOWN";
+    }
+}
+
+const char *report_mode_to_string(ReportMode mode) {
+    return mode == REPORT_MODE_ON_CHANGE ? "on_change" : "interval";
+}
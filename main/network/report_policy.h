@@ -0,0 +1,82 @@
+/**
+ * @file report_policy.h
+ * @brief 状态上报策略接口定义 - 定时上报，或按死区 / 风扇与模式变化上报并以 heartbeat 兜底
+ *
+ * 网络任务每秒调用 report_policy_check()，返回非 REPORT_TRIGGER_NONE 时生成一条状态
+ * （发布或转入离线缓存），随后调用 report_policy_commit() 记录本次上报的基准。
+ * 同时按 publish_interval 统计定时模式在同一时段本应发送的条数，用于评估节省的消息量。
+ * 所有接口只在网络任务中调用，无需加锁。
+ */
+
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 上报触发原因
+ */
+typedef enum {
+    REPORT_TRIGGER_NONE = 0,     ///< 不上报
+    REPORT_TRIGGER_INTERVAL,     ///< 定时模式到期
+    REPORT_TRIGGER_HEARTBEAT,    ///< 变化模式静默超过 heartbeat
+    REPORT_TRIGGER_TRANSITION,   ///< 风扇档位、运行模式或模式原因变化
+    REPORT_TRIGGER_DEADBAND,     ///< CO2 / 温度 / 湿度超出死区
+    REPORT_TRIGGER_COUNT,
+} ReportTrigger;
+
+/**
+ * @brief 上报统计（启动以来）
+ */
+typedef struct {
+    uint32_t sent;                           ///< 已生成的状态条数（发布或转入离线缓存）
+    uint32_t baseline;                       ///< 定时模式同期应生成的条数
+    uint32_t by_trigger[REPORT_TRIGGER_COUNT]; ///< 按触发原因统计的条数
+    ReportTrigger last_trigger;              ///< 最近一次触发原因
+} ReportStats;
+
+/**
+ * @brief 判断本周期是否上报
+ * @param sensor 传感器数据（co2 为发布值；无效时不做死区比较）
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @param mode 系统运行模式
+ * @param reason 模式判定原因
+ * @param now_sec 单调时间（秒）
+ * @return 触发原因，REPORT_TRIGGER_NONE 表示本周期不上报
+ */
+ReportTrigger report_policy_check(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                                  SystemMode mode, ModeReason reason, uint32_t now_sec);
+
+/**
+ * @brief 记录本次上报（report_policy_check() 返回触发原因后调用，无论是否发布成功）
+ * @param sensor 传感器数据（无效时沿用上次的读数基准）
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @param mode 系统运行模式
+ * @param reason 模式判定原因
+ * @param now_sec 单调时间（秒）
+ * @param sent 是否生成了状态（传感器无效时跳过发布为 false）
+ */
+void report_policy_commit(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                          SystemMode mode, ModeReason reason, uint32_t now_sec, bool sent);
+
+/**
+ * @brief 获取上报统计
+ * @param[out] out 统计
+ */
+void report_policy_get_stats(ReportStats *out);
+
+/**
+ * @brief ReportTrigger 转字符串（用于 MQTT 上报）
+ */
+const char *report_trigger_to_string(ReportTrigger trigger);
+
+/**
+ * @brief ReportMode 转字符串（用于 MQTT 上报与配置解析）
+ */
+const char *report_mode_to_string(ReportMode mode);
+
+#endif // REPORT_POLICY_H
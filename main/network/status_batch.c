@@ -0,0 +1,91 @@
+/**
+ * @file status_batch.c
+ * @brief 批量状态上报
+ *
+ * 网络任务每秒记录一个样本，按抽取间隔保留到列式缓冲中；状态发布时整批
+ * 随消息发出后清空。抽取间隔在每批第一个样本时确定，批内保持不变，
+ * 以便接收端按 t0 + i × step 还原时间轴。
+ *
+ * 只在网络任务中调用，无需加锁。
+ */
+
+#include "status_batch.h"
+#include "runtime_config.h"
+#include <math.h>
+#include <string.h>
+
+static StatusBatch s_batch;
+static uint32_t s_ticks = 0;      ///< 本批已经过的周期数
+
+/**
+ * @brief 浮点转定点（四舍五入，限幅到 int16，避开缺测标记）
+ */
+static int16_t to_fixed(float value, float scale) {
+    float v = roundf(value * scale);
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < -INT16_MAX) {
+        return -INT16_MAX;
+    }
+    return (int16_t)v;
+}
+
+void status_batch_add(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                      SystemMode mode) {
+    if (!sensor || !fans) {
+        return;
+    }
+
+    const RuntimeConfig *cfg = runtime_config_get();
+    if (cfg->status_batch_sec == 0) {
+        s_batch.count = 0;
+        return;
+    }
+
+    if (s_batch.count == 0 && s_ticks == 0) {
+        // 新批次：确定抽取间隔，保证整个上报间隔放得下
+        uint16_t min_step = (cfg->publish_interval_sec + STATUS_BATCH_MAX_SAMPLES - 1) /
+                            STATUS_BATCH_MAX_SAMPLES;
+        s_batch.step_sec = cfg->status_batch_sec > min_step ? cfg->status_batch_sec : min_step;
+    }
+
+    uint32_t tick = s_ticks++;
+    if (tick % s_batch.step_sec != 0 || s_batch.count >= STATUS_BATCH_MAX_SAMPLES) {
+        return;
+    }
+
+    int i = s_batch.count;
+    if (i == 0) {
+        s_batch.t0 = (uint32_t)sensor->timestamp;
+    }
+    if (sensor->valid) {
+        s_batch.co2[i] = to_fixed(sensor->pollutants.co2, 1.0f);
+        s_batch.temp[i] = to_fixed(sensor->temperature, 10.0f);
+        s_batch.humi[i] = to_fixed(sensor->humidity, 10.0f);
+    } else {
+        s_batch.co2[i] = s_batch.temp[i] = s_batch.humi[i] = STATUS_BATCH_GAP;
+    }
+    s_batch.fans[i] = 0;
+    for (int f = 0; f < fan_count && f < FAN_MAX_COUNT; f++) {
+        s_batch.fans[i] |= (uint16_t)((fans[f] & 0x3) << (2 * f));
+    }
+    s_batch.mode[i] = (uint8_t)mode;
+    s_batch.count++;
+}
+
+const StatusBatch *status_batch_get(void) {
+    return s_batch.count > 0 ? &s_batch : NULL;
+}
+
+void status_batch_reset(void) {
+    s_batch.count = 0;
+    s_ticks = 0;
+}
+
+FanState status_batch_get_fan(const StatusBatch *batch, int index, FanId id) {
+    if (!batch || index < 0 || index >= batch->count || id >= FAN_MAX_COUNT) {
+        return FAN_OFF;
+    }
+    return (FanState)((batch->fans[index] >> (2 * id)) & 0x3);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file status_batch.h
+ * @brief 批量状态上报接口定义 - 把上报间隔内的 1 Hz 样本（可抽取）打包进同一条状态消息
+ */
+
+#ifndef STATUS_BATCH_H
+#define STATUS_BATCH_H
+
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATUS_BATCH_GAP  INT16_MIN  ///< 列中的缺测标记（传感器数据无效）
+
+/**
+ * @brief 一个上报间隔内的列式样本
+ * 各列为定点整数：co2 单位 ppm（发布值），temp / humi 单位 0.1
+ */
+typedef struct {
+    uint32_t t0;                                ///< 第一个样本的 Unix 时间戳（秒）
+    uint16_t step_sec;                          ///< 样本间隔（秒）
+    uint16_t count;                             ///< 样本数量
+    int16_t co2[STATUS_BATCH_MAX_SAMPLES];      ///< CO2（ppm）
+    int16_t temp[STATUS_BATCH_MAX_SAMPLES];     ///< 温度（0.1 ℃）
+    int16_t humi[STATUS_BATCH_MAX_SAMPLES];     ///< 湿度（0.1 %）
+    uint16_t fans[STATUS_BATCH_MAX_SAMPLES];    ///< 风扇状态，每风扇 2 位
+    uint8_t mode[STATUS_BATCH_MAX_SAMPLES];     ///< SystemMode
+} StatusBatch;
+
+/**
+ * @brief 记录一个 1 Hz 样本（网络任务每周期调用）
+ * 按运行时配置 status_batch_sec 抽取；间隔内样本超过 STATUS_BATCH_MAX_SAMPLES 时自动加大抽取间隔。
+ * 批量上报关闭时不做任何事。
+ * @param sensor 传感器数据（co2 为发布值，valid 为 false 时记为缺测）
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @param mode 系统运行模式
+ */
+void status_batch_add(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                      SystemMode mode);
+
+/**
+ * @brief 获取当前批次（随状态消息发布）
+ * @return 批次指针，批量上报关闭或无样本时为 NULL
+ */
+const StatusBatch *status_batch_get(void);
+
+/**
+ * @brief 清空批次（每次状态发布后调用，无论成功与否）
+ */
+void status_batch_reset(void);
+
+/**
+ * @brief 取批次中某个样本的单个风扇状态
+ * @param batch 批次
+ * @param index 样本序号
+ * @param id 风扇ID
+ * @return FanState
+ */
+FanState status_batch_get_fan(const StatusBatch *batch, int index, FanId id);
+
+#endif // STATUS_BATCH_H
@@ -0,0 +1,386 @@
+/**
+ * @file telemetry_buffer.c
+ * @brief 遥测离线缓存
+ *
+ * 两级缓冲：未能实时发布的样本先进入 RAM 环形缓冲；RAM 满时把最早的
+ * TELEMETRY_SPILL_BATCH 条整批写入 "telemetry" Flash 分区（环形日志，
+ * 每条 32 字节带序号和 CRC）。Flash 中的数据总是早于 RAM 中的数据，
+ * 补传时先 Flash 后 RAM，保持时间顺序。
+ *
+ * 补传使用 QoS 1，收到 PUBACK 后才移除对应记录；断线或超时未确认的批次
+ * 会重新发送，因此后端可能收到重复样本（按 timestamp 去重）。
+ * Flash 补传进度（已确认的序号）合并保存到 NVS，重启后从该序号继续。
+ *
+ * 除 telemetry_buffer_on_published() / on_disconnected() 外，所有接口
+ * 只在网络任务中调用，无需加锁。
+ */
+
+#include "telemetry_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "TELEMETRY";
+
+// Flash 分区与 NVS 存储键值
+#define TELEMETRY_PARTITION_LABEL  "telemetry"
+#define TELEMETRY_NVS_NAMESPACE    "telemetry"
+#define TELEMETRY_NVS_KEY_ACKED    "acked_seq"
+
+#define FLASH_SECTOR_SIZE          4096
+#define FLASH_RECORD_SIZE          32
+#define RECORDS_PER_SECTOR         (FLASH_SECTOR_SIZE / FLASH_RECORD_SIZE)
+#define SEQ_ERASED                 0xFFFFFFFFu
+
+/**
+ * @brief Flash 中的一条记录（32 字节）
+ */
+typedef struct {
+    uint32_t seq;             ///< 写入序号（单调递增，0xFFFFFFFF = 已擦除）
+    TelemetrySample sample;   ///< 样本（20 字节）
+    uint32_t crc;             ///< seq + sample 的 CRC32
+    uint32_t reserved;
+} FlashRecord;
+
+/**
+ * @brief 等待确认的补传批次来源
+ */
+typedef enum {
+    SOURCE_FLASH = 0,
+    SOURCE_RAM,
+} BatchSource;
+
+// RAM 环形缓冲
+static TelemetrySample s_ram[TELEMETRY_RAM_RECORDS];
+static uint32_t s_ram_tail = 0;     ///< 最早一条
+static uint32_t s_ram_count = 0;
+
+// Flash 环形日志
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_slots = 0;        ///< 分区可容纳的记录数
+static uint32_t s_head = 0;         ///< 下一条写入位置
+static uint32_t s_tail = 0;         ///< 最早一条未补传记录
+static uint32_t s_flash_count = 0;
+static uint32_t s_next_seq = 1;
+static uint32_t s_tail_seq = 1;     ///< s_tail 处记录的序号
+static uint32_t s_unsaved_acks = 0;
+
+// 补传批次
+static int s_pending_msg = -1;
+static int s_pending_count = 0;
+static BatchSource s_pending_source = SOURCE_FLASH;
+static int64_t s_pending_since_us = 0;
+static int64_t s_last_send_us = 0;
+static volatile int s_acked_msg = -1;
+static volatile bool s_cancel_pending = false;
+
+static TelemetryStats s_stats = {0};
+
+/**
+ * @brief 计算记录 CRC（seq + sample）
+ */
+static uint32_t record_crc(const FlashRecord *rec) {
+    return esp_rom_crc32_le(0, (const uint8_t *)rec, offsetof(FlashRecord, crc));
+}
+
+/**
+ * @brief 读取并校验一条 Flash 记录
+ * @return true 记录有效
+ */
+static bool flash_read(uint32_t slot, FlashRecord *rec) {
+    if (esp_partition_read(s_part, (size_t)slot * FLASH_RECORD_SIZE, rec, sizeof(*rec)) != ESP_OK) {
+        s_stats.flash_errors++;
+        return false;
+    }
+    return rec->seq != SEQ_ERASED && rec->crc == record_crc(rec);
+}
+
+/**
+ * @brief 保存 Flash 补传进度
+ */
+static void save_acked_seq(void) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(TELEMETRY_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_u32(nvs_handle, TELEMETRY_NVS_KEY_ACKED, s_tail_seq) == ESP_OK) {
+        nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    s_unsaved_acks = 0;
+}
+
+/**
+ * @brief 放弃等待中的批次（其记录即将被移动或覆盖，确认到达时不再生效）
+ */
+static void cancel_pending(BatchSource source) {
+    if (s_pending_msg >= 0 && s_pending_source == source) {
+        s_pending_msg = -1;
+    }
+}
+
+/**
+ * @brief 从 Flash 尾部移除 n 条记录
+ */
+static void flash_consume(uint32_t n) {
+    s_tail = (s_tail + n) % s_slots;
+    s_tail_seq += n;
+    s_flash_count -= n;
+}
+
+/**
+ * @brief 追加一条记录到 Flash（写入新扇区前擦除，扇区中未补传的记录计为丢弃）
+ * @return true 写入成功
+ */
+static bool flash_append(const TelemetrySample *sample) {
+    if (s_head % RECORDS_PER_SECTOR == 0) {
+        uint32_t sector = s_head / RECORDS_PER_SECTOR;
+        while (s_flash_count > 0 && s_tail / RECORDS_PER_SECTOR == sector) {
+            cancel_pending(SOURCE_FLASH);
+            flash_consume(1);
+            s_stats.dropped++;
+        }
+        if (esp_partition_erase_range(s_part, (size_t)sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE) != ESP_OK) {
+            s_stats.flash_errors++;
+            return false;
+        }
+    }
+
+    FlashRecord rec = {.seq = s_next_seq, .sample = *sample, .reserved = SEQ_ERASED};
+    rec.crc = record_crc(&rec);
+    if (esp_partition_write(s_part, (size_t)s_head * FLASH_RECORD_SIZE, &rec, sizeof(rec)) != ESP_OK) {
+        s_stats.flash_errors++;
+        return false;
+    }
+
+    if (s_flash_count == 0) {
+        s_tail = s_head;
+        s_tail_seq = s_next_seq;
+    }
+    s_next_seq++;
+    s_head = (s_head + 1) % s_slots;
+    s_flash_count++;
+    return true;
+}
+
+/**
+ * @brief 启动时扫描 Flash，恢复写入位置与未补传记录
+ */
+static void flash_recover(void) {
+    uint32_t acked_seq = 0;
+    nvs_handle_t nvs_handle;
+    if (nvs_open(TELEMETRY_NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        nvs_get_u32(nvs_handle, TELEMETRY_NVS_KEY_ACKED, &acked_seq);
+        nvs_close(nvs_handle);
+    }
+
+    uint32_t min_seq = SEQ_ERASED, max_seq = 0, max_slot = 0;
+    FlashRecord rec;
+    for (uint32_t slot = 0; slot < s_slots; slot++) {
+        if (!flash_read(slot, &rec)) {
+            continue;
+        }
+        if (rec.seq < min_seq) {
+            min_seq = rec.seq;
+        }
+        if (rec.seq >= max_seq) {
+            max_seq = rec.seq;
+            max_slot = slot;
+        }
+    }
+
+    if (max_seq == 0) {
+        // 空分区：从头开始
+        s_head = s_tail = s_flash_count = 0;
+        s_next_seq = s_tail_seq = acked_seq > 0 ? acked_seq : 1;
+        return;
+    }
+
+    s_head = (max_slot + 1) % s_slots;
+    s_next_seq = max_seq + 1;
+    uint32_t start = acked_seq > min_seq ? acked_seq : min_seq;
+    s_flash_count = start <= max_seq ? max_seq - start + 1 : 0;
+    s_tail = (s_head + s_slots - s_flash_count) % s_slots;
+    s_tail_seq = start;
+}
+
+void telemetry_sample_make(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                           SystemMode mode, ModeReason reason, TelemetrySample *out) {
+    memset(out, 0, sizeof(*out));
+    out->timestamp = (uint32_t)sensor->timestamp;
+    out->co2 = sensor->pollutants.co2;
+    out->temperature = sensor->temperature;
+    out->humidity = sensor->humidity;
+    for (int i = 0; i < fan_count && i < FAN_MAX_COUNT; i++) {
+        out->fans |= (uint16_t)((fans[i] & 0x3) << (2 * i));
+    }
+    out->mode = (uint8_t)mode;
+    out->mode_reason = (uint8_t)reason;
+}
+
+FanState telemetry_sample_get_fan(const TelemetrySample *sample, FanId id) {
+    if (!sample || id >= FAN_MAX_COUNT) {
+        return FAN_OFF;
+    }
+    return (FanState)((sample->fans >> (2 * id)) & 0x3);
+}
+
+esp_err_t telemetry_buffer_init(void) {
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                      TELEMETRY_PARTITION_LABEL);
+    if (s_part == NULL || s_part->size < 2 * FLASH_SECTOR_SIZE) {
+        s_part = NULL;
+        ESP_LOGW(TAG, "未找到 telemetry 分区，仅使用 RAM 缓冲（%d 条）", TELEMETRY_RAM_RECORDS);
+        return ESP_OK;
+    }
+
+    s_slots = (s_part->size / FLASH_SECTOR_SIZE) * RECORDS_PER_SECTOR;
+    flash_recover();
+    ESP_LOGI(TAG, "离线缓存: RAM %d 条 + Flash %lu 条，待补传 %lu 条",
+             TELEMETRY_RAM_RECORDS, (unsigned long)s_slots, (unsigned long)s_flash_count);
+    return ESP_OK;
+}
+
+void telemetry_buffer_push(const TelemetrySample *sample) {
+    if (!sample) {
+        return;
+    }
+
+    if (s_ram_count == TELEMETRY_RAM_RECORDS) {
+        cancel_pending(SOURCE_RAM);
+        uint32_t n = s_part ? TELEMETRY_SPILL_BATCH : 1;
+        for (uint32_t i = 0; i < n; i++) {
+            // Flash 不可用或写入失败时丢弃最早一条
+            if (!s_part || !flash_append(&s_ram[s_ram_tail])) {
+                s_stats.dropped++;
+            }
+            s_ram_tail = (s_ram_tail + 1) % TELEMETRY_RAM_RECORDS;
+            s_ram_count--;
+        }
+    }
+
+    s_ram[(s_ram_tail + s_ram_count) % TELEMETRY_RAM_RECORDS] = *sample;
+    s_ram_count++;
+}
+
+/**
+ * @brief 确认等待中的批次：移除对应记录
+ */
+static void commit_pending(void) {
+    if (s_pending_source == SOURCE_FLASH) {
+        flash_consume(s_pending_count);
+        s_unsaved_acks += s_pending_count;
+        if (s_flash_count == 0 || s_unsaved_acks >= TELEMETRY_ACK_SAVE_RECORDS) {
+            save_acked_seq();
+        }
+    } else {
+        s_ram_tail = (s_ram_tail + s_pending_count) % TELEMETRY_RAM_RECORDS;
+        s_ram_count -= s_pending_count;
+    }
+    s_stats.uploaded += s_pending_count;
+    s_pending_msg = -1;
+}
+
+/**
+ * @brief 从最早的一级缓冲取出一批样本
+ * @return 样本数量
+ */
+static int collect_batch(TelemetrySample batch[], BatchSource *source) {
+    int n = 0;
+    if (s_flash_count > 0) {
+        *source = SOURCE_FLASH;
+        FlashRecord rec;
+        while (n < TELEMETRY_BATCH_MAX && (uint32_t)n < s_flash_count) {
+            uint32_t slot = (s_tail + n) % s_slots;
+            if (!flash_read(slot, &rec) || rec.seq != s_tail_seq + n) {
+                if (n > 0) {
+                    break;  // 先发送已取出的部分，损坏记录下一批处理
+                }
+                flash_consume(1);  // 损坏记录：丢弃
+                s_stats.dropped++;
+                if (s_flash_count == 0) {
+                    break;
+                }
+                continue;
+            }
+            batch[n++] = rec.sample;
+        }
+        if (n > 0 || s_flash_count > 0) {
+            return n;
+        }
+    }
+
+    *source = SOURCE_RAM;
+    while (n < TELEMETRY_BATCH_MAX && (uint32_t)n < s_ram_count) {
+        batch[n] = s_ram[(s_ram_tail + n) % TELEMETRY_RAM_RECORDS];
+        n++;
+    }
+    return n;
+}
+
+void telemetry_buffer_drain(TelemetrySendFn send, int outbox_bytes) {
+    if (s_cancel_pending) {
+        s_cancel_pending = false;
+        s_pending_msg = -1;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (s_pending_msg >= 0) {
+        if (s_acked_msg == s_pending_msg) {
+            commit_pending();
+        } else if (now - s_pending_since_us < (int64_t)TELEMETRY_ACK_TIMEOUT_MS * 1000) {
+            return;
+        } else {
+            ESP_LOGW(TAG, "补传批次 msg_id=%d 确认超时，重新发送", s_pending_msg);
+            s_pending_msg = -1;
+        }
+    }
+
+    if (!send || !telemetry_buffer_has_backlog() ||
+        now - s_last_send_us < (int64_t)TELEMETRY_DRAIN_INTERVAL_MS * 1000 ||
+        outbox_bytes > TELEMETRY_OUTBOX_LIMIT) {
+        return;
+    }
+
+    static TelemetrySample batch[TELEMETRY_BATCH_MAX];
+    BatchSource source;
+    int n = collect_batch(batch, &source);
+    if (n == 0) {
+        return;
+    }
+
+    s_last_send_us = now;
+    int msg_id = send(batch, n);
+    if (msg_id < 0) {
+        return;
+    }
+    s_pending_msg = msg_id;
+    s_pending_count = n;
+    s_pending_source = source;
+    s_pending_since_us = now;
+}
+
+void telemetry_buffer_on_published(int msg_id) {
+    s_acked_msg = msg_id;
+}
+
+void telemetry_buffer_on_disconnected(void) {
+    s_cancel_pending = true;
+}
+
+bool telemetry_buffer_has_backlog(void) {
+    return s_ram_count > 0 || s_flash_count > 0;
+}
+
+void telemetry_buffer_get_stats(TelemetryStats *stats) {
+    if (!stats) {
+        return;
+    }
+    *stats = s_stats;
+    stats->ram_depth = s_ram_count;
+    stats->flash_depth = s_flash_count;
+}
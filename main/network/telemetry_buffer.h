@@ -0,0 +1,112 @@
+/**
+ * @file telemetry_buffer.h
+ * @brief 遥测离线缓存接口定义 - 断网期间状态样本先入 RAM 环形缓冲，满后溢出到 Flash 分区，恢复后限速补传
+ */
+
+#ifndef TELEMETRY_BUFFER_H
+#define TELEMETRY_BUFFER_H
+
+#include "esp_err.h"
+#include "main.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 一条状态样本（与 status 消息字段一致的紧凑形式）
+ */
+typedef struct {
+    uint32_t timestamp;   ///< Unix 时间戳（秒）
+    float co2;            ///< CO2（ppm，发布值）
+    float temperature;    ///< 温度（℃）
+    float humidity;       ///< 湿度（%）
+    uint16_t fans;        ///< 风扇状态，每风扇 2 位（bit 2i ~ 2i+1 = Fan i 的 FanState）
+    uint8_t mode;         ///< SystemMode
+    uint8_t mode_reason;  ///< ModeReason
+} TelemetrySample;
+
+/**
+ * @brief 缓存统计（随状态与补传消息上报）
+ */
+typedef struct {
+    uint32_t ram_depth;       ///< RAM 中待补传条数
+    uint32_t flash_depth;     ///< Flash 中待补传条数
+    uint32_t dropped;         ///< 缓存满被覆盖丢弃的条数（累计）
+    uint32_t uploaded;        ///< 已确认补传的条数（累计）
+    uint32_t flash_errors;    ///< Flash 读写失败次数（累计）
+} TelemetryStats;
+
+/**
+ * @brief 补传发送回调
+ * @param samples 样本数组（按时间先后）
+ * @param count 样本数量
+ * @return MQTT msg_id（QoS 1，≥ 0 表示已进入发送队列），-1 表示发送失败
+ */
+typedef int (*TelemetrySendFn)(const TelemetrySample *samples, int count);
+
+/**
+ * @brief 由状态数据生成样本
+ * @param sensor 传感器数据（co2 为发布值）
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量
+ * @param mode 系统运行模式
+ * @param reason 模式判定原因
+ * @param[out] out 输出样本
+ */
+void telemetry_sample_make(const SensorData *sensor, const FanState fans[], uint8_t fan_count,
+                           SystemMode mode, ModeReason reason, TelemetrySample *out);
+
+/**
+ * @brief 取样本中单个风扇的状态
+ * @param sample 样本
+ * @param id 风扇ID
+ * @return FanState
+ */
+FanState telemetry_sample_get_fan(const TelemetrySample *sample, FanId id);
+
+/**
+ * @brief 初始化缓存：查找 "telemetry" Flash 分区并恢复上次未补传的记录
+ * 无该分区时仅使用 RAM 缓冲
+ * @return ESP_OK 成功
+ */
+esp_err_t telemetry_buffer_init(void);
+
+/**
+ * @brief 缓存一条未能实时发布的样本（网络任务调用）
+ * RAM 缓冲满时把最早的一批移入 Flash；Flash 也满时覆盖最早的一个扇区
+ * @param sample 样本
+ */
+void telemetry_buffer_push(const TelemetrySample *sample);
+
+/**
+ * @brief 限速补传（网络任务每周期调用，MQTT 已连接时）
+ * 每 TELEMETRY_DRAIN_INTERVAL_MS 最多发送一批，上一批未确认或 MQTT 发送队列
+ * 积压超过 TELEMETRY_OUTBOX_LIMIT 时暂停，保证实时状态优先
+ * @param send 发送回调
+ * @param outbox_bytes 当前 MQTT 发送队列字节数
+ */
+void telemetry_buffer_drain(TelemetrySendFn send, int outbox_bytes);
+
+/**
+ * @brief MQTT 发布确认（MQTT_EVENT_PUBLISHED，在 MQTT 任务中调用）
+ * @param msg_id 已确认的消息 ID
+ */
+void telemetry_buffer_on_published(int msg_id);
+
+/**
+ * @brief MQTT 断开：放弃等待中的补传批次（重连后重新发送）
+ */
+void telemetry_buffer_on_disconnected(void);
+
+/**
+ * @brief 是否有待补传数据
+ * @return true 有积压
+ */
+bool telemetry_buffer_has_backlog(void);
+
+/**
+ * @brief 获取缓存统计
+ * @param[out] stats 输出统计
+ */
+void telemetry_buffer_get_stats(TelemetryStats *stats);
+
+#endif // TELEMETRY_BUFFER_H
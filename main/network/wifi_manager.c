@@ -4,15 +4,19 @@
  */
 
 #include "wifi_manager.h"
+#include "conn_supervisor.h"
+#include "metrics.h"
+#include "main.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
+#include "esp_mac.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "nvs_flash.h"
 #include "esp_smartconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
-#include "freertos/timers.h"
 #include <string.h>
 
 static const char *TAG = "WIFI_MGR";
@@ -22,10 +26,8 @@ static const char *TAG = "WIFI_MGR";
 #define WIFI_FAIL_BIT       BIT1
 #define SC_DONE_BIT         BIT2
 
-// WiFi 重试配置
-#define WIFI_INIT_RETRY_INTERVAL_MS  5000   // 初始化阶段重试间隔 5 秒
-#define WIFI_INIT_MAX_RETRY_COUNT    3      // 初始化阶段最多重试 3 次
-#define WIFI_RUNTIME_RETRY_DELAY_MS  10000  // 运行时重连间隔 10 秒
+// WiFi 重试配置（重连间隔由 conn_supervisor 按退避安排）
+#define WIFI_INIT_MAX_RETRY_COUNT    3      // 初始化阶段最多等待重试 3 次（之后返回，后台继续重连）
 
 // SmartConfig 配置
 #define SMARTCONFIG_TIMEOUT_SEC      60     // SmartConfig 超时 60 秒
@@ -34,21 +36,164 @@ static const char *TAG = "WIFI_MGR";
 #define NVS_NAMESPACE   "wifi_config"
 #define NVS_KEY_SSID    "ssid"
 #define NVS_KEY_PASS    "password"
+#define NVS_KEY_FAST    "fast"
+
+// 快速连接缓存（上次成功连接的 AP）
+#define WIFI_FAST_VERSION  1
+
+/**
+ * @brief NVS 中保存的快速连接缓存（blob）
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t ssid[32];
+    uint8_t bssid[6];
+    uint8_t channel;
+} WifiFastBlob;
 
 // 全局变量
 static EventGroupHandle_t s_wifi_event_group = NULL;
-static TimerHandle_t s_reconnect_timer = NULL;
 static bool s_initialized = false;
 static int s_retry_count = 0;
 static bool s_is_runtime = false;  // 标记是否已进入运行时（初始化完成后）
 
+static WifiFastBlob s_fast;            // 快速连接缓存（version 为 0 表示无效）
+static bool s_pinned = false;          // 当前 STA 配置指定了缓存的 BSSID / 信道
+static bool s_link_was_up = false;     // 本次断开前已关联成功（区分断线与连接失败）
+static WifiFastStats s_fast_stats;
+
+// 断开次数（按原因归类，wifi_err_reason_t 原值见日志）
+enum {
+    WIFI_DISC_BEACON_TIMEOUT = 0,
+    WIFI_DISC_NO_AP,
+    WIFI_DISC_AUTH,
+    WIFI_DISC_ASSOC,
+    WIFI_DISC_HANDSHAKE,
+    WIFI_DISC_CONN_FAIL,
+    WIFI_DISC_OTHER,
+    WIFI_DISC_COUNT,
+};
+static const char *const s_disc_labels[WIFI_DISC_COUNT] = {
+    "beacon_timeout", "no_ap", "auth", "assoc", "handshake", "conn_fail", "other",
+};
+static MetricCounter s_disconnects[WIFI_DISC_COUNT];
+
+/**
+ * @brief 断开原因归类
+ */
+static int disconnect_category(uint8_t reason)
+{
+    switch (reason) {
+        case WIFI_REASON_BEACON_TIMEOUT:
+            return WIFI_DISC_BEACON_TIMEOUT;
+        case WIFI_REASON_NO_AP_FOUND:
+        case WIFI_REASON_NO_AP_FOUND_W_COMPATIBLE_SECURITY:
+        case WIFI_REASON_NO_AP_FOUND_IN_AUTHMODE_THRESHOLD:
+        case WIFI_REASON_NO_AP_FOUND_IN_RSSI_THRESHOLD:
+            return WIFI_DISC_NO_AP;
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_AUTH_FAIL:
+            return WIFI_DISC_AUTH;
+        case WIFI_REASON_ASSOC_FAIL:
+            return WIFI_DISC_ASSOC;
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_GROUP_KEY_UPDATE_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+            return WIFI_DISC_HANDSHAKE;
+        case WIFI_REASON_CONNECTION_FAIL:
+            return WIFI_DISC_CONN_FAIL;
+        default:
+            return WIFI_DISC_OTHER;
+    }
+}
+
+/**
+ * @brief 从 NVS 加载快速连接缓存
+ */
+static void fast_cache_load(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(s_fast);
+    esp_err_t err = nvs_get_blob(nvs_handle, NVS_KEY_FAST, &s_fast, &len);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK || len != sizeof(s_fast) || s_fast.version != WIFI_FAST_VERSION) {
+        memset(&s_fast, 0, sizeof(s_fast));
+    }
+}
+
+/**
+ * @brief 关联成功后更新快速连接缓存（AP 或信道变化时才写入 NVS）
+ */
+static void fast_cache_update(const wifi_event_sta_connected_t *event)
+{
+    WifiFastBlob blob = {.version = WIFI_FAST_VERSION, .channel = event->channel};
+    memcpy(blob.ssid, event->ssid, event->ssid_len < sizeof(blob.ssid) ? event->ssid_len : sizeof(blob.ssid));
+    memcpy(blob.bssid, event->bssid, sizeof(blob.bssid));
+    if (memcmp(&blob, &s_fast, sizeof(blob)) == 0) {
+        return;
+    }
+    s_fast = blob;
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs_handle, NVS_KEY_FAST, &blob, sizeof(blob));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "快速连接缓存保存失败: %s", esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "快速连接缓存更新: " MACSTR "，信道 %d", MAC2STR(blob.bssid), blob.channel);
+    }
+}
+
+/**
+ * @brief 按缓存指定 / 取消指定 BSSID 与信道
+ *
+ * 指定时只在缓存信道上探测该 AP；取消时全信道扫描并按信号强度选择 AP。
+ * 缓存的 SSID 与当前配置不同（重新配网）时不指定。
+ * @param sta STA 配置（就地修改）
+ * @param pin 是否指定
+ * @return 实际是否指定
+ */
+static bool fast_apply(wifi_sta_config_t *sta, bool pin)
+{
+#if CONFIG_WIFI_FAST_CONNECT
+    pin = pin && s_fast.version == WIFI_FAST_VERSION &&
+          memcmp(sta->ssid, s_fast.ssid, sizeof(sta->ssid)) == 0;
+#else
+    pin = false;
+#endif
+    sta->bssid_set = pin;
+    if (pin) {
+        memcpy(sta->bssid, s_fast.bssid, sizeof(sta->bssid));
+        sta->channel = s_fast.channel;
+        sta->scan_method = WIFI_FAST_SCAN;
+    } else {
+        sta->channel = 0;
+        sta->scan_method = WIFI_ALL_CHANNEL_SCAN;
+        sta->sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    return pin;
+}
+
 /**
- * @brief WiFi 重连定时器回调（在定时器任务上下文中执行，不阻塞事件循环）
+ * @brief 修改当前 STA 配置的指定状态（下次 esp_wifi_connect() 生效）
  */
-static void reconnect_timer_callback(TimerHandle_t xTimer)
+static void fast_pin(bool pin)
 {
-    ESP_LOGI(TAG, "执行 WiFi 重连...");
-    esp_wifi_connect();
+    wifi_config_t wifi_config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) != ESP_OK) {
+        return;
+    }
+    s_pinned = fast_apply(&wifi_config.sta, pin);
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
 }
 
 /**
@@ -64,47 +209,44 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 esp_wifi_connect();
                 break;
 
-            case WIFI_EVENT_STA_CONNECTED:
-                ESP_LOGI(TAG, "WiFi 连接成功");
+            case WIFI_EVENT_STA_CONNECTED: {
+                wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *) event_data;
+                ESP_LOGI(TAG, "WiFi 连接成功（%s）", s_pinned ? "快速连接" : "扫描");
                 s_retry_count = 0;  // 重置重试计数
+                s_link_was_up = true;
+                s_fast_stats.last_fast = s_pinned;
+                if (s_pinned) {
+                    s_fast_stats.hits++;
+                }
+                fast_cache_update(event);
+                conn_supervisor_on_link_up();
                 break;
+            }
 
             case WIFI_EVENT_STA_DISCONNECTED: {
                 wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t*) event_data;
                 ESP_LOGW(TAG, "WiFi 连接断开，原因: %d", event->reason);
+                metric_counter_inc(&s_disconnects[disconnect_category(event->reason)]);
 
                 xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
 
-                if (s_is_runtime) {
-                    // 运行时：无限重试，使用定时器延迟 10 秒后重连
-                    ESP_LOGI(TAG, "运行时断线，将在 %d 秒后重连...", WIFI_RUNTIME_RETRY_DELAY_MS / 1000);
-                    if (s_reconnect_timer != NULL) {
-                        xTimerChangePeriod(s_reconnect_timer, pdMS_TO_TICKS(WIFI_RUNTIME_RETRY_DELAY_MS), 0);
-                        xTimerStart(s_reconnect_timer, 0);
-                    } else {
-                        // 定时器未创建，直接重连（兜底）
-                        ESP_LOGW(TAG, "重连定时器未创建，立即重连");
-                        esp_wifi_connect();
-                    }
-                } else {
-                    // 初始化阶段：最多重试 3 次，使用定时器延迟 5 秒后重连
-                    if (s_retry_count < WIFI_INIT_MAX_RETRY_COUNT) {
-                        s_retry_count++;
-                        ESP_LOGI(TAG, "初始化阶段连接失败，重试 %d/%d（%d 秒后）",
-                                s_retry_count, WIFI_INIT_MAX_RETRY_COUNT,
-                                WIFI_INIT_RETRY_INTERVAL_MS / 1000);
-                        if (s_reconnect_timer != NULL) {
-                            xTimerChangePeriod(s_reconnect_timer, pdMS_TO_TICKS(WIFI_INIT_RETRY_INTERVAL_MS), 0);
-                            xTimerStart(s_reconnect_timer, 0);
-                        } else {
-                            // 定时器未创建，直接重连（兜底）
-                            ESP_LOGW(TAG, "重连定时器未创建，立即重连");
-                            esp_wifi_connect();
-                        }
-                    } else {
-                        ESP_LOGE(TAG, "初始化阶段连接失败，已达最大重试次数");
-                        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-                    }
+                // 断线后第一次重连直连缓存的 AP；直连失败则改为全信道扫描，直到再次关联成功
+                if (s_link_was_up) {
+                    s_link_was_up = false;
+                    fast_pin(true);
+                } else if (s_pinned) {
+                    s_fast_stats.fallbacks++;
+                    ESP_LOGW(TAG, "快速连接失败，改为全信道扫描");
+                    fast_pin(false);
+                }
+
+                // 重连由连接监管按退避安排（运行时无限重试）
+                conn_supervisor_on_link_down(event->reason);
+
+                // 初始化阶段：重试 3 次仍失败则结束等待，重连在后台继续
+                if (!s_is_runtime && ++s_retry_count > WIFI_INIT_MAX_RETRY_COUNT) {
+                    ESP_LOGE(TAG, "初始化阶段连接失败，已达最大重试次数，后台继续重连");
+                    xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
                 }
                 break;
             }
@@ -117,6 +259,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
             ESP_LOGI(TAG, "获得 IP 地址: " IPSTR, IP2STR(&event->ip_info.ip));
             xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+            conn_supervisor_on_ip_up();
         }
     } else if (event_base == SC_EVENT) {
         switch (event_id) {
@@ -141,7 +284,9 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 wifi_config_t wifi_config = {0};
                 memcpy(wifi_config.sta.ssid, evt->ssid, sizeof(wifi_config.sta.ssid));
                 memcpy(wifi_config.sta.password, evt->password, sizeof(wifi_config.sta.password));
+                wifi_config.sta.listen_interval = POWER_WIFI_LISTEN_INTERVAL;
 
+                s_pinned = fast_apply(&wifi_config.sta, true);  // 新 SSID 与缓存不符时全信道扫描
                 esp_wifi_disconnect();
                 esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
                 esp_wifi_connect();
@@ -204,6 +349,8 @@ esp_err_t wifi_manager_init(void)
     }
 
     ESP_LOGI(TAG, "初始化 WiFi 管理器");
+    metrics_register_counter(s_disconnects, WIFI_DISC_COUNT, "wifi_disconnects_total",
+                             "WiFi 断开或关联失败次数", "reason", s_disc_labels);
 
     // 1. 初始化 NVS
     esp_err_t ret = nvs_flash_init();
@@ -220,6 +367,13 @@ esp_err_t wifi_manager_init(void)
     // 3. 创建默认事件循环
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
+    // 3.1 启动 SNTP（获得 IP 后自动同步，作息学习与夜间模式依赖本地时间）
+    esp_sntp_config_t sntp_cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER);
+    sntp_cfg.wait_for_sync = false;
+    if (esp_netif_sntp_init(&sntp_cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "SNTP 启动失败，本地时间不可用");
+    }
+
     // 4. 创建默认 WiFi STA netif
     esp_netif_create_default_wifi_sta();
 
@@ -239,21 +393,18 @@ esp_err_t wifi_manager_init(void)
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(SC_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
 
-    // 8. 配置 WiFi 为 STA 模式
+    // 8. 配置 WiFi 为 STA 模式（凭据由本模块存 NVS，驱动配置只放 RAM，切换快速连接时不写 Flash）
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
 
-    // 9. 创建重连定时器（单次触发）
-    s_reconnect_timer = xTimerCreate("wifi_reconnect",
-                                     pdMS_TO_TICKS(WIFI_INIT_RETRY_INTERVAL_MS),
-                                     pdFALSE,  // 单次触发
-                                     NULL,
-                                     reconnect_timer_callback);
-    if (s_reconnect_timer == NULL) {
-        ESP_LOGE(TAG, "创建重连定时器失败");
-        return ESP_FAIL;
-    }
+    // 8.1 Modem sleep：射频只在 listen interval（Max modem）或 DTIM（Min modem）醒来接收
+#if CONFIG_POWER_WIFI_MAX_MODEM
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MAX_MODEM));
+#else
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
+#endif
 
-    // 10. 尝试从 NVS 读取配置
+    // 9. 尝试从 NVS 读取配置
     char ssid[32] = {0};
     char password[64] = {0};
     wifi_config_t wifi_config = {0};
@@ -285,11 +436,17 @@ esp_err_t wifi_manager_init(void)
     }
 
     if (has_config) {
-        // 有配置（NVS 或 menuconfig），尝试连接
+        // 有配置（NVS 或 menuconfig），尝试连接；有缓存时先直连上次的 AP
+        wifi_config.sta.listen_interval = POWER_WIFI_LISTEN_INTERVAL;
+        fast_cache_load();
+        s_pinned = fast_apply(&wifi_config.sta, true);
+        if (s_pinned) {
+            ESP_LOGI(TAG, "快速连接: " MACSTR "，信道 %d", MAC2STR(s_fast.bssid), s_fast.channel);
+        }
         ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
         ESP_ERROR_CHECK(esp_wifi_start());
 
-        // 等待连接结果（最多 WIFI_INIT_MAX_RETRY_COUNT * WIFI_INIT_RETRY_INTERVAL_MS）
+        // 等待连接结果（最多 WIFI_INIT_MAX_RETRY_COUNT 次失败）
         EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
                                                WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
                                                pdFALSE,
@@ -303,7 +460,7 @@ esp_err_t wifi_manager_init(void)
             return ESP_OK;
         } else if (bits & WIFI_FAIL_BIT) {
             ESP_LOGE(TAG, "WiFi 连接失败");
-            s_is_runtime = false;
+            s_is_runtime = true;   // 后台重连成功后无需再次等待
             s_initialized = true;  // 标记为已初始化，但连接失败
             return ESP_FAIL;
         }
@@ -330,6 +487,9 @@ esp_err_t wifi_manager_start_provisioning(void)
     // 清除 SC_DONE_BIT
     xEventGroupClearBits(s_wifi_event_group, SC_DONE_BIT);
 
+    // 配网期间由 SmartConfig 流程自行连接，暂停后台重连
+    conn_supervisor_hold_link(true);
+
     // 启动 SmartConfig
     ESP_ERROR_CHECK(esp_smartconfig_set_type(SC_TYPE_ESPTOUCH));
     smartconfig_start_config_t cfg = SMARTCONFIG_START_CONFIG_DEFAULT();
@@ -344,6 +504,7 @@ esp_err_t wifi_manager_start_provisioning(void)
 
     // 停止 SmartConfig
     esp_smartconfig_stop();
+    conn_supervisor_hold_link(false);
 
     if (bits & SC_DONE_BIT) {
         ESP_LOGI(TAG, "SmartConfig 配网成功");
@@ -378,3 +539,10 @@ bool wifi_manager_is_connected(void)
     EventBits_t bits = xEventGroupGetBits(s_wifi_event_group);
     return (bits & WIFI_CONNECTED_BIT) != 0;
 }
+
+void wifi_manager_get_fast_stats(WifiFastStats *out)
+{
+    if (out) {
+        *out = s_fast_stats;
+    }
+}
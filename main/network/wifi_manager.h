@@ -8,6 +8,19 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 快速连接统计（启动以来）
+ *
+ * CONFIG_WIFI_FAST_CONNECT 时每次关联成功后缓存 AP 的 BSSID 与信道（NVS），
+ * 开机与断线后的第一次连接直接在该信道上连接该 AP；失败后改为全信道扫描。
+ */
+typedef struct {
+    uint32_t hits;         ///< 直连缓存 AP 成功次数
+    uint32_t fallbacks;    ///< 直连失败改为全信道扫描的次数
+    bool last_fast;        ///< 最近一次关联是否为直连
+} WifiFastStats;
 
 /**
  * @brief 初始化 WiFi 管理器
@@ -30,4 +43,10 @@ esp_err_t wifi_manager_start_provisioning(void);
  */
 bool wifi_manager_is_connected(void);
 
+/**
+ * @brief 获取快速连接统计
+ * @param[out] out 统计
+ */
+void wifi_manager_get_fast_stats(WifiFastStats *out);
+
 #endif // WIFI_MANAGER_H
@@ -4,6 +4,7 @@
  */
 
 #include "co2_sensor.h"
+#include "metrics.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "driver/uart.h"
@@ -19,6 +20,11 @@ static uint32_t s_init_time = 0;  // 初始化时间（秒）
 #define CO2_SENSOR_UART_RX  GPIO_NUM_16
 #define CO2_SENSOR_UART_BUF_SIZE 1024  // 规格要求 1024 字节以容纳多帧
 
+// 读数失败计数（按原因）
+enum { CO2_ERR_TIMEOUT = 0, CO2_ERR_NO_MARKER, CO2_ERR_NO_VALUE, CO2_ERR_RANGE, CO2_ERR_COUNT };
+static const char *const s_err_labels[CO2_ERR_COUNT] = {"timeout", "no_marker", "no_value", "range"};
+static MetricCounter s_read_errors[CO2_ERR_COUNT];
+
 esp_err_t co2_sensor_init(void) {
     if (s_uart_ready) {
         return ESP_OK;
@@ -57,6 +63,9 @@ esp_err_t co2_sensor_init(void) {
         return err;
     }
 
+    metrics_register_counter(s_read_errors, CO2_ERR_COUNT, "co2_read_errors_total",
+                             "CO2 读数失败次数", "reason", s_err_labels);
+
     s_uart_ready = true;
     s_init_time = xTaskGetTickCount() / configTICK_RATE_HZ;  // 记录初始化时间
     ESP_LOGI(TAG, "CO2 UART 初始化完成 GPIO16/17 9600 8N1");
@@ -93,6 +102,7 @@ float co2_sensor_read_ppm(void) {
     if (total_len <= 0) {
         // 无数据或超时
         ESP_LOGW(TAG, "CO2 raw read timeout");
+        metric_counter_inc(&s_read_errors[CO2_ERR_TIMEOUT]);
         return -1.0f;
     }
 
@@ -103,6 +113,7 @@ float co2_sensor_read_ppm(void) {
     char *ppm_pos = strstr((char *)buffer, "ppm");
     if (!ppm_pos) {
         ESP_LOGW(TAG, "未找到 'ppm' 标志 (raw='%s')", (char *)buffer);
+        metric_counter_inc(&s_read_errors[CO2_ERR_NO_MARKER]);
         return -1.0f;
     }
 
@@ -129,6 +140,7 @@ float co2_sensor_read_ppm(void) {
 
     if (i == 0) {
         ESP_LOGW(TAG, "未找到有效数值 (raw='%s')", (char *)buffer);
+        metric_counter_inc(&s_read_errors[CO2_ERR_NO_VALUE]);
         return -1.0f;
     }
 
@@ -138,6 +150,7 @@ float co2_sensor_read_ppm(void) {
     // 范围验证（JX-CO2-102-5K: 0-5000 ppm）
     if (co2_ppm < 0.0f || co2_ppm > 5000.0f) {
         ESP_LOGW(TAG, "CO₂ 浓度超出范围: %.1f ppm", co2_ppm);
+        metric_counter_inc(&s_read_errors[CO2_ERR_RANGE]);
         return -1.0f;
     }
 
@@ -6,6 +6,7 @@
 #include "sensor_manager.h"
 #include "co2_sensor.h"
 #include "sht35.h"
+#include "runtime_config.h"
 #include "../main.h"
 #include "esp_log.h"
 #include <sys/time.h>
@@ -50,8 +51,9 @@ esp_err_t sensor_manager_read_all(SensorData *data) {
     }
 
     // 读取 CO2
+    const RuntimeConfig *cfg = runtime_config_get();
     float co2_value = co2_sensor_read_ppm();
-    bool co2_valid = (co2_value >= CO2_MIN_VALID && co2_value <= CO2_MAX_VALID);
+    bool co2_valid = (co2_value >= cfg->co2_min_valid && co2_value <= cfg->co2_max_valid);
     bool using_cache = false;  // 是否使用缓存值
 
     // 如果 CO₂ 读取失败，尝试使用缓存值
@@ -102,8 +104,8 @@ esp_err_t sensor_manager_read_all(SensorData *data) {
     data->timestamp = tv.tv_sec;
 
     // 数据有效性检查
-    bool temp_valid = (data->temperature >= TEMP_MIN_VALID && data->temperature <= TEMP_MAX_VALID);
-    bool humi_valid = (data->humidity >= HUMI_MIN_VALID && data->humidity <= HUMI_MAX_VALID);
+    bool temp_valid = (data->temperature >= cfg->temp_min_valid && data->temperature <= cfg->temp_max_valid);
+    bool humi_valid = (data->humidity >= cfg->humi_min_valid && data->humidity <= cfg->humi_max_valid);
 
     // 如果使用缓存且温湿度有效，数据仍然可用
     if (using_cache) {
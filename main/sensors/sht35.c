@@ -4,7 +4,9 @@
  */
 
 #include "sht35.h"
+#include "metrics.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c.h"
 
 static const char *TAG = "SHT35";
@@ -16,6 +18,13 @@ static bool s_i2c_ready = false;
 #define SHT35_I2C_SCL           GPIO_NUM_20
 #define SHT35_I2C_FREQ_HZ       400000
 
+// 读取失败计数（按原因）与读取耗时（含 50 ms 测量等待）
+enum { SHT35_ERR_I2C = 0, SHT35_ERR_CRC, SHT35_ERR_COUNT };
+static const char *const s_err_labels[SHT35_ERR_COUNT] = {"i2c", "crc"};
+static MetricCounter s_errors[SHT35_ERR_COUNT];
+static const uint32_t s_read_bounds[] = {55000, 60000, 75000, 100000, 250000, 1000000};
+static MetricHistogram s_read_us;
+
 esp_err_t sht35_init(void) {
     if (s_i2c_ready) {
         return ESP_OK;
@@ -42,6 +51,11 @@ esp_err_t sht35_init(void) {
         return err;
     }
 
+    metrics_register_counter(s_errors, SHT35_ERR_COUNT, "sht35_errors_total",
+                             "SHT35 读取失败次数", "reason", s_err_labels);
+    metrics_register_histogram(&s_read_us, "sht35_read_us", "SHT35 单次读取耗时（微秒）",
+                               s_read_bounds, sizeof(s_read_bounds) / sizeof(s_read_bounds[0]));
+
     s_i2c_ready = true;
     ESP_LOGI(TAG, "初始化 SHT35 完成 I2C GPIO21/20 400kHz 地址0x44");
     return ESP_OK;
@@ -78,6 +92,8 @@ esp_err_t sht35_read(float *temp, float *humi) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    int64_t start = esp_timer_get_time();
+
     // 发送单次测量命令（高重复性）：0x2C 0x06
     uint8_t cmd[2] = {0x2C, 0x06};
     i2c_cmd_handle_t cmd_handle = i2c_cmd_link_create();
@@ -90,6 +106,7 @@ esp_err_t sht35_read(float *temp, float *humi) {
 
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "发送测量命令失败 (%d)", err);
+        metric_counter_inc(&s_errors[SHT35_ERR_I2C]);
         return err;
     }
 
@@ -115,6 +132,7 @@ esp_err_t sht35_read(float *temp, float *humi) {
 
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "最终读取数据失败 (%d)", err);
+        metric_counter_inc(&s_errors[SHT35_ERR_I2C]);
         return err;
     }
 
@@ -122,6 +140,7 @@ esp_err_t sht35_read(float *temp, float *humi) {
     uint8_t temp_crc = crc8_compute(data, 2);
     if (temp_crc != data[2]) {
         ESP_LOGW(TAG, "温度 CRC 校验失败 (计算:%02X, 接收:%02X)", temp_crc, data[2]);
+        metric_counter_inc(&s_errors[SHT35_ERR_CRC]);
         return ESP_ERR_INVALID_CRC;
     }
 
@@ -129,6 +148,7 @@ esp_err_t sht35_read(float *temp, float *humi) {
     uint8_t humi_crc = crc8_compute(data + 3, 2);
     if (humi_crc != data[5]) {
         ESP_LOGW(TAG, "湿度 CRC 校验失败 (计算:%02X, 接收:%02X)", humi_crc, data[5]);
+        metric_counter_inc(&s_errors[SHT35_ERR_CRC]);
         return ESP_ERR_INVALID_CRC;
     }
 
@@ -139,6 +159,7 @@ esp_err_t sht35_read(float *temp, float *humi) {
     *temp = -45.0f + 175.0f * ((float)raw_temp / 65535.0f);
     *humi = 100.0f * ((float)raw_humi / 65535.0f);
 
+    metric_histogram_observe(&s_read_us, (uint32_t)(esp_timer_get_time() - start));
     ESP_LOGI(TAG, "SHT35 OK T=%.2f H=%.2f", *temp, *humi);
 
     return ESP_OK;
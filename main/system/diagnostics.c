@@ -0,0 +1,296 @@
+/**
+ * @file diagnostics.c
+ * @brief 运行诊断
+ *
+ * 任务 CPU 占用：相邻两次采样之间各任务运行时间计数之差 / 运行时间计时器之差。
+ * 任务按 xTaskNumber 与上次采样对应；窗口内新建的任务从 0 开始计，结果同样准确。
+ * 运行时间计数为 32 位微秒计数，约 71 分钟回绕一次，采样间隔远小于回绕周期，无符号相减即可。
+ *
+ * 堆告警带回差（恢复到阈值 + DIAG_HEAP_HYST_BYTES 以上才解除）；栈高水位只会下降，
+ * 栈告警一旦出现不再解除；CPU 告警按每个窗口重新判定。只有新出现的告警触发立即上报。
+ */
+
+#include "diagnostics.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "DIAG";
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define DIAG_TASK_STATS 1
+
+/**
+ * @brief 上次采样时的任务基准
+ */
+typedef struct {
+    UBaseType_t number;                 ///< xTaskNumber
+    configRUN_TIME_COUNTER_TYPE run;    ///< 运行时间计数
+    uint8_t alarms;                     ///< 告警（用于判断是否新出现）
+} TaskBaseline;
+
+static TaskStatus_t s_status[DIAG_MAX_TASKS];   ///< uxTaskGetSystemState 输出（静态，避免占用网络任务栈）
+static TaskBaseline s_base[DIAG_MAX_TASKS];
+static int s_base_count = 0;
+static configRUN_TIME_COUNTER_TYPE s_base_total = 0;
+static bool s_truncated_logged = false;
+#endif
+
+static DiagSnapshot s_snap;
+static bool s_started = false;
+static uint32_t s_last_sample_sec = 0;
+static uint32_t s_next_sample_sec = 0;
+static uint32_t s_next_publish_sec = 0;
+static volatile bool s_report_pending = false;
+
+// 堆内存仪表（每次采样更新，供 HTTP 等导出端直接读取）
+static MetricGauge s_heap_free_gauge;
+static MetricGauge s_heap_min_free_gauge;
+static MetricGauge s_heap_largest_gauge;
+
+#if DIAG_TASK_STATS
+/**
+ * @brief 采样各任务 CPU 占用与栈高水位
+ * @param has_window 是否已有上次采样（第一次采样只建立基准，CPU 占用记为 0）
+ * @return 新出现的告警
+ */
+static uint8_t sample_tasks(bool has_window)
+{
+    UBaseType_t n = uxTaskGetSystemState(s_status, DIAG_MAX_TASKS, NULL);
+    configRUN_TIME_COUNTER_TYPE total = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE total_delta = total - s_base_total;
+    s_base_total = total;
+
+    if (n == 0) {
+        // 数组不足以容纳全部任务时 uxTaskGetSystemState 不输出任何任务
+        if (!s_truncated_logged) {
+            ESP_LOGW(TAG, "任务数超过 %d，不统计任务数据", DIAG_MAX_TASKS);
+            s_truncated_logged = true;
+        }
+        s_snap.tasks_truncated = true;
+        s_snap.task_count = 0;
+        s_snap.cpu_busy_pct = 0.0f;
+        s_base_count = 0;
+        return 0;
+    }
+    s_snap.tasks_truncated = false;
+
+    TaskHandle_t idle[portNUM_PROCESSORS];
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        idle[i] = xTaskGetIdleTaskHandleForCore(i);
+    }
+
+    uint8_t raised = 0;
+    configRUN_TIME_COUNTER_TYPE idle_delta = 0;
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *st = &s_status[i];
+        configRUN_TIME_COUNTER_TYPE prev_run = 0;
+        uint8_t prev_alarms = 0;
+        for (int j = 0; j < s_base_count; j++) {
+            if (s_base[j].number == st->xTaskNumber) {
+                prev_run = s_base[j].run;
+                prev_alarms = s_base[j].alarms;
+                break;
+            }
+        }
+
+        bool is_idle = false;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            if (st->xHandle == idle[c]) {
+                is_idle = true;
+            }
+        }
+
+        configRUN_TIME_COUNTER_TYPE run_delta = st->ulRunTimeCounter - prev_run;
+        if (is_idle) {
+            idle_delta += run_delta;
+        }
+
+        DiagTask *t = &s_snap.tasks[i];
+        strncpy(t->name, st->pcTaskName, sizeof(t->name) - 1);
+        t->name[sizeof(t->name) - 1] = '\0';
+        t->priority = (uint8_t)st->uxCurrentPriority;
+        t->cpu_pct = (has_window && total_delta > 0) ? (float)run_delta * 100.0f / (float)total_delta : 0.0f;
+        t->stack_free = st->usStackHighWaterMark;
+        t->alarms = 0;
+        if (t->stack_free < DIAG_STACK_LOW_BYTES) {
+            t->alarms |= DIAG_ALARM_STACK_LOW;
+        }
+        if (!is_idle && t->cpu_pct > DIAG_TASK_CPU_HIGH_PCT) {
+            t->alarms |= DIAG_ALARM_CPU_HIGH;
+        }
+
+        uint8_t new_alarms = t->alarms & ~prev_alarms;
+        if (new_alarms & DIAG_ALARM_STACK_LOW) {
+            ESP_LOGW(TAG, "任务 %s 栈剩余高水位 %lu 字节（阈值 %d）",
+                     t->name, (unsigned long)t->stack_free, DIAG_STACK_LOW_BYTES);
+        }
+        if (new_alarms & DIAG_ALARM_CPU_HIGH) {
+            ESP_LOGW(TAG, "任务 %s CPU 占用 %.1f%%（阈值 %.0f%%）",
+                     t->name, t->cpu_pct, DIAG_TASK_CPU_HIGH_PCT);
+        }
+        raised |= new_alarms;
+
+        s_base[i].number = st->xTaskNumber;
+        s_base[i].run = st->ulRunTimeCounter;
+        s_base[i].alarms = t->alarms;
+    }
+    s_base_count = n;
+    s_snap.task_count = n;
+
+    if (has_window && total_delta > 0) {
+        float idle_pct = (float)idle_delta * 100.0f / ((float)total_delta * portNUM_PROCESSORS);
+        s_snap.cpu_busy_pct = idle_pct < 100.0f ? 100.0f - idle_pct : 0.0f;
+    } else {
+        s_snap.cpu_busy_pct = 0.0f;
+    }
+
+    // 按 CPU 占用降序（插入排序，任务数很少）
+    for (int i = 1; i < s_snap.task_count; i++) {
+        DiagTask t = s_snap.tasks[i];
+        int j = i - 1;
+        while (j >= 0 && s_snap.tasks[j].cpu_pct < t.cpu_pct) {
+            s_snap.tasks[j + 1] = s_snap.tasks[j];
+            j--;
+        }
+        s_snap.tasks[j + 1] = t;
+    }
+    return raised;
+}
+#endif  // DIAG_TASK_STATS
+
+/**
+ * @brief 采样堆内存
+ * @return 新出现的告警
+ */
+static uint8_t sample_heap(void)
+{
+    s_snap.heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s_snap.heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    s_snap.heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s_snap.internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    metric_gauge_set(&s_heap_free_gauge, (int32_t)s_snap.heap_free);
+    metric_gauge_set(&s_heap_min_free_gauge, (int32_t)s_snap.heap_min_free);
+    metric_gauge_set(&s_heap_largest_gauge, (int32_t)s_snap.heap_largest);
+    s_snap.heap_frag_pct = s_snap.heap_free > 0 ?
+        (1.0f - (float)s_snap.heap_largest / (float)s_snap.heap_free) * 100.0f : 0.0f;
+
+    uint8_t prev = s_snap.alarms & (DIAG_ALARM_HEAP_LOW | DIAG_ALARM_HEAP_FRAGMENTED);
+    uint8_t now = 0;
+    if (s_snap.heap_free < DIAG_HEAP_LOW_BYTES ||
+        ((prev & DIAG_ALARM_HEAP_LOW) && s_snap.heap_free < DIAG_HEAP_LOW_BYTES + DIAG_HEAP_HYST_BYTES)) {
+        now |= DIAG_ALARM_HEAP_LOW;
+    }
+    if (s_snap.heap_largest < DIAG_HEAP_LARGEST_MIN_BYTES ||
+        ((prev & DIAG_ALARM_HEAP_FRAGMENTED) &&
+         s_snap.heap_largest < DIAG_HEAP_LARGEST_MIN_BYTES + DIAG_HEAP_HYST_BYTES)) {
+        now |= DIAG_ALARM_HEAP_FRAGMENTED;
+    }
+
+    uint8_t raised = now & ~prev;
+    if (raised & DIAG_ALARM_HEAP_LOW) {
+        ESP_LOGW(TAG, "堆空闲不足: %lu 字节（阈值 %d，最低 %lu）", (unsigned long)s_snap.heap_free,
+                 DIAG_HEAP_LOW_BYTES, (unsigned long)s_snap.heap_min_free);
+    }
+    if (raised & DIAG_ALARM_HEAP_FRAGMENTED) {
+        ESP_LOGW(TAG, "堆最大连续块 %lu 字节（阈值 %d），碎片率 %.0f%%",
+                 (unsigned long)s_snap.heap_largest, DIAG_HEAP_LARGEST_MIN_BYTES, s_snap.heap_frag_pct);
+    }
+    if (prev & ~now) {
+        ESP_LOGI(TAG, "堆告警解除: 空闲 %lu 字节，最大块 %lu 字节",
+                 (unsigned long)s_snap.heap_free, (unsigned long)s_snap.heap_largest);
+    }
+    s_snap.alarms = now;
+    return raised;
+}
+
+/**
+ * @brief 采样一次并检查阈值
+ */
+static void sample(uint32_t now_sec, bool has_window)
+{
+    uint8_t raised = sample_heap();
+#if DIAG_TASK_STATS
+    raised |= sample_tasks(has_window);
+    for (int i = 0; i < s_snap.task_count; i++) {
+        s_snap.alarms |= s_snap.tasks[i].alarms;
+    }
+#endif
+    s_snap.window_sec = has_window ? now_sec - s_last_sample_sec : 0;
+    s_last_sample_sec = now_sec;
+
+    ESP_LOGD(TAG, "采样: CPU %.1f%%，堆空闲 %lu（最低 %lu，最大块 %lu），任务 %d 个，告警 0x%02x",
+             s_snap.cpu_busy_pct, (unsigned long)s_snap.heap_free, (unsigned long)s_snap.heap_min_free,
+             (unsigned long)s_snap.heap_largest, s_snap.task_count, s_snap.alarms);
+
+    if (raised) {
+        s_report_pending = true;
+    }
+}
+
+esp_err_t diagnostics_init(void)
+{
+    esp_err_t ret = metrics_register_gauge(&s_heap_free_gauge, "heap_free_bytes", "堆当前空闲（字节）");
+    if (ret == ESP_OK) {
+        ret = metrics_register_gauge(&s_heap_min_free_gauge, "heap_min_free_bytes", "堆启动以来最低空闲（字节）");
+    }
+    if (ret == ESP_OK) {
+        ret = metrics_register_gauge(&s_heap_largest_gauge, "heap_largest_block_bytes", "堆最大连续空闲块（字节）");
+    }
+    return ret;
+}
+
+void diagnostics_update(uint32_t now_sec)
+{
+    if (!s_started) {
+        // 第一次调用只建立基准，完成第一个窗口后上报一次
+        s_started = true;
+        sample(now_sec, false);
+        s_next_sample_sec = now_sec + DIAG_SAMPLE_SEC;
+        s_next_publish_sec = s_next_sample_sec;
+        return;
+    }
+    if (now_sec < s_next_sample_sec) {
+        return;
+    }
+
+    sample(now_sec, true);
+    s_next_sample_sec = now_sec + DIAG_SAMPLE_SEC;
+    if (now_sec >= s_next_publish_sec) {
+        s_report_pending = true;
+        s_next_publish_sec = now_sec + DIAG_PUBLISH_SEC;
+    }
+}
+
+bool diagnostics_take_report_pending(void)
+{
+    bool pending = s_report_pending;
+    s_report_pending = false;
+    return pending;
+}
+
+void diagnostics_request_report(void)
+{
+    s_report_pending = true;
+}
+
+void diagnostics_get_snapshot(DiagSnapshot *out)
+{
+    if (out) {
+        *out = s_snap;
+    }
+}
+
+const char *diag_alarm_to_string(DiagAlarm alarm)
+{
+    switch (alarm) {
+        case DIAG_ALARM_HEAP_LOW:        return "HEAP_LOW";
+        case DIAG_ALARM_HEAP_FRAGMENTED: return "HEAP_FRAGMENTED";
+        case DIAG_ALARM_STACK_LOW:       return "STACK_LOW";
+        case DIAG_ALARM_CPU_HIGH:        return "CPU_HIGH";
+        default:                         return "UNKNOWN";
+    }
+}
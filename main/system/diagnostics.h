@@ -0,0 +1,95 @@
+/**
+ * @file diagnostics.h
+ * @brief 运行诊断接口定义 - 任务 CPU 占用、栈高水位与堆内存采样及阈值告警
+ *
+ * 每 DIAG_SAMPLE_SEC 秒采样一次（由网络任务调用 diagnostics_update()）：
+ * - 各任务在采样窗口内的 CPU 占用（FreeRTOS 运行时间统计，按单核百分比计）与栈剩余高水位
+ * - 堆（MALLOC_CAP_8BIT）当前空闲、启动以来最低空闲、最大连续块与碎片率，以及内部 RAM 空闲
+ * 每 DIAG_PUBLISH_SEC 秒上报一次；新出现告警时立即上报（见 mqtt_publish_diag()）。
+ *
+ * 栈剩余高水位用于核对 main.h 中 TASK_STACK_SIZE_SMALL / TASK_STACK_SIZE_LARGE 的取值；
+ * 堆内存缓慢泄漏表现为 heap.free / heap.min_free 在多次上报中持续下降。
+ * 全部状态只在网络任务中读写（远程请求上报的标志除外）。
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "main.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 诊断告警（位掩码）
+ */
+typedef enum {
+    DIAG_ALARM_HEAP_LOW        = 1 << 0,    ///< 堆空闲低于 DIAG_HEAP_LOW_BYTES
+    DIAG_ALARM_HEAP_FRAGMENTED = 1 << 1,    ///< 最大连续块低于 DIAG_HEAP_LARGEST_MIN_BYTES
+    DIAG_ALARM_STACK_LOW       = 1 << 2,    ///< 任务栈剩余高水位低于 DIAG_STACK_LOW_BYTES
+    DIAG_ALARM_CPU_HIGH        = 1 << 3,    ///< 任务在采样窗口内 CPU 占用高于 DIAG_TASK_CPU_HIGH_PCT
+} DiagAlarm;
+
+/**
+ * @brief 单个任务的诊断数据
+ */
+typedef struct {
+    char name[DIAG_TASK_NAME_LEN];  ///< 任务名
+    uint8_t priority;               ///< 当前优先级
+    float cpu_pct;                  ///< 采样窗口内 CPU 占用（%，单核百分比，满载一个核为 100）
+    uint32_t stack_free;            ///< 栈剩余高水位（字节，启动以来最少剩余）
+    uint8_t alarms;                 ///< 该任务的告警（DiagAlarm 位掩码）
+} DiagTask;
+
+/**
+ * @brief 诊断快照（最近一次采样）
+ */
+typedef struct {
+    uint32_t window_sec;            ///< 采样窗口长度（秒，0 = 尚未完成第一个窗口）
+    float cpu_busy_pct;             ///< 窗口内 CPU 忙碌率（%，各核平均）
+    uint32_t heap_free;             ///< 堆当前空闲（字节）
+    uint32_t heap_min_free;         ///< 堆启动以来最低空闲（字节）
+    uint32_t heap_largest;          ///< 堆最大连续空闲块（字节）
+    float heap_frag_pct;            ///< 碎片率（%，1 - 最大块 / 空闲）
+    uint32_t internal_free;         ///< 内部 RAM 空闲（字节，WiFi / TLS 缓冲区需要内部 RAM）
+    uint8_t alarms;                 ///< 当前告警（DiagAlarm 位掩码，含各任务告警的并集）
+    uint8_t task_count;             ///< tasks 中的有效项数（按 CPU 占用降序）
+    bool tasks_truncated;           ///< 任务数超过 DIAG_MAX_TASKS，本次没有任务数据
+    DiagTask tasks[DIAG_MAX_TASKS];
+} DiagSnapshot;
+
+/**
+ * @brief 初始化（登记堆内存仪表，见 metrics.h）
+ * @return ESP_OK 成功，其他为登记失败（诊断采样不受影响）
+ */
+esp_err_t diagnostics_init(void);
+
+/**
+ * @brief 周期调用（网络任务每秒一次），到达采样间隔时采样并检查阈值
+ * @param now_sec 当前时间（秒，系统节拍计）
+ */
+void diagnostics_update(uint32_t now_sec);
+
+/**
+ * @brief 取出并清除"待上报"标志（定时上报、新告警或远程请求）
+ * @return true 需要发布诊断消息
+ */
+bool diagnostics_take_report_pending(void);
+
+/**
+ * @brief 请求在下一个周期上报诊断（远程命令或发布失败后重试）
+ */
+void diagnostics_request_report(void);
+
+/**
+ * @brief 获取最近一次采样的快照
+ * @param[out] out 快照
+ */
+void diagnostics_get_snapshot(DiagSnapshot *out);
+
+/**
+ * @brief 单个告警位转字符串（用于日志与 MQTT 上报）
+ */
+const char *diag_alarm_to_string(DiagAlarm alarm);
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,136 @@
+/**
+ * @file metrics.c
+ * @brief 指标登记表
+ *
+ * 登记只在各模块初始化时发生，加锁串行化；表项写完后才发布新的计数（release），
+ * 读者先读计数（acquire）再读表项，因此读取不加锁。
+ */
+
+#include "metrics.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "METRICS";
+
+static MetricDesc s_metrics[METRICS_MAX];
+static _Atomic int s_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 登记一项（storage 为指标存储地址，用于识别重复登记）
+ */
+static esp_err_t register_desc(const MetricDesc *desc, const void *storage)
+{
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&s_lock);
+    int n = atomic_load_explicit(&s_count, memory_order_relaxed);
+    for (int i = 0; i < n; i++) {
+        if (s_metrics[i].counters == storage) {
+            portEXIT_CRITICAL(&s_lock);
+            return ESP_OK;
+        }
+    }
+    if (n >= METRICS_MAX) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        s_metrics[n] = *desc;
+        atomic_store_explicit(&s_count, n + 1, memory_order_release);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "登记表已满（%d 项），未登记 %s", METRICS_MAX, desc->name);
+    }
+    return ret;
+}
+
+esp_err_t metrics_register_counter(MetricCounter *counters, uint8_t count, const char *name,
+                                   const char *help, const char *label, const char *const *label_values)
+{
+    if (!counters || count == 0 || !name || !help || (count > 1 && (!label || !label_values))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    MetricDesc desc = {
+        .name = name,
+        .help = help,
+        .type = METRIC_TYPE_COUNTER,
+        .label = label,
+        .label_values = label_values,
+        .count = count,
+        .counters = counters,
+    };
+    return register_desc(&desc, counters);
+}
+
+esp_err_t metrics_register_gauge(MetricGauge *gauge, const char *name, const char *help)
+{
+    if (!gauge || !name || !help) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    MetricDesc desc = {
+        .name = name,
+        .help = help,
+        .type = METRIC_TYPE_GAUGE,
+        .count = 1,
+        .gauge = gauge,
+    };
+    return register_desc(&desc, gauge);
+}
+
+esp_err_t metrics_register_histogram(MetricHistogram *histogram, const char *name, const char *help,
+                                     const uint32_t *bounds, uint8_t bound_count)
+{
+    if (!histogram || !name || !help || !bounds || bound_count == 0 ||
+        bound_count > METRICS_HIST_MAX_BOUNDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 1; i < bound_count; i++) {
+        if (bounds[i] <= bounds[i - 1]) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    histogram->bounds = bounds;
+    histogram->bound_count = bound_count;
+
+    MetricDesc desc = {
+        .name = name,
+        .help = help,
+        .type = METRIC_TYPE_HISTOGRAM,
+        .count = 1,
+        .histogram = histogram,
+    };
+    return register_desc(&desc, histogram);
+}
+
+void metric_histogram_observe(MetricHistogram *h, uint32_t value)
+{
+    int i = 0;
+    while (i < h->bound_count && value > h->bounds[i]) {
+        i++;
+    }
+    atomic_fetch_add_explicit(&h->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+}
+
+int metrics_count(void)
+{
+    return atomic_load_explicit(&s_count, memory_order_acquire);
+}
+
+const MetricDesc *metrics_get(int index)
+{
+    if (index < 0 || index >= metrics_count()) {
+        return NULL;
+    }
+    return &s_metrics[index];
+}
+
+const char *metric_type_to_string(MetricType type)
+{
+    switch (type) {
+        case METRIC_TYPE_COUNTER:   return "counter";
+        case METRIC_TYPE_GAUGE:     return "gauge";
+        case METRIC_TYPE_HISTOGRAM: return "histogram";
+        default:                    return "untyped";
+    }
+}
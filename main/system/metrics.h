@@ -0,0 +1,164 @@
+/**
+ * @file metrics.h
+ * @brief 指标登记表接口定义 - 计数器、仪表与固定分桶的延迟直方图
+ *
+ * 指标存储由各模块定义为静态变量，在模块初始化时登记到本表；登记之后不再分配内存。
+ * 更新只是一次宽松序的原子加法或原子存储（ESP32-S3 上为 S32C1I 比较交换，几个周期），
+ * 可在任意任务与中断中调用，不加锁、不阻塞。
+ *
+ * 读取（诊断消息、HTTP 导出）逐项原子读取，同一指标内各分桶之间不保证是同一时刻，
+ * 对计数型数据足够。指标名与标签按 Prometheus 约定命名（小写下划线，计数器以 _total 结尾，
+ * 带单位后缀），以便直接导出。
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "main.h"
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 计数器（只增，32 位回绕）
+ */
+typedef struct {
+    _Atomic uint32_t value;
+} MetricCounter;
+
+/**
+ * @brief 仪表（可任意设置）
+ */
+typedef struct {
+    _Atomic int32_t value;
+} MetricGauge;
+
+/**
+ * @brief 固定分桶直方图
+ *
+ * buckets[i]（i < bound_count）统计 bounds[i-1] < v ≤ bounds[i] 的观测，
+ * buckets[bound_count] 统计超过最大上界的观测；导出时再累加为 Prometheus 的累计分桶。
+ * sum 为 32 位观测值之和，会回绕（按微秒计时约 71 分钟累计时长回绕一次，导出端按计数器重置处理）。
+ */
+typedef struct {
+    const uint32_t *bounds;                                 ///< 各桶上界（升序，登记时设置）
+    uint8_t bound_count;                                    ///< 上界个数（≤ METRICS_HIST_MAX_BOUNDS）
+    _Atomic uint32_t buckets[METRICS_HIST_MAX_BOUNDS + 1];  ///< 各桶计数（非累计）
+    _Atomic uint32_t sum;                                   ///< 观测值之和
+} MetricHistogram;
+
+/**
+ * @brief 指标类型
+ */
+typedef enum {
+    METRIC_TYPE_COUNTER = 0,
+    METRIC_TYPE_GAUGE,
+    METRIC_TYPE_HISTOGRAM,
+} MetricType;
+
+/**
+ * @brief 登记表项（只读）
+ */
+typedef struct {
+    const char *name;                   ///< 指标名
+    const char *help;                   ///< 说明
+    MetricType type;
+    const char *label;                  ///< 标签名（计数器组，NULL = 无标签）
+    const char *const *label_values;    ///< 各计数器的标签值（label 非 NULL 时有效）
+    uint8_t count;                      ///< 计数器个数（无标签为 1）
+    union {
+        MetricCounter *counters;
+        MetricGauge *gauge;
+        MetricHistogram *histogram;
+    };
+} MetricDesc;
+
+static inline void metric_counter_inc(MetricCounter *c)
+{
+    atomic_fetch_add_explicit(&c->value, 1, memory_order_relaxed);
+}
+
+static inline void metric_counter_add(MetricCounter *c, uint32_t n)
+{
+    atomic_fetch_add_explicit(&c->value, n, memory_order_relaxed);
+}
+
+static inline uint32_t metric_counter_get(const MetricCounter *c)
+{
+    return atomic_load_explicit(&c->value, memory_order_relaxed);
+}
+
+static inline void metric_gauge_set(MetricGauge *g, int32_t v)
+{
+    atomic_store_explicit(&g->value, v, memory_order_relaxed);
+}
+
+static inline int32_t metric_gauge_get(const MetricGauge *g)
+{
+    return atomic_load_explicit(&g->value, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次观测（须在登记之后调用）
+ * @param value 观测值（单位由指标名后缀约定，延迟统一用微秒）
+ */
+void metric_histogram_observe(MetricHistogram *h, uint32_t value);
+
+/**
+ * @brief 读取直方图第 i 个分桶的计数（非累计，i = bound_count 为超出最大上界的桶）
+ */
+static inline uint32_t metric_histogram_bucket(const MetricHistogram *h, int i)
+{
+    return atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+}
+
+static inline uint32_t metric_histogram_sum(const MetricHistogram *h)
+{
+    return atomic_load_explicit(&h->sum, memory_order_relaxed);
+}
+
+/**
+ * @brief 登记计数器（组）
+ * @param counters 计数器数组（静态存储）
+ * @param count 数组长度（无标签时为 1）
+ * @param name 指标名
+ * @param help 说明
+ * @param label 标签名（无标签时为 NULL）
+ * @param label_values 各计数器的标签值（与 counters 一一对应，无标签时为 NULL）
+ * @return ESP_OK 成功（同一存储重复登记也返回 ESP_OK），ESP_ERR_NO_MEM 登记表已满，
+ *         ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t metrics_register_counter(MetricCounter *counters, uint8_t count, const char *name,
+                                   const char *help, const char *label, const char *const *label_values);
+
+/**
+ * @brief 登记仪表
+ * @return 同 metrics_register_counter()
+ */
+esp_err_t metrics_register_gauge(MetricGauge *gauge, const char *name, const char *help);
+
+/**
+ * @brief 登记直方图
+ * @param bounds 各桶上界（升序，静态存储，最多 METRICS_HIST_MAX_BOUNDS 个）
+ * @return 同 metrics_register_counter()
+ */
+esp_err_t metrics_register_histogram(MetricHistogram *histogram, const char *name, const char *help,
+                                     const uint32_t *bounds, uint8_t bound_count);
+
+/**
+ * @brief 已登记的指标数
+ */
+int metrics_count(void);
+
+/**
+ * @brief 获取第 index 个登记表项（0 ≤ index < metrics_count()）
+ */
+const MetricDesc *metrics_get(int index);
+
+/**
+ * @brief MetricType 转字符串（Prometheus TYPE："counter" / "gauge" / "histogram"）
+ */
+const char *metric_type_to_string(MetricType type);
+
+#endif // METRICS_H
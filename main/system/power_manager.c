@@ -0,0 +1,236 @@
+/**
+ * @file power_manager.c
+ * @brief 功耗管理
+ *
+ * 突发段计数由多个任务（TLS 握手在 MQTT 任务、OLED 刷新在显示任务）与测量定时器访问，
+ * 加锁保护；PM 锁本身是计数锁，在锁外获取 / 释放。
+ *
+ * 电流估算模型（测量模式）：
+ *   持有高频锁的时间按最高频率运行电流计，其余时间按最低频率计，
+ *   CPU 忙碌部分按运行电流、空闲部分按空闲电流插值；未开启调频时全部按最高频率计。
+ *   射频按已连接计：每个唤醒间隔接收一次信标，占空比 = POWER_EST_BEACON_WAKE_MS / 唤醒间隔。
+ *   发送（状态上报等）的射频电流未计入，上报间隔越短实际电流越高于估算值。
+ */
+
+#include "power_manager.h"
+#include "main.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+static const char *TAG = "POWER";
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_burst_lock = NULL;
+#endif
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static PowerStats s_stats;
+static int s_burst_depth = 0;          ///< 当前持有突发段的次数（各任务合计）
+static int64_t s_burst_since_us = 0;   ///< 最近一次从 0 进入突发段的时刻
+static int64_t s_burst_total_us = 0;   ///< 启动以来突发段累计时长（不含进行中的一段）
+
+#if CONFIG_POWER_MEASURE
+static esp_timer_handle_t s_measure_timer = NULL;
+static configRUN_TIME_COUNTER_TYPE s_win_idle[portNUM_PROCESSORS];  ///< 窗口起点各核空闲任务运行时间
+static configRUN_TIME_COUNTER_TYPE s_win_total;                     ///< 窗口起点运行时间计数
+static int64_t s_win_start_us;
+static int64_t s_win_burst_us;                                      ///< 窗口起点突发段累计时长
+
+/**
+ * @brief 截至 now_us 的突发段累计时长
+ */
+static int64_t burst_total(int64_t now_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t total = s_burst_total_us + (s_burst_depth > 0 ? now_us - s_burst_since_us : 0);
+    portEXIT_CRITICAL(&s_lock);
+    return total;
+}
+
+/**
+ * @brief 记录窗口起点（窗口变量只在初始化与测量定时器回调中访问）
+ */
+static void window_start(int64_t now_us)
+{
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        s_win_idle[i] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(i));
+    }
+    s_win_total = portGET_RUN_TIME_COUNTER_VALUE();
+    s_win_start_us = now_us;
+    s_win_burst_us = burst_total(now_us);
+}
+
+/**
+ * @brief 按电流估算模型计算平均电流（mA）
+ * @param busy CPU 忙碌占比（0 ~ 1）
+ * @param burst 持有高频锁的时间占比（0 ~ 1）
+ */
+static float estimate_ma(float busy, float burst, bool dfs)
+{
+    float cpu_ma;
+    if (dfs) {
+        float rest = 1.0f - burst;
+        float busy_rest = rest > 0.0f ? (busy - burst) / rest : 0.0f;  // 突发段外的忙碌占比
+        if (busy_rest < 0.0f) {
+            busy_rest = 0.0f;
+        } else if (busy_rest > 1.0f) {
+            busy_rest = 1.0f;
+        }
+        cpu_ma = burst * POWER_EST_ACTIVE_MAX_MA +
+                 rest * (POWER_EST_IDLE_MIN_MA + busy_rest * (POWER_EST_ACTIVE_MIN_MA - POWER_EST_IDLE_MIN_MA));
+    } else {
+        cpu_ma = POWER_EST_IDLE_MAX_MA + busy * (POWER_EST_ACTIVE_MAX_MA - POWER_EST_IDLE_MAX_MA);
+    }
+
+#if CONFIG_POWER_WIFI_MAX_MODEM
+    const float wake_interval_ms = POWER_WIFI_LISTEN_INTERVAL * POWER_BEACON_INTERVAL_MS;
+#else
+    const float wake_interval_ms = POWER_BEACON_INTERVAL_MS;  // Min modem：每个 DTIM（按 DTIM = 1 估算）
+#endif
+    float duty = POWER_EST_BEACON_WAKE_MS / wake_interval_ms;
+    if (duty > 1.0f) {
+        duty = 1.0f;
+    }
+    return cpu_ma + duty * POWER_EST_RADIO_RX_MA;
+}
+
+/**
+ * @brief 测量窗口结束（esp_timer 任务中调用）
+ */
+static void measure_window_cb(void *arg)
+{
+    configRUN_TIME_COUNTER_TYPE idle_delta = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        idle_delta += ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(i)) - s_win_idle[i];
+    }
+    configRUN_TIME_COUNTER_TYPE total_delta = portGET_RUN_TIME_COUNTER_VALUE() - s_win_total;
+    int64_t now_us = esp_timer_get_time();
+    int64_t wall_us = now_us - s_win_start_us;
+    int64_t burst_us = burst_total(now_us) - s_win_burst_us;
+    window_start(now_us);
+
+    if (total_delta == 0 || wall_us <= 0) {
+        return;
+    }
+    float idle = (float)idle_delta / ((float)total_delta * portNUM_PROCESSORS);
+    if (idle > 1.0f) {
+        idle = 1.0f;
+    }
+    float burst = (float)burst_us / (float)wall_us;
+    if (burst > 1.0f) {
+        burst = 1.0f;
+    }
+    float ma = estimate_ma(1.0f - idle, burst, s_stats.dfs);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.measured = true;
+    s_stats.idle_pct = idle * 100.0f;
+    s_stats.burst_pct = burst * 100.0f;
+    s_stats.est_ma = ma;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "功耗测量（%lu 秒）: CPU 空闲 %.1f%%，高频 %.2f%%，估算电流 %.1f mA",
+             (unsigned long)(wall_us / 1000000), idle * 100.0f, burst * 100.0f, ma);
+}
+#endif  // CONFIG_POWER_MEASURE
+
+esp_err_t power_manager_init(void)
+{
+    esp_err_t ret = ESP_OK;
+    s_stats.cpu_max_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    s_stats.cpu_min_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_cfg = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = POWER_CPU_MIN_MHZ,
+        .light_sleep_enable = false,
+    };
+    ret = esp_pm_configure(&pm_cfg);
+    if (ret == ESP_OK) {
+        ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "burst", &s_burst_lock);
+    }
+    if (ret == ESP_OK) {
+        s_stats.dfs = true;
+        s_stats.cpu_min_mhz = POWER_CPU_MIN_MHZ;
+        ESP_LOGI(TAG, "动态调频: %d ~ %d MHz", POWER_CPU_MIN_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    } else {
+        ESP_LOGW(TAG, "动态调频配置失败: %s，固定 %d MHz 运行", esp_err_to_name(ret),
+                 CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    }
+#else
+    ESP_LOGI(TAG, "未开启 CONFIG_PM_ENABLE，固定 %d MHz 运行", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#endif
+
+#if CONFIG_POWER_MEASURE
+    window_start(esp_timer_get_time());
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = measure_window_cb,
+        .name = "power_measure",
+    };
+    if (esp_timer_create(&timer_args, &s_measure_timer) != ESP_OK ||
+        esp_timer_start_periodic(s_measure_timer, (uint64_t)POWER_MEASURE_WINDOW_SEC * 1000000) != ESP_OK) {
+        ESP_LOGE(TAG, "创建测量定时器失败");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "功耗测量模式：每 %d 秒统计一次", POWER_MEASURE_WINDOW_SEC);
+#endif
+
+    return ret;
+}
+
+void power_manager_burst_begin(void)
+{
+#if CONFIG_PM_ENABLE
+    if (s_burst_lock != NULL) {
+        esp_pm_lock_acquire(s_burst_lock);
+    }
+#endif
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_burst_depth++ == 0) {
+        s_burst_since_us = now_us;
+    }
+    s_stats.bursts++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void power_manager_burst_end(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_burst_depth > 0 && --s_burst_depth == 0) {
+        s_burst_total_us += now_us - s_burst_since_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+#if CONFIG_PM_ENABLE
+    if (s_burst_lock != NULL) {
+        esp_pm_lock_release(s_burst_lock);
+    }
+#endif
+}
+
+void power_manager_wait_period(uint32_t period_ms)
+{
+    TickType_t period = pdMS_TO_TICKS(period_ms);
+    if (period == 0) {
+        period = 1;
+    }
+    vTaskDelay(period - xTaskGetTickCount() % period);
+}
+
+void power_manager_get_stats(PowerStats *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file power_manager.h
+ * @brief 功耗管理接口定义 - 动态调频、突发段 PM 锁、任务唤醒对齐与功耗测量
+ *
+ * - 动态调频（CONFIG_PM_ENABLE）：CPU 平时运行在 POWER_CPU_MIN_MHZ，
+ *   TLS 握手、OLED 整帧刷新等突发段持有 CPU_FREQ_MAX 锁，以最高频率尽快完成后回落
+ * - 唤醒对齐：各周期任务按同一时间网格醒来（power_manager_wait_period），
+ *   每个周期只集中唤醒一次，而不是各任务按各自的启动相位分散唤醒
+ * - 测量模式（CONFIG_POWER_MEASURE）：每 POWER_MEASURE_WINDOW_SEC 秒统计 CPU 空闲率、
+ *   持锁高频时间占比，按 main.h 中的电流系数估算模组平均电流
+ *
+ * 不开启自动 Light-sleep：CO2 传感器在 UART2 上持续输出 ASCII 帧，
+ * Light-sleep 期间 UART 停止接收且 UART2 不能唤醒芯片，会丢帧或读到残帧；
+ * 风扇 PWM（LEDC）与转速计（PCNT）也依赖 APB 时钟。
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 功耗统计（测量模式下为最近一个完整窗口的结果）
+ */
+typedef struct {
+    bool dfs;                   ///< 动态调频是否生效
+    uint16_t cpu_max_mhz;       ///< 最高频率
+    uint16_t cpu_min_mhz;       ///< 最低频率（未开启调频时等于最高频率）
+    bool measured;              ///< 是否已有完整测量窗口（未开启测量模式时始终为 false）
+    float idle_pct;             ///< CPU 空闲率（%，各核平均）
+    float burst_pct;            ///< 持有高频锁的时间占比（%）
+    float est_ma;               ///< 估算模组平均电流（mA，不含传感器、OLED 与风扇）
+    uint32_t bursts;            ///< 启动以来的突发段次数
+} PowerStats;
+
+/**
+ * @brief 初始化功耗管理（配置动态调频，须在 WiFi 初始化之前调用）
+ * @return ESP_OK 成功；调频配置失败时返回错误码，系统以固定频率继续运行
+ */
+esp_err_t power_manager_init(void);
+
+/**
+ * @brief 进入突发段（以最高频率运行，可嵌套、可在多个任务中同时持有）
+ */
+void power_manager_burst_begin(void);
+
+/**
+ * @brief 退出突发段（与 power_manager_burst_begin() 成对调用）
+ */
+void power_manager_burst_end(void);
+
+/**
+ * @brief 阻塞到下一个 period_ms 整倍数时刻（按系统节拍计），代替周期任务中的 vTaskDelay
+ *
+ * 周期相同的任务在同一节拍醒来；处理时间不会累积成相位漂移。
+ * @param period_ms 周期（毫秒）
+ */
+void power_manager_wait_period(uint32_t period_ms);
+
+/**
+ * @brief 获取功耗统计
+ * @param[out] out 统计
+ */
+void power_manager_get_stats(PowerStats *out);
+
+#endif // POWER_MANAGER_H
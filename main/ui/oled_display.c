@@ -5,8 +5,13 @@
 
 #include "oled_display.h"
 #include "u8g2_esp32_hal.h"
+#include "runtime_config.h"
+#include "power_manager.h"
+#include "metrics.h"
 #include "../main.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/timers.h"
 #include "driver/gpio.h"
@@ -52,6 +57,15 @@ static TimerHandle_t g_alert_timer = NULL;
 static TimerHandle_t g_blink_timer = NULL;
 static char g_alert_message[64] = {0};  // 缓存告警消息
 static uint8_t g_alert_countdown = 3;   // 倒计时秒数
+static uint32_t g_frame_crc = 0;        // 屏上主页面帧缓冲的 CRC
+static bool g_frame_valid = false;      // g_frame_crc 是否对应屏上内容（告警页面会覆盖）
+
+// 跳过的刷新（按原因）与整帧传输耗时
+enum { OLED_SKIP_UNCHANGED = 0, OLED_SKIP_LOCK_TIMEOUT, OLED_SKIP_COUNT };
+static const char *const g_skip_labels[OLED_SKIP_COUNT] = {"unchanged", "lock_timeout"};
+static MetricCounter g_refresh_skipped[OLED_SKIP_COUNT];
+static const uint32_t g_send_bounds[] = {10000, 20000, 30000, 50000, 100000};
+static MetricHistogram g_send_us;
 
 // ============================================================================
 // 内部函数声明
@@ -61,10 +75,11 @@ static void draw_co2_value(SensorData *sensor);
 static void draw_mode_badge(SystemMode mode);
 static void draw_temp_humidity(SensorData *sensor);
 static void draw_trend_graph(void);
-static void draw_status_bar(FanState fan, SystemMode mode);
+static void draw_status_bar(const FanState fans[], uint8_t fan_count, SystemMode mode);
 static void alert_timer_callback(TimerHandle_t timer);
 static void blink_timer_callback(TimerHandle_t timer);
 static void draw_alert_page(void);
+static void send_frame(void);
 
 // ============================================================================
 // 公共函数实现
@@ -110,13 +125,18 @@ esp_err_t oled_display_init(void) {
         return ESP_FAIL;
     }
 
+    metrics_register_counter(g_refresh_skipped, OLED_SKIP_COUNT, "oled_refresh_skipped_total",
+                             "OLED 跳过的刷新次数", "reason", g_skip_labels);
+    metrics_register_histogram(&g_send_us, "oled_frame_send_us", "OLED 整帧传输耗时（微秒）",
+                               g_send_bounds, sizeof(g_send_bounds) / sizeof(g_send_bounds[0]));
+
     g_initialized = true;
     ESP_LOGI(TAG, "OLED 初始化完成");
     return ESP_OK;
 }
 
-void oled_display_main_page(SensorData *sensor, FanState fan, SystemMode mode) {
-    if (!g_initialized || !sensor) {
+void oled_display_main_page(SensorData *sensor, const FanState fans[], uint8_t fan_count, SystemMode mode) {
+    if (!g_initialized || !sensor || !fans) {
         return;
     }
 
@@ -126,8 +146,10 @@ void oled_display_main_page(SensorData *sensor, FanState fan, SystemMode mode) {
     }
 
     // 获取 I2C 锁保护显示操作
+    // 绘制与整帧 I2C 传输以最高频率集中完成
     SemaphoreHandle_t i2c_mutex = get_i2c_mutex();
     if (xSemaphoreTake(i2c_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        power_manager_burst_begin();
         u8g2_ClearBuffer(&g_u8g2);
 
         // 绘制各个组件
@@ -135,14 +157,26 @@ void oled_display_main_page(SensorData *sensor, FanState fan, SystemMode mode) {
         draw_mode_badge(mode);
         draw_temp_humidity(sensor);
         draw_trend_graph();
-        draw_status_bar(fan, mode);
-
-        u8g2_SendBuffer(&g_u8g2);
+        draw_status_bar(fans, fan_count, mode);
+
+        // 帧内容与屏上相同时不传输（整帧 1 KB，400 kHz 下约 25 ms）
+        uint32_t crc = esp_rom_crc32_le(0, u8g2_GetBufferPtr(&g_u8g2),
+                                        8u * u8g2_GetBufferTileWidth(&g_u8g2) * u8g2_GetBufferTileHeight(&g_u8g2));
+        bool same = g_frame_valid && crc == g_frame_crc;
+        if (!same) {
+            send_frame();
+            g_frame_crc = crc;
+            g_frame_valid = true;
+        } else {
+            metric_counter_inc(&g_refresh_skipped[OLED_SKIP_UNCHANGED]);
+        }
+        power_manager_burst_end();
         xSemaphoreGive(i2c_mutex);
 
-        ESP_LOGD(TAG, "刷新主页面");
+        ESP_LOGD(TAG, same ? "主页面未变化，跳过刷新" : "刷新主页面");
     } else {
         ESP_LOGW(TAG, "获取 I2C 锁超时，跳过本次刷新");
+        metric_counter_inc(&g_refresh_skipped[OLED_SKIP_LOCK_TIMEOUT]);
     }
 }
 
@@ -189,10 +223,23 @@ void oled_add_history_point(SensorData *sensor) {
     ESP_LOGD(TAG, "添加历史点: %.1f ppm (count=%d)", co2, g_history.count);
 }
 
+uint32_t oled_display_get_skipped_frames(void) {
+    return metric_counter_get(&g_refresh_skipped[OLED_SKIP_UNCHANGED]);
+}
+
 // ============================================================================
 // 内部函数实现
 // ============================================================================
 
+/**
+ * @brief 整帧传输到屏幕并记录耗时（调用方持有 I2C 锁）
+ */
+static void send_frame(void) {
+    int64_t start = esp_timer_get_time();
+    u8g2_SendBuffer(&g_u8g2);
+    metric_histogram_observe(&g_send_us, (uint32_t)(esp_timer_get_time() - start));
+}
+
 static void draw_co2_value(SensorData *sensor) {
     char buf[32];
 
@@ -209,11 +256,12 @@ static void draw_co2_value(SensorData *sensor) {
         u8g2_SetFont(&g_u8g2, u8g2_font_6x10_tf);
         const char *status = "OK";
         // 告警与级别仍基于实际传感器数值判断
-        if (sensor->pollutants.co2 > CO2_ALERT_THRESHOLD) {
+        const RuntimeConfig *cfg = runtime_config_get();
+        if (sensor->pollutants.co2 > cfg->co2_alert) {
             status = "HIGH!";
-        } else if (sensor->pollutants.co2 > CO2_THRESHOLD_HIGH) {
+        } else if (sensor->pollutants.co2 > cfg->co2_high) {
             status = "High";
-        } else if (sensor->pollutants.co2 > CO2_THRESHOLD_LOW) {
+        } else if (sensor->pollutants.co2 > cfg->co2_low) {
             status = "Mid";
         }
         u8g2_DrawStr(&g_u8g2, 60, 15, status);
@@ -330,25 +378,33 @@ static void draw_trend_graph(void) {
     }
 }
 
-static void draw_status_bar(FanState fan, SystemMode mode) {
+static void draw_status_bar(const FanState fans[], uint8_t fan_count, SystemMode mode) {
     char buf[32];
 
     u8g2_SetFont(&g_u8g2, u8g2_font_5x7_tf);
 
-    // 风扇状态
-    const char *fan_str = "OFF";
-    switch (fan) {
-        case FAN_LOW:
-            fan_str = "LOW";
-            break;
-        case FAN_HIGH:
-            fan_str = "HIGH";
-            break;
-        default:
-            break;
+    if (fan_count == 1) {
+        // 单风扇：显示完整档位
+        const char *fan_str = "OFF";
+        switch (fans[0]) {
+            case FAN_LOW:
+                fan_str = "LOW";
+                break;
+            case FAN_HIGH:
+                fan_str = "HIGH";
+                break;
+            default:
+                break;
+        }
+        snprintf(buf, sizeof(buf), "Fan:%s", fan_str);
+    } else {
+        // 多风扇：每个风扇一个字符（O=OFF, L=LOW, H=HIGH）
+        int pos = snprintf(buf, sizeof(buf), "Fan:");
+        for (int i = 0; i < fan_count && i < FAN_MAX_COUNT && pos < (int)sizeof(buf) - 1; i++) {
+            buf[pos++] = (fans[i] == FAN_HIGH) ? 'H' : (fans[i] == FAN_LOW) ? 'L' : 'O';
+        }
+        buf[pos] = '\0';
     }
-
-    snprintf(buf, sizeof(buf), "Fan:%s", fan_str);
     u8g2_DrawStr(&g_u8g2, 0, 63, buf);
 
     // WiFi 状态（简化显示）
@@ -360,6 +416,8 @@ static void draw_alert_page(void) {
     // 获取 I2C 锁保护显示操作
     SemaphoreHandle_t i2c_mutex = get_i2c_mutex();
     if (xSemaphoreTake(i2c_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        power_manager_burst_begin();
+        g_frame_valid = false;  // 告警结束后主页面须整帧重绘
         u8g2_ClearBuffer(&g_u8g2);
 
         // 绘制告警页面
@@ -379,8 +437,11 @@ static void draw_alert_page(void) {
         snprintf(countdown_str, sizeof(countdown_str), "%ds auto return", g_alert_countdown);
         u8g2_DrawStr(&g_u8g2, 10, 60, countdown_str);
 
-        u8g2_SendBuffer(&g_u8g2);
+        send_frame();
+        power_manager_burst_end();
         xSemaphoreGive(i2c_mutex);
+    } else {
+        metric_counter_inc(&g_refresh_skipped[OLED_SKIP_LOCK_TIMEOUT]);
     }
 }
 
@@ -22,11 +22,13 @@ esp_err_t oled_display_init(void);
  *   - 第2行：温度 湿度
  *   - 第3-6行：CO2 趋势图（扩展区域）
  *   - 第7-8行：风扇状态 + WiFi 状态
+ * 帧内容与屏上相同时不传输（计入跳过次数）
  * @param sensor 传感器数据
- * @param fan 风扇状态
+ * @param fans 风扇状态数组
+ * @param fan_count 风扇数量（单风扇显示完整档位，多风扇每个风扇一个字符 O/L/H）
  * @param mode 系统模式
  */
-void oled_display_main_page(SensorData *sensor, FanState fan, SystemMode mode);
+void oled_display_main_page(SensorData *sensor, const FanState fans[], uint8_t fan_count, SystemMode mode);
 
 /**
  * @brief 显示告警页面
@@ -41,4 +43,9 @@ void oled_display_alert(const char *message);
  */
 void oled_add_history_point(SensorData *sensor);
 
+/**
+ * @brief 获取主页面因内容未变化而跳过的刷新次数
+ */
+uint32_t oled_display_get_skipped_frames(void);
+
 #endif // OLED_DISPLAY_H
@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""
+本地 HTTP 接口压测与格式校验工具（CONFIG_LOCAL_HTTP，仅依赖 Python 标准库）
+
+以多个并发抓取者（各用一条保持连接，断开后重连）反复 GET /metrics，检查：
+
+  - 响应为 200、Content-Type 为 Prometheus 文本格式 0.0.4，分块传输正确结束
+  - 每个样本行的指标名已由 # TYPE 声明，值可解析为数字
+  - 直方图分桶按 le 递增且累计值单调不减，+Inf 桶等于 _count
+  - 同一抓取者相邻两次抓取之间，计数器与直方图计数不减（32 位回绕除外）
+
+结束时打印吞吐、延迟分位数与错误统计，存在错误时退出码为 1。
+给出 --token 时另外校验 POST /command：错误令牌返回 401，正确令牌返回 200 与租约状态
+（会以 ttl=0 下发一条释放租约的命令，设备随即回退本地控制）。
+
+示例：
+  python3 tools/http_load.py 192.168.1.50 --clients 8 --duration 30
+  python3 tools/http_load.py 192.168.1.50:8080 --clients 4 --requests 200 --token "$TOKEN"
+  curl -s http://192.168.1.50/metrics | grep vent_fan_state
+"""
+
+import argparse
+import http.client
+import json
+import math
+import re
+import sys
+import threading
+import time
+
+CONTENT_TYPE = "text/plain; version=0.0.4"
+SAMPLE_RE = re.compile(r'^([a-zA-Z_:][a-zA-Z0-9_:]*)(\{([^}]*)\})? (\S+)$')
+LABEL_RE = re.compile(r'([a-zA-Z_][a-zA-Z0-9_]*)="((?:[^"\\]|\\.)*)"')
+WRAP = 1 << 32
+RETRIES = 5
+
+
+class ExpositionError(ValueError):
+    pass
+
+
+def parse_exposition(text):
+    """解析文本格式，返回 ({指标名: 类型}, [(样本名, 标签元组, 值)])，格式错误时抛出 ExpositionError"""
+    types = {}
+    samples = []
+    for lineno, line in enumerate(text.split("\n"), 1):
+        if not line:
+            continue
+        if line.startswith("#"):
+            parts = line.split(" ", 3)
+            if len(parts) >= 4 and parts[1] == "TYPE":
+                if parts[2] in types:
+                    raise ExpositionError("第 %d 行: %s 重复声明" % (lineno, parts[2]))
+                types[parts[2]] = parts[3]
+            continue
+        m = SAMPLE_RE.match(line)
+        if not m:
+            raise ExpositionError("第 %d 行无法解析: %r" % (lineno, line))
+        name, labels, value = m.group(1), m.group(3) or "", m.group(4)
+        family = name
+        for suffix in ("_bucket", "_sum", "_count"):
+            if name.endswith(suffix) and types.get(name[:-len(suffix)]) == "histogram":
+                family = name[:-len(suffix)]
+        if family not in types:
+            raise ExpositionError("第 %d 行: %s 没有 TYPE 声明" % (lineno, name))
+        try:
+            v = float(value)
+        except ValueError:
+            raise ExpositionError("第 %d 行: 值 %r 不是数字" % (lineno, value))
+        samples.append((name, tuple(LABEL_RE.findall(labels)), v))
+    return types, samples
+
+
+def check_histograms(types, samples):
+    """检查直方图分桶：le 递增、累计值不减、+Inf 等于 _count"""
+    errors = []
+    for family, kind in types.items():
+        if kind != "histogram":
+            continue
+        buckets = [(dict(l)["le"], v) for n, l, v in samples if n == family + "_bucket"]
+        counts = [v for n, l, v in samples if n == family + "_count"]
+        if not buckets or buckets[-1][0] != "+Inf" or len(counts) != 1:
+            errors.append("%s: 缺少 +Inf 桶或 _count" % family)
+            continue
+        bounds = [float(le) for le, _ in buckets]
+        values = [v for _, v in buckets]
+        if bounds != sorted(bounds) or len(set(bounds)) != len(bounds):
+            errors.append("%s: le 不是严格递增" % family)
+        if values != sorted(values):
+            errors.append("%s: 累计分桶递减 %s" % (family, values))
+        if values[-1] != counts[0]:
+            errors.append("%s: +Inf=%d 与 _count=%d 不等" % (family, values[-1], counts[0]))
+    return errors
+
+
+def monotonic_series(types, samples):
+    """应单调不减的序列：计数器与直方图的分桶 / _count"""
+    out = {}
+    for name, labels, v in samples:
+        kind = types.get(name)
+        if kind == "counter" or (name.endswith(("_bucket", "_count")) and
+                                 types.get(name.rsplit("_", 1)[0]) == "histogram"):
+            out[(name, labels)] = v
+    return out
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.bytes = 0
+        self.errors = {}
+        self.reconnects = 0
+
+    def ok(self, latency, size):
+        with self.lock:
+            self.latencies.append(latency)
+            self.bytes += size
+
+    def reconnect(self):
+        with self.lock:
+            self.reconnects += 1
+
+    def error(self, kind, detail):
+        with self.lock:
+            entry = self.errors.setdefault(kind, [0, detail])
+            entry[0] += 1
+
+
+def scraper(host, port, timeout, deadline, max_requests, stats):
+    """单个抓取者：保持连接反复抓取，比较相邻两次的单调序列"""
+    conn = None
+    previous = None
+    done = 0
+    failures = 0
+    while time.monotonic() < deadline and (max_requests <= 0 or done < max_requests):
+        done += 1
+        if conn is None:
+            conn = http.client.HTTPConnection(host, port, timeout=timeout)
+        start = time.monotonic()
+        try:
+            conn.request("GET", "/metrics")
+            resp = conn.getresponse()
+            body = resp.read()
+        except (OSError, http.client.HTTPException) as e:
+            conn.close()
+            conn = None
+            # 连接数满时服务器关闭最久未活动的连接（抓取者多于 LOCAL_HTTP_MAX_SOCKETS 时常见），
+            # 重连重试；连续 RETRIES 次失败才计为错误
+            failures += 1
+            if failures < RETRIES:
+                stats.reconnect()
+                done -= 1
+            else:
+                failures = 0
+                stats.error("连接", "%s: %s" % (type(e).__name__, e))
+                time.sleep(0.2)
+            continue
+        failures = 0
+        latency = time.monotonic() - start
+        if resp.status != 200:
+            stats.error("状态码 %d" % resp.status, body[:80])
+            continue
+        if not (resp.getheader("Content-Type") or "").startswith(CONTENT_TYPE):
+            stats.error("Content-Type", resp.getheader("Content-Type"))
+        try:
+            types, samples = parse_exposition(body.decode("utf-8"))
+        except (UnicodeDecodeError, ExpositionError) as e:
+            stats.error("格式", str(e))
+            continue
+        for err in check_histograms(types, samples):
+            stats.error("直方图", err)
+        current = monotonic_series(types, samples)
+        if previous is not None:
+            for key, v in current.items():
+                old = previous.get(key)
+                if old is not None and v < old and old - v < WRAP // 2:
+                    stats.error("计数器回退", "%s%s: %d -> %d" % (key[0], dict(key[1]), old, v))
+        previous = current
+        stats.ok(latency, len(body))
+    if conn is not None:
+        conn.close()
+
+
+def check_command(host, port, timeout, token):
+    """校验 /command 鉴权：错误令牌 401，正确令牌 200（ttl=0 释放租约）"""
+    errors = []
+    body = json.dumps({"ttl": 0})
+    cases = [("错误令牌", token + "x", 401), ("正确令牌", token, 200)]
+    for name, tok, expect in cases:
+        conn = http.client.HTTPConnection(host, port, timeout=timeout)
+        try:
+            conn.request("POST", "/command", body=body,
+                         headers={"Authorization": "Bearer " + tok, "Content-Type": "application/json"})
+            resp = conn.getresponse()
+            text = resp.read().decode("utf-8", "replace")
+        except (OSError, http.client.HTTPException) as e:
+            errors.append("%s: %s" % (name, e))
+            continue
+        finally:
+            conn.close()
+        if resp.status != expect:
+            errors.append("%s: 期望 %d，实际 %d %s" % (name, expect, resp.status, text))
+        elif expect == 200:
+            print("命令响应: %s" % text)
+    return errors
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    k = min(len(sorted_values) - 1, max(0, math.ceil(p / 100.0 * len(sorted_values)) - 1))
+    return sorted_values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="本地 HTTP 接口并发抓取压测与格式校验")
+    parser.add_argument("address", help="设备地址，host 或 host:port")
+    parser.add_argument("--clients", type=int, default=4, help="并发抓取者数（默认 4）")
+    parser.add_argument("--duration", type=float, default=10.0, help="持续时间（秒，默认 10）")
+    parser.add_argument("--requests", type=int, default=0, help="每个抓取者最多请求数（0 = 不限）")
+    parser.add_argument("--timeout", type=float, default=5.0, help="单次请求超时（秒）")
+    parser.add_argument("--token", help="同时校验 POST /command 鉴权（会释放远程租约）")
+    args = parser.parse_args()
+
+    host, _, port = args.address.partition(":")
+    port = int(port) if port else 80
+
+    stats = Stats()
+    deadline = time.monotonic() + args.duration
+    threads = [threading.Thread(target=scraper,
+                                args=(host, port, args.timeout, deadline, args.requests, stats))
+               for _ in range(args.clients)]
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - start
+
+    lat = sorted(stats.latencies)
+    n = len(lat)
+    print("抓取 %d 次（%d 个并发），%.1f 秒，%.1f 次/秒，平均 %.0f 字节" %
+          (n, args.clients, elapsed, n / elapsed if elapsed > 0 else 0, stats.bytes / n if n else 0))
+    if n:
+        print("延迟 ms: p50 %.1f  p95 %.1f  p99 %.1f  max %.1f" %
+              tuple(x * 1000 for x in (percentile(lat, 50), percentile(lat, 95), percentile(lat, 99), lat[-1])))
+
+    if stats.reconnects:
+        print("连接被服务器关闭后重连 %d 次" % stats.reconnects)
+
+    failed = bool(stats.errors) or n == 0
+    for kind, (count, detail) in sorted(stats.errors.items()):
+        print("错误 %-10s %d 次，例: %s" % (kind, count, detail))
+
+    if args.token is not None:
+        for err in check_command(host, port, args.timeout, args.token):
+            print("命令校验失败: %s" % err)
+            failed = True
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
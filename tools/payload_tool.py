@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+设备上报消息编解码工具（后端 / 调试用，仅依赖 Python 标准库）
+
+设备按运行时配置 payload_format 以 JSON 或 CBOR 发布 status / alert / status/backlog，
+两种编码的消息结构与键名完全相同。本工具：
+
+  decode   把 CBOR（或 JSON）消息解码为 JSON，可选展开 status 中的批量样本 series
+  encode   把 JSON 编码为 CBOR（例如以 CBOR 下发远程风扇命令）
+
+示例：
+  mosquitto_sub -t home/ventilation/esp32_a0b1c2d3e4f5/status -C 1 | python3 tools/payload_tool.py decode
+  python3 tools/payload_tool.py decode --hex bf63636f32f95a2264...ff --expand-series
+  python3 tools/payload_tool.py encode '{"fan_0":"HIGH","ttl":120}' -o cmd.cbor
+  mosquitto_pub -t home/ventilation/esp32_a0b1c2d3e4f5/command -f cmd.cbor
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+BREAK = object()
+
+
+class CborError(ValueError):
+    pass
+
+
+def _shortest_float32(value):
+    """单精度值还原为能往返的最短十进制表示（设备写入前已按定点位数舍入）"""
+    if not math.isfinite(value):
+        return value
+    for digits in range(1, 10):
+        candidate = float("%.*g" % (digits, value))
+        if struct.unpack(">f", struct.pack(">f", candidate))[0] == value:
+            return candidate
+    return value
+
+
+class CborDecoder:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def _take(self, n):
+        if self.pos + n > len(self.data):
+            raise CborError("数据不完整（偏移 %d）" % self.pos)
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def _arg(self, ai):
+        if ai < 24:
+            return ai
+        if ai == 31:
+            return None  # 不定长
+        if ai > 27:
+            raise CborError("无效的附加信息 %d" % ai)
+        return int.from_bytes(self._take(1 << (ai - 24)), "big")
+
+    def decode(self):
+        ib = self._take(1)[0]
+        major, ai = ib >> 5, ib & 0x1F
+        if major == 7:
+            return self._simple(ai)
+        arg = self._arg(ai)
+        if major == 0:
+            return arg
+        if major == 1:
+            return -1 - arg
+        if major in (2, 3):
+            if arg is None:
+                chunks = []
+                while True:
+                    item = self.decode()
+                    if item is BREAK:
+                        break
+                    chunks.append(item)
+                raw = b"".join(c if isinstance(c, bytes) else c.encode() for c in chunks)
+            else:
+                raw = self._take(arg)
+            return raw.hex() if major == 2 else raw.decode("utf-8")
+        if major == 4:
+            return self._items(arg, lambda: self.decode(), list)
+        if major == 5:
+            result = {}
+            count = 0
+            while arg is None or count < arg:
+                key = self.decode()
+                if key is BREAK and arg is None:
+                    break
+                result[str(key)] = self.decode()
+                count += 1
+            return result
+        # major == 6：标签，直接返回内容
+        return self.decode()
+
+    def _items(self, arg, read, container):
+        out = container()
+        if arg is None:
+            while True:
+                item = read()
+                if item is BREAK:
+                    return out
+                out.append(item)
+        for _ in range(arg):
+            out.append(read())
+        return out
+
+    def _simple(self, ai):
+        if ai == 20:
+            return False
+        if ai == 21:
+            return True
+        if ai in (22, 23):
+            return None
+        if ai == 25:
+            return struct.unpack(">e", self._take(2))[0]
+        if ai == 26:
+            return _shortest_float32(struct.unpack(">f", self._take(4))[0])
+        if ai == 27:
+            return struct.unpack(">d", self._take(8))[0]
+        if ai == 31:
+            return BREAK
+        if ai == 24:
+            return "simple(%d)" % self._take(1)[0]
+        return "simple(%d)" % ai
+
+
+def cbor_decode(data):
+    decoder = CborDecoder(data)
+    value = decoder.decode()
+    if decoder.pos != len(data):
+        raise CborError("消息末尾有 %d 字节多余数据" % (len(data) - decoder.pos))
+    return value
+
+
+def _head(major, arg):
+    if arg < 24:
+        return bytes([major << 5 | arg])
+    for ai, size in ((24, 1), (25, 2), (26, 4), (27, 8)):
+        if arg < 1 << (8 * size):
+            return bytes([major << 5 | ai]) + arg.to_bytes(size, "big")
+    raise CborError("整数超出范围")
+
+
+def cbor_encode(value):
+    if value is None:
+        return b"\xf6"
+    if value is True:
+        return b"\xf5"
+    if value is False:
+        return b"\xf4"
+    if isinstance(value, int):
+        return _head(0, value) if value >= 0 else _head(1, -1 - value)
+    if isinstance(value, float):
+        if value.is_integer() and abs(value) < 2 ** 63:
+            return cbor_encode(int(value))
+        for fmt, ib in ((">e", 0xF9), (">f", 0xFA)):
+            try:
+                packed = struct.pack(fmt, value)
+            except (OverflowError, struct.error):
+                continue
+            if struct.unpack(fmt, packed)[0] == value:
+                return bytes([ib]) + packed
+        return b"\xfb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        raw = value.encode("utf-8")
+        return _head(3, len(raw)) + raw
+    if isinstance(value, list):
+        return _head(4, len(value)) + b"".join(cbor_encode(v) for v in value)
+    if isinstance(value, dict):
+        return _head(5, len(value)) + b"".join(cbor_encode(str(k)) + cbor_encode(v)
+                                               for k, v in value.items())
+    raise CborError("不支持的类型 %s" % type(value).__name__)
+
+
+def expand_series(message):
+    """把 status 中增量编码的 series 展开为逐样本记录（与 MQTT.md 2.1 的定义一致）"""
+    series = message.get("series")
+    if not isinstance(series, dict):
+        return message
+    t0, step = series["t0"], series["step"]
+    scales = {"co2": 1, "temp": 10, "humi": 10}
+    columns = {}
+    for key, scale in scales.items():
+        values, prev = [], None
+        for delta in series.get(key, []):
+            if delta is None:
+                values.append(None)
+                continue
+            prev = delta if prev is None else prev + delta
+            values.append(prev / scale if scale != 1 else prev)
+        columns[key] = values
+
+    count = len(columns["co2"])
+    fans = _expand_changes(series.get("fans", []), count)
+    modes = _expand_changes(series.get("mode", []), count)
+    samples = []
+    for i in range(count):
+        samples.append({
+            "timestamp": t0 + i * step,
+            "co2": columns["co2"][i],
+            "temp": columns["temp"][i],
+            "humi": columns["humi"][i],
+            "fans": fans[i],
+            "mode": modes[i][0] if modes[i] else None,
+        })
+    expanded = dict(message)
+    expanded["series"] = samples
+    return expanded
+
+
+def _expand_changes(changes, count):
+    out, current, j = [], [], 0
+    for i in range(count):
+        while j < len(changes) and changes[j][0] <= i:
+            current = changes[j][1:]
+            j += 1
+        out.append(current)
+    return out
+
+
+def _read_input(args):
+    if args.hex:
+        return bytes.fromhex(args.hex)
+    if args.file and args.file != "-":
+        with open(args.file, "rb") as f:
+            return f.read()
+    return sys.stdin.buffer.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="设备上报消息 JSON / CBOR 编解码")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    dec = sub.add_parser("decode", help="CBOR / JSON 消息解码为 JSON")
+    dec.add_argument("file", nargs="?", default="-", help="消息文件（默认标准输入）")
+    dec.add_argument("--hex", help="以十六进制字符串给出消息")
+    dec.add_argument("--expand-series", action="store_true", help="展开 status 中的批量样本")
+    dec.add_argument("--compact", action="store_true", help="单行输出")
+
+    enc = sub.add_parser("encode", help="JSON 编码为 CBOR")
+    enc.add_argument("json", help="JSON 文本，或 @文件名")
+    enc.add_argument("-o", "--output", help="输出文件（默认以十六进制打印）")
+
+    args = parser.parse_args()
+
+    if args.command == "decode":
+        data = _read_input(args)
+        if data[:1] == b"{":
+            message = json.loads(data.decode("utf-8"))
+            encoding = "json"
+        else:
+            message = cbor_decode(data)
+            encoding = "cbor"
+        if args.expand_series:
+            message = expand_series(message)
+        indent = None if args.compact else 2
+        print(json.dumps(message, ensure_ascii=False, indent=indent))
+        print("# %s, %d 字节" % (encoding, len(data)), file=sys.stderr)
+        return 0
+
+    text = args.json
+    if text.startswith("@"):
+        with open(text[1:], "r", encoding="utf-8") as f:
+            text = f.read()
+    encoded = cbor_encode(json.loads(text))
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(encoded)
+    else:
+        print(encoded.hex())
+    print("# cbor %d 字节（JSON %d 字节）" % (len(encoded), len(json.dumps(json.loads(text),
+          ensure_ascii=False, separators=(",", ":")).encode("utf-8"))), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+MQTT TLS 握手对比：完整握手 vs 会话复用，证书包 vs 固定 CA（Guides/MQTT.md「TLS 握手」表格的数据来源）
+
+在本机启动一个 TLS Broker 替身（TLS 1.2，RSA-2048 叶证书 + 自签 CA，收到 CONNECT 回 CONNACK），
+客户端经一个中继连接，中继每个数据块单向延迟 RTT/2，模拟设备到 Broker 的往返时间，并统计：
+
+  - 握手耗时（客户端 wrap_socket 起止，中位数）与客户端 CPU 时间
+  - 握手完成时的上 / 下行字节数（TLS 记录，不含 MQTT 报文）
+  - 握手往返：握手完成前服务端发出的数据组数（完整握手 2，会话复用 1）
+
+证书由 openssl 命令行在临时目录中生成。"证书包"一行把系统 CA 证书包与替身 CA 合并后加载，
+对应设备挂载 ESP-IDF 证书包；"固定 CA"只加载替身 CA，对应 CONFIG_MQTT_TLS_PINNED_CA。
+主机上的耗时只反映往返次数与数据量，设备上 RSA 校验与 ECDHE 运算另占大部分时间。
+
+  python3 tools/tls_bench.py                     # 模拟 40 ms RTT，每种 30 次
+  python3 tools/tls_bench.py --rtt 0 --runs 100  # 只看 CPU 与字节数
+  python3 tools/tls_bench.py --runs 5 --check    # ctest：会话复用必须生效且往返、下行字节更少
+
+--check：每次复用都被服务端接受、复用握手往返 1 次且完整握手 2 次、复用下行字节少于完整握手时返回 0。
+"""
+
+import argparse
+import os
+import socket
+import ssl
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SYSTEM_BUNDLE = "/etc/ssl/certs/ca-certificates.crt"
+MQTT_CONNECT = b"\x10\x0c\x00\x04MQTT\x04\x02\x00\x3c\x00\x00"
+MQTT_CONNACK = b"\x20\x02\x00\x00"
+MQTT_DISCONNECT = b"\xe0\x00"
+
+
+def make_certs(workdir):
+    """生成自签 CA 与 localhost 叶证书，返回 (ca.pem, 证书链, 私钥) 路径"""
+    def run(*args):
+        subprocess.run(["openssl"] + list(args), cwd=workdir, check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    run("req", "-x509", "-newkey", "rsa:2048", "-nodes", "-keyout", "ca.key", "-out", "ca.pem",
+        "-days", "1", "-subj", "/CN=Bench Root CA")
+    run("req", "-newkey", "rsa:2048", "-nodes", "-keyout", "srv.key", "-out", "srv.csr",
+        "-subj", "/CN=localhost")
+    with open(os.path.join(workdir, "ext.cnf"), "w") as f:
+        f.write("subjectAltName=DNS:localhost\n")
+    run("x509", "-req", "-in", "srv.csr", "-CA", "ca.pem", "-CAkey", "ca.key", "-CAcreateserial",
+        "-out", "srv.pem", "-days", "1", "-extfile", "ext.cnf")
+
+    path = lambda name: os.path.join(workdir, name)
+    with open(path("chain.pem"), "w") as out:
+        for name in ("srv.pem", "ca.pem"):
+            with open(path(name)) as f:
+                out.write(f.read())
+    return path("ca.pem"), path("chain.pem"), path("srv.key")
+
+
+def start_broker(chain, key):
+    """TLS Broker 替身：每个连接收 CONNECT 回 CONNACK，等客户端断开。返回端口"""
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    ctx.load_cert_chain(chain, key)
+    ls = socket.socket()
+    ls.bind(("127.0.0.1", 0))
+    ls.listen(16)
+
+    def handle(conn):
+        try:
+            s = ctx.wrap_socket(conn, server_side=True)
+            s.recv(64)
+            s.sendall(MQTT_CONNACK)
+            s.recv(64)
+            s.close()
+        except (OSError, ssl.SSLError):
+            conn.close()
+
+    def accept_loop():
+        while True:
+            conn, _ = ls.accept()
+            threading.Thread(target=handle, args=(conn,), daemon=True).start()
+
+    threading.Thread(target=accept_loop, daemon=True).start()
+    return ls.getsockname()[1]
+
+
+class Relay:
+    """延迟中继：每个数据块单向延迟 rtt/2 后转发，按方向统计字节数与数据组数"""
+
+    def __init__(self, upstream_port, rtt_ms):
+        self.upstream = upstream_port
+        self.delay = rtt_ms / 2000.0
+        self.ls = socket.socket()
+        self.ls.bind(("127.0.0.1", 0))
+        self.ls.listen(16)
+        self.port = self.ls.getsockname()[1]
+        self.lock = threading.Lock()
+        self.stats = {}     # 客户端源端口 → 统计
+        threading.Thread(target=self.accept_loop, daemon=True).start()
+
+    def accept_loop(self):
+        while True:
+            client, addr = self.ls.accept()
+            upstream = socket.create_connection(("127.0.0.1", self.upstream))
+            st = {"up": 0, "down": 0, "down_flights": 0, "last": None}
+            with self.lock:
+                self.stats[addr[1]] = st
+            for src, dst, direction in ((client, upstream, "up"), (upstream, client, "down")):
+                threading.Thread(target=self.pump, args=(src, dst, direction, st), daemon=True).start()
+
+    def pump(self, src, dst, direction, st):
+        try:
+            while True:
+                data = src.recv(65536)
+                if not data:
+                    break
+                time.sleep(self.delay)
+                with self.lock:
+                    st[direction] += len(data)
+                    if direction == "down" and st["last"] != "down":
+                        st["down_flights"] += 1
+                    st["last"] = direction
+                dst.sendall(data)
+        except OSError:
+            pass
+        try:
+            dst.shutdown(socket.SHUT_WR)
+        except OSError:
+            pass
+
+    def snapshot(self, local_port):
+        with self.lock:
+            return dict(self.stats[local_port])
+
+
+def connect_once(relay, ctx, session):
+    """一次连接：握手 → CONNECT / CONNACK → DISCONNECT。返回 (耗时 ms, CPU ms, 是否复用, 会话, 握手统计)"""
+    raw = socket.create_connection(("127.0.0.1", relay.port))
+    local_port = raw.getsockname()[1]
+    t0 = time.perf_counter()
+    c0 = time.thread_time()
+    s = ctx.wrap_socket(raw, server_hostname="localhost", session=session)
+    elapsed = (time.perf_counter() - t0) * 1000
+    cpu = (time.thread_time() - c0) * 1000
+    st = relay.snapshot(local_port)
+    s.sendall(MQTT_CONNECT)
+    s.recv(len(MQTT_CONNACK))
+    reused, new_session = s.session_reused, s.session
+    s.sendall(MQTT_DISCONNECT)
+    s.close()
+    return elapsed, cpu, reused, new_session, st
+
+
+def run_case(relay, ctx, resume, runs):
+    """连续 runs 次重连（复用时每次提交上一次的会话），返回各项中位数与复用是否全部生效"""
+    _, _, _, session, _ = connect_once(relay, ctx, None)
+    times, cpus, ups, downs, trips, all_reused = [], [], [], [], [], True
+    for _ in range(runs):
+        elapsed, cpu, reused, new_session, st = connect_once(relay, ctx, session if resume else None)
+        if resume:
+            all_reused = all_reused and reused
+            session = new_session
+        times.append(elapsed)
+        cpus.append(cpu)
+        ups.append(st["up"])
+        downs.append(st["down"])
+        trips.append(st["down_flights"])
+    med = lambda v: statistics.median(v)
+    return {"ms": med(times), "cpu": med(cpus), "up": int(med(ups)), "down": int(med(downs)),
+            "trips": int(med(trips)), "reused": all_reused}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT TLS 完整握手与会话复用对比（本地 Broker 替身）")
+    parser.add_argument("--rtt", type=float, default=40.0, help="模拟往返时间（毫秒，默认 40）")
+    parser.add_argument("--runs", type=int, default=30, help="每种情形的重连次数（默认 30）")
+    parser.add_argument("--bundle", default=SYSTEM_BUNDLE,
+                        help="证书包情形加载的系统 CA 证书包（不存在时跳过该情形）")
+    parser.add_argument("--check", action="store_true", help="校验会话复用的效果（ctest 用）")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as workdir:
+        ca, chain, key = make_certs(workdir)
+        relay = Relay(start_broker(chain, key), args.rtt)
+
+        cases = []
+        pinned = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        pinned.load_verify_locations(ca)
+        if os.path.exists(args.bundle):
+            bundle = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+            bundle.load_verify_locations(args.bundle)
+            bundle.load_verify_locations(ca)
+            count = len(bundle.get_ca_certs())
+            cases.append(("完整握手，证书包（%d 个 CA）" % count, bundle, False))
+        cases.append(("完整握手，固定 CA", pinned, False))
+        cases.append(("会话复用，固定 CA", pinned, True))
+
+        print("模拟 RTT %.0f ms，每种 %d 次重连，TLS 1.2，RSA-2048 证书链（叶证书 + CA）" % (args.rtt, args.runs))
+        print("%-24s %10s %10s %8s %8s %6s" % ("情形", "握手 ms", "CPU ms", "上行", "下行", "往返"))
+        results = {}
+        for label, ctx, resume in cases:
+            r = run_case(relay, ctx, resume, args.runs)
+            results[(ctx is pinned, resume)] = r
+            print("%-24s %10.1f %10.2f %8d %8d %6d" % (label, r["ms"], r["cpu"], r["up"], r["down"], r["trips"]))
+
+    if not args.check:
+        return 0
+    full, resumed = results[(True, False)], results[(True, True)]
+    errors = []
+    if not resumed["reused"]:
+        errors.append("会话复用未被接受")
+    if full["trips"] != 2 or resumed["trips"] != 1:
+        errors.append("握手往返：完整 %d 次，复用 %d 次（期望 2 / 1）" % (full["trips"], resumed["trips"]))
+    if resumed["down"] >= full["down"]:
+        errors.append("复用下行 %d 字节不少于完整握手 %d 字节" % (resumed["down"], full["down"]))
+    for e in errors:
+        print("校验失败: %s" % e)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())